@@ -0,0 +1,198 @@
+//
+//		DirWatchTest
+//
+//		DirWatch with inotify on a temporary folder.
+//
+//		Files and folders are created, renamed, moved in and out and
+//		deleted, and each batch of changes is checked :
+//
+//		  o a file created, renamed and deleted is added, renamed and removed
+//		  o a folder created is added and the files in it are reported
+//		  o a file moved in from outside is added
+//		  o a folder renamed is one change, and files in it are reported
+//		    under the new name
+//		  o a folder moved out is removed, and files changed in it later
+//		    are not reported
+//		  o a folder deleted is removed
+//		  o Close returns promptly
+//
+//		Not part of the application build. Linux only. From the repository folder :
+//
+//		  g++ -O2 -std=c++17 -I. Benchmark/DirWatchTest.cpp DirWatch.cpp FrameTrace.cpp FrameStats.cpp -lpthread -o dirwatchtest
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <filesystem>
+#include <unistd.h>
+#include "DirWatch.h"
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+static void Check(bool bPass, const char* name, const char* detail)
+{
+	if (!bPass)
+		failures++;
+	printf("%-36s %-30s %s\n", name, detail, bPass ? "pass" : "FAIL");
+}
+
+static std::mutex mutex;
+static std::condition_variable ready;
+static unsigned int batches = 0;
+
+// Wait for the next batch, or for the time given, and take the changes.
+// A file written is also reported modified when it is closed, which is left out.
+static std::vector<DirChange> TakeBatch(DirWatch& watch, double seconds)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		ready.wait_for(lock, std::chrono::duration<double>(seconds), [&]() { return batches > 0; });
+		batches = 0;
+	}
+	bool bOverflow = false;
+	std::vector<DirChange> changes;
+	for (const DirChange& change : watch.TakeChanges(bOverflow)) {
+		if (change.action != DIR_MODIFIED)
+			changes.push_back(change);
+	}
+	return changes;
+}
+
+static const char* ActionName(DirAction action)
+{
+	switch (action) {
+		case DIR_ADDED:    return "added";
+		case DIR_REMOVED:  return "removed";
+		case DIR_MODIFIED: return "modified";
+		default:           return "renamed";
+	}
+}
+
+// Changes are the ones expected, as "action path" or "renamed old>new"
+static void CheckChanges(const std::vector<DirChange>& changes, const std::vector<std::string>& expected, const char* name)
+{
+	std::string found;
+	bool bSame = (changes.size() == expected.size());
+	for (size_t i = 0; i < changes.size(); i++) {
+		std::string text = std::string(ActionName(changes[i].action)) + " ";
+		if (changes[i].action == DIR_RENAMED)
+			text += changes[i].oldpath + ">";
+		text += changes[i].path;
+		if (i >= expected.size() || text != expected[i])
+			bSame = false;
+		found += (i > 0 ? ", " : "") + text;
+	}
+	char detail[64]{};
+	snprintf(detail, 64, "%s", changes.empty() ? "no changes" : found.c_str());
+	Check(bSame, name, detail);
+}
+
+static void WriteFile(const fs::path& path)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file) {
+		fputs("image", file);
+		fclose(file);
+	}
+}
+
+int main()
+{
+	std::error_code ec;
+	const fs::path base = fs::temp_directory_path(ec) / ("dirwatchtest" + std::to_string((unsigned long)getpid()));
+	const fs::path root = base / "watched";
+	const fs::path outside = base / "outside";
+	fs::remove_all(base, ec);
+	fs::create_directories(root, ec);
+	fs::create_directories(outside, ec);
+
+	DirWatch watch;
+	watch.SetCallback([]() {
+		std::lock_guard<std::mutex> lock(mutex);
+		batches++;
+		ready.notify_one();
+	});
+	const bool bOpen = watch.Open(root.string(), 50);
+	Check(bOpen, "Open", root.c_str());
+	if (!bOpen) {
+		printf("\nFAILED\n");
+		return 1;
+	}
+
+	WriteFile(root / "a.jpg");
+	CheckChanges(TakeBatch(watch, 2.0), { "added a.jpg" }, "File created");
+
+	fs::rename(root / "a.jpg", root / "b.jpg", ec);
+	CheckChanges(TakeBatch(watch, 2.0), { "renamed a.jpg>b.jpg" }, "File renamed");
+
+	fs::remove(root / "b.jpg", ec);
+	CheckChanges(TakeBatch(watch, 2.0), { "removed b.jpg" }, "File deleted");
+
+	fs::create_directory(root / "sub", ec);
+	CheckChanges(TakeBatch(watch, 2.0), { "added sub" }, "Folder created");
+	WriteFile(root / "sub" / "c.jpg");
+	CheckChanges(TakeBatch(watch, 2.0), { "added sub/c.jpg" }, "  file in it");
+
+	WriteFile(outside / "d.jpg");
+	fs::rename(outside / "d.jpg", root / "d.jpg", ec);
+	CheckChanges(TakeBatch(watch, 2.0), { "added d.jpg" }, "File moved in");
+
+	fs::create_directory(root / "sub" / "deep", ec);
+	TakeBatch(watch, 2.0);
+	fs::rename(root / "sub", root / "renamed", ec);
+	CheckChanges(TakeBatch(watch, 2.0), { "renamed sub>renamed" }, "Folder renamed");
+	WriteFile(root / "renamed" / "deep" / "e.jpg");
+	CheckChanges(TakeBatch(watch, 2.0), { "added renamed/deep/e.jpg" }, "  file in it, new name");
+
+	fs::rename(root / "renamed", outside / "renamed", ec);
+	CheckChanges(TakeBatch(watch, 2.0), { "removed renamed" }, "Folder moved out");
+	WriteFile(outside / "renamed" / "f.jpg");
+	WriteFile(outside / "renamed" / "deep" / "g.jpg");
+	fs::remove(outside / "renamed" / "c.jpg", ec);
+	CheckChanges(TakeBatch(watch, 0.5), {}, "  files in it not reported");
+
+	fs::create_directories(root / "gone" / "inner", ec);
+	TakeBatch(watch, 2.0);
+	fs::remove_all(root / "gone", ec);
+	const std::vector<DirChange> removed = TakeBatch(watch, 2.0);
+	const bool bGone = !removed.empty() && removed.back().action == DIR_REMOVED && removed.back().path == "gone";
+	Check(bGone, "Folder deleted", bGone ? "removed gone" : "not removed");
+
+	const auto start = std::chrono::steady_clock::now();
+	watch.Close();
+	const double msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	char detail[64]{};
+	snprintf(detail, 64, "%.1f msec", msec);
+	Check(!watch.IsOpen() && msec < 100.0, "Close", detail);
+
+	fs::remove_all(base, ec);
+	printf("\n%s\n", failures ? "FAILED" : "All passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,191 @@
+//
+//		DirtyBench
+//
+//		Dirty tile presentation against drawing every frame in full.
+//
+//		Synthetic frames have a still background with part of it changing
+//		from frame to frame : a clock, a scrolling ticker, a moving sprite,
+//		and all of it for the case where the whole frame must be drawn.
+//		Two MemoryPresenters draw each frame, one in full and one with the
+//		tiles found changed by FrameChange. Their targets are compared after
+//		every frame and must be the same.
+//
+//		Not part of the application build. From the repository folder :
+//
+//		  g++ -O2 -std=c++17 -I. Benchmark/DirtyBench.cpp Presenter.cpp MemoryPresenter.cpp FrameChange.cpp FrameScaler.cpp FrameFit.cpp FrameStats.cpp FrameTrace.cpp CpuFeatures.cpp -lpthread -o dirtybench
+//
+//		  dirtybench [frames]
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include "MemoryPresenter.h"
+#include "FrameChange.h"
+
+struct DirtyCase {
+	const char* name;
+	int srcWidth, srcHeight;
+	int dstWidth, dstHeight;
+	FitMode mode;
+	ScaleFilter filter;
+};
+
+static const DirtyCase cases[] = {
+	{ "1080p",          1920, 1080, 1920, 1080, FIT_FILL, SCALE_AREA },
+	{ "4K to 1080p",    3840, 2160, 1920, 1080, FIT_FILL, SCALE_AREA },
+	{ "720p to 1080p",  1280,  720, 1920, 1080, FIT_FILL, SCALE_BILINEAR },
+	{ "1080p to 1440p", 1920, 1080, 2560, 1440, FIT_FILL, SCALE_NEAREST },
+	{ "4:3 fit 1080p",  1440, 1080, 1920, 1080, FIT_FIT,  SCALE_AREA },
+};
+
+enum Pattern {
+	PATTERN_CLOCK = 0,  // Small block redrawn every frame
+	PATTERN_TICKER,     // Strip across the bottom scrolled every frame
+	PATTERN_SPRITE,     // Block moving over the background
+	PATTERN_FULL        // Every pixel changed
+};
+
+static const char* patternNames[4] = { "Clock", "Ticker", "Sprite", "Full" };
+
+static void FillRandom(unsigned char* pixels, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		pixels[i] = (unsigned char)(rand() & 0xFF);
+}
+
+// Change the frame for the pattern, starting from the background
+static void NextFrame(std::vector<unsigned char>& frame, const std::vector<unsigned char>& background,
+	int width, int height, Pattern pattern, int index)
+{
+	const size_t pitch = (size_t)width*4;
+	switch (pattern) {
+		case PATTERN_CLOCK: {
+			const int w = width/10;
+			const int h = height/14;
+			for (int y = 0; y < h; y++)
+				FillRandom(frame.data() + (size_t)(height/20 + y)*pitch + (size_t)(width - width/20 - w)*4, (size_t)w*4);
+			break;
+		}
+		case PATTERN_TICKER: {
+			const int h = height/27;
+			const int shift = (index*4) % width;
+			for (int y = height - h; y < height; y++) {
+				const unsigned char* from = background.data() + (size_t)y*pitch;
+				unsigned char* to = frame.data() + (size_t)y*pitch;
+				memcpy(to, from + (size_t)shift*4, (size_t)(width - shift)*4);
+				memcpy(to + (size_t)(width - shift)*4, from, (size_t)shift*4);
+			}
+			break;
+		}
+		case PATTERN_SPRITE: {
+			const int size = height/8;
+			const int range = width - size;
+			const int last = ((index - 1)*8) % range;
+			const int x = (index*8) % range;
+			const int y = height/2 - size/2;
+			for (int j = 0; j < size; j++) {
+				const size_t offset = (size_t)(y + j)*pitch;
+				if (index > 0)
+					memcpy(frame.data() + offset + (size_t)last*4, background.data() + offset + (size_t)last*4, (size_t)size*4);
+				memset(frame.data() + offset + (size_t)x*4, (index*16) & 0xFF, (size_t)size*4);
+			}
+			break;
+		}
+		default:
+			FillRandom(frame.data(), frame.size());
+			break;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const int frames = (argc > 1) ? atoi(argv[1]) : 60;
+	if (frames <= 0)
+		return 1;
+
+	int failures = 0;
+
+	printf("SIMD %s, %d frames\n\n", SimdLevelName(GetSimdLevel()), frames);
+	printf("%-14s %-8s %-8s %8s %8s %8s %8s %8s  %s\n",
+		"Size", "Filter", "Pattern", "full", "dirty", "detect", "area", "partial", "result");
+
+	srand(1);
+	for (const DirtyCase& c : cases) {
+
+		std::vector<unsigned char> background((size_t)c.srcWidth*c.srcHeight*4);
+		FillRandom(background.data(), background.size());
+
+		for (int p = 0; p < 4; p++) {
+			const Pattern pattern = (Pattern)p;
+			std::vector<unsigned char> frame = background;
+
+			MemoryPresenter full;
+			MemoryPresenter dirty;
+			full.SetTargetSize(c.dstWidth, c.dstHeight);
+			dirty.SetTargetSize(c.dstWidth, c.dstHeight);
+			full.SetFilter(c.filter);
+			dirty.SetFilter(c.filter);
+			FrameChange change;
+
+			double fullTime = 0.0;
+			double dirtyTime = 0.0;
+			double detectTime = 0.0;
+			bool bExact = true;
+			for (int i = 0; i < frames; i++) {
+				NextFrame(frame, background, c.srcWidth, c.srcHeight, pattern, i);
+
+				auto start = std::chrono::steady_clock::now();
+				full.Present(frame.data(), c.srcWidth, c.srcHeight, c.mode);
+				fullTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+				start = std::chrono::steady_clock::now();
+				change.Update(frame.data(), c.srcWidth, c.srcHeight);
+				detectTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+				start = std::chrono::steady_clock::now();
+				dirty.Present(frame.data(), c.srcWidth, c.srcHeight, c.mode, &change);
+				dirtyTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+				if (memcmp(full.GetTarget(), dirty.GetTarget(), (size_t)c.dstWidth*c.dstHeight*4) != 0)
+					bExact = false;
+			}
+			if (!bExact)
+				failures++;
+
+			// The first frame is always drawn in full
+			const PresenterStats& stats = dirty.GetStats();
+			printf("%-14s %-8s %-8s %8.2f %8.2f %8.2f %7.1f%% %7.1f%%  %s\n", c.name,
+				c.filter == SCALE_NEAREST ? "Nearest" : (c.filter == SCALE_BILINEAR ? "Bilinear" : "Area"),
+				patternNames[p], fullTime/frames, dirtyTime/frames, detectTime/frames,
+				100.0*stats.dirty, 100.0*(double)stats.partial/(double)stats.presents, bExact ? "same" : "DIFFERENT");
+		}
+	}
+
+	printf("\nmsec per frame. Area is the mean fraction of the destination drawn.\n");
+	if (failures > 0)
+		printf("%d targets differ from the full present\n", failures);
+
+	return failures > 0 ? 1 : 0;
+}
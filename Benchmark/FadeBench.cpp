@@ -0,0 +1,165 @@
+//
+//		FadeBench
+//
+//		Cost of slideshow cross fades drawn by SlideFade.
+//
+//		A slideshow of 10 second slides with 1 second fades at 30 fps is run
+//		for a little over a minute on the FrameScheduler with a simulated clock, drawing
+//		to a MemoryPresenter of the desktop size. The blending and drawing
+//		are real and timed. For each size the report shows :
+//
+//		  o Frames drawn for each transition and the time to blend and draw one
+//		  o Time spent on a transition and the share of one core it used
+//		  o Wakes and frames drawn between transitions, which should be none
+//		    other than the one render for each slide
+//
+//		The last frame of each transition must be the new slide exactly.
+//
+//		Not part of the application build. From the repository folder :
+//
+//		  g++ -O2 -std=c++17 -I. Benchmark/FadeBench.cpp SlideFade.cpp PixelKernels.cpp Presenter.cpp MemoryPresenter.cpp FrameScheduler.cpp FramePool.cpp FrameScaler.cpp FrameFit.cpp FrameChange.cpp FrameStats.cpp FrameTrace.cpp CpuFeatures.cpp -lpthread -o fadebench
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include "SlideFade.h"
+#include "MemoryPresenter.h"
+#include "FrameScheduler.h"
+#include "FramePool.h"
+#include "CpuFeatures.h"
+
+static int failures = 0;
+
+// A slide with a gradient that differs for each seed
+static FrameBuffer MakeSlide(unsigned int width, unsigned int height, unsigned int seed)
+{
+	FrameBuffer slide = FramePool::Shared().Acquire((size_t)width*height*4);
+	unsigned char* p = slide.data();
+	for (unsigned int y = 0; y < height; y++) {
+		for (unsigned int x = 0; x < width; x++) {
+			p[0] = (unsigned char)(x*seed + y);
+			p[1] = (unsigned char)(y*seed + x/3);
+			p[2] = (unsigned char)((x ^ y)*seed);
+			p[3] = 255;
+			p += 4;
+		}
+	}
+	return slide;
+}
+
+static void Run(unsigned int width, unsigned int height)
+{
+	const double slideTime = 10000.0; // msec
+	const double end = 61500.0; // The last transition ends
+
+	MemoryPresenter presenter;
+	presenter.SetTargetSize(width, height);
+	FrameScheduler scheduler;
+	SlideFade fade;
+	fade.SetDuration(1000.0);
+	fade.SetInterval(1000.0/30.0);
+
+	// The two slides shown in turn, and a copy of each to check against
+	std::vector<unsigned char> expected[2];
+	for (unsigned int i = 0; i < 2; i++) {
+		FrameBuffer slide = MakeSlide(width, height, 3 + i*4);
+		expected[i].assign(slide.data(), slide.data() + slide.size());
+	}
+
+	unsigned int slides = 0;
+	unsigned int wakes = 0;
+	unsigned int idleWakes = 0;    // Wakes between transitions without a slide due
+	uint64_t idlePresents = 0;     // Frames drawn between transitions
+	bool bExact = true;
+	double start = 0.0;
+	double now = 0.0;
+	scheduler.Wake();
+
+	while (now < end) {
+		// Whole msec, rounded up, as for MsgWaitForMultipleObjectsEx
+		const double wait = scheduler.GetWaitTime(now/1000.0);
+		if (wait < 0.0)
+			break;
+		now += ceil(wait*1000.0 - 1e-9);
+		if (now >= end)
+			break;
+
+		wakes++;
+		const unsigned int due = scheduler.Poll(now/1000.0);
+		if (!due)
+			continue;
+
+		const bool bWasFading = fade.IsFading();
+		const uint64_t presents = presenter.GetStats().presents;
+		if (slides == 0 || now - start >= slideTime) {
+			FrameBuffer slide = MakeSlide(width, height, 3 + (slides % 2)*4);
+			fade.Start("slide", slide, width, height, now);
+			start = now;
+			slides++;
+		}
+		else if (!bWasFading) {
+			idleWakes++;
+		}
+		fade.Present(presenter, now);
+		if (bWasFading && !fade.IsFading()) {
+			// The last frame of a transition
+			const std::vector<unsigned char>& slide = expected[(slides - 1) % 2];
+			if (memcmp(presenter.GetTarget(), slide.data(), slide.size()) != 0)
+				bExact = false;
+		}
+		if (!bWasFading && !fade.IsFading() && now != start)
+			idlePresents += presenter.GetStats().presents - presents;
+
+		scheduler.CancelAll();
+		if (fade.IsFading())
+			scheduler.Schedule(SCHEDULE_FRAME, fade.GetNextTime()/1000.0);
+		else
+			scheduler.Schedule(SCHEDULE_SLIDE, (start + slideTime)/1000.0);
+	}
+
+	const SlideFadeStats& stats = fade.GetStats();
+	const double frames = stats.fades ? (double)stats.frames/(double)stats.fades : 0.0;
+	const double share = 100.0*stats.cost/fade.GetDuration();
+	const bool bPass = bExact && stats.fades == slides - 1 && idleWakes == 0 && idlePresents == 0;
+	if (!bPass)
+		failures++;
+	printf("%4ux%-4u %6llu %7.1f %9.3f %9.3f %9.1f %9.1f %6.1f%% %6u %6u %6llu  %s\n", width, height,
+		(unsigned long long)stats.fades, frames, stats.blend, stats.present, stats.cost, stats.max, share,
+		wakes, idleWakes, (unsigned long long)idlePresents, bPass ? "pass" : "FAIL");
+}
+
+int main()
+{
+	printf("Blend kernel %s\n\n", SimdLevelName(GetSimdLevel()));
+	printf("%-9s %6s %7s %9s %9s %9s %9s %7s %6s %6s %6s  %s\n", "Size", "fades", "frames",
+		"blend", "present", "msec", "max", "core", "wakes", "idle", "drawn", "result");
+
+	Run(1280, 720);
+	Run(1920, 1080);
+	Run(2560, 1440);
+	Run(3840, 2160);
+
+	printf("\n%s\n", failures ? "FAILED" : "All passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,275 @@
+//
+//		KernelBench
+//
+//		Pixel kernel timing and correctness for each instruction set.
+//
+//		Every kernel variant supported by this CPU is timed on one thread
+//		and its output compared with the scalar kernel. Throughput is
+//		bytes read and written per second and output pixels per clock cycle.
+//		Cycles are from the time stamp counter on x86 and estimated from
+//		a chain of dependent additions on other processors.
+//
+//		Kernels without a variant for an instruction set are not listed
+//		for it. All variants are expected to match the scalar result
+//		exactly, the tolerance is the largest difference in any byte.
+//
+//		Not part of the application build. From the repository folder :
+//
+//		  g++ -O2 -std=c++17 -I. Benchmark/KernelBench.cpp PixelKernels.cpp YuvConvert.cpp FrameScaler.cpp FrameFit.cpp FrameChange.cpp CpuFeatures.cpp -lpthread -o kernelbench
+//		  cl /O2 /EHsc /std:c++17 /I. Benchmark\KernelBench.cpp PixelKernels.cpp YuvConvert.cpp FrameScaler.cpp FrameFit.cpp FrameChange.cpp CpuFeatures.cpp
+//
+//		  kernelbench [msec for each variant]
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include "PixelKernels.h"
+#include "YuvConvert.h"
+#include "FrameScaler.h"
+#include "FrameChange.h"
+
+#if defined(SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(SIMD_X86)
+#include <x86intrin.h>
+#endif
+
+struct Kernel {
+	const char* name;
+	bool bNeon;                  // Has a NEON variant
+	unsigned int tolerance;      // Largest difference allowed in a byte
+	double bytes;                // Read and written by each call
+	double pixels;               // Output pixels of each call
+	std::function<void(SimdLevel)> run;
+	std::vector<unsigned char>* output;
+};
+
+static double Seconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Clock cycles per second
+static double MeasureClock()
+{
+	const double start = Seconds();
+#ifdef SIMD_X86
+	const uint64_t tsc = __rdtsc();
+	while (Seconds() - start < 0.1) {}
+	return (double)(__rdtsc() - tsc)/(Seconds() - start);
+#else
+	// One addition a cycle
+	const uint64_t count = 200000000;
+	uint64_t x = 0;
+	for (uint64_t i = 0; i < count; i++) {
+		x += i;
+		__asm__ volatile("" : "+r"(x));
+	}
+	return (double)count/(Seconds() - start);
+#endif
+}
+
+// Average seconds for a call after one untimed call
+static double TimeKernel(const Kernel& k, SimdLevel level, double budget)
+{
+	k.run(level);
+	int calls = 0;
+	const double start = Seconds();
+	double elapsed = 0.0;
+	do {
+		k.run(level);
+		calls++;
+		elapsed = Seconds() - start;
+	} while (elapsed < budget);
+	return elapsed/(double)calls;
+}
+
+static unsigned int MaxDifference(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b)
+{
+	if (a.size() != b.size())
+		return 256;
+	unsigned int diff = 0;
+	for (size_t i = 0; i < a.size(); i++) {
+		const unsigned int d = (a[i] > b[i]) ? a[i] - b[i] : b[i] - a[i];
+		if (d > diff)
+			diff = d;
+	}
+	return diff;
+}
+
+static void Randomize(std::vector<unsigned char>& buffer)
+{
+	for (size_t i = 0; i < buffer.size(); i++)
+		buffer[i] = (unsigned char)(rand() & 0xFF);
+}
+
+int main(int argc, char* argv[])
+{
+	const int msec = (argc > 1) ? atoi(argv[1]) : 200;
+	if (msec <= 0)
+		return 1;
+	const double budget = msec/1000.0;
+
+	srand(1);
+	const unsigned int width = 1920;
+	const unsigned int height = 1080;
+	const double pixels = (double)width*height;
+
+	// Random pixels so that nothing is skipped
+	std::vector<unsigned char> yuv(YuvFrameSize(width, height));
+	std::vector<unsigned char> bgra(width*height*4);
+	std::vector<unsigned char> other(bgra.size());
+	std::vector<unsigned char> large((size_t)width*2*height*2*4);
+	Randomize(yuv);
+	Randomize(bgra);
+	Randomize(other);
+	Randomize(large);
+
+	// A second frame with some tiles changed
+	std::vector<unsigned char> changed(bgra);
+	for (size_t i = 0; i < changed.size(); i += 4099)
+		changed[i] ^= 1;
+
+	std::vector<unsigned char> out[12];
+	std::vector<Kernel> kernels;
+
+	const YuvFormat yuvFormats[2] = { YUV_I420, YUV_NV12 };
+	const char* yuvNames[2] = { "I420 to BGRA", "NV12 to BGRA" };
+	for (int i = 0; i < 2; i++) {
+		std::vector<unsigned char>* o = &out[kernels.size()];
+		YuvColor color;
+		color.format = yuvFormats[i];
+		kernels.push_back({ yuvNames[i], false, 0, (double)yuv.size() + pixels*4, pixels,
+			[&yuv, o, color, width, height](SimdLevel level) {
+				o->resize((size_t)width*height*4);
+				YuvToBgra(yuv.data(), o->data(), width, height, color, level);
+			}, o });
+	}
+
+	const char* scaleNames[3] = { "Scale nearest", "Scale bilinear", "Scale area" };
+	for (int f = 0; f < 3; f++) {
+		std::vector<unsigned char>* o = &out[kernels.size()];
+		const ScaleFilter filter = (ScaleFilter)f;
+		kernels.push_back({ scaleNames[f], false, 0, (double)large.size() + pixels*4, pixels,
+			[&large, o, filter, width, height](SimdLevel level) {
+				// 4K to 1080p on one thread
+				static FrameScaler scaler;
+				scaler.SetThreads(1);
+				scaler.SetSimdLevel(level);
+				const FitRect srcRect = { 0, 0, (int)width*2, (int)height*2 };
+				const FitRect dstRect = { 0, 0, (int)width, (int)height };
+				o->resize((size_t)width*height*4);
+				scaler.Scale(large.data(), width*2*4, srcRect, o->data(), width*4, dstRect, filter);
+			}, o });
+	}
+
+	{
+		std::vector<unsigned char>* o = &out[kernels.size()];
+		kernels.push_back({ "Change tiles", false, 0, pixels*4*2, pixels*2,
+			[&bgra, &changed, o, width, height](SimdLevel level) {
+				// Tiles changed between two frames
+				static FrameChange change;
+				change.SetSimdLevel(level);
+				change.Reset();
+				change.Update(bgra.data(), width, height);
+				change.Update(changed.data(), width, height);
+				*o = change.GetChanged();
+			}, o });
+	}
+
+	const PixelFormat convertFormats[4][2] = {
+		{ PIXEL_BGRA, PIXEL_RGBA }, { PIXEL_BGRX, PIXEL_BGRA },
+		{ PIXEL_BGRX, PIXEL_RGBA }, { PIXEL_BGRA, PIXEL_BGRA }
+	};
+	static char convertNames[4][32];
+	for (int i = 0; i < 4; i++) {
+		std::vector<unsigned char>* o = &out[kernels.size()];
+		const PixelFormat src = convertFormats[i][0];
+		const PixelFormat dst = convertFormats[i][1];
+		snprintf(convertNames[i], 32, "%s to %s", PixelFormatName(src), PixelFormatName(dst));
+		kernels.push_back({ convertNames[i], true, 0, pixels*8, pixels,
+			[&bgra, o, src, dst, width, height](SimdLevel level) {
+				o->resize((size_t)width*height*4);
+				ConvertPixels(bgra.data(), 0, src, o->data(), 0, dst, width, height, level);
+			}, o });
+	}
+
+	{
+		std::vector<unsigned char>* o = &out[kernels.size()];
+		kernels.push_back({ "Blend", true, 0, pixels*12, pixels,
+			[&bgra, &other, o, width, height](SimdLevel level) {
+				o->resize((size_t)width*height*4);
+				BlendPixels(bgra.data(), other.data(), o->data(), width, height, 0, 77, level);
+			}, o });
+	}
+
+	const double clock = MeasureClock();
+	const SimdLevel levels[4] = { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2, SIMD_NEON };
+	int failures = 0;
+
+	printf("Best SIMD %s, clock %.2f GHz, %ux%u, %d msec for each\n\n",
+		SimdLevelName(GetSimdLevel()), clock/1e9, width, height, msec);
+	printf("%-16s %-7s %9s %8s %8s %8s  %s\n", "Kernel", "SIMD", "usec", "GB/s", "pix/cyc", "speedup", "result");
+
+	for (const Kernel& k : kernels) {
+
+		// Scalar reference
+		k.run(SIMD_SCALAR);
+		const std::vector<unsigned char> reference = *k.output;
+		double scalarTime = 0.0;
+
+		for (SimdLevel level : levels) {
+			if (!IsSimdSupported(level) || (level == SIMD_NEON && !k.bNeon))
+				continue;
+
+			k.output->assign(k.output->size(), 0);
+			k.run(level);
+			const unsigned int diff = MaxDifference(*k.output, reference);
+			char result[32]{};
+			if (diff == 0)
+				snprintf(result, 32, "exact");
+			else if (diff <= k.tolerance)
+				snprintf(result, 32, "within %u", diff);
+			else
+				snprintf(result, 32, "DIFFERENT by %u", diff);
+			if (diff > k.tolerance)
+				failures++;
+
+			const double t = TimeKernel(k, level, budget);
+			if (level == SIMD_SCALAR)
+				scalarTime = t;
+			printf("%-16s %-7s %9.1f %8.2f %8.3f %7.1fx  %s\n", k.name, SimdLevelName(level),
+				t*1e6, k.bytes/t/1e9, k.pixels/(t*clock), scalarTime/t, result);
+		}
+	}
+
+	printf("\nOne thread. usec per call, GB/s read and written.\n");
+	if (failures > 0)
+		printf("%d results differ from the scalar reference\n", failures);
+
+	return failures > 0 ? 1 : 0;
+}
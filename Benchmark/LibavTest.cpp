@@ -0,0 +1,231 @@
+//
+//		LibavTest
+//
+//		LibavSource against PipeSource on a real video file.
+//
+//		The file is decoded at its own size by the FFmpeg libraries in this
+//		process and by ffmpeg through the pipe, each for two and a half loops.
+//		The frame count and size given by ffprobe are the reference. Checks :
+//
+//		  o each backend opens and publishes frames of the video size
+//		  o a loop has the frame count of the file, for each backend
+//		  o a loop start is reported for the first frame of each loop
+//		  o frames are the same in both backends, within rounding of the
+//		    colour conversion, and in the same order
+//		  o the frames of the second loop are those of the first
+//
+//		With no file, a 50 frame clip is made with ffmpeg from its test source.
+//
+//		Not part of the application build. Linux only. Needs the FFmpeg
+//		development packages. From the repository folder :
+//
+//		  g++ -O2 -std=c++17 -DUSE_LIBAV -I. Benchmark/LibavTest.cpp LibavSource.cpp PipeSource.cpp FrameReader.cpp FrameRing.cpp FramePool.cpp YuvConvert.cpp LoopTiming.cpp FrameFit.cpp FrameStats.cpp FrameTrace.cpp CpuFeatures.cpp VideoProbe.cpp $(pkg-config --cflags --libs libavformat libavcodec libswscale libavutil) -lpthread -o libavtest
+//
+//		  libavtest [--ffmpeg DIR] [video file]
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include "PipeSource.h"
+#include "LibavSource.h"
+#include "VideoProbe.h"
+
+static int failures = 0;
+
+static void Check(bool bPass, const char* name, const char* detail)
+{
+	if (!bPass)
+		failures++;
+	printf("%-36s %-30s %s\n", name, detail, bPass ? "pass" : "FAIL");
+}
+
+// Frames taken from one backend
+struct Decoded {
+	bool bOpen = false;
+	bool bTaken = false;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	std::vector<size_t> loops; // Frame number of each loop start
+	std::vector<std::vector<unsigned char>> frames;
+};
+
+// Take count frames in order, or until the source finishes or the timeout
+static void Decode(VideoSource& source, const VideoSourceParams& params, size_t count, Decoded& decoded)
+{
+	FrameRing ring;
+	if (!ring.Allocate(params.fit.width, params.fit.height, 3))
+		return;
+	decoded.width = params.fit.width;
+	decoded.height = params.fit.height;
+	const size_t size = (size_t)decoded.width*decoded.height*4;
+
+	// The sink runs on the source thread before each frame is published
+	std::atomic<size_t> sunk{0};
+	source.SetFrameSink([&](const unsigned char*, bool bLoopStart) {
+		if (bLoopStart)
+			decoded.loops.push_back(sunk.load());
+		sunk++;
+	});
+	decoded.bOpen = source.Open(params, &ring);
+
+	const auto start = std::chrono::steady_clock::now();
+	while (decoded.bOpen && decoded.frames.size() < count) {
+		unsigned char* frame = ring.AcquireNext();
+		if (frame) {
+			decoded.frames.emplace_back(frame, frame + size);
+			continue;
+		}
+		if (source.IsFinished() && ring.GetPending() == 0)
+			break;
+		if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > 30.0)
+			break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	decoded.bTaken = (decoded.frames.size() == count);
+	source.Close();
+	ring.Release();
+	// Loop starts of frames not taken
+	while (!decoded.loops.empty() && decoded.loops.back() >= count)
+		decoded.loops.pop_back();
+}
+
+// Mean absolute difference of two frames, per colour channel
+static double Difference(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b)
+{
+	if (a.size() != b.size() || a.empty())
+		return 255.0;
+	uint64_t sum = 0;
+	size_t n = 0;
+	for (size_t i = 0; i < a.size(); i++) {
+		if ((i & 3) == 3)
+			continue; // alpha
+		sum += (a[i] > b[i]) ? a[i] - b[i] : b[i] - a[i];
+		n++;
+	}
+	return (double)sum/n;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string folder;
+	std::string path;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--ffmpeg") == 0 && i + 1 < argc)
+			folder = std::string(argv[++i]) + "/";
+		else
+			path = argv[i];
+	}
+	const std::string ffmpeg = folder + "ffmpeg";
+	char detail[64]{};
+
+	if (path.empty()) {
+		path = "libavtest.mp4";
+		const std::string command = ffmpeg + " -hide_banner -loglevel error -y -f lavfi -i testsrc2=size=320x180:rate=25"
+			" -frames:v 50 -pix_fmt yuv420p -c:v mpeg4 -q:v 2 " + path;
+		if (system(command.c_str()) != 0) {
+			printf("Could not make %s with %s\n", path.c_str(), ffmpeg.c_str());
+			return 1;
+		}
+	}
+
+	VideoInfo info;
+	const bool bProbed = ProbeVideo(folder + "ffprobe", path, info);
+	snprintf(detail, 64, "%ux%u, %u frames", info.width, info.height, info.frames);
+	Check(bProbed && info.frames > 1, "Probe the video file", detail);
+	if (!bProbed || info.frames <= 1) {
+		printf("\nFAILED\n");
+		return 1;
+	}
+
+	VideoSourceParams params;
+	params.path = path;
+	params.ffmpegPath = ffmpeg + " -hide_banner -loglevel fatal";
+	params.videoWidth = info.width;
+	params.videoHeight = info.height;
+	params.fit = NegotiateFit(info.width, info.height, info.width, info.height, FIT_STRETCH);
+	params.loopFrames = info.frames;
+	params.rateNum = info.rateNum;
+	params.rateDen = info.rateDen;
+	params.bVariableRate = info.bVariableRate;
+	params.color.matrix = (info.colorSpace == "bt709" || (info.colorSpace != "smpte170m" && info.height >= 720)) ? YUV_BT709 : YUV_BT601;
+
+	const size_t loop = info.frames;
+	const size_t count = loop*2 + loop/2;
+	Decoded decoded[2];
+	PipeSource pipe;
+	LibavSource libav;
+	Decode(pipe, params, count, decoded[0]);
+	Decode(libav, params, count, decoded[1]);
+
+	for (int b = 0; b < 2; b++) {
+		const Decoded& d = decoded[b];
+		const char* name = b ? "libav" : "pipe";
+		snprintf(detail, 64, "%zu frames %ux%u", d.frames.size(), d.width, d.height);
+		Check(d.bOpen && d.bTaken && d.width == info.width && d.height == info.height, name, detail);
+		bool bLoops = (d.loops.size() == 3);
+		for (size_t i = 0; bLoops && i < d.loops.size(); i++)
+			bLoops = (d.loops[i] == i*loop);
+		snprintf(detail, 64, "%zu loop starts, loop of %zu", d.loops.size(), d.loops.size() > 1 ? d.loops[1] - d.loops[0] : (size_t)0);
+		Check(bLoops, "  loop start at each loop", detail);
+		// Each frame of the second loop is the same frame of the first
+		double worst = 0.0;
+		for (size_t i = 0; i < loop && loop + i < d.frames.size(); i++) {
+			const double diff = Difference(d.frames[i], d.frames[loop + i]);
+			if (diff > worst)
+				worst = diff;
+		}
+		snprintf(detail, 64, "max difference %.2f", worst);
+		Check(d.bTaken && worst < 0.5, "  second loop as the first", detail);
+	}
+
+	// The same frame in both, and a frame is nearer to its own than to
+	// the next in the other backend, so they are in the same order
+	if (decoded[0].bTaken && decoded[1].bTaken) {
+		double worst = 0.0;
+		size_t misplaced = 0;
+		for (size_t i = 0; i < count; i++) {
+			const double diff = Difference(decoded[0].frames[i], decoded[1].frames[i]);
+			if (diff > worst)
+				worst = diff;
+			if (i + 1 < count && Difference(decoded[0].frames[i], decoded[1].frames[i + 1]) <= diff)
+				misplaced++;
+		}
+		snprintf(detail, 64, "max difference %.2f", worst);
+		Check(worst < 3.0, "Same frames in both backends", detail);
+		snprintf(detail, 64, "%zu out of order", misplaced);
+		Check(misplaced == 0, "  in the same order", detail);
+	}
+	else {
+		Check(false, "Same frames in both backends", "not decoded");
+	}
+
+	printf("\n%s\n", failures ? "FAILED" : "All passed");
+	return failures ? 1 : 0;
+}
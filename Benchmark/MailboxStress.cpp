@@ -0,0 +1,193 @@
+//
+//		MailboxStress
+//
+//		FrameMailbox stress test with the producer and consumer running
+//		at different rates.
+//
+//		The producer fills every pixel of each frame with its sequence
+//		number, and changes the frame size every few frames. The consumer
+//		checks each frame it takes :
+//
+//		  o every pixel has the same sequence number, so the frame is not torn
+//		  o the size is the size written with that sequence number
+//		  o sequence numbers only increase
+//		  o the frame taken is at least as new as the last one published
+//		    before the take, so the latest frame is never lost
+//
+//		After the producer stops, the consumer must take the last frame.
+//
+//		Not part of the application build. From the repository folder :
+//
+//		  g++ -O2 -std=c++17 -I. Benchmark/MailboxStress.cpp FrameMailbox.cpp FramePool.cpp -lpthread -o mailboxstress
+//		  g++ -O1 -g -std=c++17 -fsanitize=thread -I. Benchmark/MailboxStress.cpp FrameMailbox.cpp FramePool.cpp -lpthread -o mailboxstress
+//
+//		  mailboxstress [frames]
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include "FrameMailbox.h"
+
+struct StressCase {
+	const char* name;
+	int producerUs;   // Time between frames published, 0 for as fast as possible
+	int consumerUs;   // Time between takes
+};
+
+static const StressCase cases[] = {
+	{ "Same rate",          0,     0 },
+	{ "Fast producer",      0,   500 },
+	{ "Slow producer",    500,     0 },
+	{ "60 fps to 30 fps", 16667, 33333 },
+	{ "30 fps to 60 fps", 33333, 16667 },
+};
+
+// Frame size for a sequence number, changed every 7 frames
+static void FrameSize(uint64_t sequence, unsigned int& width, unsigned int& height)
+{
+	const unsigned int step = (unsigned int)((sequence/7) % 4);
+	width = 320 + step*64;
+	height = 180 + step*36;
+}
+
+static void Wait(int usec)
+{
+	if (usec > 0)
+		std::this_thread::sleep_for(std::chrono::microseconds(usec));
+	else
+		std::this_thread::yield();
+}
+
+struct StressResult {
+	uint64_t taken = 0;
+	uint64_t torn = 0;
+	uint64_t badsize = 0;
+	uint64_t order = 0;
+	uint64_t lost = 0;
+	bool bLast = false;
+};
+
+static StressResult RunCase(const StressCase& c, uint64_t frames)
+{
+	FrameMailbox mailbox;
+	StressResult result;
+	std::atomic<bool> bDone{false};
+
+	std::thread producer([&]() {
+		for (uint64_t sequence = 1; sequence <= frames; sequence++) {
+			unsigned int width = 0;
+			unsigned int height = 0;
+			FrameSize(sequence, width, height);
+			uint32_t* pixels = (uint32_t*)mailbox.BeginWrite(width, height);
+			const size_t count = (size_t)width*height;
+			for (size_t i = 0; i < count; i++)
+				pixels[i] = (uint32_t)sequence;
+			mailbox.EndWrite();
+			Wait(c.producerUs);
+		}
+		bDone = true;
+	});
+
+	// Check the frame taken against the newest published before the take
+	auto Check = [&](const unsigned char* frame, unsigned int width, unsigned int height, uint64_t published, uint64_t& last) {
+		if (!frame) {
+			if (mailbox.GetHeldSequence() < published)
+				result.lost++;
+			return;
+		}
+		result.taken++;
+		const uint64_t sequence = mailbox.GetHeldSequence();
+		if (sequence <= last)
+			result.order++;
+		if (sequence < published)
+			result.lost++;
+		last = sequence;
+		unsigned int w = 0;
+		unsigned int h = 0;
+		FrameSize(sequence, w, h);
+		if (w != width || h != height) {
+			result.badsize++;
+			return;
+		}
+		const uint32_t* pixels = (const uint32_t*)frame;
+		const size_t count = (size_t)width*height;
+		for (size_t i = 0; i < count; i++) {
+			if (pixels[i] != (uint32_t)sequence) {
+				result.torn++;
+				break;
+			}
+		}
+	};
+
+	uint64_t last = 0;
+	while (!bDone) {
+		const uint64_t published = mailbox.GetPublished();
+		unsigned int width = 0;
+		unsigned int height = 0;
+		const unsigned char* frame = mailbox.TakeLatest(width, height);
+		Check(frame, width, height, published, last);
+		Wait(c.consumerUs);
+	}
+	producer.join();
+
+	// The last frame published must be taken
+	unsigned int width = 0;
+	unsigned int height = 0;
+	const unsigned char* frame = mailbox.TakeLatest(width, height);
+	if (frame)
+		Check(frame, width, height, frames, last);
+	result.bLast = (mailbox.GetHeldSequence() == frames);
+
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	const int frames = (argc > 1) ? atoi(argv[1]) : 300;
+	if (frames <= 0)
+		return 1;
+
+	int failures = 0;
+	printf("%d frames for each case\n\n", frames);
+	printf("%-18s %8s %8s %6s %6s %6s %6s  %s\n", "Case", "taken", "msec", "torn", "size", "order", "lost", "result");
+
+	for (const StressCase& c : cases) {
+		const auto start = std::chrono::steady_clock::now();
+		const StressResult r = RunCase(c, (uint64_t)frames);
+		const double msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		const bool bPass = (r.torn == 0 && r.badsize == 0 && r.order == 0 && r.lost == 0 && r.bLast);
+		if (!bPass)
+			failures++;
+		printf("%-18s %8llu %8.0f %6llu %6llu %6llu %6llu  %s\n", c.name, (unsigned long long)r.taken, msec,
+			(unsigned long long)r.torn, (unsigned long long)r.badsize, (unsigned long long)r.order, (unsigned long long)r.lost,
+			bPass ? "pass" : (r.bLast ? "FAIL" : "FAIL, last frame not taken"));
+	}
+
+	if (failures > 0)
+		printf("\n%d cases failed\n", failures);
+
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,606 @@
+//
+//		PipelineBench
+//
+//		The video path from the FFmpeg pipe to the desktop without Windows.
+//
+//		The program runs itself in place of ffmpeg with the command line
+//		made by PipeSource. As the stand-in, it sends raw yuv420p or bgra
+//		frames of the size asked for by -vf on stdout, at the frame rate
+//		of the input "gen:WIDTHxHEIGHT@FPS" or as fast as they are read.
+//		Each frame carries the time it was sent in its first row.
+//
+//		The frames are read and converted by the PipeSource reader thread,
+//		taken when due by a FramePacer and drawn by a MemoryPresenter,
+//		as in the render loop of the application. For each scenario :
+//
+//		  o Frames shown a second, against the video rate, and frames dropped
+//		  o Process CPU time per frame shown, and of the stand-in per frame sent
+//		  o Latency from a frame being sent to it being drawn, 50/90/99%
+//		  o Convert, scale and present times at 50 and 99% (FrameStats)
+//		  o Frame pool memory and resident memory of the process
+//
+//		A video file can be decoded instead by the real ffmpeg, or by the
+//		FFmpeg libraries (LibavSource) in this process, to compare the two
+//		backends on the same file. Latency is not measured for a file.
+//
+//		Not part of the application build. Linux only. From the repository folder :
+//
+//		  g++ -O2 -std=c++17 -I. Benchmark/PipelineBench.cpp PipeSource.cpp FrameReader.cpp FrameRing.cpp FramePool.cpp YuvConvert.cpp LoopTiming.cpp FramePacer.cpp Presenter.cpp MemoryPresenter.cpp FrameScaler.cpp FrameFit.cpp FrameChange.cpp FrameStats.cpp FrameTrace.cpp CpuFeatures.cpp VideoProbe.cpp -lpthread -o pipelinebench
+//
+//		With the libav backend, using the FFmpeg development packages
+//		(e.g. libavformat-dev, libavcodec-dev, libswscale-dev, libavutil-dev) :
+//
+//		  g++ -O2 -std=c++17 -DUSE_LIBAV -I. Benchmark/PipelineBench.cpp LibavSource.cpp PipeSource.cpp FrameReader.cpp FrameRing.cpp FramePool.cpp YuvConvert.cpp LoopTiming.cpp FramePacer.cpp Presenter.cpp MemoryPresenter.cpp FrameScaler.cpp FrameFit.cpp FrameChange.cpp FrameStats.cpp FrameTrace.cpp CpuFeatures.cpp VideoProbe.cpp $(pkg-config --cflags --libs libavformat libavcodec libswscale libavutil) -lpthread -o pipelinebench
+//
+//		  pipelinebench [options] [scenario ...]
+//
+//		  Scenarios are 720p, 1080p or 4k with a rate, such as 1080p60,
+//		  or WIDTHxHEIGHT@FPS. The default is 720p, 1080p and 4k at 24, 30 and 60 fps.
+//		  Any other scenario is a video file.
+//
+//		  --seconds N       Time measured for each scenario (default 3)
+//		  --desktop WxH     Target size (default 1920x1080)
+//		  --fit MODE        stretch, fit, fill or center (default fill)
+//		  --filter FILTER   nearest, bilinear or area (default area)
+//		  --bgra            The pipe sends bgra instead of yuv420p
+//		  --max             Frames sent and drawn as fast as possible
+//		  --trace FILE      Save a Chrome trace of the last scenario
+//		  --ffmpeg DIR      Folder of ffmpeg and ffprobe for video files (default PATH)
+//		  --libav           Decode video files with the FFmpeg libraries
+//		  --compare         Decode video files with both backends in turn
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <memory>
+#include "PipeSource.h"
+#include "LibavSource.h"
+#include "VideoProbe.h"
+#include "FramePacer.h"
+#include "MemoryPresenter.h"
+#include "FrameChange.h"
+#include "FramePool.h"
+#include "FrameStats.h"
+#include "FrameTrace.h"
+
+// The send time is 64 bits of 8 pixels each along the first two rows
+#define STAMP_BITS 64
+#define STAMP_PIXELS 8
+
+struct Scenario {
+	std::string name;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int fps = 0;
+	std::string path;  // Video file, or empty for the stand-in
+	VideoInfo video;   // Probed video file
+};
+
+struct BenchOptions {
+	double seconds = 3.0;
+	unsigned int desktopWidth = 1920;
+	unsigned int desktopHeight = 1080;
+	FitMode mode = FIT_FILL;
+	ScaleFilter filter = SCALE_AREA;
+	bool bYuv = true;
+	bool bMax = false;
+	std::string tracePath;
+	std::string ffmpegFolder;
+	bool bLibav = false;
+	bool bCompare = false;
+};
+
+//
+// Stand-in for ffmpeg
+//
+
+// Size from "scale=W:H..." or "crop=W:H". Other filters are ignored.
+static bool ParseFilterSize(const std::string& filter, const char* name, unsigned int& width, unsigned int& height)
+{
+	size_t pos = 0;
+	while ((pos = filter.find(name, pos)) != std::string::npos) {
+		unsigned int w = 0, h = 0;
+		if (sscanf(filter.c_str() + pos + strlen(name), "%u:%u", &w, &h) == 2 && w > 0 && h > 0) {
+			width = w;
+			height = h;
+			return true;
+		}
+		pos += strlen(name);
+	}
+	return false;
+}
+
+static void StampLuma(unsigned char* yplane, unsigned int pitch, uint64_t stamp)
+{
+	for (unsigned int bit = 0; bit < STAMP_BITS; bit++) {
+		const unsigned char luma = ((stamp >> bit) & 1) ? 235 : 16;
+		for (unsigned int row = 0; row < 2; row++)
+			memset(yplane + (size_t)row*pitch + bit*STAMP_PIXELS, luma, STAMP_PIXELS);
+	}
+}
+
+static void StampBgra(unsigned char* bgra, uint64_t stamp)
+{
+	for (unsigned int bit = 0; bit < STAMP_BITS; bit++) {
+		const unsigned char value = ((stamp >> bit) & 1) ? 255 : 0;
+		unsigned char* pixel = bgra + (size_t)bit*STAMP_PIXELS*4;
+		for (unsigned int i = 0; i < STAMP_PIXELS; i++) {
+			pixel[i*4 + 0] = value;
+			pixel[i*4 + 1] = value;
+			pixel[i*4 + 2] = value;
+			pixel[i*4 + 3] = 255;
+		}
+	}
+}
+
+// Read the send time from the first row of a BGRA frame
+static uint64_t ReadStamp(const unsigned char* bgra)
+{
+	uint64_t stamp = 0;
+	for (unsigned int bit = 0; bit < STAMP_BITS; bit++) {
+		if (bgra[((size_t)bit*STAMP_PIXELS + STAMP_PIXELS/2)*4] > 128)
+			stamp |= (uint64_t)1 << bit;
+	}
+	return stamp;
+}
+
+// Send frames until the pipe is closed
+static int Generate(int argc, char* argv[])
+{
+	unsigned int sourceWidth = 0, sourceHeight = 0, fps = 0;
+	unsigned int width = 0, height = 0;
+	bool bYuv = true;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+			sscanf(argv[++i], "gen:%ux%u@%u", &sourceWidth, &sourceHeight, &fps);
+		else if (strcmp(argv[i], "-vf") == 0 && i + 1 < argc) {
+			const std::string filter = argv[++i];
+			if (!ParseFilterSize(filter, "crop=", width, height))
+				ParseFilterSize(filter, "scale=", width, height);
+		}
+		else if (strcmp(argv[i], "-pix_fmt") == 0 && i + 1 < argc)
+			bYuv = (strcmp(argv[++i], "yuv420p") == 0);
+	}
+	if (width == 0 || height == 0) {
+		width = sourceWidth;
+		height = sourceHeight;
+	}
+	if (width < STAMP_BITS*STAMP_PIXELS || height < 2) {
+		fprintf(stderr, "Stand-in frames must be at least %d pixels wide\n", STAMP_BITS*STAMP_PIXELS);
+		return 1;
+	}
+
+	// A few frames of a moving pattern, sent in turn
+	const size_t framesize = bYuv ? YuvFrameSize(width, height) : (size_t)width*height*4;
+	std::vector<std::vector<unsigned char>> frames(3, std::vector<unsigned char>(framesize));
+	for (size_t f = 0; f < frames.size(); f++) {
+		unsigned char* data = frames[f].data();
+		const unsigned int shift = (unsigned int)f*16;
+		if (bYuv) {
+			for (unsigned int y = 0; y < height; y++)
+				for (unsigned int x = 0; x < width; x++)
+					data[(size_t)y*width + x] = (unsigned char)(16 + ((x + y + shift) % 220));
+			unsigned char* u = data + (size_t)width*height;
+			unsigned char* v = u + (size_t)(width/2)*(height/2);
+			for (unsigned int y = 0; y < height/2; y++) {
+				for (unsigned int x = 0; x < width/2; x++) {
+					u[(size_t)y*(width/2) + x] = (unsigned char)(16 + ((x + shift) % 224));
+					v[(size_t)y*(width/2) + x] = (unsigned char)(16 + ((y + shift) % 224));
+				}
+			}
+			// Neutral colour under the stamp
+			memset(u, 128, STAMP_BITS*STAMP_PIXELS/2);
+			memset(v, 128, STAMP_BITS*STAMP_PIXELS/2);
+		}
+		else {
+			for (unsigned int y = 0; y < height; y++) {
+				for (unsigned int x = 0; x < width; x++) {
+					unsigned char* pixel = data + ((size_t)y*width + x)*4;
+					pixel[0] = (unsigned char)(x + shift);
+					pixel[1] = (unsigned char)(y + shift);
+					pixel[2] = (unsigned char)(x + y);
+					pixel[3] = 255;
+				}
+			}
+		}
+	}
+
+	// Sent at the frame rate, or as fast as the reader takes them
+	using namespace std::chrono;
+	const steady_clock::time_point start = steady_clock::now();
+	for (uint64_t n = 0; ; n++) {
+		if (fps > 0)
+			std::this_thread::sleep_until(start + duration_cast<steady_clock::duration>(duration<double>((double)n/(double)fps)));
+		std::vector<unsigned char>& frame = frames[n % frames.size()];
+		const uint64_t stamp = FrameStats::Ticks();
+		if (bYuv)
+			StampLuma(frame.data(), width, stamp);
+		else
+			StampBgra(frame.data(), stamp);
+		if (fwrite(frame.data(), 1, framesize, stdout) != framesize || fflush(stdout) != 0)
+			break;
+	}
+	return 0;
+}
+
+//
+// Benchmark
+//
+
+static double CpuSeconds(int who)
+{
+	struct rusage usage{};
+	getrusage(who, &usage);
+	return (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec/1e6
+		+ (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec/1e6;
+}
+
+static double ResidentMB()
+{
+	FILE* file = fopen("/proc/self/statm", "r");
+	if (!file)
+		return 0.0;
+	unsigned long size = 0, resident = 0;
+	const int n = fscanf(file, "%lu %lu", &size, &resident);
+	fclose(file);
+	return (n == 2) ? (double)resident*(double)sysconf(_SC_PAGESIZE)/1048576.0 : 0.0;
+}
+
+static std::string SelfPath(const char* argv0)
+{
+	char path[4096]{};
+	const ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+	return (n > 0) ? std::string(path, (size_t)n) : std::string(argv0);
+}
+
+static bool ParseScenario(const char* arg, Scenario& scenario)
+{
+	unsigned int fps = 0;
+	scenario.name = arg;
+	if (sscanf(arg, "720p%u", &fps) == 1) { scenario.width = 1280; scenario.height = 720; }
+	else if (sscanf(arg, "1080p%u", &fps) == 1) { scenario.width = 1920; scenario.height = 1080; }
+	else if (sscanf(arg, "4k%u", &fps) == 1 || sscanf(arg, "4K%u", &fps) == 1) { scenario.width = 3840; scenario.height = 2160; }
+	else if (sscanf(arg, "%ux%u@%u", &scenario.width, &scenario.height, &fps) != 3) return false;
+	scenario.fps = fps;
+	return scenario.width > 0 && scenario.height > 0 && fps > 0;
+}
+
+// A video file, probed for its size and frame rate
+static bool ProbeScenario(const char* arg, const BenchOptions& options, Scenario& scenario)
+{
+	std::string ffprobe = options.ffmpegFolder.empty() ? "ffprobe" : options.ffmpegFolder + "/ffprobe";
+	if (!ProbeVideo(ffprobe, arg, scenario.video))
+		return false;
+	scenario.path = arg;
+	const char* name = strrchr(arg, '/');
+	scenario.name = name ? name + 1 : arg;
+	if (scenario.name.size() > 10)
+		scenario.name.resize(10);
+	scenario.width = scenario.video.width;
+	scenario.height = scenario.video.height;
+	scenario.fps = (scenario.video.rateNum + scenario.video.rateDen/2)/scenario.video.rateDen;
+	return true;
+}
+
+static bool IsLibavBuild()
+{
+#ifdef USE_LIBAV
+	return true;
+#else
+	return false;
+#endif
+}
+
+static bool RunScenario(const std::string& self, const Scenario& scenario, const BenchOptions& options, VideoBackend backend, bool bTrace)
+{
+	VideoSourceParams params;
+	char input[64]{};
+	snprintf(input, 64, "gen:%ux%u@%u", scenario.width, scenario.height, options.bMax ? 0 : scenario.fps);
+	params.path = input;
+	params.ffmpegPath = self;
+	params.videoWidth = scenario.width;
+	params.videoHeight = scenario.height;
+	params.fit = NegotiateFit(scenario.width, scenario.height, options.desktopWidth, options.desktopHeight, options.mode);
+	params.bYuv = options.bYuv;
+	params.rateNum = scenario.fps;
+	if (!scenario.path.empty()) {
+		// Decoded by ffmpeg or the FFmpeg libraries
+		params.path = scenario.path;
+		// Quiet, as the pipe closing at the end is an error for ffmpeg
+		params.ffmpegPath = options.ffmpegFolder.empty() ? "ffmpeg" : options.ffmpegFolder + "/ffmpeg";
+		params.ffmpegPath += " -hide_banner -loglevel fatal";
+		params.loopFrames = scenario.video.frames;
+		params.rateNum = scenario.video.rateNum;
+		params.rateDen = scenario.video.rateDen;
+		params.bVariableRate = scenario.video.bVariableRate;
+		params.color.matrix = (scenario.video.colorSpace == "bt709" || (scenario.video.colorSpace != "smpte170m" && scenario.height >= 720)) ? YUV_BT709 : YUV_BT601;
+	}
+	const unsigned int width = params.fit.width;
+	const unsigned int height = params.fit.height;
+
+	FrameRing ring;
+	if (!ring.Allocate(width, height, 4))
+		return false;
+
+	// Frames published wake the loop, as the scheduler does in the application
+	std::mutex mutex;
+	std::condition_variable wake;
+	uint64_t wakes = 0;
+	std::unique_ptr<VideoSource> source;
+	if (backend == VIDEO_PIPE)
+		source.reset(new PipeSource());
+#ifdef USE_LIBAV
+	else if (backend == VIDEO_LIBAV)
+		source.reset(new LibavSource());
+#endif
+	if (!source)
+		return false;
+	source->SetFrameCallback([&]() {
+		std::lock_guard<std::mutex> lock(mutex);
+		wakes++;
+		wake.notify_one();
+	});
+
+	MemoryPresenter presenter;
+	presenter.SetTargetSize(options.desktopWidth, options.desktopHeight);
+	presenter.SetFilter(options.filter);
+	FrameChange change;
+	FramePacer pacer;
+	FrameHistogram latency;
+
+	const double childStart = CpuSeconds(RUSAGE_CHILDREN);
+	if (!source->Open(params, &ring))
+		return false;
+
+	// The first half second is not measured
+	const double warmup = 0.5;
+	const double begin = FramePacer::Now();
+	double measureStart = 0.0;
+	double cpuStart = 0.0;
+	double lastFrame = 0.0;
+	uint64_t shown = 0;
+	uint64_t droppedStart = 0;
+	bool bMeasuring = false;
+
+	while (true) {
+		const double now = FramePacer::Now();
+		if (!bMeasuring && now - begin >= warmup) {
+			bMeasuring = true;
+			measureStart = now;
+			cpuStart = CpuSeconds(RUSAGE_SELF);
+			droppedStart = pacer.GetStats().dropped;
+			FrameStats::Shared().Reset();
+			if (bTrace)
+				FrameTrace::Shared().SetEnabled(true);
+		}
+		if (bMeasuring && now - measureStart >= options.seconds)
+			break;
+		if (source->IsFinished())
+			break;
+
+		// Frames due, or the next one for the maximum rate
+		const unsigned int pending = ring.GetPending();
+		unsigned int take = 0;
+		if (options.bMax) {
+			take = (pending > 0) ? 1 : 0;
+		}
+		else if (pending > 0 || pacer.IsRunning()) {
+			if (!pacer.IsRunning())
+				pacer.Start(now, params.rateNum, params.rateDen);
+			take = pacer.Select(now, pending);
+		}
+		unsigned char* frame = nullptr;
+		for (unsigned int i = 0; i < take; i++)
+			frame = ring.AcquireNext();
+
+		if (frame) {
+			TRACE_SCOPE("Render", "render");
+			const uint64_t stamp = scenario.path.empty() ? ReadStamp(frame) : 0;
+			change.Update(frame, width, height);
+			presenter.Present(frame, width, height, options.mode, &change);
+			if (bMeasuring) {
+				const uint64_t done = FrameStats::Ticks();
+				if (stamp > 0 && done > stamp)
+					latency.Record(done - stamp);
+				if (lastFrame > 0.0)
+					FrameStats::Shared().Record(STAGE_INTERVAL, (uint64_t)((now - lastFrame)*1e6));
+				shown++;
+			}
+			lastFrame = now;
+		}
+
+		// Wait for the next frame to be due or to be read
+		double wait = 0.1;
+		if (ring.GetPending() > 0)
+			wait = options.bMax ? 0.0 : pacer.GetWaitTime(FramePacer::Now());
+		if (wait > 0.0) {
+			std::unique_lock<std::mutex> lock(mutex);
+			const uint64_t seen = wakes;
+			wake.wait_for(lock, std::chrono::duration<double>(wait), [&]() { return wakes != seen; });
+		}
+	}
+
+	const double elapsed = FramePacer::Now() - measureStart;
+	const double cpu = CpuSeconds(RUSAGE_SELF) - cpuStart;
+	const uint64_t dropped = pacer.GetStats().dropped - droppedStart;
+	const FramePoolStats pool = FramePool::Shared().GetStats();
+	const double resident = ResidentMB();
+	if (bTrace)
+		FrameTrace::Shared().SetEnabled(false);
+
+	// The stand-in ends when the pipe is closed
+	source->Close();
+	const double childCpu = CpuSeconds(RUSAGE_CHILDREN) - childStart;
+	const uint64_t sent = ring.GetPublished();
+	// Memory of this scenario is given back before the next
+	ring.Release();
+	FramePool::Shared().Trim();
+
+	if (shown == 0 || elapsed <= 0.0)
+		return false;
+
+	const FrameHistogramStats lat = latency.GetStats();
+	const FrameHistogramStats convert = FrameStats::Shared().GetHistogram(STAGE_CONVERT).GetStats();
+	const FrameHistogramStats scale = FrameStats::Shared().GetHistogram(STAGE_SCALE).GetStats();
+	const FrameHistogramStats present = FrameStats::Shared().GetHistogram(STAGE_PRESENT).GetStats();
+
+	// Decoding is in this process for libav and in the child for the pipe
+	const double cpuFrame = 1000.0*cpu/(double)shown;
+	const double genFrame = sent > 0 ? 1000.0*childCpu/(double)sent : 0.0;
+	char output[32]{};
+	snprintf(output, 32, "%ux%u", width, height);
+	printf("%-10s %-5s %-10s %7.1f %5u %5llu %7.2f %7.2f %7.2f %6.1f %6.1f %6.1f %6.2f %6.2f %6.2f %6.2f %6.2f %6.2f %7.1f %7.1f\n",
+		scenario.name.c_str(), backend == VIDEO_LIBAV ? "libav" : "pipe", output, (double)shown/elapsed, options.bMax ? 0 : scenario.fps,
+		(unsigned long long)dropped, cpuFrame, genFrame, cpuFrame + genFrame,
+		lat.p50, lat.p90, lat.p99,
+		convert.p50, convert.p99, scale.p50, scale.p99, present.p50, present.p99,
+		(double)pool.bytes/1048576.0, resident);
+	fflush(stdout);
+
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	// Started by PipeSource in place of ffmpeg
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-i") == 0)
+			return Generate(argc, argv);
+	}
+
+	BenchOptions options;
+	std::vector<Scenario> scenarios;
+	std::vector<const char*> files;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		const bool bValue = (i + 1 < argc);
+		if (arg == "--seconds" && bValue) {
+			options.seconds = atof(argv[++i]);
+		}
+		else if (arg == "--desktop" && bValue) {
+			if (sscanf(argv[++i], "%ux%u", &options.desktopWidth, &options.desktopHeight) != 2)
+				return 1;
+		}
+		else if (arg == "--fit" && bValue) {
+			const std::string mode = argv[++i];
+			options.mode = (mode == "stretch") ? FIT_STRETCH : (mode == "fit") ? FIT_FIT : (mode == "center") ? FIT_CENTER : FIT_FILL;
+		}
+		else if (arg == "--filter" && bValue) {
+			const std::string filter = argv[++i];
+			options.filter = (filter == "nearest") ? SCALE_NEAREST : (filter == "bilinear") ? SCALE_BILINEAR : SCALE_AREA;
+		}
+		else if (arg == "--bgra") {
+			options.bYuv = false;
+		}
+		else if (arg == "--max") {
+			options.bMax = true;
+		}
+		else if (arg == "--trace" && bValue) {
+			options.tracePath = argv[++i];
+		}
+		else if (arg == "--ffmpeg" && bValue) {
+			options.ffmpegFolder = argv[++i];
+		}
+		else if (arg == "--libav") {
+			options.bLibav = true;
+		}
+		else if (arg == "--compare") {
+			options.bCompare = true;
+		}
+		else {
+			files.push_back(argv[i]);
+		}
+	}
+
+	// Options can follow the scenarios
+	for (size_t i = 0; i < files.size(); i++) {
+		Scenario scenario;
+		if (!ParseScenario(files[i], scenario) && !ProbeScenario(files[i], options, scenario)) {
+			printf("Unknown scenario or option, or no video file %s\n", files[i]);
+			return 1;
+		}
+		scenarios.push_back(scenario);
+	}
+	if ((options.bLibav || options.bCompare) && !IsLibavBuild()) {
+		printf("Built without USE_LIBAV\n");
+		return 1;
+	}
+	if (scenarios.empty()) {
+		const char* names[] = { "720p24", "720p30", "720p60", "1080p24", "1080p30", "1080p60", "4k24", "4k30", "4k60" };
+		for (const char* name : names) {
+			Scenario scenario;
+			ParseScenario(name, scenario);
+			scenarios.push_back(scenario);
+		}
+	}
+
+	const std::string self = SelfPath(argv[0]);
+	printf("SIMD %s, %s pipe, desktop %ux%u, %s, %s, %.1f seconds each%s\n\n",
+		SimdLevelName(GetSimdLevel()), options.bYuv ? "yuv420p" : "bgra",
+		options.desktopWidth, options.desktopHeight, FitModeName(options.mode),
+		options.filter == SCALE_NEAREST ? "nearest" : (options.filter == SCALE_BILINEAR ? "bilinear" : "area"),
+		options.seconds, options.bMax ? ", maximum rate" : "");
+	printf("%-10s %-5s %-10s %7s %5s %5s %7s %7s %7s %6s %6s %6s %6s %6s %6s %6s %6s %6s %7s %7s\n",
+		"Scenario", "src", "Output", "fps", "rate", "drop", "cpu", "gen", "total",
+		"lat50", "lat90", "lat99", "conv50", "conv99", "scl50", "scl99", "pres50", "pres99", "pool", "rss");
+
+	int failures = 0;
+	for (size_t i = 0; i < scenarios.size(); i++) {
+		// The stand-in is only read through the pipe
+		std::vector<VideoBackend> backends;
+		if (scenarios[i].path.empty() || !options.bLibav || options.bCompare)
+			backends.push_back(VIDEO_PIPE);
+		if (!scenarios[i].path.empty() && (options.bLibav || options.bCompare))
+			backends.push_back(VIDEO_LIBAV);
+		for (size_t b = 0; b < backends.size(); b++) {
+			const bool bTrace = !options.tracePath.empty() && i + 1 == scenarios.size() && b + 1 == backends.size();
+			if (!RunScenario(self, scenarios[i], options, backends[b], bTrace)) {
+				printf("%-10s %-5s no frames\n", scenarios[i].name.c_str(), backends[b] == VIDEO_LIBAV ? "libav" : "pipe");
+				failures++;
+			}
+		}
+	}
+
+	printf("\nfps is frames drawn a second. cpu is msec of process CPU time per frame drawn,\n");
+	printf("gen msec of the stand-in or ffmpeg per frame sent, and total the sum.\n");
+	printf("Latency from sending to drawing is measured for the stand-in only.\n");
+	printf("Latency, and convert, scale and present times, are msec. Memory is MB.\n");
+
+	if (!options.tracePath.empty()) {
+		if (FrameTrace::Shared().Save(options.tracePath))
+			printf("Trace saved to %s\n", options.tracePath.c_str());
+		else
+			failures++;
+	}
+
+	return failures > 0 ? 1 : 0;
+}
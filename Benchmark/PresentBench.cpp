@@ -0,0 +1,208 @@
+//
+//		PresentBench
+//
+//		Time taken by a Presenter for each frame.
+//
+//		Each case presents a run of frames of one size to a target of
+//		another, as the render loop does, and times every Present :
+//
+//		  o Full - every pixel of each frame has changed
+//		  o Unchanged - the same frame again, with FrameChange finding no
+//		    changed tiles, as for a paused or still video
+//		  o Repaint - the same frame drawn in full without change tiles,
+//		    as for the once a second refresh of an unchanged frame
+//		  o Detect - FrameChange hashing of the frame, paid by every frame
+//		    before it is presented or skipped
+//
+//		A MemoryPresenter is timed everywhere. On Windows a GdiPresenter
+//		also draws to a window the size of the target.
+//
+//		Not part of the application build. From the repository folder :
+//
+//		  g++ -O2 -std=c++17 -I. Benchmark/PresentBench.cpp Presenter.cpp MemoryPresenter.cpp FrameChange.cpp FrameScaler.cpp FrameFit.cpp FrameStats.cpp FrameTrace.cpp CpuFeatures.cpp -lpthread -o presentbench
+//		  cl /O2 /EHsc /std:c++17 /I. Benchmark\PresentBench.cpp Presenter.cpp MemoryPresenter.cpp GdiPresenter.cpp FrameChange.cpp FrameScaler.cpp FrameFit.cpp FrameStats.cpp FrameTrace.cpp CpuFeatures.cpp user32.lib gdi32.lib
+//
+//		  presentbench [frames]
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "MemoryPresenter.h"
+#include "FrameChange.h"
+#ifdef _WIN32
+#include "GdiPresenter.h"
+#endif
+
+struct PresentCase {
+	const char* name;
+	unsigned int srcWidth, srcHeight;
+	unsigned int dstWidth, dstHeight;
+	FitMode mode;
+	ScaleFilter filter;
+};
+
+static const PresentCase cases[] = {
+	{ "1080p",          1920, 1080, 1920, 1080, FIT_FILL, SCALE_AREA },
+	{ "4K to 1080p",    3840, 2160, 1920, 1080, FIT_FILL, SCALE_AREA },
+	{ "720p to 1080p",  1280,  720, 1920, 1080, FIT_FILL, SCALE_BILINEAR },
+	{ "1080p to 1440p", 1920, 1080, 2560, 1440, FIT_FILL, SCALE_NEAREST },
+	{ "4:3 fit 1080p",  1440, 1080, 1920, 1080, FIT_FIT,  SCALE_AREA },
+};
+
+// Times of one kind of present (msec)
+struct PresentTimes {
+	std::vector<double> times;
+	void Add(double msec) { times.push_back(msec); }
+	double Percentile(double p)
+	{
+		if (times.empty())
+			return 0.0;
+		std::sort(times.begin(), times.end());
+		return times[std::min(times.size() - 1, (size_t)(p*(double)times.size()))];
+	}
+};
+
+static void FillRandom(unsigned char* pixels, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		pixels[i] = (unsigned char)(rand() & 0xFF);
+}
+
+static double Since(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Present frames of the case and print the times
+static bool RunCase(Presenter& presenter, const char* name, const PresentCase& c,
+	const std::vector<std::vector<unsigned char>>& frames, int count)
+{
+	presenter.SetFilter(c.filter);
+	presenter.Invalidate();
+	FrameChange change;
+	PresentTimes full, unchanged, repaint, detect;
+
+	// The first frame is drawn in full with the borders cleared
+	bool bOK = presenter.Present(frames[0].data(), c.srcWidth, c.srcHeight, c.mode);
+
+	for (int i = 0; i < count && bOK; i++) {
+		const unsigned char* frame = frames[(size_t)(i + 1) % frames.size()].data();
+
+		auto start = std::chrono::steady_clock::now();
+		change.Update(frame, c.srcWidth, c.srcHeight);
+		detect.Add(Since(start));
+
+		start = std::chrono::steady_clock::now();
+		bOK = presenter.Present(frame, c.srcWidth, c.srcHeight, c.mode, &change);
+		full.Add(Since(start));
+
+		// Nothing has changed since the frame above
+		change.Update(frame, c.srcWidth, c.srcHeight);
+		start = std::chrono::steady_clock::now();
+		bOK = bOK && presenter.Present(frame, c.srcWidth, c.srcHeight, c.mode, &change);
+		unchanged.Add(Since(start));
+
+		start = std::chrono::steady_clock::now();
+		bOK = bOK && presenter.Present(frame, c.srcWidth, c.srcHeight, c.mode);
+		repaint.Add(Since(start));
+	}
+
+	printf("%-14s %-8s %7.3f %7.3f %7.3f %7.3f %7.3f %7.3f %7.3f %7.3f  %s\n", c.name, name,
+		full.Percentile(0.5), full.Percentile(0.99),
+		unchanged.Percentile(0.5), unchanged.Percentile(0.99),
+		repaint.Percentile(0.5), repaint.Percentile(0.99),
+		detect.Percentile(0.5), detect.Percentile(0.99), bOK ? "pass" : "FAIL");
+
+	return bOK;
+}
+
+#ifdef _WIN32
+
+// Window the size of the target for the GdiPresenter
+static HWND CreateTarget(unsigned int width, unsigned int height)
+{
+	WNDCLASSA wc{};
+	wc.lpfnWndProc = DefWindowProcA;
+	wc.hInstance = GetModuleHandle(NULL);
+	wc.lpszClassName = "PresentBench";
+	RegisterClassA(&wc);
+	HWND hwnd = CreateWindowExA(WS_EX_TOOLWINDOW, "PresentBench", "PresentBench", WS_POPUP,
+		0, 0, (int)width, (int)height, NULL, NULL, wc.hInstance, NULL);
+	if (hwnd)
+		ShowWindow(hwnd, SW_SHOWNOACTIVATE);
+	return hwnd;
+}
+
+#endif
+
+int main(int argc, char* argv[])
+{
+	const int count = (argc > 1) ? atoi(argv[1]) : 60;
+	if (count <= 0)
+		return 1;
+
+	int failures = 0;
+
+	printf("SIMD %s, %d frames\n\n", SimdLevelName(GetSimdLevel()), count);
+	printf("%-14s %-8s %7s %7s %7s %7s %7s %7s %7s %7s  %s\n", "Size", "Target",
+		"full50", "full99", "same50", "same99", "rep50", "rep99", "det50", "det99", "result");
+
+	srand(1);
+	for (const PresentCase& c : cases) {
+
+		// A few random frames presented in turn so that every pixel changes
+		std::vector<std::vector<unsigned char>> frames(3, std::vector<unsigned char>((size_t)c.srcWidth*c.srcHeight*4));
+		for (size_t f = 0; f < frames.size(); f++)
+			FillRandom(frames[f].data(), frames[f].size());
+
+		MemoryPresenter memory;
+		memory.SetTargetSize(c.dstWidth, c.dstHeight);
+		if (!RunCase(memory, "Memory", c, frames, count))
+			failures++;
+
+#ifdef _WIN32
+		HWND hwnd = CreateTarget(c.dstWidth, c.dstHeight);
+		if (hwnd) {
+			GdiPresenter gdi;
+			gdi.SetWindow(hwnd);
+			if (!RunCase(gdi, "GDI", c, frames, count))
+				failures++;
+			gdi.Release();
+			DestroyWindow(hwnd);
+		}
+		else {
+			printf("%-14s %-8s no window\n", c.name, "GDI");
+			failures++;
+		}
+#endif
+	}
+
+	printf("\nmsec per present at 50 and 99%%. full is a new frame, same the same frame\n");
+	printf("with no changed tiles, rep the same frame drawn in full. det is FrameChange.\n");
+	printf("%s\n", failures > 0 ? "FAILED" : "All passed");
+
+	return failures > 0 ? 1 : 0;
+}
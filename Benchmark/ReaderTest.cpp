@@ -0,0 +1,250 @@
+//
+//		ReaderTest
+//
+//		FrameReader and FrameRing fed by a stand-in producer process.
+//
+//		The same program is started as the producer, in place of FFmpeg.
+//		It writes a number of fixed-size frames to stdout, each filled
+//		from its frame number, and can end with part of a frame. The
+//		reader restarts the command at the end of the stream as it does
+//		for a looping video. The consumer takes frames in order and checks :
+//
+//		  o every byte of each frame is the one written, so frames are whole
+//		  o frame numbers follow in order for each run of the producer
+//		  o a loop start is reported for the first frame of each run
+//		  o a partial frame at the end of the stream is not published
+//		  o a producer that writes nothing finishes the reader
+//		  o Close returns while the producer is still writing
+//		  o the reader sleeps while the ring is full rather than polling it
+//		  o the loop stall times the restart, not the wait for a free slot
+//
+//		Not part of the application build. From the repository folder :
+//
+//		  g++ -O2 -std=c++17 -I. Benchmark/ReaderTest.cpp FrameReader.cpp FrameRing.cpp FramePool.cpp LoopTiming.cpp FrameStats.cpp FrameTrace.cpp -lpthread -o readertest
+//
+//		Run from the folder it is built in so that it can start itself.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include "FrameReader.h"
+#include "FrameRing.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <sys/resource.h>
+#endif
+
+static const unsigned int frameWidth = 64;
+static const unsigned int frameHeight = 32;
+static const size_t frameSize = (size_t)frameWidth*frameHeight*4;
+
+// Byte i of frame n
+static unsigned char FrameByte(uint32_t n, size_t i)
+{
+	return (unsigned char)((n*31 + i*7 + (i >> 8)) & 0xFF);
+}
+
+// Producer : write frames to stdout, then part of a frame if asked
+static int Produce(uint32_t frames, bool bPartial)
+{
+#ifdef _WIN32
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	std::vector<unsigned char> frame(frameSize);
+	for (uint32_t n = 0; n < frames; n++) {
+		for (size_t i = 0; i < frameSize; i++)
+			frame[i] = FrameByte(n, i);
+		memcpy(frame.data(), &n, sizeof(n));
+		if (fwrite(frame.data(), 1, frameSize, stdout) != frameSize)
+			return 0; // The reader has closed the pipe
+	}
+	if (bPartial)
+		fwrite(frame.data(), 1, frameSize/2, stdout);
+	fflush(stdout);
+	return 0;
+}
+
+static int failures = 0;
+
+static void Check(bool bPass, const char* name, const char* detail)
+{
+	if (!bPass)
+		failures++;
+	printf("%-36s %-30s %s\n", name, detail, bPass ? "pass" : "FAIL");
+}
+
+// Take frames in order until count have been taken or the reader finishes.
+// Returns false on timeout. bWhole is false if any frame is not as written.
+static bool TakeFrames(FrameReader& reader, FrameRing& ring, size_t count, double timeout,
+	std::vector<uint32_t>& numbers, bool& bWhole)
+{
+	bWhole = true;
+	const auto start = std::chrono::steady_clock::now();
+	while (numbers.size() < count) {
+		unsigned char* frame = ring.AcquireNext();
+		if (!frame) {
+			if (reader.IsFinished() && ring.GetPending() == 0)
+				return true;
+			if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > timeout)
+				return false;
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+			continue;
+		}
+		uint32_t n = 0;
+		memcpy(&n, frame, sizeof(n));
+		for (size_t i = sizeof(n); i < frameSize; i++) {
+			if (frame[i] != FrameByte(n, i)) {
+				bWhole = false;
+				break;
+			}
+		}
+		numbers.push_back(n);
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc >= 3 && strcmp(argv[1], "produce") == 0)
+		return Produce((uint32_t)atoi(argv[2]), argc >= 4 && strcmp(argv[3], "partial") == 0);
+
+	const std::string self = argv[0];
+	char detail[64]{};
+
+	// Runs of 100 frames, then of 10 frames and half a frame
+	for (int bPartial = 0; bPartial < 2; bPartial++) {
+		const uint32_t run = bPartial ? 10 : 100;
+		const size_t count = run*3 + run/2;
+		FrameRing ring;
+		ring.Allocate(frameWidth, frameHeight, 3);
+		FrameReader reader;
+		std::vector<size_t> loops;
+		std::atomic<size_t> sunk{0};
+		reader.SetFrameSink([&](const unsigned char*, bool bLoopStart) {
+			if (bLoopStart)
+				loops.push_back(sunk.load());
+			sunk++;
+		});
+		const std::string command = "\"" + self + "\" produce " + std::to_string(run) + (bPartial ? " partial" : "");
+		const bool bOpen = reader.Open(command, &ring);
+
+		std::vector<uint32_t> numbers;
+		bool bWhole = true;
+		const bool bTaken = bOpen && TakeFrames(reader, ring, count, 10.0, numbers, bWhole);
+		reader.Close();
+
+		// 0 .. run-1 repeated
+		bool bOrder = (numbers.size() == count);
+		for (size_t i = 0; bOrder && i < numbers.size(); i++)
+			bOrder = (numbers[i] == (uint32_t)(i % run));
+		// Loop starts at the first frame of each run. The sink runs before
+		// a frame is published, so a few more may have been written.
+		bool bLoops = loops.size() >= 4 && sunk.load() >= count;
+		for (size_t i = 0; bLoops && i < loops.size(); i++)
+			bLoops = (loops[i] == i*run);
+
+		const char* name = bPartial ? "Runs of 10 and half a frame" : "Runs of 100 frames";
+		snprintf(detail, 64, "%zu frames, %u restarts", numbers.size(), reader.GetRestarts());
+		Check(bTaken && bOrder, name, detail);
+		Check(bWhole, "  every byte as written", "");
+		snprintf(detail, 64, "%zu loop starts", loops.size());
+		Check(bLoops, "  loop start at each run", detail);
+		Check(ring.GetDropped() == 0, "  no frame skipped", "");
+	}
+
+	// A consumer taking a frame every 30 msec keeps the ring full.
+	// The stall at each restart is the time to start the producer and
+	// read its first frame, which is much less.
+	{
+		FrameRing ring;
+		ring.Allocate(frameWidth, frameHeight, 3);
+		FrameReader reader;
+		const bool bOpen = reader.Open("\"" + self + "\" produce 5", &ring);
+		unsigned int taken = 0;
+		const auto start = std::chrono::steady_clock::now();
+		while (bOpen && taken < 20
+			&& std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < 10.0) {
+			if (ring.AcquireNext())
+				taken++;
+			std::this_thread::sleep_for(std::chrono::milliseconds(30));
+		}
+		const LoopTiming& timing = reader.GetLoopTiming();
+		snprintf(detail, 64, "%u loops, max %.1f msec", timing.GetLoops(), timing.GetMaxLoopStall());
+		Check(bOpen && timing.GetLoops() >= 3 && timing.GetMaxLoopStall() < 20.0
+			&& timing.GetFrameInterval() < 5.0, "Loop stall without the slot wait", detail);
+		reader.Close();
+	}
+
+	// A producer with no frames finishes the reader
+	{
+		FrameRing ring;
+		ring.Allocate(frameWidth, frameHeight, 3);
+		FrameReader reader;
+		const bool bOpen = reader.Open("\"" + self + "\" produce 0", &ring);
+		const auto start = std::chrono::steady_clock::now();
+		while (bOpen && !reader.IsFinished()
+			&& std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < 10.0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		snprintf(detail, 64, "%llu frames", (unsigned long long)ring.GetPublished());
+		Check(bOpen && reader.IsFinished() && ring.GetPublished() == 0 && reader.GetRestarts() == 0,
+			"No frames finishes the reader", detail);
+		reader.Close();
+	}
+
+	// Close while the producer is blocked writing to a full ring
+	{
+		FrameRing ring;
+		ring.Allocate(frameWidth, frameHeight, 3);
+		FrameReader reader;
+		const bool bOpen = reader.Open("\"" + self + "\" produce 1000000", &ring);
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+#ifndef _WIN32
+		// Each wake of the reader thread is a context switch
+		struct rusage before {};
+		struct rusage after {};
+		getrusage(RUSAGE_SELF, &before);
+		std::this_thread::sleep_for(std::chrono::milliseconds(500));
+		getrusage(RUSAGE_SELF, &after);
+		const long wakes = (after.ru_nvcsw + after.ru_nivcsw) - (before.ru_nvcsw + before.ru_nivcsw);
+		snprintf(detail, 64, "%ld wakes in 500 msec", wakes);
+		Check(bOpen && wakes < 20, "Full ring is not polled", detail);
+#endif
+		const auto start = std::chrono::steady_clock::now();
+		reader.Close();
+		const double msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		snprintf(detail, 64, "%.1f msec, %llu published", msec, (unsigned long long)ring.GetPublished());
+		Check(bOpen && msec < 2000.0 && ring.GetPublished() == ring.GetSlotCount(), "Close with the producer writing", detail);
+	}
+
+	printf("\n%s\n", failures ? "FAILED" : "All passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+//
+//		ScaleBench
+//
+//		FrameScaler timing and correctness against the scalar reference.
+//
+//		For each size and filter, the scalar kernels on one thread are the
+//		reference. Each instruction set is timed on one thread and on all
+//		threads, and its output compared with the reference.
+//
+//		Not part of the application build. From the repository folder :
+//
+//		  g++ -O2 -std=c++17 -I. Benchmark/ScaleBench.cpp FrameScaler.cpp FrameFit.cpp CpuFeatures.cpp -lpthread -o scalebench
+//		  cl /O2 /EHsc /std:c++17 /I. Benchmark\ScaleBench.cpp FrameScaler.cpp FrameFit.cpp CpuFeatures.cpp
+//
+//		  scalebench [frames]
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include "FrameScaler.h"
+
+struct ScaleCase {
+	const char* name;
+	int srcWidth, srcHeight;
+	int dstWidth, dstHeight;
+};
+
+static const ScaleCase cases[] = {
+	{ "4K to 1080p",    3840, 2160, 1920, 1080 },
+	{ "4K to 1440p",    3840, 2160, 2560, 1440 },
+	{ "1080p to 720p",  1920, 1080, 1280,  720 },
+	{ "720p to 1080p",  1280,  720, 1920, 1080 },
+	{ "1080p to 4K",    1920, 1080, 3840, 2160 },
+};
+
+static const char* filterNames[3] = { "Nearest", "Bilinear", "Area" };
+
+// Average msec for a scale after one untimed pass
+static double TimeScale(FrameScaler& scaler, const std::vector<unsigned char>& src, const ScaleCase& c,
+	std::vector<unsigned char>& dst, ScaleFilter filter, int frames)
+{
+	const FitRect srcRect = { 0, 0, c.srcWidth, c.srcHeight };
+	const FitRect dstRect = { 0, 0, c.dstWidth, c.dstHeight };
+	scaler.Scale(src.data(), c.srcWidth*4, srcRect, dst.data(), c.dstWidth*4, dstRect, filter);
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < frames; i++)
+		scaler.Scale(src.data(), c.srcWidth*4, srcRect, dst.data(), c.dstWidth*4, dstRect, filter);
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()/(double)frames;
+}
+
+int main(int argc, char* argv[])
+{
+	const int frames = (argc > 1) ? atoi(argv[1]) : 20;
+	if (frames <= 0)
+		return 1;
+
+	const SimdLevel best = GetSimdLevel();
+	const SimdLevel levels[3] = { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 };
+	int failures = 0;
+
+	printf("Best SIMD %s, %u threads, %d frames\n\n", SimdLevelName(best), FrameScaler().GetThreads(), frames);
+	printf("%-14s %-9s %-7s %8s %8s %9s %8s  %s\n", "Size", "Filter", "SIMD", "1 thread", "threads", "Mpix/s", "speedup", "result");
+
+	srand(1);
+	for (const ScaleCase& c : cases) {
+
+		// Random pixels so that nothing is skipped
+		std::vector<unsigned char> src((size_t)c.srcWidth*c.srcHeight*4);
+		for (size_t i = 0; i < src.size(); i++)
+			src[i] = (unsigned char)(rand() & 0xFF);
+		std::vector<unsigned char> reference((size_t)c.dstWidth*c.dstHeight*4);
+		std::vector<unsigned char> dst(reference.size());
+
+		for (int f = 0; f < 3; f++) {
+			const ScaleFilter filter = (ScaleFilter)f;
+
+			FrameScaler scalar;
+			scalar.SetSimdLevel(SIMD_SCALAR);
+			scalar.SetThreads(1);
+			const double scalarTime = TimeScale(scalar, src, c, reference, filter, frames);
+
+			for (SimdLevel level : levels) {
+				if (!IsSimdSupported(level))
+					continue;
+
+				FrameScaler single;
+				single.SetSimdLevel(level);
+				single.SetThreads(1);
+				const double singleTime = (level == SIMD_SCALAR) ? scalarTime : TimeScale(single, src, c, dst, filter, frames);
+
+				FrameScaler threaded;
+				threaded.SetSimdLevel(level);
+				memset(dst.data(), 0, dst.size());
+				const double threadTime = TimeScale(threaded, src, c, dst, filter, frames);
+
+				// Same result as the reference
+				const bool bExact = (memcmp(dst.data(), reference.data(), dst.size()) == 0);
+				if (!bExact)
+					failures++;
+
+				const double mpix = (double)c.dstWidth*c.dstHeight/(threadTime*1000.0);
+				printf("%-14s %-9s %-7s %8.2f %8.2f %9.1f %7.1fx  %s\n", c.name, filterNames[f], SimdLevelName(level),
+					singleTime, threadTime, mpix, scalarTime/threadTime, bExact ? "exact" : "DIFFERENT");
+			}
+		}
+	}
+
+	printf("\nmsec per frame. Speedup is against scalar on one thread.\n");
+	if (failures > 0)
+		printf("%d results differ from the scalar reference\n", failures);
+
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,237 @@
+//
+//		SchedulerSim
+//
+//		FrameScheduler with a simulated clock.
+//
+//		The render loop of the application is modelled with waits rounded
+//		up to whole msec, as for MsgWaitForMultipleObjectsEx. Frames from
+//		a reader thread arrive as wakes at set times. For each mode, the
+//		number of wakes, renders and the lateness of each one are checked :
+//
+//		  o Still image - no wake at all, and none counted in the last minute
+//		  o Messages - wakes with nothing due are counted, but not as renders
+//		  o Slideshow - one render for each slide, on time
+//		  o Video - every frame shown on time with the decoder ahead, or
+//		    as soon as it is decoded with the decoder falling behind
+//		  o Spout - one render for each frame received, and a refresh once
+//		    a second when the sender stops sending
+//
+//		Not part of the application build. From the repository folder :
+//
+//		  g++ -O2 -std=c++17 -I. Benchmark/SchedulerSim.cpp FrameScheduler.cpp FramePacer.cpp -o schedulersim
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include <functional>
+#include "FrameScheduler.h"
+#include "FramePacer.h"
+
+struct SimResult {
+	unsigned int wakes = 0;    // Returns from the wait
+	unsigned int renders = 0;  // Polls with something due
+	double lateMax = 0.0;      // Render after the time wanted (msec)
+};
+
+// Run the loop from time 0 to end. Wakes from another thread happen at
+// the times in events. render is called when something is due and returns
+// the time it wanted to render at, or a negative value if not known.
+// schedule sets the next deadlines.
+static SimResult RunLoop(FrameScheduler& scheduler, double end, const std::vector<double>& events,
+	std::function<double(double now, unsigned int due)> render, std::function<void(double now)> schedule)
+{
+	SimResult result;
+	double now = 0.0;
+	size_t next = 0;
+
+	while (now < end) {
+		const double wait = scheduler.GetWaitTime(now);
+		const double event = (next < events.size()) ? events[next] : HUGE_VAL;
+		// Whole msec, rounded up
+		const double deadline = (wait < 0.0) ? HUGE_VAL : now + ceil(wait*1000.0 - 1e-9)/1000.0;
+		if (deadline == HUGE_VAL && event == HUGE_VAL)
+			break; // Would wait for ever
+		if (event <= deadline) {
+			now = event;
+			next++;
+			scheduler.Wake();
+		}
+		else {
+			now = deadline;
+		}
+		if (now >= end)
+			break;
+
+		result.wakes++;
+		const unsigned int due = scheduler.Poll(now);
+		if (due) {
+			result.renders++;
+			const double wanted = render(now, due);
+			if (wanted >= 0.0 && (now - wanted)*1000.0 > result.lateMax)
+				result.lateMax = (now - wanted)*1000.0;
+			schedule(now);
+		}
+	}
+	return result;
+}
+
+static int failures = 0;
+
+static void Report(const char* name, const SimResult& r, unsigned int renders, double lateLimit)
+{
+	const bool bPass = (r.renders == renders && r.wakes == r.renders && r.lateMax <= lateLimit);
+	if (!bPass)
+		failures++;
+	printf("%-24s %6u %8u %8u %9.3f  %s\n", name, r.wakes, r.renders, renders, r.lateMax, bPass ? "pass" : "FAIL");
+}
+
+int main()
+{
+	printf("%-24s %6s %8s %8s %9s  %s\n", "Mode", "wakes", "renders", "expected", "late msec", "result");
+
+	// Still image. The first render is requested, then nothing.
+	{
+		FrameScheduler scheduler;
+		scheduler.Wake();
+		const SimResult r = RunLoop(scheduler, 3600.0, {},
+			[](double, unsigned int) { return 0.0; },
+			[&](double) { scheduler.CancelAll(); });
+		Report("Still image, 1 hour", r, 1, 0.0);
+		// No wakes in the last minute
+		if (scheduler.GetWakesPerMinute(3600.0) != 0.0) {
+			printf("  %.1f wakes a minute while idle\n", scheduler.GetWakesPerMinute(3600.0));
+			failures++;
+		}
+	}
+
+	// Messages that need no work, one a second for a minute
+	{
+		FrameScheduler scheduler;
+		unsigned int renders = 0;
+		for (int i = 0; i < 60; i++) {
+			if (scheduler.Poll(0.5 + (double)i))
+				renders++;
+		}
+		const double wakes = scheduler.GetWakesPerMinute(60.0);
+		const double work = scheduler.GetRendersPerMinute(60.0);
+		const bool bPass = (renders == 0 && wakes == 60.0 && work == 0.0);
+		if (!bPass)
+			failures++;
+		printf("%-24s %6.0f %8u %8u %9s  %s\n", "Messages, no work", wakes, renders, 0u, "-", bPass ? "pass" : "FAIL");
+	}
+
+	// Slideshow of 10 second slides for a minute
+	{
+		FrameScheduler scheduler;
+		const double duration = 10.0;
+		double start = 0.0;
+		scheduler.Wake();
+		const SimResult r = RunLoop(scheduler, 60.5, {},
+			[&](double now, unsigned int) {
+				const double wanted = (now - start >= duration) ? start + duration : now;
+				start = now;
+				return wanted;
+			},
+			[&](double) { scheduler.Schedule(SCHEDULE_SLIDE, start + duration); });
+		Report("Slideshow 10 sec", r, 7, 1.0);
+	}
+
+	// Video with the decoder ahead, and with it falling behind.
+	// Each frame decoded wakes the loop.
+	const double rates[2] = { 30000.0/1001.0, 24.0 };
+	for (int bBehind = 0; bBehind < 2; bBehind++) {
+		for (double rate : rates) {
+			FrameScheduler scheduler;
+			FramePacer pacer;
+			const double seconds = 10.0;
+			// Ahead, frame n is decoded two frames before it is due.
+			// Behind, frames are decoded at 3/4 of the frame rate.
+			std::vector<double> decoded;
+			for (int n = 0; ; n++) {
+				const double t = bBehind ? 0.001 + n/(rate*0.75) : 0.001 + (n - 2)/rate;
+				if (t >= seconds)
+					break;
+				decoded.push_back(t < 0.001 ? 0.001 : t);
+			}
+			size_t nDecoded = 0;
+			int64_t shown = 0;
+			const SimResult r = RunLoop(scheduler, seconds, decoded,
+				[&](double now, unsigned int due) {
+					if (due & SCHEDULE_WOKEN)
+						nDecoded++;
+					if (!pacer.IsRunning())
+						pacer.Start(now, (unsigned int)(rate*1001.0 + 0.5), 1001);
+					const unsigned int take = pacer.Select(now, (unsigned int)(nDecoded - (size_t)shown));
+					if (take == 0)
+						return -1.0;
+					shown += take;
+					// A frame decoded late is wanted when it arrives
+					const double time = pacer.GetFrameTime(pacer.GetNextFrame() - 1);
+					return (time < now && (due & SCHEDULE_WOKEN)) ? now : time;
+				},
+				[&](double now) {
+					scheduler.CancelAll();
+					if (pacer.IsRunning() && nDecoded > (size_t)shown)
+						scheduler.Schedule(SCHEDULE_FRAME, now + pacer.GetWaitTime(now));
+				});
+			// Ahead, every frame due is shown and none dropped.
+			// Behind, every frame is shown when it is decoded.
+			const FramePacerStats& stats = pacer.GetStats();
+			const uint64_t frames = bBehind ? decoded.size() : (uint64_t)pacer.GetDueFrame(seconds - 1e-6) + 1;
+			char name[64]{};
+			snprintf(name, 64, "Video %.2f fps %s", rate, bBehind ? "behind" : "ahead");
+			Report(name, r, r.renders, 1.0);
+			if (stats.presented != frames || stats.dropped != 0) {
+				printf("  shown %llu of %llu, dropped %llu\n", (unsigned long long)stats.presented,
+					(unsigned long long)frames, (unsigned long long)stats.dropped);
+				failures++;
+			}
+		}
+	}
+
+	// Spout frames at 60 fps for 5 seconds, then none for 5 seconds
+	{
+		FrameScheduler scheduler;
+		std::vector<double> received;
+		for (int i = 0; i < 300; i++)
+			received.push_back(0.010 + (double)i/60.0);
+		double last = -1.0;
+		const SimResult r = RunLoop(scheduler, 10.0, received,
+			[&](double now, unsigned int due) {
+				const double wanted = (due & SCHEDULE_WOKEN) ? now : last + 1.0;
+				last = now;
+				return wanted;
+			},
+			[&](double) {
+				scheduler.CancelAll();
+				scheduler.Schedule(SCHEDULE_REFRESH, last + 1.0);
+			});
+		// Refreshes each second after the last frame, up to the end
+		Report("Spout 60 fps then still", r, 300 + 5, 1.0);
+	}
+
+	if (failures > 0)
+		printf("\n%d modes failed\n", failures);
+
+	return failures > 0 ? 1 : 0;
+}
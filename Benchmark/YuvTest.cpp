@@ -0,0 +1,181 @@
+//
+//		YuvTest
+//
+//		YuvToBgra SIMD kernels checked against the scalar converter.
+//
+//		Every kernel supported by this CPU converts I420 and NV12 frames of
+//		odd and even sizes, with both matrices and both ranges, from random
+//		planes packed as FFmpeg sends them and from planes with padded
+//		lines. The output must be exactly the same as the scalar result,
+//		and the bytes after each destination line must not be written.
+//		Buffers are the exact size, so that an address sanitizer build
+//		finds any read or write past the end of a plane.
+//
+//		Throughput at 1920x1080 is then shown for each kernel, as MB/s
+//		of YUV read and BGRA written.
+//
+//		Not part of the application build. From the repository folder :
+//
+//		  g++ -O2 -std=c++17 -I. Benchmark/YuvTest.cpp YuvConvert.cpp CpuFeatures.cpp -o yuvtest
+//		  g++ -O1 -g -std=c++17 -fsanitize=address -I. Benchmark/YuvTest.cpp YuvConvert.cpp CpuFeatures.cpp -o yuvtest
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include "YuvConvert.h"
+#include "CpuFeatures.h"
+
+static void Randomize(std::vector<unsigned char>& buffer, unsigned int seed)
+{
+	srand(seed);
+	for (size_t i = 0; i < buffer.size(); i++)
+		buffer[i] = (unsigned char)(rand() & 0xFF);
+}
+
+static const char* FormatName(YuvFormat format)
+{
+	return format == YUV_NV12 ? "NV12" : "I420";
+}
+
+int main()
+{
+	const SimdLevel levels[3] = { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 };
+	const unsigned int sizes[][2] = {
+		{ 1, 1 }, { 2, 2 }, { 3, 5 }, { 7, 3 }, { 15, 7 }, { 16, 2 }, { 17, 9 }, { 31, 3 },
+		{ 32, 32 }, { 33, 33 }, { 47, 11 }, { 63, 17 }, { 64, 1 }, { 65, 65 }, { 127, 31 },
+		{ 129, 5 }, { 641, 361 }, { 1279, 719 }, { 1920, 1080 }
+	};
+	const YuvFormat formats[2] = { YUV_I420, YUV_NV12 };
+
+	printf("Best SIMD %s\n\n", SimdLevelName(GetSimdLevel()));
+
+	int failures = 0;
+	unsigned int cases = 0;
+	for (SimdLevel level : levels) {
+		if (level == SIMD_SCALAR || !IsSimdSupported(level))
+			continue;
+		unsigned int failed = 0;
+		for (const auto& size : sizes) {
+			const unsigned int width = size[0];
+			const unsigned int height = size[1];
+			for (YuvFormat format : formats) {
+				for (int matrix = 0; matrix < 2; matrix++) {
+					for (int bFull = 0; bFull < 2; bFull++) {
+						YuvColor color;
+						color.format = format;
+						color.matrix = (YuvMatrix)matrix;
+						color.bFullRange = (bFull != 0);
+						cases++;
+
+						// Packed as sent by FFmpeg
+						std::vector<unsigned char> yuv(YuvFrameSize(width, height));
+						Randomize(yuv, width*7919 + height*31 + matrix*2 + bFull);
+						std::vector<unsigned char> expected((size_t)width*height*4);
+						std::vector<unsigned char> actual((size_t)width*height*4);
+						YuvToBgra(yuv.data(), expected.data(), width, height, color, SIMD_SCALAR);
+						YuvToBgra(yuv.data(), actual.data(), width, height, color, level);
+						bool bPass = (expected == actual);
+
+						// Separate planes with padded lines
+						const unsigned int cw = (width + 1)/2;
+						const unsigned int ch = (height + 1)/2;
+						const unsigned int ypitch = width + 13;
+						const unsigned int uvpitch = (format == YUV_NV12 ? cw*2 : cw) + 5;
+						const unsigned int dstpitch = width*4 + 12;
+						std::vector<unsigned char> yplane((size_t)ypitch*(height - 1) + width);
+						std::vector<unsigned char> uplane((size_t)uvpitch*(ch - 1) + (format == YUV_NV12 ? cw*2 : cw));
+						std::vector<unsigned char> vplane((size_t)uvpitch*(ch - 1) + cw);
+						Randomize(yplane, width + height);
+						Randomize(uplane, width*3 + height);
+						Randomize(vplane, width*5 + height);
+						std::vector<unsigned char> expected2((size_t)dstpitch*height, 0xCD);
+						std::vector<unsigned char> actual2((size_t)dstpitch*height, 0xCD);
+						YuvToBgra(yplane.data(), ypitch, uplane.data(), vplane.data(), uvpitch,
+							expected2.data(), dstpitch, width, height, color, SIMD_SCALAR);
+						YuvToBgra(yplane.data(), ypitch, uplane.data(), vplane.data(), uvpitch,
+							actual2.data(), dstpitch, width, height, color, level);
+						bPass = bPass && (expected2 == actual2);
+						// Padding after each line untouched
+						for (unsigned int y = 0; bPass && y < height; y++) {
+							for (unsigned int x = width*4; x < dstpitch; x++) {
+								if (actual2[(size_t)y*dstpitch + x] != 0xCD) {
+									bPass = false;
+									break;
+								}
+							}
+						}
+
+						if (!bPass) {
+							if (failed < 10)
+								printf("  %s %s %ux%u BT.%s %s range differs\n", SimdLevelName(level), FormatName(format),
+									width, height, matrix ? "709" : "601", bFull ? "full" : "limited");
+							failed++;
+						}
+					}
+				}
+			}
+		}
+		printf("%-6s %u sizes, I420 and NV12, BT.601 and BT.709, limited and full range : %s\n",
+			SimdLevelName(level), (unsigned int)(sizeof(sizes)/sizeof(sizes[0])), failed ? "FAIL" : "exact");
+		failures += failed;
+	}
+	if (cases == 0)
+		printf("No SIMD kernels on this CPU\n");
+
+	// Throughput
+	const unsigned int width = 1920;
+	const unsigned int height = 1080;
+	std::vector<unsigned char> yuv(YuvFrameSize(width, height));
+	std::vector<unsigned char> bgra((size_t)width*height*4);
+	Randomize(yuv, 1);
+	const double bytes = (double)yuv.size() + (double)bgra.size();
+	printf("\n%ux%u %-6s %-6s %9s %9s %9s\n", width, height, "Format", "SIMD", "msec", "MB/s", "speedup");
+	for (YuvFormat format : formats) {
+		YuvColor color;
+		color.format = format;
+		double scalar = 0.0;
+		for (SimdLevel level : levels) {
+			if (!IsSimdSupported(level))
+				continue;
+			YuvToBgra(yuv.data(), bgra.data(), width, height, color, level);
+			unsigned int frames = 0;
+			const auto start = std::chrono::steady_clock::now();
+			double elapsed = 0.0;
+			while (elapsed < 0.5) {
+				YuvToBgra(yuv.data(), bgra.data(), width, height, color, level);
+				frames++;
+				elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			}
+			const double msec = elapsed*1000.0/frames;
+			if (level == SIMD_SCALAR)
+				scalar = msec;
+			printf("%9s %-6s %-6s %9.3f %9.0f %8.2fx\n", "", FormatName(format), SimdLevelName(level),
+				msec, bytes/(msec/1000.0)/1e6, scalar/msec);
+		}
+	}
+
+	printf("\n%s\n", failures ? "FAILED" : "All exact");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+//
+//		CacheSource
+//
+//		Video source replaying one loop of frames from a FrameCache file.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "CacheSource.h"
+#include "FrameStats.h"
+#include "FrameTrace.h"
+
+CacheSource::CacheSource()
+{
+}
+
+CacheSource::~CacheSource()
+{
+	Close();
+}
+
+bool CacheSource::Open(const VideoSourceParams& params, FrameRing* ring)
+{
+	Close();
+
+	if (!ring || ring->GetWidth() != params.fit.width || ring->GetHeight() != params.fit.height)
+		return false;
+
+	if (!m_Reader.Open(params.cachePath))
+		return false;
+	if (m_Reader.GetWidth() != ring->GetWidth() || m_Reader.GetHeight() != ring->GetHeight()) {
+		m_Reader.Close();
+		return false;
+	}
+
+	m_Ring = ring;
+	m_LoopTiming.Reset();
+	m_bStop = false;
+	m_bFinished = false;
+	m_bOpen = true;
+	m_Thread = std::thread(&CacheSource::Replay, this);
+
+	return true;
+}
+
+void CacheSource::Close()
+{
+	if (m_Thread.joinable()) {
+		m_bStop = true;
+		m_Ring->WakeWriter();
+		m_Thread.join();
+	}
+	m_Reader.Close();
+	m_Ring = nullptr;
+	m_bOpen = false;
+}
+
+// Replay thread
+void CacheSource::Replay()
+{
+	FrameTrace::Shared().SetThreadName("Frame cache reader");
+
+	const unsigned int nFrames = m_Reader.GetFrameCount();
+	const unsigned char* prev = nullptr; // Slot of the previous frame
+	unsigned int index = 0;
+
+	while (!m_bStop) {
+
+		// Wait for a free slot
+		m_LoopTiming.BeginWait();
+		unsigned char* slot = m_Ring->WaitWrite(m_bStop);
+		m_LoopTiming.EndWait();
+		if (!slot)
+			break;
+
+		// The previous slot is not written again until the ring
+		// has wrapped, so it holds the reference for a delta frame
+		TRACE_SCOPE("ReadFrame", "read");
+		FrameStageTimer read(STAGE_READ);
+		if (!m_Reader.ReadFrame(index, slot, prev)) {
+			read.Cancel();
+			break;
+		}
+		read.Stop();
+
+		if (m_FrameSink) m_FrameSink(slot, index == 0);
+		m_Ring->EndWrite();
+		m_LoopTiming.AddFrame(index == 0);
+		if (m_FrameCallback) m_FrameCallback();
+
+		prev = slot;
+		if (++index >= nFrames)
+			index = 0;
+	}
+
+	m_bFinished = !m_bStop;
+}
@@ -0,0 +1,69 @@
+//
+//		CacheSource
+//
+//		Video source replaying one loop of frames from a FrameCache file.
+//
+//		The file is memory mapped and frames are decoded from the mapping
+//		into the ring slots, so a cached clip needs no FFmpeg decode at all.
+//		Delta frames are applied to the previous slot written.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include "VideoSource.h"
+#include "FrameCache.h"
+
+class CacheSource : public VideoSource {
+
+public:
+
+	CacheSource();
+	~CacheSource();
+
+	// params.cachePath is the cache file. Its frame size must match the ring.
+	bool Open(const VideoSourceParams& params, FrameRing* ring) override;
+	void Close() override;
+	bool IsOpen() const override { return m_bOpen; }
+	bool IsFinished() const override { return m_bFinished.load(); }
+	void SetFrameCallback(std::function<void()> callback) override { m_FrameCallback = callback; }
+	void SetFrameSink(std::function<void(const unsigned char*, bool)> sink) override { m_FrameSink = sink; }
+	const LoopTiming& GetLoopTiming() const override { return m_LoopTiming; }
+	VideoBackend GetBackend() const override { return VIDEO_CACHE; }
+
+private:
+
+	void Replay();
+
+	FrameCacheReader m_Reader;
+	FrameRing* m_Ring = nullptr;
+
+	std::thread m_Thread;
+	std::atomic<bool> m_bStop{false};
+	std::atomic<bool> m_bFinished{false};
+	bool m_bOpen = false;
+	std::function<void()> m_FrameCallback;
+	std::function<void(const unsigned char*, bool)> m_FrameSink;
+	LoopTiming m_LoopTiming;
+
+};
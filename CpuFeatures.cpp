@@ -0,0 +1,162 @@
+//
+//		CpuFeatures
+//
+//		Runtime detection of SIMD instruction sets for pixel kernels.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "CpuFeatures.h"
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+#ifdef SIMD_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef SIMD_X86
+
+static void CpuId(int leaf, int subleaf, int regs[4])
+{
+#ifdef _MSC_VER
+	__cpuidex(regs, leaf, subleaf);
+#else
+	unsigned int a = 0, b = 0, c = 0, d = 0;
+	__cpuid_count(leaf, subleaf, a, b, c, d);
+	regs[0] = (int)a; regs[1] = (int)b; regs[2] = (int)c; regs[3] = (int)d;
+#endif
+}
+
+// Operating system support for saving AVX registers
+static bool OsSavesYmm()
+{
+#ifdef _MSC_VER
+	unsigned long long xcr0 = _xgetbv(0);
+#else
+	unsigned int eax = 0, edx = 0;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	unsigned long long xcr0 = ((unsigned long long)edx << 32) | eax;
+#endif
+	return (xcr0 & 0x6) == 0x6; // XMM and YMM state
+}
+
+#endif
+
+static CpuFeatures DetectCpuFeatures()
+{
+	CpuFeatures features;
+
+#ifdef SIMD_X86
+	int regs[4]{};
+	CpuId(0, 0, regs);
+	const int maxleaf = regs[0];
+	if (maxleaf >= 1) {
+		CpuId(1, 0, regs);
+		features.bSSE2 = (regs[3] & (1 << 26)) != 0;
+		const bool bOsxsave = (regs[2] & (1 << 27)) != 0;
+		const bool bAvx = (regs[2] & (1 << 28)) != 0;
+		if (maxleaf >= 7 && bOsxsave && bAvx && OsSavesYmm()) {
+			CpuId(7, 0, regs);
+			features.bAVX2 = (regs[1] & (1 << 5)) != 0;
+		}
+	}
+#endif
+
+#ifdef SIMD_NEON
+	// NEON is part of the 64 bit ARM architecture
+	features.bNEON = true;
+#endif
+
+	return features;
+}
+
+const CpuFeatures& GetCpuFeatures()
+{
+	static const CpuFeatures features = DetectCpuFeatures();
+	return features;
+}
+
+SimdLevel GetSimdLevel()
+{
+	const CpuFeatures& features = GetCpuFeatures();
+	if (features.bAVX2) return SIMD_AVX2;
+	if (features.bSSE2) return SIMD_SSE2;
+	if (features.bNEON) return SIMD_NEON;
+	return SIMD_SCALAR;
+}
+
+bool IsSimdSupported(SimdLevel level)
+{
+	const CpuFeatures& features = GetCpuFeatures();
+	switch (level) {
+		case SIMD_SCALAR: return true;
+		case SIMD_SSE2:   return features.bSSE2;
+		case SIMD_AVX2:   return features.bAVX2;
+		case SIMD_NEON:   return features.bNEON;
+		default:          return false;
+	}
+}
+
+SimdLevel ResolveSimdLevel(SimdLevel level)
+{
+	if (level == SIMD_AUTO || !IsSimdSupported(level))
+		return GetSimdLevel();
+	return level;
+}
+
+const char* SimdLevelName(SimdLevel level)
+{
+	switch (level) {
+		case SIMD_SCALAR: return "Scalar";
+		case SIMD_SSE2:   return "SSE2";
+		case SIMD_AVX2:   return "AVX2";
+		case SIMD_NEON:   return "NEON";
+		default:          return "Auto";
+	}
+}
+
+unsigned int GetProcessCores()
+{
+	unsigned int cores = 0;
+#ifdef _WIN32
+	DWORD_PTR process = 0;
+	DWORD_PTR system = 0;
+	if (GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) {
+		for (; process; process &= process - 1)
+			cores++;
+	}
+#else
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) == 0)
+		cores = (unsigned int)CPU_COUNT(&set);
+#endif
+	if (cores == 0)
+		cores = std::thread::hardware_concurrency();
+	return cores > 0 ? cores : 1;
+}
@@ -0,0 +1,78 @@
+//
+//		CpuFeatures
+//
+//		Runtime detection of SIMD instruction sets for pixel kernels.
+//
+//		Kernels are compiled for every instruction set the compiler supports
+//		and the best one is chosen at run time. AVX2 functions are marked with
+//		SIMD_TARGET_AVX2 so that they can be built without /arch:AVX2 or -mavx2.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define SIMD_NEON
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_TARGET_AVX2
+#endif
+
+// Instruction set used by a kernel
+enum SimdLevel {
+	SIMD_AUTO = -1, // Best available
+	SIMD_SCALAR = 0,
+	SIMD_SSE2,
+	SIMD_AVX2,
+	SIMD_NEON
+};
+
+struct CpuFeatures {
+	bool bSSE2 = false;
+	bool bAVX2 = false;
+	bool bNEON = false;
+};
+
+// Features of this CPU, detected once
+const CpuFeatures& GetCpuFeatures();
+
+// Best instruction set available
+SimdLevel GetSimdLevel();
+
+// Resolve SIMD_AUTO and levels not supported to the best available
+SimdLevel ResolveSimdLevel(SimdLevel level);
+
+// Is the level supported by this CPU
+bool IsSimdSupported(SimdLevel level);
+
+// Name for statistics
+const char* SimdLevelName(SimdLevel level);
+
+// Cores the process may run on, from its affinity mask.
+// Read each time, as the mask can be changed while it runs.
+unsigned int GetProcessCores();
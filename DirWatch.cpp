@@ -0,0 +1,459 @@
+//
+//		DirWatch
+//
+//		Changes to the files in a folder and its subfolders.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "DirWatch.h"
+#include "FrameTrace.h"
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unordered_map>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace fs = std::filesystem;
+
+DirWatch::DirWatch()
+{
+}
+
+DirWatch::~DirWatch()
+{
+	Close();
+}
+
+bool DirWatch::Open(const std::string& folder, unsigned int debounce)
+{
+	Close();
+
+	std::error_code ec;
+	if (folder.empty() || !fs::is_directory(fs::path(folder), ec))
+		return false;
+
+#ifdef _WIN32
+	HANDLE hDir = CreateFileA(folder.c_str(), FILE_LIST_DIRECTORY,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+		FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+	if (hDir == INVALID_HANDLE_VALUE)
+		return false;
+	m_hDir = hDir;
+	m_hStop = CreateEvent(NULL, TRUE, FALSE, NULL);
+#else
+	m_Notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_Notify < 0)
+		return false;
+	if (pipe(m_StopPipe) != 0) {
+		close(m_Notify);
+		m_Notify = -1;
+		return false;
+	}
+#endif
+
+	m_Folder = folder;
+	m_Debounce = (debounce > 0) ? debounce : 1;
+	m_bStop = false;
+	m_Thread = std::thread(&DirWatch::Watch, this);
+
+	// The thread adds the watches, and changes made before then would be lost
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Started.wait(lock, [this]() { return m_bWatching; });
+	return true;
+}
+
+void DirWatch::Close()
+{
+	if (m_Thread.joinable()) {
+		m_bStop = true;
+#ifdef _WIN32
+		SetEvent((HANDLE)m_hStop);
+#else
+		const char c = 0;
+		if (write(m_StopPipe[1], &c, 1) < 0) {}
+#endif
+		m_Thread.join();
+	}
+
+#ifdef _WIN32
+	if (m_hDir) CloseHandle((HANDLE)m_hDir);
+	if (m_hStop) CloseHandle((HANDLE)m_hStop);
+	m_hDir = nullptr;
+	m_hStop = nullptr;
+#else
+	if (m_Notify >= 0) close(m_Notify);
+	if (m_StopPipe[0] >= 0) close(m_StopPipe[0]);
+	if (m_StopPipe[1] >= 0) close(m_StopPipe[1]);
+	m_Notify = -1;
+	m_StopPipe[0] = m_StopPipe[1] = -1;
+#endif
+
+	m_Pending.clear();
+	m_bPendingOverflow = false;
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Ready.clear();
+	m_bOverflow = false;
+	m_bWatching = false;
+	m_Folder.clear();
+}
+
+std::vector<DirChange> DirWatch::TakeChanges(bool& bOverflow)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	std::vector<DirChange> changes;
+	changes.swap(m_Ready);
+	bOverflow = m_bOverflow;
+	m_bOverflow = false;
+	return changes;
+}
+
+DirWatchStats DirWatch::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Stats;
+}
+
+void DirWatch::AddChange(DirAction action, const std::string& path, const std::string& oldpath)
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (m_Pending.empty() && !m_bPendingOverflow)
+		m_First = now;
+	m_Last = now;
+
+	// A file being written is reported many times
+	if (!m_Pending.empty() && m_Pending.back().action == action
+		&& m_Pending.back().path == path && m_Pending.back().oldpath == oldpath)
+		return;
+
+	DirChange change;
+	change.action = action;
+	change.path = path;
+	change.oldpath = oldpath;
+	m_Pending.push_back(change);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Stats.changes++;
+}
+
+void DirWatch::AddOverflow()
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (m_Pending.empty() && !m_bPendingOverflow)
+		m_First = now;
+	m_Last = now;
+	m_bPendingOverflow = true;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Stats.overflows++;
+}
+
+int DirWatch::GetWaitTime() const
+{
+	if (m_Pending.empty() && !m_bPendingOverflow)
+		return -1;
+	const auto now = std::chrono::steady_clock::now();
+	const auto due = std::min(m_Last + std::chrono::milliseconds(m_Debounce),
+		m_First + std::chrono::milliseconds(m_Debounce*10));
+	if (due <= now)
+		return 0;
+	return (int)std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count() + 1;
+}
+
+void DirWatch::Flush()
+{
+	if (GetWaitTime() != 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Ready.insert(m_Ready.end(), m_Pending.begin(), m_Pending.end());
+		m_bOverflow = m_bOverflow || m_bPendingOverflow;
+		m_Stats.batches++;
+	}
+	m_Pending.clear();
+	m_bPendingOverflow = false;
+
+	TRACE_INSTANT("Folder changes", "image");
+	if (m_Callback)
+		m_Callback();
+}
+
+void DirWatch::SetWatching()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_bWatching = true;
+	m_Started.notify_all();
+}
+
+#ifdef _WIN32
+
+// Relative path in the code page used for file names
+static std::string ToPath(const WCHAR* name, int length)
+{
+	const int bytes = WideCharToMultiByte(CP_ACP, 0, name, length, NULL, 0, NULL, NULL);
+	if (bytes <= 0)
+		return std::string();
+	std::string path((size_t)bytes, '\0');
+	WideCharToMultiByte(CP_ACP, 0, name, length, &path[0], bytes, NULL, NULL);
+	return path;
+}
+
+void DirWatch::Watch()
+{
+	FrameTrace::Shared().SetThreadName("Folder watch");
+
+	const HANDLE hDir = (HANDLE)m_hDir;
+	const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE;
+	std::vector<DWORD> buffer(16384); // 64 KB, the most allowed for a network share
+	OVERLAPPED overlapped{};
+	overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	bool bReading = false;
+
+	while (!m_bStop) {
+
+		if (!bReading) {
+			ResetEvent(overlapped.hEvent);
+			if (!ReadDirectoryChangesW(hDir, buffer.data(), (DWORD)(buffer.size()*sizeof(DWORD)), TRUE,
+				filter, NULL, &overlapped, NULL))
+				break;
+			bReading = true;
+			SetWatching();
+		}
+
+		const HANDLE handles[2] = { overlapped.hEvent, (HANDLE)m_hStop };
+		const int wait = GetWaitTime();
+		const DWORD result = WaitForMultipleObjects(2, handles, FALSE, (wait < 0) ? INFINITE : (DWORD)wait);
+		if (result == WAIT_OBJECT_0 + 1)
+			break;
+
+		if (result == WAIT_OBJECT_0) {
+			bReading = false;
+			DWORD bytes = 0;
+			if (!GetOverlappedResult(hDir, &overlapped, &bytes, FALSE)) {
+				if (GetLastError() != ERROR_NOTIFY_ENUM_DIR)
+					break;
+				AddOverflow();
+			}
+			else if (bytes == 0) {
+				// The buffer was too small for the changes
+				AddOverflow();
+			}
+			else {
+				const unsigned char* p = (const unsigned char*)buffer.data();
+				std::string oldpath;
+				while (true) {
+					const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)p;
+					const std::string path = ToPath(info->FileName, (int)(info->FileNameLength/sizeof(WCHAR)));
+					switch (info->Action) {
+						case FILE_ACTION_ADDED:
+							AddChange(DIR_ADDED, path);
+							break;
+						case FILE_ACTION_REMOVED:
+							AddChange(DIR_REMOVED, path);
+							break;
+						case FILE_ACTION_MODIFIED:
+							AddChange(DIR_MODIFIED, path);
+							break;
+						case FILE_ACTION_RENAMED_OLD_NAME:
+							if (!oldpath.empty())
+								AddChange(DIR_REMOVED, oldpath);
+							oldpath = path;
+							break;
+						case FILE_ACTION_RENAMED_NEW_NAME:
+							if (oldpath.empty())
+								AddChange(DIR_ADDED, path);
+							else
+								AddChange(DIR_RENAMED, path, oldpath);
+							oldpath.clear();
+							break;
+						default:
+							break;
+					}
+					if (info->NextEntryOffset == 0)
+						break;
+					p += info->NextEntryOffset;
+				}
+				if (!oldpath.empty())
+					AddChange(DIR_REMOVED, oldpath);
+			}
+		}
+
+		Flush();
+	}
+
+	// The read has to finish before the buffer is released
+	if (bReading) {
+		DWORD bytes = 0;
+		CancelIoEx(hDir, &overlapped);
+		GetOverlappedResult(hDir, &overlapped, &bytes, TRUE);
+	}
+	CloseHandle(overlapped.hEvent);
+	SetWatching(); // If the first read failed
+}
+
+#else
+
+static const uint32_t watchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+	| IN_CLOSE_WRITE | IN_ONLYDIR | IN_DONT_FOLLOW;
+
+static std::string JoinPath(const std::string& folder, const std::string& name)
+{
+	return folder.empty() ? name : folder + "/" + name;
+}
+
+// Watch a folder and the folders within it. inotify is not recursive.
+static void AddWatches(int notify, const std::string& root, const std::string& relative,
+	std::unordered_map<int, std::string>& watches)
+{
+	const fs::path folder = relative.empty() ? fs::path(root) : fs::path(root) / relative;
+	const int wd = inotify_add_watch(notify, folder.c_str(), watchMask);
+	if (wd < 0)
+		return;
+	watches[wd] = relative;
+
+	std::error_code ec;
+	for (fs::directory_iterator it(folder, ec), end; !ec && it != end; it.increment(ec)) {
+		std::error_code fec;
+		if (!it->is_symlink(fec) && it->is_directory(fec))
+			AddWatches(notify, root, JoinPath(relative, it->path().filename().string()), watches);
+	}
+}
+
+// Stop watching a folder moved out of the watched folder, and the folders within it.
+// Their watches stay with them and would report changes under the old paths.
+static void RemoveWatches(int notify, const std::string& relative,
+	std::unordered_map<int, std::string>& watches)
+{
+	for (auto it = watches.begin(); it != watches.end(); ) {
+		if (it->second == relative || it->second.compare(0, relative.size() + 1, relative + "/") == 0) {
+			inotify_rm_watch(notify, it->first);
+			it = watches.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void DirWatch::Watch()
+{
+	FrameTrace::Shared().SetThreadName("Folder watch");
+
+	std::unordered_map<int, std::string> watches; // Relative folder of each watch
+	AddWatches(m_Notify, m_Folder, std::string(), watches);
+	SetWatching();
+
+	alignas(struct inotify_event) char buffer[65536];
+	while (!m_bStop) {
+
+		struct pollfd fds[2] = { { m_Notify, POLLIN, 0 }, { m_StopPipe[0], POLLIN, 0 } };
+		if (poll(fds, 2, GetWaitTime()) < 0 && errno != EINTR)
+			break;
+		if (fds[1].revents)
+			break;
+
+		if (fds[0].revents & POLLIN) {
+			const ssize_t bytes = read(m_Notify, buffer, sizeof(buffer));
+			// The source of a move, waiting for its destination
+			uint32_t cookie = 0;
+			std::string frompath;
+			bool bFromFolder = false;
+			// A move source not followed by its destination has left the folder
+			auto movedOut = [&]() {
+				if (bFromFolder)
+					RemoveWatches(m_Notify, frompath, watches);
+				AddChange(DIR_REMOVED, frompath);
+				frompath.clear();
+			};
+
+			for (ssize_t i = 0; i < bytes; ) {
+				const struct inotify_event* event = (const struct inotify_event*)(buffer + i);
+				i += sizeof(struct inotify_event) + event->len;
+
+				if (event->mask & IN_Q_OVERFLOW) {
+					AddOverflow();
+					continue;
+				}
+				if (event->mask & IN_IGNORED) {
+					watches.erase(event->wd);
+					continue;
+				}
+				auto watch = watches.find(event->wd);
+				if (watch == watches.end() || event->len == 0)
+					continue;
+				const std::string path = JoinPath(watch->second, event->name);
+				const bool bFolder = (event->mask & IN_ISDIR) != 0;
+
+				if (!frompath.empty() && !((event->mask & IN_MOVED_TO) && event->cookie == cookie))
+					movedOut();
+
+				if (event->mask & IN_CREATE) {
+					if (bFolder)
+						AddWatches(m_Notify, m_Folder, path, watches);
+					AddChange(DIR_ADDED, path);
+				}
+				else if (event->mask & IN_DELETE) {
+					AddChange(DIR_REMOVED, path);
+				}
+				else if (event->mask & IN_CLOSE_WRITE) {
+					AddChange(DIR_MODIFIED, path);
+				}
+				else if (event->mask & IN_MOVED_FROM) {
+					cookie = event->cookie;
+					frompath = path;
+					bFromFolder = bFolder;
+				}
+				else if (event->mask & IN_MOVED_TO) {
+					if (!frompath.empty()) {
+						// Watches within a renamed folder keep their descriptors
+						if (bFromFolder) {
+							for (auto& it : watches) {
+								if (it.second == frompath)
+									it.second = path;
+								else if (it.second.compare(0, frompath.size() + 1, frompath + "/") == 0)
+									it.second = path + it.second.substr(frompath.size());
+							}
+						}
+						AddChange(DIR_RENAMED, path, frompath);
+						frompath.clear();
+					}
+					else {
+						if (bFolder)
+							AddWatches(m_Notify, m_Folder, path, watches);
+						AddChange(DIR_ADDED, path);
+					}
+				}
+			}
+			if (!frompath.empty())
+				movedOut();
+		}
+
+		Flush();
+	}
+}
+
+#endif
@@ -0,0 +1,134 @@
+//
+//		DirWatch
+//
+//		Changes to the files in a folder and its subfolders.
+//
+//		A thread waits for change notifications from the system,
+//		ReadDirectoryChangesW on Windows and inotify on Linux, and
+//		collects them. When no change has arrived for the debounce time,
+//		or changes have kept arriving for ten times as long, the callback
+//		is called so that the changes can be taken as one batch.
+//
+//		Paths are relative to the folder. A rename within the folder is
+//		one change if the system reports both names, otherwise a removal
+//		and an addition. A folder added, removed or renamed is reported
+//		for the folder alone, not for each file in it. If notifications
+//		were lost the batch is marked as overflowed and the folder should
+//		be scanned again.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <chrono>
+
+enum DirAction {
+	DIR_ADDED = 0,
+	DIR_REMOVED,
+	DIR_MODIFIED,
+	DIR_RENAMED
+};
+
+struct DirChange {
+	DirAction action = DIR_ADDED;
+	std::string path;     // Relative to the folder
+	std::string oldpath;  // Previous path for DIR_RENAMED
+};
+
+// Notifications received
+struct DirWatchStats {
+	uint64_t changes = 0;
+	uint64_t batches = 0;
+	uint64_t overflows = 0;
+};
+
+class DirWatch {
+
+public:
+
+	DirWatch();
+	~DirWatch();
+
+	// Start watching a folder and its subfolders. Changes are recorded from when it returns.
+	// debounce is the time without changes before a batch is ready (msec).
+	bool Open(const std::string& folder, unsigned int debounce = 500);
+	// Stop watching and discard changes not taken
+	void Close();
+	bool IsOpen() const { return m_Thread.joinable(); }
+	const std::string& GetFolder() const { return m_Folder; }
+
+	// Called on the watch thread when a batch of changes is ready
+	void SetCallback(std::function<void()> callback) { m_Callback = callback; }
+
+	// Changes ready, in the order they happened.
+	// bOverflow is set if changes were lost.
+	std::vector<DirChange> TakeChanges(bool& bOverflow);
+
+	DirWatchStats GetStats() const;
+
+private:
+
+	void Watch();
+	void AddChange(DirAction action, const std::string& path, const std::string& oldpath = std::string());
+	void AddOverflow();
+	// Time until the changes pending are ready (msec), -1 if there are none
+	int GetWaitTime() const;
+	// Make the changes pending ready if it is time
+	void Flush();
+	// Let Open return once changes are being recorded
+	void SetWatching();
+
+	std::string m_Folder;
+	unsigned int m_Debounce = 500;
+	std::thread m_Thread;
+	std::atomic<bool> m_bStop{false};
+	std::function<void()> m_Callback;
+
+	// Collected on the watch thread
+	std::vector<DirChange> m_Pending;
+	bool m_bPendingOverflow = false;
+	std::chrono::steady_clock::time_point m_First; // First and last change pending
+	std::chrono::steady_clock::time_point m_Last;
+
+	mutable std::mutex m_Mutex;
+	std::vector<DirChange> m_Ready;
+	bool m_bOverflow = false;
+	DirWatchStats m_Stats;
+	std::condition_variable m_Started;
+	bool m_bWatching = false;
+
+#ifdef _WIN32
+	void* m_hDir = nullptr;       // Folder handle
+	void* m_hStop = nullptr;      // Event to wake the thread to stop
+#else
+	int m_Notify = -1;            // inotify descriptor
+	int m_StopPipe[2] = { -1, -1 };
+#endif
+
+};
@@ -0,0 +1,118 @@
+//
+//		DiskCache
+//
+//		A folder of cache files limited to a total size.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "DiskCache.h"
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+DiskCache::DiskCache()
+{
+}
+
+bool DiskCache::Open(const std::string& folder, uint64_t budget)
+{
+	std::error_code ec;
+	fs::create_directories(fs::path(folder), ec);
+	if (!fs::is_directory(fs::path(folder), ec))
+		return false;
+	m_Folder = folder;
+	m_Budget = budget;
+	return true;
+}
+
+std::string DiskCache::HashKey(const std::string& key)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < key.size(); i++) {
+		hash ^= (unsigned char)key[i];
+		hash *= 1099511628211ULL;
+	}
+	char tmp[17]{};
+	snprintf(tmp, 17, "%016llx", (unsigned long long)hash);
+	return tmp;
+}
+
+std::string DiskCache::GetPath(const std::string& key, const char* extension) const
+{
+	if (m_Folder.empty())
+		return std::string();
+	fs::path path = fs::path(m_Folder) / (HashKey(key) + (extension ? extension : ""));
+	return path.string();
+}
+
+bool DiskCache::Touch(const std::string& path) const
+{
+	std::error_code ec;
+	const fs::path file = fs::path(path);
+	if (!fs::is_regular_file(file, ec))
+		return false;
+	fs::last_write_time(file, fs::file_time_type::clock::now(), ec);
+	return true;
+}
+
+uint64_t DiskCache::Evict(const std::string& keep) const
+{
+	if (m_Folder.empty())
+		return 0;
+
+	struct CacheFile {
+		fs::path path;
+		uint64_t size;
+		fs::file_time_type time;
+	};
+	std::vector<CacheFile> files;
+	uint64_t total = 0;
+
+	std::error_code ec;
+	for (fs::directory_iterator it(fs::path(m_Folder), ec), end; !ec && it != end; it.increment(ec)) {
+		if (!it->is_regular_file(ec) || it->path().extension() == ".tmp")
+			continue;
+		CacheFile file;
+		file.path = it->path();
+		file.size = (uint64_t)it->file_size(ec);
+		file.time = it->last_write_time(ec);
+		total += file.size;
+		files.push_back(file);
+	}
+
+	// Least recently used first
+	std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) {
+		return a.time < b.time;
+	});
+
+	const fs::path keeppath = fs::path(keep);
+	for (size_t i = 0; i < files.size() && total > m_Budget; i++) {
+		if (!keep.empty() && files[i].path == keeppath)
+			continue;
+		if (fs::remove(files[i].path, ec))
+			total -= files[i].size;
+	}
+
+	return total;
+}
@@ -0,0 +1,68 @@
+//
+//		DiskCache
+//
+//		A folder of cache files limited to a total size.
+//
+//		Files are named from a hash of the strings that identify their
+//		contents. The modified time of a file is updated when it is used,
+//		and the least recently used files are removed when the folder is
+//		larger than the budget.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+class DiskCache {
+
+public:
+
+	DiskCache();
+
+	// Folder for the files, created if necessary,
+	// and the total size allowed in bytes
+	bool Open(const std::string& folder, uint64_t budget);
+	bool IsOpen() const { return !m_Folder.empty(); }
+	void SetBudget(uint64_t budget) { m_Budget = budget; }
+	uint64_t GetBudget() const { return m_Budget; }
+
+	// Path of the file for a key and extension, e.g. ".frames"
+	std::string GetPath(const std::string& key, const char* extension) const;
+
+	// Does the file exist. If it does, it becomes the most recently used.
+	bool Touch(const std::string& path) const;
+
+	// Remove the least recently used files until within the budget.
+	// Files with a ".tmp" extension are being written and are not counted.
+	// Returns the total size of the remaining files.
+	uint64_t Evict(const std::string& keep = std::string()) const;
+
+	// 64 bit FNV-1a hash of a key as 16 hex characters
+	static std::string HashKey(const std::string& key);
+
+private:
+
+	std::string m_Folder;
+	uint64_t m_Budget = 0;
+
+};
@@ -0,0 +1,513 @@
+//
+//		FrameCache
+//
+//		Decoded frames of one loop of a video in a file that is
+//		memory mapped for replay.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "FrameCache.h"
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char framecachemagic[8] = { 'S', 'W', 'P', 'F', 'R', 'A', 'M', 'E' };
+static const uint32_t framecacheversion = 1;
+static const uint64_t framealign = 64;
+
+//
+// MappedFile
+//
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0 || (uint64_t)size.QuadPart > (uint64_t)SIZE_MAX) {
+		CloseHandle(hFile);
+		return false;
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!hMapping) {
+		CloseHandle(hFile);
+		return false;
+	}
+
+	void* data = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return false;
+	}
+
+	m_hFile = hFile;
+	m_hMapping = hMapping;
+	m_Data = (const unsigned char*)data;
+	m_Size = (uint64_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_Data) UnmapViewOfFile(m_Data);
+	if (m_hMapping) CloseHandle((HANDLE)m_hMapping);
+	if (m_hFile) CloseHandle((HANDLE)m_hFile);
+	m_Data = nullptr;
+	m_hMapping = nullptr;
+	m_hFile = nullptr;
+	m_Size = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st {};
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+
+	m_fd = fd;
+	m_Data = (const unsigned char*)data;
+	m_Size = (uint64_t)st.st_size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_Data) munmap((void*)m_Data, (size_t)m_Size);
+	if (m_fd >= 0) close(m_fd);
+	m_Data = nullptr;
+	m_fd = -1;
+	m_Size = 0;
+}
+
+#endif
+
+//
+// Delta coding
+//
+// A frame is a sequence of runs :
+//   uint32_t same     pixels unchanged from the previous frame
+//   uint32_t literal  new pixels that follow
+//   literal pixels
+//
+
+// Short unchanged runs are kept in a literal run
+// rather than starting a new pair of counts
+static const uint32_t minsamerun = 4;
+
+static void EncodeDelta(const uint32_t* cur, const uint32_t* prev, size_t npixels, std::vector<uint32_t>& out)
+{
+	out.clear();
+	size_t i = 0;
+	while (i < npixels) {
+		size_t start = i;
+		while (i < npixels && cur[i] == prev[i])
+			i++;
+		const uint32_t same = (uint32_t)(i - start);
+
+		start = i;
+		while (i < npixels) {
+			if (cur[i] != prev[i]) {
+				i++;
+				continue;
+			}
+			// End the literal run at a long enough unchanged run
+			size_t j = i;
+			while (j < npixels && j - i < minsamerun && cur[j] == prev[j])
+				j++;
+			if (j - i >= minsamerun || j == npixels)
+				break;
+			i = j;
+		}
+		const uint32_t literal = (uint32_t)(i - start);
+
+		out.push_back(same);
+		out.push_back(literal);
+		out.insert(out.end(), cur + start, cur + start + literal);
+	}
+}
+
+static bool DecodeDelta(const uint32_t* src, size_t srcwords, const uint32_t* prev, uint32_t* dst, size_t npixels)
+{
+	size_t pos = 0;
+	size_t word = 0;
+	while (pos < npixels) {
+		if (word + 2 > srcwords)
+			return false;
+		const size_t same = src[word];
+		const size_t literal = src[word + 1];
+		word += 2;
+		if (same > npixels - pos || literal > npixels - pos - same || literal > srcwords - word)
+			return false;
+		memcpy(dst + pos, prev + pos, same*4);
+		pos += same;
+		memcpy(dst + pos, src + word, literal*4);
+		pos += literal;
+		word += literal;
+	}
+	return true;
+}
+
+//
+// FrameCacheWriter
+//
+
+FrameCacheWriter::FrameCacheWriter()
+{
+}
+
+FrameCacheWriter::~FrameCacheWriter()
+{
+	Abort();
+}
+
+bool FrameCacheWriter::Open(const std::string& path, unsigned int width, unsigned int height,
+	unsigned int rateNum, unsigned int rateDen, bool bDelta)
+{
+	Abort();
+
+	if (width == 0 || height == 0)
+		return false;
+
+#ifdef _MSC_VER
+	if (fopen_s(&m_File, path.c_str(), "wb") != 0)
+		m_File = nullptr;
+#else
+	m_File = fopen(path.c_str(), "wb");
+#endif
+	if (!m_File)
+		return false;
+
+	m_Path = path;
+	memset(&m_Header, 0, sizeof(m_Header));
+	memcpy(m_Header.magic, framecachemagic, sizeof(framecachemagic));
+	m_Header.version = framecacheversion;
+	m_Header.width = width;
+	m_Header.height = height;
+	m_Header.frames = 0; // Not finished
+	m_Header.rateNum = rateNum;
+	m_Header.rateDen = rateDen;
+	m_Index.clear();
+	m_Previous.clear();
+	m_bDelta = bDelta;
+	m_Offset = 0;
+
+	// Space for the header, written again when finished
+	if (!Write(&m_Header, sizeof(m_Header))) {
+		Abort();
+		return false;
+	}
+	return true;
+}
+
+bool FrameCacheWriter::Write(const void* data, size_t size)
+{
+	if (fwrite(data, 1, size, m_File) != size)
+		return false;
+	m_Offset += size;
+	return true;
+}
+
+bool FrameCacheWriter::AddFrame(const unsigned char* frame)
+{
+	if (!m_File || !frame)
+		return false;
+
+	// Align the frame data
+	static const unsigned char zeros[framealign]{};
+	const size_t padding = (size_t)((framealign - (m_Offset % framealign)) % framealign);
+	if (padding > 0 && !Write(zeros, padding))
+		return false;
+
+	const size_t npixels = (size_t)m_Header.width*(size_t)m_Header.height;
+	const size_t framesize = npixels*4;
+
+	FrameCacheEntry entry{};
+	entry.offset = m_Offset;
+	entry.type = FRAMECACHE_RAW;
+	entry.size = (uint32_t)framesize;
+
+	// Use changes from the previous frame if a quarter smaller
+	if (m_bDelta && !m_Previous.empty()) {
+		EncodeDelta((const uint32_t*)frame, (const uint32_t*)m_Previous.data(), npixels, m_Delta);
+		const size_t deltasize = m_Delta.size()*4;
+		if (deltasize < framesize - framesize/4) {
+			entry.type = FRAMECACHE_DELTA;
+			entry.size = (uint32_t)deltasize;
+		}
+	}
+
+	const bool bWritten = (entry.type == FRAMECACHE_DELTA)
+		? Write(m_Delta.data(), entry.size)
+		: Write(frame, entry.size);
+	if (!bWritten)
+		return false;
+
+	m_Index.push_back(entry);
+	if (m_bDelta)
+		m_Previous.assign(frame, frame + framesize);
+
+	return true;
+}
+
+bool FrameCacheWriter::Finish()
+{
+	if (!m_File || m_Index.empty())
+		return false;
+
+	bool bResult = true;
+	m_Header.indexOffset = m_Offset;
+	if (!Write(m_Index.data(), m_Index.size()*sizeof(FrameCacheEntry)))
+		bResult = false;
+
+	// The frame count marks the file as finished
+	m_Header.frames = (uint32_t)m_Index.size();
+	if (bResult && (fseek(m_File, 0, SEEK_SET) != 0 || fwrite(&m_Header, 1, sizeof(m_Header), m_File) != sizeof(m_Header)))
+		bResult = false;
+	if (fclose(m_File) != 0)
+		bResult = false;
+	m_File = nullptr;
+	m_Previous.clear();
+	m_Delta.clear();
+
+	if (!bResult)
+		remove(m_Path.c_str());
+
+	return bResult;
+}
+
+void FrameCacheWriter::Abort()
+{
+	if (m_File) {
+		fclose(m_File);
+		m_File = nullptr;
+		remove(m_Path.c_str());
+	}
+	m_Index.clear();
+	m_Previous.clear();
+	m_Delta.clear();
+}
+
+//
+// FrameCacheReader
+//
+
+FrameCacheReader::FrameCacheReader()
+{
+}
+
+FrameCacheReader::~FrameCacheReader()
+{
+	Close();
+}
+
+bool FrameCacheReader::Open(const std::string& path)
+{
+	Close();
+
+	if (!m_Mapping.Open(path))
+		return false;
+
+	const unsigned char* data = m_Mapping.GetData();
+	const uint64_t size = m_Mapping.GetSize();
+	if (size < sizeof(FrameCacheHeader)) {
+		Close();
+		return false;
+	}
+
+	const FrameCacheHeader* header = (const FrameCacheHeader*)data;
+	if (memcmp(header->magic, framecachemagic, sizeof(framecachemagic)) != 0
+		|| header->version != framecacheversion
+		|| header->frames == 0 || header->width == 0 || header->height == 0
+		|| header->indexOffset > size
+		|| (size - header->indexOffset)/sizeof(FrameCacheEntry) < header->frames) {
+		Close();
+		return false;
+	}
+
+	// Check that every frame is within the file
+	const FrameCacheEntry* index = (const FrameCacheEntry*)(data + header->indexOffset);
+	const uint64_t framesize = (uint64_t)header->width*(uint64_t)header->height*4;
+	for (uint32_t i = 0; i < header->frames; i++) {
+		if (index[i].offset > header->indexOffset || index[i].size > header->indexOffset - index[i].offset
+			|| (index[i].type == FRAMECACHE_RAW && index[i].size != framesize)
+			|| (index[i].type != FRAMECACHE_RAW && index[i].type != FRAMECACHE_DELTA)
+			|| (i == 0 && index[i].type != FRAMECACHE_RAW)) {
+			Close();
+			return false;
+		}
+	}
+
+	m_Header = header;
+	m_Index = index;
+	return true;
+}
+
+void FrameCacheReader::Close()
+{
+	m_Header = nullptr;
+	m_Index = nullptr;
+	m_Mapping.Close();
+}
+
+bool FrameCacheReader::ReadFrame(unsigned int index, unsigned char* dst, const unsigned char* prev) const
+{
+	if (!m_Header || index >= m_Header->frames || !dst)
+		return false;
+
+	const FrameCacheEntry& entry = m_Index[index];
+	const unsigned char* src = m_Mapping.GetData() + entry.offset;
+	if (entry.type == FRAMECACHE_RAW) {
+		memcpy(dst, src, entry.size);
+		return true;
+	}
+
+	if (!prev)
+		return false;
+	const size_t npixels = (size_t)m_Header->width*(size_t)m_Header->height;
+	return DecodeDelta((const uint32_t*)src, entry.size/4, (const uint32_t*)prev, (uint32_t*)dst, npixels);
+}
+
+//
+// FrameCacheRecorder
+//
+
+FrameCacheRecorder::FrameCacheRecorder()
+{
+}
+
+FrameCacheRecorder::~FrameCacheRecorder()
+{
+	Stop();
+}
+
+bool FrameCacheRecorder::Start(const std::string& path, unsigned int width, unsigned int height,
+	unsigned int rateNum, unsigned int rateDen, uint64_t maxbytes, unsigned int frames)
+{
+	Stop();
+	if (path.empty() || width == 0 || height == 0)
+		return false;
+	m_Path = path;
+	m_Width = width;
+	m_Height = height;
+	m_RateNum = rateNum;
+	m_RateDen = rateDen;
+	m_MaxBytes = maxbytes;
+	m_Frames = frames;
+	m_bStarted = false;
+	m_bComplete = false;
+	m_bRecording = true;
+	return true;
+}
+
+void FrameCacheRecorder::Stop()
+{
+	// An unfinished file is deleted
+	m_Writer.Abort();
+	m_bRecording = false;
+	m_bStarted = false;
+	m_bComplete = false;
+}
+
+void FrameCacheRecorder::AddFrame(const unsigned char* frame, bool bLoopStart)
+{
+	if (!m_bRecording)
+		return;
+
+	if (bLoopStart) {
+		if (!m_bStarted) {
+			// Written to a temporary file until finished
+			if (!m_Writer.Open(m_Path + ".tmp", m_Width, m_Height, m_RateNum, m_RateDen)) {
+				m_bRecording = false;
+				return;
+			}
+			m_bStarted = true;
+		}
+		else {
+			// The next loop has started. The cache file is complete
+			// unless the loop is not the length expected. It would
+			// then replay with a jump at the end of every loop.
+			bool bFinished = false;
+			if (m_Frames > 0 && m_Writer.GetFrameCount() != m_Frames)
+				m_Writer.Abort();
+			else
+				bFinished = m_Writer.Finish();
+			if (bFinished) {
+				remove(m_Path.c_str());
+				bFinished = (rename((m_Path + ".tmp").c_str(), m_Path.c_str()) == 0);
+				if (!bFinished)
+					remove((m_Path + ".tmp").c_str());
+			}
+			m_bRecording = false;
+			m_bComplete = bFinished;
+			return;
+		}
+	}
+
+	if (!m_bStarted)
+		return;
+
+	// Too large for the cache
+	if (!m_Writer.AddFrame(frame) || m_Writer.GetFileSize() > m_MaxBytes) {
+		m_Writer.Abort();
+		m_bRecording = false;
+	}
+}
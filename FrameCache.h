@@ -0,0 +1,203 @@
+//
+//		FrameCache
+//
+//		Decoded frames of one loop of a video in a file that is
+//		memory mapped for replay.
+//
+//		The first loop is written as it is decoded. Each frame is stored
+//		either as it is or, if smaller, as runs of pixels unchanged from
+//		the previous frame and runs of new pixels. The first frame is
+//		always stored as it is. Later loops are copied from the mapping
+//		with no decoder running at all.
+//
+//		File layout
+//		  FrameCacheHeader
+//		  Frame data, each frame aligned to 64 bytes
+//		  Index of FrameCacheEntry, one for each frame
+//
+//		The header is written last. A file that was not finished has no
+//		frame count and is not used.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <atomic>
+
+enum FrameCacheType {
+	FRAMECACHE_RAW = 0,  // BGRA pixels
+	FRAMECACHE_DELTA     // Runs of unchanged and new pixels
+};
+
+struct FrameCacheHeader {
+	char magic[8];            // "SWPFRAME"
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t frames;          // 0 until the file is finished
+	uint32_t rateNum;         // Frame rate of the video
+	uint32_t rateDen;
+	uint64_t indexOffset;     // FrameCacheEntry table
+};
+
+struct FrameCacheEntry {
+	uint64_t offset;
+	uint32_t size;
+	uint32_t type;            // FrameCacheType
+};
+
+// Read only memory mapping of a whole file
+class MappedFile {
+
+public:
+
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const std::string& path);
+	void Close();
+	const unsigned char* GetData() const { return m_Data; }
+	uint64_t GetSize() const { return m_Size; }
+
+private:
+
+	const unsigned char* m_Data = nullptr;
+	uint64_t m_Size = 0;
+#ifdef _WIN32
+	void* m_hFile = nullptr;
+	void* m_hMapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+
+};
+
+// Write a cache file frame by frame
+class FrameCacheWriter {
+
+public:
+
+	FrameCacheWriter();
+	~FrameCacheWriter();
+
+	// Create the file for frames of the given size.
+	// bDelta stores frames as changes from the previous frame if smaller.
+	bool Open(const std::string& path, unsigned int width, unsigned int height,
+		unsigned int rateNum, unsigned int rateDen, bool bDelta = true);
+	// Add the next BGRA frame
+	bool AddFrame(const unsigned char* frame);
+	// Write the index and header and close the file
+	bool Finish();
+	// Close and delete the file
+	void Abort();
+
+	bool IsOpen() const { return m_File != nullptr; }
+	unsigned int GetFrameCount() const { return (unsigned int)m_Index.size(); }
+	uint64_t GetFileSize() const { return m_Offset; }
+
+private:
+
+	bool Write(const void* data, size_t size);
+
+	FILE* m_File = nullptr;
+	std::string m_Path;
+	FrameCacheHeader m_Header{};
+	std::vector<FrameCacheEntry> m_Index;
+	std::vector<unsigned char> m_Previous; // Last frame added
+	std::vector<uint32_t> m_Delta;         // Encoded frame
+	uint64_t m_Offset = 0;
+	bool m_bDelta = true;
+
+};
+
+// Read frames from a mapped cache file
+class FrameCacheReader {
+
+public:
+
+	FrameCacheReader();
+	~FrameCacheReader();
+
+	bool Open(const std::string& path);
+	void Close();
+	bool IsOpen() const { return m_Header != nullptr; }
+
+	unsigned int GetWidth() const { return m_Header ? m_Header->width : 0; }
+	unsigned int GetHeight() const { return m_Header ? m_Header->height : 0; }
+	unsigned int GetFrameCount() const { return m_Header ? m_Header->frames : 0; }
+
+	// Decode a frame into dst, width*height*4 bytes.
+	// prev must hold the frame before it, except for the first frame.
+	// Frames are decoded in order from the first.
+	bool ReadFrame(unsigned int index, unsigned char* dst, const unsigned char* prev) const;
+
+private:
+
+	MappedFile m_Mapping;
+	const FrameCacheHeader* m_Header = nullptr;
+	const FrameCacheEntry* m_Index = nullptr;
+
+};
+
+// Record one loop of a video source to a cache file.
+// Frames are added on the source thread.
+class FrameCacheRecorder {
+
+public:
+
+	FrameCacheRecorder();
+	~FrameCacheRecorder();
+
+	// Start recording to the cache file at the next loop start.
+	// Recording stops if the file would be larger than maxbytes.
+	// If frames is not 0, a loop of any other length is not kept.
+	bool Start(const std::string& path, unsigned int width, unsigned int height,
+		unsigned int rateNum, unsigned int rateDen, uint64_t maxbytes, unsigned int frames = 0);
+	// Stop and delete an unfinished file
+	void Stop();
+
+	// A new frame from the source. bLoopStart is true for the first frame of a loop.
+	void AddFrame(const unsigned char* frame, bool bLoopStart);
+
+	bool IsRecording() const { return m_bRecording.load(); }
+	// A complete loop has been written. Cleared by Start and Stop.
+	bool IsComplete() const { return m_bComplete.load(); }
+	const std::string& GetPath() const { return m_Path; }
+
+private:
+
+	FrameCacheWriter m_Writer;
+	std::string m_Path;
+	unsigned int m_Width = 0;
+	unsigned int m_Height = 0;
+	unsigned int m_RateNum = 0;
+	unsigned int m_RateDen = 0;
+	uint64_t m_MaxBytes = 0;
+	unsigned int m_Frames = 0; // Frames expected in a loop, 0 if not known
+	bool m_bStarted = false; // First loop start seen
+	std::atomic<bool> m_bRecording{false};
+	std::atomic<bool> m_bComplete{false};
+
+};
@@ -0,0 +1,240 @@
+//
+//		FrameChange
+//
+//		Detect which tiles of a BGRA frame have changed since the last frame.
+//
+//		For each 32 byte block of a tile line, as four 64 bit words w[i]
+//		with keys k[i] :
+//
+//		  d = w[i] ^ k[i]
+//		  acc[i]   += (d & 0xFFFFFFFF) * (d >> 32)
+//		  acc[i^1] += w[i]
+//		  k[i]     += step
+//
+//		Keys start from the line number. Pixels left over at the end of a
+//		tile line are mixed into acc[0] one at a time.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "FrameChange.h"
+#include <string.h>
+#include <chrono>
+
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif
+
+static const uint64_t keys[4] = {
+	0xBE4BA423396CFEB8ULL, 0x1CAD21F72C81017CULL, 0xDB979083E96DD4DEULL, 0x1F67B3B7A4A44072ULL
+};
+static const uint64_t keystep = 0x9E3779B97F4A7C15ULL;
+static const uint64_t linestep = 0xC2B2AE3D27D4EB4FULL;
+
+// Keys for the first block of a line
+static inline void LineKeys(unsigned int y, uint64_t* k)
+{
+	const uint64_t line = (uint64_t)(y + 1)*linestep;
+	for (int i = 0; i < 4; i++)
+		k[i] = keys[i] ^ line;
+}
+
+// Final mix of the lanes
+static inline uint64_t Finish(const uint64_t* acc)
+{
+	uint64_t h = acc[0] ^ ((acc[1] << 17) | (acc[1] >> 47)) ^ ((acc[2] << 31) | (acc[2] >> 33)) ^ ((acc[3] << 47) | (acc[3] >> 17));
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+//
+// Scalar reference. Returns the bytes used, a multiple of 32.
+//
+static unsigned int AccumulateScalar(const unsigned char* line, unsigned int bytes, uint64_t* acc, uint64_t* k)
+{
+	unsigned int i = 0;
+	for (; i + 32 <= bytes; i += 32) {
+		uint64_t w[4];
+		memcpy(w, line + i, 32);
+		for (int j = 0; j < 4; j++) {
+			const uint64_t d = w[j] ^ k[j];
+			acc[j] += (d & 0xFFFFFFFFULL)*(d >> 32);
+			acc[j ^ 1] += w[j];
+			k[j] += keystep;
+		}
+	}
+	return i;
+}
+
+#ifdef SIMD_X86
+
+static unsigned int AccumulateSSE2(const unsigned char* line, unsigned int bytes, uint64_t* acc, uint64_t* k)
+{
+	__m128i acc01 = _mm_loadu_si128((const __m128i*)acc);
+	__m128i acc23 = _mm_loadu_si128((const __m128i*)(acc + 2));
+	__m128i k01 = _mm_loadu_si128((const __m128i*)k);
+	__m128i k23 = _mm_loadu_si128((const __m128i*)(k + 2));
+	const __m128i step = _mm_set1_epi64x((long long)keystep);
+
+	unsigned int i = 0;
+	for (; i + 32 <= bytes; i += 32) {
+		const __m128i w01 = _mm_loadu_si128((const __m128i*)(line + i));
+		const __m128i w23 = _mm_loadu_si128((const __m128i*)(line + i + 16));
+		const __m128i d01 = _mm_xor_si128(w01, k01);
+		const __m128i d23 = _mm_xor_si128(w23, k23);
+		acc01 = _mm_add_epi64(acc01, _mm_mul_epu32(d01, _mm_srli_epi64(d01, 32)));
+		acc23 = _mm_add_epi64(acc23, _mm_mul_epu32(d23, _mm_srli_epi64(d23, 32)));
+		// Words added to the other lane of the pair
+		acc01 = _mm_add_epi64(acc01, _mm_shuffle_epi32(w01, _MM_SHUFFLE(1, 0, 3, 2)));
+		acc23 = _mm_add_epi64(acc23, _mm_shuffle_epi32(w23, _MM_SHUFFLE(1, 0, 3, 2)));
+		k01 = _mm_add_epi64(k01, step);
+		k23 = _mm_add_epi64(k23, step);
+	}
+
+	_mm_storeu_si128((__m128i*)acc, acc01);
+	_mm_storeu_si128((__m128i*)(acc + 2), acc23);
+	_mm_storeu_si128((__m128i*)k, k01);
+	_mm_storeu_si128((__m128i*)(k + 2), k23);
+	return i;
+}
+
+SIMD_TARGET_AVX2
+static unsigned int AccumulateAVX2(const unsigned char* line, unsigned int bytes, uint64_t* acc, uint64_t* k)
+{
+	__m256i a = _mm256_loadu_si256((const __m256i*)acc);
+	__m256i key = _mm256_loadu_si256((const __m256i*)k);
+	const __m256i step = _mm256_set1_epi64x((long long)keystep);
+
+	unsigned int i = 0;
+	for (; i + 32 <= bytes; i += 32) {
+		const __m256i w = _mm256_loadu_si256((const __m256i*)(line + i));
+		const __m256i d = _mm256_xor_si256(w, key);
+		a = _mm256_add_epi64(a, _mm256_mul_epu32(d, _mm256_srli_epi64(d, 32)));
+		a = _mm256_add_epi64(a, _mm256_shuffle_epi32(w, _MM_SHUFFLE(1, 0, 3, 2)));
+		key = _mm256_add_epi64(key, step);
+	}
+
+	_mm256_storeu_si256((__m256i*)acc, a);
+	_mm256_storeu_si256((__m256i*)k, key);
+	return i;
+}
+
+#endif // SIMD_X86
+
+FrameChange::FrameChange()
+{
+	m_Level = ResolveSimdLevel(SIMD_AUTO);
+}
+
+void FrameChange::SetTileSize(unsigned int size)
+{
+	size = (size < 8) ? 8 : (size & ~7u);
+	if (size == m_TileSize)
+		return;
+	m_TileSize = size;
+	Reset();
+}
+
+void FrameChange::Reset()
+{
+	m_bValid = false;
+}
+
+bool FrameChange::Update(const unsigned char* frame, unsigned int width, unsigned int height, unsigned int pitch)
+{
+	if (!frame || width == 0 || height == 0)
+		return false;
+	if (pitch == 0)
+		pitch = width*4;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	// A new size changes every tile
+	if (width != m_Width || height != m_Height) {
+		m_Width = width;
+		m_Height = height;
+		m_TilesX = (width + m_TileSize - 1)/m_TileSize;
+		m_TilesY = (height + m_TileSize - 1)/m_TileSize;
+		m_Hash.assign((size_t)m_TilesX*m_TilesY, 0);
+		m_Changed.assign(m_Hash.size(), 1);
+		m_Acc.resize((size_t)m_TilesX*4);
+		m_bValid = false;
+	}
+
+	m_nChanged = 0;
+	uint64_t k[4];
+	for (unsigned int ty = 0; ty < m_TilesY; ty++) {
+
+		// Lanes for each tile of this tile line
+		memset(m_Acc.data(), 0, m_Acc.size()*sizeof(uint64_t));
+
+		const unsigned int y1 = (ty + 1)*m_TileSize < height ? (ty + 1)*m_TileSize : height;
+		for (unsigned int y = ty*m_TileSize; y < y1; y++) {
+			const unsigned char* line = frame + (size_t)y*pitch;
+			for (unsigned int tx = 0; tx < m_TilesX; tx++) {
+				const unsigned int x0 = tx*m_TileSize;
+				const unsigned int pixels = (x0 + m_TileSize <= width) ? m_TileSize : width - x0;
+				const unsigned char* segment = line + (size_t)x0*4;
+				const unsigned int bytes = pixels*4;
+				uint64_t* acc = m_Acc.data() + (size_t)tx*4;
+				LineKeys(y, k);
+				unsigned int i = 0;
+#ifdef SIMD_X86
+				if (m_Level == SIMD_AVX2)
+					i = AccumulateAVX2(segment, bytes, acc, k);
+				else if (m_Level == SIMD_SSE2)
+					i = AccumulateSSE2(segment, bytes, acc, k);
+				else
+#endif
+					i = AccumulateScalar(segment, bytes, acc, k);
+				// Remaining pixels
+				for (; i < bytes; i += 4) {
+					uint32_t p;
+					memcpy(&p, segment + i, 4);
+					acc[0] = (acc[0] + (p ^ k[0]))*0x9FB21C651E98DF25ULL;
+					k[0] += keystep;
+				}
+			}
+		}
+
+		// Compare the tile hashes with the last frame
+		for (unsigned int tx = 0; tx < m_TilesX; tx++) {
+			const size_t tile = (size_t)ty*m_TilesX + tx;
+			const uint64_t hash = Finish(m_Acc.data() + (size_t)tx*4);
+			const bool bChanged = !m_bValid || hash != m_Hash[tile];
+			m_Hash[tile] = hash;
+			m_Changed[tile] = bChanged ? 1 : 0;
+			if (bChanged) m_nChanged++;
+		}
+	}
+	m_bValid = true;
+
+	const double msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	m_Stats.frames++;
+	if (m_nChanged == 0) m_Stats.unchanged++;
+	m_Stats.mean += (msec - m_Stats.mean)/(double)m_Stats.frames;
+	if (msec > m_Stats.max) m_Stats.max = msec;
+
+	return m_nChanged > 0;
+}
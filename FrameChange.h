@@ -0,0 +1,95 @@
+//
+//		FrameChange
+//
+//		Detect which tiles of a BGRA frame have changed since the last frame.
+//
+//		Each tile is hashed with a 64 bit multiply-accumulate over 32 byte
+//		blocks, similar to XXH3, keyed by line and block position so that
+//		moved content is a change. The hash of every tile is compared with
+//		the previous frame. All pixels are read, so no change is missed
+//		apart from a hash collision.
+//
+//		The SSE2 and AVX2 kernels give the same hash as the scalar reference.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "CpuFeatures.h"
+
+// Frames compared and the time taken (msec)
+struct FrameChangeStats {
+	uint64_t frames = 0;
+	uint64_t unchanged = 0;
+	double mean = 0.0;
+	double max = 0.0;
+};
+
+class FrameChange {
+
+public:
+
+	FrameChange();
+
+	// Tile size in pixels, a multiple of 8. Default 64.
+	void SetTileSize(unsigned int size);
+	unsigned int GetTileSize() const { return m_TileSize; }
+
+	// Kernel instruction set, SIMD_AUTO for the best available
+	void SetSimdLevel(SimdLevel level) { m_Level = ResolveSimdLevel(level); }
+	SimdLevel GetSimdLevel() const { return m_Level; }
+
+	// The next frame is changed everywhere
+	void Reset();
+
+	// Hash the tiles of a frame and compare with the previous frame.
+	// Pitch is bytes per line, 0 for width*4.
+	// Returns true if any tile has changed.
+	bool Update(const unsigned char* frame, unsigned int width, unsigned int height, unsigned int pitch = 0);
+
+	// Tiles across and down for the last frame
+	unsigned int GetTilesX() const { return m_TilesX; }
+	unsigned int GetTilesY() const { return m_TilesY; }
+	// One byte for each tile, line by line, non-zero if changed by the last Update
+	const std::vector<unsigned char>& GetChanged() const { return m_Changed; }
+	unsigned int GetChangedCount() const { return m_nChanged; }
+
+	const FrameChangeStats& GetStats() const { return m_Stats; }
+	void ResetStats() { m_Stats = FrameChangeStats(); }
+
+private:
+
+	SimdLevel m_Level = SIMD_SCALAR;
+	unsigned int m_TileSize = 64;
+	unsigned int m_Width = 0;
+	unsigned int m_Height = 0;
+	unsigned int m_TilesX = 0;
+	unsigned int m_TilesY = 0;
+	std::vector<uint64_t> m_Acc;       // Four lanes for each tile across
+	std::vector<uint64_t> m_Hash;      // Tile hashes of the last frame
+	std::vector<unsigned char> m_Changed;
+	unsigned int m_nChanged = 0;
+	bool m_bValid = false;             // m_Hash holds the previous frame
+	FrameChangeStats m_Stats;
+
+};
@@ -0,0 +1,179 @@
+//
+//		FrameFit
+//
+//		Placement of a frame within a target window.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "FrameFit.h"
+#include <stdint.h>
+
+// a*b/c rounded
+static unsigned int MulDivRound(unsigned int a, unsigned int b, unsigned int c)
+{
+	if (c == 0) return 0;
+	return (unsigned int)(((uint64_t)a*(uint64_t)b + c/2)/c);
+}
+
+static unsigned int Min(unsigned int a, unsigned int b)
+{
+	return (a < b) ? a : b;
+}
+
+// Round down to an even size, at least 2
+static unsigned int Even(unsigned int n)
+{
+	n &= ~1u;
+	return (n < 2) ? 2 : n;
+}
+
+// Source wider than the target aspect ratio
+static bool IsWider(unsigned int srcWidth, unsigned int srcHeight, unsigned int dstWidth, unsigned int dstHeight)
+{
+	return (uint64_t)srcWidth*dstHeight > (uint64_t)dstWidth*srcHeight;
+}
+
+FitRect FitDestination(unsigned int srcWidth, unsigned int srcHeight,
+	unsigned int dstWidth, unsigned int dstHeight, FitMode mode)
+{
+	FitRect rect;
+	rect.width = (int)dstWidth;
+	rect.height = (int)dstHeight;
+	if (srcWidth == 0 || srcHeight == 0 || dstWidth == 0 || dstHeight == 0)
+		return rect;
+
+	switch (mode) {
+		case FIT_FIT:
+			if (IsWider(srcWidth, srcHeight, dstWidth, dstHeight))
+				rect.height = (int)MulDivRound(srcHeight, dstWidth, srcWidth);
+			else
+				rect.width = (int)MulDivRound(srcWidth, dstHeight, srcHeight);
+			break;
+		case FIT_CENTER:
+			rect.width = (int)Min(srcWidth, dstWidth);
+			rect.height = (int)Min(srcHeight, dstHeight);
+			break;
+		case FIT_FILL:    // Source is cropped to the whole target
+		case FIT_STRETCH:
+		default:
+			break;
+	}
+	rect.x = ((int)dstWidth - rect.width)/2;
+	rect.y = ((int)dstHeight - rect.height)/2;
+
+	return rect;
+}
+
+FitRect FitSource(unsigned int srcWidth, unsigned int srcHeight,
+	unsigned int dstWidth, unsigned int dstHeight, FitMode mode)
+{
+	FitRect rect;
+	rect.width = (int)srcWidth;
+	rect.height = (int)srcHeight;
+	if (srcWidth == 0 || srcHeight == 0 || dstWidth == 0 || dstHeight == 0)
+		return rect;
+
+	switch (mode) {
+		case FIT_FILL:
+			if (IsWider(srcWidth, srcHeight, dstWidth, dstHeight))
+				rect.width = (int)MulDivRound(srcHeight, dstWidth, dstHeight);
+			else
+				rect.height = (int)MulDivRound(srcWidth, dstHeight, dstWidth);
+			break;
+		case FIT_CENTER:
+			rect.width = (int)Min(srcWidth, dstWidth);
+			rect.height = (int)Min(srcHeight, dstHeight);
+			break;
+		case FIT_FIT:     // Whole source
+		case FIT_STRETCH:
+		default:
+			break;
+	}
+	rect.x = ((int)srcWidth - rect.width)/2;
+	rect.y = ((int)srcHeight - rect.height)/2;
+
+	return rect;
+}
+
+FitSize NegotiateFit(unsigned int srcWidth, unsigned int srcHeight,
+	unsigned int dstWidth, unsigned int dstHeight, FitMode mode)
+{
+	FitSize size;
+	size.scaleWidth = srcWidth;
+	size.scaleHeight = srcHeight;
+
+	if (srcWidth > 0 && srcHeight > 0 && dstWidth > 0 && dstHeight > 0) {
+		switch (mode) {
+			case FIT_STRETCH:
+				// Each axis independently, never larger than the source
+				size.scaleWidth = Min(srcWidth, dstWidth);
+				size.scaleHeight = Min(srcHeight, dstHeight);
+				break;
+			case FIT_FIT:
+				{
+					// Scale down to the fitted size
+					FitRect dst = FitDestination(srcWidth, srcHeight, dstWidth, dstHeight, mode);
+					if ((unsigned int)dst.width < srcWidth) {
+						size.scaleWidth = (unsigned int)dst.width;
+						size.scaleHeight = (unsigned int)dst.height;
+					}
+				}
+				break;
+			case FIT_FILL:
+				{
+					// Scale down so that the visible part matches the target
+					FitRect src = FitSource(srcWidth, srcHeight, dstWidth, dstHeight, mode);
+					if (dstWidth < (unsigned int)src.width) {
+						size.scaleWidth = MulDivRound(srcWidth, dstWidth, (unsigned int)src.width);
+						size.scaleHeight = MulDivRound(srcHeight, dstHeight, (unsigned int)src.height);
+					}
+				}
+				break;
+			case FIT_CENTER:
+			default:
+				break;
+		}
+	}
+
+	// Only the part shown in the target is produced
+	size.scaleWidth = Even(size.scaleWidth);
+	size.scaleHeight = Even(size.scaleHeight);
+	size.width = size.scaleWidth;
+	size.height = size.scaleHeight;
+	if ((mode == FIT_FILL || mode == FIT_CENTER) && dstWidth > 0 && dstHeight > 0) {
+		FitRect src = FitSource(size.scaleWidth, size.scaleHeight, dstWidth, dstHeight, mode);
+		size.width = Even((unsigned int)src.width);
+		size.height = Even((unsigned int)src.height);
+	}
+
+	return size;
+}
+
+const char* FitModeName(FitMode mode)
+{
+	switch (mode) {
+		case FIT_FIT:    return "Fit";
+		case FIT_FILL:   return "Fill";
+		case FIT_CENTER: return "Center";
+		case FIT_STRETCH:
+		default:         return "Stretch";
+	}
+}
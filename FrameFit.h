@@ -0,0 +1,75 @@
+//
+//		FrameFit
+//
+//		Placement of a frame within a target window.
+//
+//		Stretch - scale to the target size, ignoring aspect ratio
+//		Fit     - scale to fit inside the target, keeping aspect ratio
+//		Fill    - scale to cover the target, keeping aspect ratio, and crop
+//		Center  - no scaling, centred and cropped if larger than the target
+//
+//		NegotiateFit finds the smallest frame size a video source has to produce
+//		for the target so that no pixels are decoded that are not displayed.
+//		Sources are never scaled up. The presenter scales up if necessary.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+enum FitMode {
+	FIT_STRETCH = 0,
+	FIT_FIT,
+	FIT_FILL,
+	FIT_CENTER
+};
+
+// A rectangle in target or source pixels
+struct FitRect {
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
+// Size a source has to produce for a target
+struct FitSize {
+	unsigned int scaleWidth = 0;  // Scaled size of the whole source
+	unsigned int scaleHeight = 0;
+	unsigned int width = 0;       // Output size after cropping the scaled source
+	unsigned int height = 0;
+};
+
+// Destination rectangle of the source within the target,
+// clipped to the target for Fill and Center.
+FitRect FitDestination(unsigned int srcWidth, unsigned int srcHeight,
+	unsigned int dstWidth, unsigned int dstHeight, FitMode mode);
+
+// Part of the source drawn to the destination rectangle
+FitRect FitSource(unsigned int srcWidth, unsigned int srcHeight,
+	unsigned int dstWidth, unsigned int dstHeight, FitMode mode);
+
+// Output size for a source to produce for the target.
+// Sizes are even for chroma subsampled formats.
+FitSize NegotiateFit(unsigned int srcWidth, unsigned int srcHeight,
+	unsigned int dstWidth, unsigned int dstHeight, FitMode mode);
+
+// Mode name for menus and statistics
+const char* FitModeName(FitMode mode);
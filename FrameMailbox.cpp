@@ -0,0 +1,117 @@
+//
+//		FrameMailbox
+//
+//		Latest frame wins handoff of BGRA frames between two threads.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "FrameMailbox.h"
+
+FrameMailbox::FrameMailbox()
+{
+}
+
+void FrameMailbox::Reset()
+{
+	for (int i = 0; i < 3; i++) {
+		m_Slots[i].width = 0;
+		m_Slots[i].height = 0;
+		m_Slots[i].sequence = 0;
+	}
+	m_Back = 0;
+	m_Front = 1;
+	m_Middle.store(2, std::memory_order_relaxed);
+	m_Published.store(0, std::memory_order_relaxed);
+	m_Dropped.store(0, std::memory_order_relaxed);
+}
+
+void FrameMailbox::Release()
+{
+	Reset();
+	for (int i = 0; i < 3; i++)
+		m_Slots[i].pixels.reset();
+}
+
+//
+// Producer
+//
+
+unsigned char* FrameMailbox::BeginWrite(unsigned int width, unsigned int height)
+{
+	if (width == 0 || height == 0)
+		return nullptr;
+
+	Slot& slot = m_Slots[m_Back];
+	const size_t size = (size_t)width*(size_t)height*4;
+	if (slot.pixels.capacity() < size) {
+		slot.pixels.reset();
+		slot.pixels = FramePool::Shared().Acquire(size);
+		if (slot.pixels.empty())
+			return nullptr;
+	}
+	slot.width = width;
+	slot.height = height;
+
+	return slot.pixels.data();
+}
+
+void FrameMailbox::EndWrite()
+{
+	const uint64_t published = m_Published.load(std::memory_order_relaxed) + 1;
+	m_Slots[m_Back].sequence = published;
+
+	// The written slot becomes the middle and the old middle is written next
+	const unsigned int middle = m_Middle.exchange(m_Back | MAILBOX_NEW, std::memory_order_acq_rel);
+	m_Back = middle & ~MAILBOX_NEW;
+	if (middle & MAILBOX_NEW)
+		m_Dropped.fetch_add(1, std::memory_order_relaxed);
+
+	m_Published.store(published, std::memory_order_release);
+}
+
+//
+// Consumer
+//
+
+unsigned char* FrameMailbox::TakeLatest(unsigned int& width, unsigned int& height)
+{
+	if (!(m_Middle.load(std::memory_order_relaxed) & MAILBOX_NEW))
+		return nullptr;
+
+	// The held slot becomes the middle, to be written again
+	const unsigned int middle = m_Middle.exchange(m_Front, std::memory_order_acq_rel);
+	m_Front = middle & ~MAILBOX_NEW;
+
+	return GetHeld(width, height);
+}
+
+unsigned char* FrameMailbox::GetHeld(unsigned int& width, unsigned int& height)
+{
+	const Slot& slot = m_Slots[m_Front];
+	if (slot.sequence == 0) {
+		width = 0;
+		height = 0;
+		return nullptr;
+	}
+	width = slot.width;
+	height = slot.height;
+	return m_Slots[m_Front].pixels.data();
+}
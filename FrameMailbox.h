@@ -0,0 +1,103 @@
+//
+//		FrameMailbox
+//
+//		Latest frame wins handoff of BGRA frames between two threads.
+//
+//		Three slots are swapped between the producer, the consumer and a
+//		middle slot holding the newest published frame. Publishing a frame
+//		replaces the middle slot whether or not it has been taken, so the
+//		producer never waits for the consumer. The consumer swaps the middle
+//		slot for the one it holds when it is newer, so it never waits for the
+//		producer and always gets the newest complete frame. A slot is only
+//		written by the thread that owns it, so a frame is never torn.
+//
+//		Each slot keeps its own size, so the frame size can change between
+//		frames, for example when a Spout sender is resized. Slot buffers
+//		come from the shared FramePool and are only replaced by a larger
+//		one when a frame does not fit.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "FramePool.h"
+
+class FrameMailbox {
+
+public:
+
+	FrameMailbox();
+
+	// Discard all frames but keep the slots.
+	// Not thread safe. Call while the producer is stopped.
+	void Reset();
+	// Discard all frames and return the slot buffers to the pool
+	void Release();
+
+	//
+	// Producer
+	//
+
+	// Return the slot to write a frame of the given size to.
+	// Returns nullptr if the size is zero or the buffer cannot be allocated.
+	unsigned char* BeginWrite(unsigned int width, unsigned int height);
+	// Publish the frame written to the slot returned by BeginWrite
+	void EndWrite();
+
+	//
+	// Consumer
+	//
+
+	// Return the newest frame if it is newer than the one held and hold it
+	// until the next frame is taken. Returns nullptr if nothing new.
+	unsigned char* TakeLatest(unsigned int& width, unsigned int& height);
+	// The frame held by the consumer or nullptr
+	unsigned char* GetHeld(unsigned int& width, unsigned int& height);
+	// Number of the frame held, counting from 1, or 0 if none
+	uint64_t GetHeldSequence() const { return m_Slots[m_Front].sequence; }
+
+	// Frames published, and frames replaced before they were taken
+	uint64_t GetPublished() const { return m_Published.load(std::memory_order_acquire); }
+	uint64_t GetDropped() const { return m_Dropped.load(std::memory_order_relaxed); }
+
+private:
+
+	struct Slot {
+		FrameBuffer pixels;
+		unsigned int width = 0;
+		unsigned int height = 0;
+		uint64_t sequence = 0;
+	};
+
+	// The middle slot index with this bit set holds a frame not yet taken
+	static const unsigned int MAILBOX_NEW = 4;
+
+	Slot m_Slots[3];
+	unsigned int m_Back = 0;               // Owned by the producer
+	unsigned int m_Front = 1;              // Owned by the consumer
+	std::atomic<unsigned int> m_Middle{2}; // Exchanged by both
+	std::atomic<uint64_t> m_Published{0};
+	std::atomic<uint64_t> m_Dropped{0};
+
+};
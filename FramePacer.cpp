@@ -0,0 +1,149 @@
+//
+//		FramePacer
+//
+//		Presentation clock for video frames.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "FramePacer.h"
+#include <math.h>
+#include <chrono>
+
+FramePacer::FramePacer()
+{
+}
+
+void FramePacer::Start(double now, unsigned int num, unsigned int den)
+{
+	m_Num = (num > 0 && den > 0) ? num : 30;
+	m_Den = (num > 0 && den > 0) ? den : 1;
+	m_Time = now;
+	m_Position = 0.0;
+	m_Next = 0;
+	m_Repeated = -1;
+	m_Stats = FramePacerStats();
+	m_JitterSum = 0.0;
+	m_bRunning = true;
+}
+
+void FramePacer::Stop()
+{
+	m_bRunning = false;
+}
+
+void FramePacer::SetSpeed(double now, double speed)
+{
+	if (speed <= 0.0)
+		return;
+	if (m_bRunning) {
+		m_Position += (now - m_Time)*m_Speed;
+		m_Time = now;
+	}
+	m_Speed = speed;
+}
+
+int64_t FramePacer::GetDueFrame(double now) const
+{
+	const double position = m_Position + (now - m_Time)*m_Speed;
+	// Allow for rounding at the exact due time
+	return (int64_t)floor(position*(double)m_Num/(double)m_Den + 1e-6);
+}
+
+double FramePacer::GetFrameTime(int64_t frame) const
+{
+	const double position = (double)frame*(double)m_Den/(double)m_Num;
+	return m_Time + (position - m_Position)/m_Speed;
+}
+
+double FramePacer::GetWaitTime(double now) const
+{
+	const double wait = GetFrameTime(m_Next) - now;
+	return (wait > 0.0) ? wait : 0.0;
+}
+
+unsigned int FramePacer::Select(double now, unsigned int pending)
+{
+	if (!m_bRunning)
+		return 0;
+
+	const int64_t due = GetDueFrame(now);
+
+	// The next frame is not due yet
+	if (due < m_Next)
+		return 0;
+
+	// A frame is due but none has been decoded.
+	// Count each frame period that the current frame is repeated.
+	if (pending == 0) {
+		if (due > m_Repeated) {
+			const int64_t first = (m_Repeated >= m_Next) ? m_Repeated + 1 : m_Next;
+			m_Stats.repeated += (uint64_t)(due - first + 1);
+			m_Repeated = due;
+		}
+		return 0;
+	}
+
+	// Take frames up to the one due, as far as they are available
+	int64_t take = due - m_Next + 1;
+	if (take > (int64_t)pending)
+		take = (int64_t)pending;
+	const int64_t frame = m_Next + take - 1;
+	m_Next += take;
+
+	const double late = now - GetFrameTime(frame);
+	AddJitter(late);
+	m_Stats.presented++;
+	m_Stats.dropped += (uint64_t)(take - 1);
+
+	// Every frame available was taken and it is still late.
+	// Decoding has fallen behind, so continue from this frame
+	// instead of dropping all that follow to catch up.
+	if (frame < due && late > m_LateLimit)
+		Rebase(now, frame);
+
+	return (unsigned int)take;
+}
+
+void FramePacer::Rebase(double now, int64_t frame)
+{
+	m_Position = (double)frame*(double)m_Den/(double)m_Num;
+	m_Time = now;
+	m_Repeated = frame;
+	m_Stats.rebased++;
+}
+
+void FramePacer::AddJitter(double seconds)
+{
+	const double msec = seconds*1000.0;
+	const double n = (double)(m_Stats.presented + 1);
+	const double delta = msec - m_Stats.jitterMean;
+	m_Stats.jitterMean += delta/n;
+	m_JitterSum += delta*(msec - m_Stats.jitterMean);
+	m_Stats.jitterStd = (n > 1.0) ? sqrt(m_JitterSum/(n - 1.0)) : 0.0;
+	if (fabs(msec) > m_Stats.jitterMax)
+		m_Stats.jitterMax = fabs(msec);
+}
+
+double FramePacer::Now()
+{
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
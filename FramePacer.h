@@ -0,0 +1,117 @@
+//
+//		FramePacer
+//
+//		Presentation clock for video frames.
+//
+//		Frame n of the stream is due at n * den / num seconds of media time,
+//		where num/den is the stream frame rate. Media time runs from the time
+//		the first frame is shown at the playback speed. Frames are taken in
+//		order from a FrameRing and each one is shown when it is due.
+//
+//		  o Ahead - the next frame is not due yet and the current one stays.
+//		  o Behind - frames already past their time are dropped and only
+//		    the latest one due is shown.
+//		  o Underflow - no frame has been decoded when one is due and the
+//		    current frame is repeated. If the frame then shown is late by more
+//		    than the late limit, the clock is moved on to that frame rather than
+//		    dropping the frames that follow to catch up.
+//
+//		Times are seconds on any monotonic clock passed in by the caller.
+//		Now() returns the steady clock used by the application.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+
+// Pacing statistics since Start
+struct FramePacerStats {
+	uint64_t presented = 0;  // Frames shown
+	uint64_t dropped = 0;    // Frames skipped because they were late
+	uint64_t repeated = 0;   // Frame periods with no new frame decoded
+	uint64_t rebased = 0;    // Clock moved on after underflow
+	double jitterMean = 0.0; // Presentation time minus due time (msec)
+	double jitterStd = 0.0;  // Standard deviation (msec)
+	double jitterMax = 0.0;  // Largest absolute difference (msec)
+};
+
+class FramePacer {
+
+public:
+
+	FramePacer();
+
+	// Start the clock with frame 0 due at time now.
+	// num/den is the stream frame rate, e.g. 30000/1001.
+	void Start(double now, unsigned int num, unsigned int den);
+	void Stop();
+	bool IsRunning() const { return m_bRunning; }
+
+	// Playback speed multiplier, 1.0 for normal speed.
+	// The clock continues from the current position.
+	void SetSpeed(double now, double speed);
+	double GetSpeed() const { return m_Speed; }
+
+	// Lateness (seconds) after underflow before the clock is moved on
+	void SetLateLimit(double seconds) { m_LateLimit = seconds; }
+
+	// Decide which of the frames pending in the ring to take at time now.
+	// Returns the number to take, 0 to keep the current frame.
+	// All but the last taken are dropped and the last is shown.
+	unsigned int Select(double now, unsigned int pending);
+
+	// Index of the next frame to be taken from the ring
+	int64_t GetNextFrame() const { return m_Next; }
+	// Index of the frame due at time now
+	int64_t GetDueFrame(double now) const;
+	// Time that a frame is due
+	double GetFrameTime(int64_t frame) const;
+	// Seconds from now until the next frame is due, 0 if already due
+	double GetWaitTime(double now) const;
+
+	const FramePacerStats& GetStats() const { return m_Stats; }
+
+	// Monotonic clock in seconds
+	static double Now();
+
+private:
+
+	void Rebase(double now, int64_t frame);
+	void AddJitter(double seconds);
+
+	bool m_bRunning = false;
+	unsigned int m_Num = 30;
+	unsigned int m_Den = 1;
+	double m_Speed = 1.0;
+	double m_LateLimit = 0.1;
+
+	// Media time m_Position at clock time m_Time
+	double m_Time = 0.0;
+	double m_Position = 0.0;
+
+	int64_t m_Next = 0;      // Next frame in the ring
+	int64_t m_Repeated = -1; // Last due frame counted as repeated
+
+	FramePacerStats m_Stats;
+	double m_JitterSum = 0.0; // Running variance (Welford)
+
+};
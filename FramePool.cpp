@@ -0,0 +1,297 @@
+//
+//		FramePool
+//
+//		Pool of aligned frame buffers shared by the frame sources.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "FramePool.h"
+#include <stdlib.h>
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// Buffers are a whole number of these
+static const size_t POOL_PAGE = 4096;
+static const size_t POOL_ALIGN = 64;
+static const size_t POOL_LARGE_PAGE = 2*1024*1024;
+
+struct FramePoolBlock {
+	unsigned char* data = nullptr;
+	size_t capacity = 0;
+	bool bLargePage = false;     // From large pages
+	std::atomic<long> refs{0};
+	std::shared_ptr<FramePoolState> state;
+};
+
+struct FramePoolState {
+	std::mutex mutex;
+	std::vector<FramePoolBlock*> free; // Smallest first
+	bool bLargePages = false;
+	bool bClosed = false;        // The pool has been destroyed
+	FramePoolStats stats;
+
+	void Return(FramePoolBlock* block);
+};
+
+static void FreeBlock(FramePoolBlock* block)
+{
+#ifdef _WIN32
+	if (block->bLargePage)
+		VirtualFree(block->data, 0, MEM_RELEASE);
+	else
+		_aligned_free(block->data);
+#else
+	free(block->data);
+#endif
+	delete block;
+}
+
+//
+// FrameBuffer
+//
+
+FrameBuffer::FrameBuffer(const FrameBuffer& other) : m_Block(other.m_Block), m_Size(other.m_Size)
+{
+	if (m_Block)
+		m_Block->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+FrameBuffer::FrameBuffer(FrameBuffer&& other) noexcept : m_Block(other.m_Block), m_Size(other.m_Size)
+{
+	other.m_Block = nullptr;
+	other.m_Size = 0;
+}
+
+FrameBuffer& FrameBuffer::operator=(const FrameBuffer& other)
+{
+	if (this != &other) {
+		if (other.m_Block)
+			other.m_Block->refs.fetch_add(1, std::memory_order_relaxed);
+		reset();
+		m_Block = other.m_Block;
+		m_Size = other.m_Size;
+	}
+	return *this;
+}
+
+FrameBuffer& FrameBuffer::operator=(FrameBuffer&& other) noexcept
+{
+	if (this != &other) {
+		reset();
+		m_Block = other.m_Block;
+		m_Size = other.m_Size;
+		other.m_Block = nullptr;
+		other.m_Size = 0;
+	}
+	return *this;
+}
+
+FrameBuffer::~FrameBuffer()
+{
+	reset();
+}
+
+unsigned char* FrameBuffer::data() const
+{
+	return m_Block ? m_Block->data : nullptr;
+}
+
+size_t FrameBuffer::capacity() const
+{
+	return m_Block ? m_Block->capacity : 0;
+}
+
+long FrameBuffer::use_count() const
+{
+	return m_Block ? m_Block->refs.load(std::memory_order_relaxed) : 0;
+}
+
+void FrameBuffer::reset()
+{
+	FramePoolBlock* block = m_Block;
+	m_Block = nullptr;
+	m_Size = 0;
+	if (block && block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		// Keep the pool state until the block is back in it
+		std::shared_ptr<FramePoolState> state = block->state;
+		state->Return(block);
+	}
+}
+
+//
+// FramePool
+//
+
+FramePool::FramePool() : m_State(std::make_shared<FramePoolState>())
+{
+}
+
+FramePool::~FramePool()
+{
+	// Buffers still in use are freed when they are released
+	{
+		std::lock_guard<std::mutex> lock(m_State->mutex);
+		m_State->bClosed = true;
+	}
+	Trim();
+}
+
+FramePool& FramePool::Shared()
+{
+	static FramePool pool;
+	return pool;
+}
+
+void FramePoolState::Return(FramePoolBlock* block)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.used--;
+	stats.usedBytes -= block->capacity;
+	if (bClosed) {
+		// The pool has been destroyed
+		stats.buffers--;
+		stats.bytes -= block->capacity;
+		if (block->bLargePage)
+			stats.largePages--;
+		FreeBlock(block);
+		return;
+	}
+	free.insert(std::upper_bound(free.begin(), free.end(), block,
+		[](const FramePoolBlock* a, const FramePoolBlock* b) { return a->capacity < b->capacity; }), block);
+}
+
+FrameBuffer FramePool::Acquire(size_t size)
+{
+	if (size == 0)
+		return FrameBuffer();
+
+	FramePoolState& state = *m_State;
+	std::lock_guard<std::mutex> lock(state.mutex);
+
+	// The smallest free buffer that fits
+	FramePoolBlock* block = nullptr;
+	for (size_t i = 0; i < state.free.size(); i++) {
+		if (state.free[i]->capacity >= size) {
+			block = state.free[i];
+			state.free.erase(state.free.begin() + i);
+			state.stats.reuses++;
+			break;
+		}
+	}
+
+	if (!block) {
+		block = new FramePoolBlock;
+		block->capacity = (size + POOL_PAGE - 1)/POOL_PAGE*POOL_PAGE;
+#ifdef _WIN32
+		if (state.bLargePages) {
+			// Fails without the "Lock pages in memory" right
+			const size_t large = GetLargePageMinimum();
+			if (large > 0) {
+				const size_t capacity = (size + large - 1)/large*large;
+				block->data = (unsigned char*)VirtualAlloc(NULL, capacity, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+				if (block->data) {
+					block->capacity = capacity;
+					block->bLargePage = true;
+					state.stats.largePages++;
+				}
+			}
+		}
+		if (!block->data)
+			block->data = (unsigned char*)_aligned_malloc(block->capacity, state.bLargePages ? POOL_LARGE_PAGE : POOL_ALIGN);
+#else
+		if (state.bLargePages) {
+			block->capacity = (size + POOL_LARGE_PAGE - 1)/POOL_LARGE_PAGE*POOL_LARGE_PAGE;
+			void* data = nullptr;
+			if (posix_memalign(&data, POOL_LARGE_PAGE, block->capacity) == 0) {
+				block->data = (unsigned char*)data;
+#ifdef MADV_HUGEPAGE
+				// Transparent huge pages if enabled
+				if (madvise(data, block->capacity, MADV_HUGEPAGE) == 0) {
+					block->bLargePage = true;
+					state.stats.largePages++;
+				}
+#endif
+			}
+		}
+		else {
+			void* data = nullptr;
+			if (posix_memalign(&data, POOL_ALIGN, block->capacity) == 0)
+				block->data = (unsigned char*)data;
+		}
+#endif
+		if (!block->data) {
+			delete block;
+			return FrameBuffer();
+		}
+		block->state = m_State;
+		state.stats.allocations++;
+		state.stats.buffers++;
+		state.stats.bytes += block->capacity;
+		state.stats.peakBytes = std::max(state.stats.peakBytes, state.stats.bytes);
+	}
+
+	block->refs.store(1, std::memory_order_relaxed);
+	state.stats.used++;
+	state.stats.usedBytes += block->capacity;
+
+	return FrameBuffer(block, size);
+}
+
+void FramePool::SetLargePages(bool bLarge)
+{
+	std::lock_guard<std::mutex> lock(m_State->mutex);
+	m_State->bLargePages = bLarge;
+}
+
+bool FramePool::GetLargePages() const
+{
+	std::lock_guard<std::mutex> lock(m_State->mutex);
+	return m_State->bLargePages;
+}
+
+void FramePool::Trim()
+{
+	// Blocks hold the state, so free them after the lock is released
+	std::vector<FramePoolBlock*> blocks;
+	{
+		std::lock_guard<std::mutex> lock(m_State->mutex);
+		blocks.swap(m_State->free);
+		for (size_t i = 0; i < blocks.size(); i++) {
+			m_State->stats.buffers--;
+			m_State->stats.bytes -= blocks[i]->capacity;
+			if (blocks[i]->bLargePage)
+				m_State->stats.largePages--;
+		}
+	}
+	for (size_t i = 0; i < blocks.size(); i++)
+		FreeBlock(blocks[i]);
+}
+
+FramePoolStats FramePool::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_State->mutex);
+	return m_State->stats;
+}
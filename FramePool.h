@@ -0,0 +1,126 @@
+//
+//		FramePool
+//
+//		Pool of aligned frame buffers shared by the frame sources.
+//
+//		A buffer released by its last FrameBuffer goes back to the pool
+//		and is given out again for any frame that fits. New memory is only
+//		allocated when no free buffer is large enough, so switching between
+//		senders, videos and sizes reuses the same few buffers instead of
+//		freeing and allocating them each time.
+//
+//		Buffers are aligned to 64 bytes, the cache line size, and sized in
+//		whole pages. With large pages, buffers are allocated from large
+//		pages if the system allows it (on Windows, the user needs the
+//		"Lock pages in memory" right), and otherwise aligned to them.
+//
+//		FrameBuffer is a reference counted handle that can be passed
+//		between threads. The pool and its statistics are thread safe.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Memory held by a pool (bytes)
+struct FramePoolStats {
+	size_t buffers = 0;        // Buffers allocated
+	size_t bytes = 0;          // Memory allocated
+	size_t used = 0;           // Buffers in use
+	size_t usedBytes = 0;      // Memory of the buffers in use
+	size_t peakBytes = 0;      // Most memory allocated
+	uint64_t allocations = 0;  // Buffers allocated
+	uint64_t reuses = 0;       // Buffers given out again from the pool
+	size_t largePages = 0;     // Buffers allocated from large pages
+};
+
+class FramePool;
+struct FramePoolBlock;
+struct FramePoolState;
+
+class FrameBuffer {
+
+public:
+
+	FrameBuffer() {}
+	FrameBuffer(const FrameBuffer& other);
+	FrameBuffer(FrameBuffer&& other) noexcept;
+	FrameBuffer& operator=(const FrameBuffer& other);
+	FrameBuffer& operator=(FrameBuffer&& other) noexcept;
+	~FrameBuffer();
+
+	unsigned char* data() const;
+	// Size asked for
+	size_t size() const { return m_Size; }
+	// Size of the memory, at least size()
+	size_t capacity() const;
+	bool empty() const { return m_Block == nullptr; }
+	// References to the memory, including this one
+	long use_count() const;
+
+	// Give the memory back to the pool if this is the last reference
+	void reset();
+
+private:
+
+	friend class FramePool;
+
+	FrameBuffer(FramePoolBlock* block, size_t size) : m_Block(block), m_Size(size) {}
+
+	FramePoolBlock* m_Block = nullptr;
+	size_t m_Size = 0;
+
+};
+
+class FramePool {
+
+public:
+
+	FramePool();
+	~FramePool();
+
+	// Pool shared by all frame sources
+	static FramePool& Shared();
+
+	// Get a buffer of at least size bytes
+	FrameBuffer Acquire(size_t size);
+
+	// Allocate new buffers from large pages if possible
+	void SetLargePages(bool bLarge);
+	bool GetLargePages() const;
+
+	// Free the buffers not in use
+	void Trim();
+
+	FramePoolStats GetStats() const;
+
+private:
+
+	// Held by each buffer so that the pool can be destroyed before them
+	std::shared_ptr<FramePoolState> m_State;
+
+};
@@ -0,0 +1,175 @@
+//
+//		FrameReader
+//
+//		Background thread that reads raw BGRA frames from an FFmpeg
+//		output pipe into a FrameRing.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "FrameReader.h"
+#include "FrameStats.h"
+#include "FrameTrace.h"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#define PIPE_READ_MODE "rb"
+#else
+#define PIPE_READ_MODE "r"
+#endif
+
+FrameReader::FrameReader()
+{
+}
+
+FrameReader::~FrameReader()
+{
+	Close();
+}
+
+bool FrameReader::Open(const std::string& command, FrameRing* ring)
+{
+	Close();
+
+	if (command.empty() || !ring || ring->GetFrameSize() == 0)
+		return false;
+
+	m_pipe = popen(command.c_str(), PIPE_READ_MODE);
+	if (!m_pipe)
+		return false;
+
+	m_Command = command;
+	m_Ring = ring;
+	m_Restarts = 0;
+	m_LoopTiming.Reset();
+	m_bStop = false;
+	m_bFinished = false;
+	m_bOpen = true;
+	m_Thread = std::thread(&FrameReader::ReadFrames, this);
+
+	return true;
+}
+
+void FrameReader::Close()
+{
+	if (m_Thread.joinable()) {
+		m_bStop = true;
+		m_Ring->WakeWriter();
+		m_Thread.join();
+	}
+	// The thread closes the pipe on exit
+	if (m_pipe) {
+		pclose(m_pipe);
+		m_pipe = nullptr;
+	}
+	m_Ring = nullptr;
+	m_bOpen = false;
+}
+
+void FrameReader::SetConverter(size_t inputsize, std::function<void(const unsigned char* src, unsigned char* dst)> converter)
+{
+	m_Converter = converter;
+	if (m_Converter)
+		m_Staging.resize(inputsize);
+	else
+		m_Staging.clear();
+}
+
+// Read one complete frame. Returns false at the end of the stream.
+bool FrameReader::ReadFrame(unsigned char* buffer, size_t size)
+{
+	TRACE_SCOPE("fread", "read");
+	size_t total = 0;
+	while (total < size) {
+		size_t n = fread(buffer + total, 1, size - total, m_pipe);
+		if (n == 0)
+			return false;
+		total += n;
+	}
+	return true;
+}
+
+// Reader thread
+void FrameReader::ReadFrames()
+{
+	FrameTrace::Shared().SetThreadName("FFmpeg pipe reader");
+
+	// Size of the frames sent by the pipe
+	const bool bConvert = m_Converter && !m_Staging.empty();
+	const size_t framesize = bConvert ? m_Staging.size() : m_Ring->GetFrameSize();
+	unsigned int nFrames = 0; // Frames since the pipe was opened
+	bool bRestarted = false;  // The next frame follows a restart
+
+	while (!m_bStop) {
+
+		// Wait for a free slot.
+		// The consumer releases a slot when the next frame is due,
+		// so the ring is full while frames are decoded ahead of time.
+		m_LoopTiming.BeginWait();
+		unsigned char* slot = m_Ring->WaitWrite(m_bStop);
+		m_LoopTiming.EndWait();
+		if (!slot)
+			break;
+
+		// Includes the wait for FFmpeg to send the frame
+		FrameStageTimer read(STAGE_READ);
+		if (ReadFrame(bConvert ? m_Staging.data() : slot, framesize)) {
+			read.Stop();
+			if (bConvert) {
+				TRACE_SCOPE("Convert", "read");
+				FrameStageTimer convert(STAGE_CONVERT);
+				m_Converter(m_Staging.data(), slot);
+			}
+			// The first frame after a restart, or the first frame of
+			// the next loop of a looping command, is a loop boundary
+			const bool bLoopStart = (m_LoopTiming.GetFrameCount() == 0) || bRestarted
+				|| (m_LoopFrames > 0 && nFrames > 0 && (nFrames % m_LoopFrames) == 0);
+			if (m_FrameSink) m_FrameSink(slot, bLoopStart);
+			m_Ring->EndWrite();
+			m_LoopTiming.AddFrame(bLoopStart);
+			bRestarted = false;
+			nFrames++;
+			if (m_FrameCallback) m_FrameCallback();
+		}
+		else {
+			// End of the file
+			// Restart the same command and continue
+			read.Cancel();
+			pclose(m_pipe);
+			m_pipe = nullptr;
+			// Stop if the command produced no frames at all
+			if (m_bStop || nFrames == 0)
+				break;
+			nFrames = 0;
+			m_pipe = popen(m_Command.c_str(), PIPE_READ_MODE);
+			if (!m_pipe)
+				break;
+			m_Restarts++;
+			bRestarted = true;
+		}
+	}
+
+	if (m_pipe) {
+		pclose(m_pipe);
+		m_pipe = nullptr;
+	}
+	m_bFinished = true;
+}
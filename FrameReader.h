@@ -0,0 +1,107 @@
+//
+//		FrameReader
+//
+//		Background thread that reads raw BGRA frames from an FFmpeg
+//		output pipe into a FrameRing.
+//
+//		If the pipe carries another pixel format, such as YUV 4:2:0, a converter
+//		is set with the input frame size. Frames are read into a staging buffer
+//		and converted into the ring slot on the reader thread.
+//
+//		The reader thread owns the pipe. It is opened by Open so that
+//		failure can be reported, and closed by the thread when stopped.
+//		The render loop never waits on the pipe.
+//
+//		Loop transitions are timed with LoopTiming.
+//		The loop length in frames is set by SetLoopFrames. A restart of
+//		the command at end of file is also counted as a loop boundary.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <vector>
+#include "FrameRing.h"
+#include "LoopTiming.h"
+
+class FrameReader {
+
+public:
+
+	FrameReader();
+	~FrameReader();
+
+	// Open a pipe from the command line and start reading frames into the ring.
+	// The ring must be allocated for the frame size produced by the command.
+	bool Open(const std::string& command, FrameRing* ring);
+	// Stop the reader thread and close the pipe
+	void Close();
+	bool IsOpen() const { return m_bOpen; }
+	// The reader thread has stopped because the command failed
+	bool IsFinished() const { return m_bFinished.load(); }
+
+	// Called on the reader thread after each frame is published
+	void SetFrameCallback(std::function<void()> callback) { m_FrameCallback = callback; }
+	// Called on the reader thread with each frame before it is published.
+	// bLoopStart is true for the first frame of each loop.
+	void SetFrameSink(std::function<void(const unsigned char* frame, bool bLoopStart)> sink) { m_FrameSink = sink; }
+
+	// Convert input frames of the given size to the ring frame format.
+	// Set before Open. An empty function reads directly into the ring.
+	void SetConverter(size_t inputsize, std::function<void(const unsigned char* src, unsigned char* dst)> converter);
+
+	// Number of times the command was restarted at end of file
+	unsigned int GetRestarts() const { return m_Restarts.load(); }
+
+	// Frames in one loop of the video, 0 if not known
+	void SetLoopFrames(unsigned int nFrames) { m_LoopFrames = nFrames; }
+	// Loop boundary timing
+	const LoopTiming& GetLoopTiming() const { return m_LoopTiming; }
+
+private:
+
+	void ReadFrames();
+	bool ReadFrame(unsigned char* buffer, size_t size);
+
+	std::string m_Command;
+	FrameRing* m_Ring = nullptr;
+	FILE* m_pipe = nullptr;
+	std::thread m_Thread;
+	std::atomic<bool> m_bStop{false};
+	std::atomic<bool> m_bFinished{false};
+	std::atomic<unsigned int> m_Restarts{0};
+	bool m_bOpen = false;
+	std::function<void()> m_FrameCallback;
+	std::function<void(const unsigned char*, bool)> m_FrameSink;
+	std::function<void(const unsigned char*, unsigned char*)> m_Converter;
+	std::vector<unsigned char> m_Staging; // Input frame to convert
+
+	// Loop boundary timing
+	unsigned int m_LoopFrames = 0;
+	LoopTiming m_LoopTiming;
+
+};
@@ -0,0 +1,196 @@
+//
+//		FrameRing
+//
+//		Single producer / single consumer ring of preallocated BGRA frame slots.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "FrameRing.h"
+
+FrameRing::FrameRing()
+{
+}
+
+FrameRing::~FrameRing()
+{
+	Release();
+}
+
+bool FrameRing::Allocate(unsigned int width, unsigned int height, unsigned int nSlots)
+{
+	if (width == 0 || height == 0 || nSlots < 2)
+		return false;
+
+	Release();
+
+	m_Width = width;
+	m_Height = height;
+	m_FrameSize = (size_t)width*(size_t)height*4;
+	for (unsigned int i = 0; i < nSlots; i++) {
+		FrameBuffer buffer = FramePool::Shared().Acquire(m_FrameSize);
+		if (buffer.empty()) {
+			Release();
+			return false;
+		}
+		m_Slots.push_back(buffer.data());
+		m_Buffers.push_back(std::move(buffer));
+	}
+	Reset();
+
+	return true;
+}
+
+void FrameRing::Release()
+{
+	m_Slots.clear();
+	m_Buffers.clear();
+	m_Width = 0;
+	m_Height = 0;
+	m_FrameSize = 0;
+	Reset();
+}
+
+void FrameRing::Reset()
+{
+	m_Head.store(0, std::memory_order_relaxed);
+	m_Tail.store(0, std::memory_order_relaxed);
+	m_bHolding = false;
+	m_Dropped = 0;
+}
+
+//
+// Producer
+//
+
+unsigned char* FrameRing::BeginWrite()
+{
+	if (m_Slots.empty())
+		return nullptr;
+
+	const uint64_t head = m_Head.load(std::memory_order_relaxed);
+	const uint64_t tail = m_Tail.load(std::memory_order_acquire);
+	if (head - tail >= m_Slots.size())
+		return nullptr; // Full
+
+	return m_Slots[head % m_Slots.size()];
+}
+
+unsigned char* FrameRing::WaitWrite(const std::atomic<bool>& bStop)
+{
+	unsigned char* slot = BeginWrite();
+	if (slot || m_Slots.empty())
+		return slot;
+
+	std::unique_lock<std::mutex> lock(m_WaitMutex);
+	m_bWriterWaiting.store(true, std::memory_order_relaxed);
+	// The flag is seen by the consumer, or the slot it released is seen here
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	m_Space.wait(lock, [&]() { return bStop.load() || (slot = BeginWrite()) != nullptr; });
+	m_bWriterWaiting.store(false, std::memory_order_relaxed);
+	return bStop.load() ? nullptr : slot;
+}
+
+void FrameRing::WakeWriter()
+{
+	std::lock_guard<std::mutex> lock(m_WaitMutex);
+	m_Space.notify_one();
+}
+
+// Called by the consumer after a slot is released
+void FrameRing::SignalWriter()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_bWriterWaiting.load(std::memory_order_relaxed)) {
+		std::lock_guard<std::mutex> lock(m_WaitMutex);
+		m_Space.notify_one();
+	}
+}
+
+void FrameRing::EndWrite()
+{
+	const uint64_t head = m_Head.load(std::memory_order_relaxed);
+	m_Head.store(head + 1, std::memory_order_release);
+}
+
+//
+// Consumer
+//
+
+unsigned char* FrameRing::AcquireLatest()
+{
+	if (m_Slots.empty())
+		return nullptr;
+
+	const uint64_t head = m_Head.load(std::memory_order_acquire);
+	const uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+
+	// Nothing published, or only the frame already held
+	if (head == tail || (m_bHolding && head - tail == 1))
+		return nullptr;
+
+	// Frames skipped between the held frame and the newest
+	uint64_t skipped = head - 1 - tail;
+	if (m_bHolding && skipped > 0) skipped--;
+	m_Dropped += skipped;
+
+	// Release everything older than the newest frame and hold that
+	m_Tail.store(head - 1, std::memory_order_release);
+	m_bHolding = true;
+	SignalWriter();
+
+	return m_Slots[(head - 1) % m_Slots.size()];
+}
+
+unsigned char* FrameRing::AcquireNext()
+{
+	if (m_Slots.empty())
+		return nullptr;
+
+	const uint64_t head = m_Head.load(std::memory_order_acquire);
+	uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+	if (m_bHolding)
+		tail++; // The next frame after the one held
+
+	if (tail >= head)
+		return nullptr;
+
+	// Release the held frame to the producer
+	m_Tail.store(tail, std::memory_order_release);
+	m_bHolding = true;
+	SignalWriter();
+
+	return m_Slots[tail % m_Slots.size()];
+}
+
+unsigned char* FrameRing::GetHeld()
+{
+	if (!m_bHolding || m_Slots.empty())
+		return nullptr;
+	return m_Slots[m_Tail.load(std::memory_order_relaxed) % m_Slots.size()];
+}
+
+unsigned int FrameRing::GetPending() const
+{
+	const uint64_t head = m_Head.load(std::memory_order_acquire);
+	uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+	if (m_bHolding) tail++;
+	return (head > tail) ? (unsigned int)(head - tail) : 0;
+}
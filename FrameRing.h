@@ -0,0 +1,122 @@
+//
+//		FrameRing
+//
+//		Single producer / single consumer ring of preallocated BGRA frame slots.
+//
+//		The producer (a reader thread) fills free slots and publishes them in order.
+//		The consumer (the render loop) holds the slot it is presenting until a newer
+//		one has been published, so a slot is never overwritten while it is drawn.
+//		The consumer can take the newest frame, skipping older ones, or take
+//		frames in order to present them at their presentation time.
+//		Handoff between the two threads uses only atomic counters.
+//		A producer with no free slot sleeps on a condition variable until
+//		the consumer releases one. The consumer only takes the lock to
+//		signal it when the producer is waiting.
+//		Slots are taken from the shared FramePool and returned to it by Release.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <stddef.h>
+#include <stdint.h>
+#include "FramePool.h"
+
+class FrameRing {
+
+public:
+
+	FrameRing();
+	~FrameRing();
+
+	// Allocate slots for frames of the given size.
+	// Not thread safe. Call before the producer is started.
+	bool Allocate(unsigned int width, unsigned int height, unsigned int nSlots = 3);
+	// Free all slots
+	void Release();
+	// Discard all frames but keep the slots
+	void Reset();
+
+	unsigned int GetWidth() const { return m_Width; }
+	unsigned int GetHeight() const { return m_Height; }
+	size_t GetFrameSize() const { return m_FrameSize; }
+	unsigned int GetSlotCount() const { return (unsigned int)m_Slots.size(); }
+
+	//
+	// Producer
+	//
+
+	// Return the next free slot or nullptr if the ring is full
+	unsigned char* BeginWrite();
+	// Wait for the next free slot. Returns nullptr if bStop is set,
+	// after which WakeWriter must be called to end the wait.
+	unsigned char* WaitWrite(const std::atomic<bool>& bStop);
+	// End a WaitWrite in progress, once the producer's stop flag is set
+	void WakeWriter();
+	// Publish the slot returned by BeginWrite
+	void EndWrite();
+
+	//
+	// Consumer
+	//
+
+	// Return the newest published frame if it is newer than the one held.
+	// Older frames are released to the producer and the returned slot is
+	// held until a newer frame is acquired. Returns nullptr if nothing new.
+	unsigned char* AcquireLatest();
+	// Return the next frame in order and hold it, releasing the one held.
+	// Returns nullptr if no frame is pending.
+	unsigned char* AcquireNext();
+	// The frame currently held by the consumer or nullptr
+	unsigned char* GetHeld();
+	// Number of frames published but not yet acquired
+	unsigned int GetPending() const;
+
+	// Total frames published and frames released unseen
+	uint64_t GetPublished() const { return m_Head.load(std::memory_order_acquire); }
+	uint64_t GetDropped() const { return m_Dropped; }
+
+private:
+
+	std::vector<FrameBuffer> m_Buffers;
+	std::vector<unsigned char*> m_Slots;
+	unsigned int m_Width = 0;
+	unsigned int m_Height = 0;
+	size_t m_FrameSize = 0;
+
+	// Counters increase without wrapping (64 bit)
+	// Slots in [tail, head) are owned by the consumer.
+	std::atomic<uint64_t> m_Head{0}; // Frames published (producer)
+	std::atomic<uint64_t> m_Tail{0}; // Frames released (consumer)
+	bool m_bHolding = false;         // Consumer holds the slot at m_Tail
+	uint64_t m_Dropped = 0;          // Frames released without being acquired
+
+	// A producer waiting for a free slot
+	void SignalWriter();
+	std::mutex m_WaitMutex;
+	std::condition_variable m_Space;
+	std::atomic<bool> m_bWriterWaiting{false};
+
+};
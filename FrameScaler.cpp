@@ -0,0 +1,507 @@
+//
+//		FrameScaler
+//
+//		Scale part of a BGRA image to a rectangle of another.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "FrameScaler.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif
+
+#define SCALE_SHIFT 14
+#define SCALE_ONE (1 << SCALE_SHIFT)
+#define SCALE_ROUND (1 << (SCALE_SHIFT - 1))
+
+// Frames smaller than this are scaled on the calling thread
+#define SCALE_THREAD_PIXELS (256*256)
+
+// Two 16 bit weights packed for _mm_madd_epi16
+static inline int Pair16(int lo, int hi)
+{
+	return (int)(((unsigned int)hi << 16) | ((unsigned int)lo & 0xFFFF));
+}
+
+static inline unsigned char Clamp255(int value)
+{
+	return (unsigned char)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+//
+// Scalar reference.
+// Kernels process from offset i to the end.
+//
+
+// Weighted sum of source lines for each byte
+static void VerticalScalar(const unsigned char* const* lines, const int16_t* weights, int taps,
+	unsigned char* dst, unsigned int i, unsigned int bytes)
+{
+	for (; i < bytes; i++) {
+		int sum = SCALE_ROUND;
+		for (int j = 0; j < taps; j++)
+			sum += (int)lines[j][i]*weights[j];
+		dst[i] = Clamp255(sum >> SCALE_SHIFT);
+	}
+}
+
+// Weighted sum of source pixels for each destination pixel
+static void HorizontalScalar(const unsigned char* src, const int* start, const int16_t* weights, int taps,
+	unsigned char* dst, unsigned int x, unsigned int width)
+{
+	for (; x < width; x++) {
+		const unsigned char* pixels = src + (size_t)start[x]*4;
+		const int16_t* w = weights + (size_t)x*taps;
+		for (int c = 0; c < 4; c++) {
+			int sum = SCALE_ROUND;
+			for (int j = 0; j < taps; j++)
+				sum += (int)pixels[j*4 + c]*w[j];
+			dst[x*4 + c] = Clamp255(sum >> SCALE_SHIFT);
+		}
+	}
+}
+
+static void NearestScalar(const unsigned char* src, const int* start, unsigned char* dst,
+	unsigned int x, unsigned int width)
+{
+	const uint32_t* source = (const uint32_t*)src;
+	uint32_t* target = (uint32_t*)dst;
+	for (; x < width; x++)
+		target[x] = source[start[x]];
+}
+
+#ifdef SIMD_X86
+
+//
+// SSE2
+//
+// Lines are taken in pairs with their weights packed for _mm_madd_epi16,
+// which gives a*wa + b*wb in 32 bits for each byte.
+// A missing second line has weight 0.
+//
+
+static unsigned int VerticalSSE2(const unsigned char* const* lines, const int16_t* weights, int taps,
+	unsigned char* dst, unsigned int bytes)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi32(SCALE_ROUND);
+
+	unsigned int i = 0;
+	for (; i + 16 <= bytes; i += 16) {
+		__m128i acc0 = round;
+		__m128i acc1 = round;
+		__m128i acc2 = round;
+		__m128i acc3 = round;
+		for (int j = 0; j < taps; j += 2) {
+			const bool bPair = (j + 1 < taps);
+			const __m128i w = _mm_set1_epi32(Pair16(weights[j], bPair ? weights[j + 1] : 0));
+			const __m128i a = _mm_loadu_si128((const __m128i*)(lines[j] + i));
+			const __m128i b = bPair ? _mm_loadu_si128((const __m128i*)(lines[j + 1] + i)) : zero;
+			const __m128i a_lo = _mm_unpacklo_epi8(a, zero);
+			const __m128i a_hi = _mm_unpackhi_epi8(a, zero);
+			const __m128i b_lo = _mm_unpacklo_epi8(b, zero);
+			const __m128i b_hi = _mm_unpackhi_epi8(b, zero);
+			acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(a_lo, b_lo), w));
+			acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(a_lo, b_lo), w));
+			acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(a_hi, b_hi), w));
+			acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(a_hi, b_hi), w));
+		}
+		const __m128i lo = _mm_packs_epi32(_mm_srai_epi32(acc0, SCALE_SHIFT), _mm_srai_epi32(acc1, SCALE_SHIFT));
+		const __m128i hi = _mm_packs_epi32(_mm_srai_epi32(acc2, SCALE_SHIFT), _mm_srai_epi32(acc3, SCALE_SHIFT));
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+	}
+	return i;
+}
+
+// One destination pixel per iteration. Adjacent source pixels are
+// interleaved by channel so that each madd adds two taps.
+static unsigned int HorizontalSSE2(const unsigned char* src, const int* start, const int16_t* weights, int taps,
+	unsigned char* dst, unsigned int width)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi32(SCALE_ROUND);
+
+	for (unsigned int x = 0; x < width; x++) {
+		const unsigned char* pixels = src + (size_t)start[x]*4;
+		const int16_t* w = weights + (size_t)x*taps;
+		__m128i acc = round;
+		int j = 0;
+		for (; j + 1 < taps; j += 2) {
+			// b0 b1 g0 g1 r0 r1 a0 a1 as 16 bit
+			const __m128i p = _mm_loadl_epi64((const __m128i*)(pixels + j*4));
+			const __m128i p16 = _mm_unpacklo_epi8(_mm_unpacklo_epi8(p, _mm_srli_si128(p, 4)), zero);
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(p16, _mm_set1_epi32(Pair16(w[j], w[j + 1]))));
+		}
+		if (j < taps) {
+			const __m128i p = _mm_cvtsi32_si128(*(const int*)(pixels + j*4));
+			const __m128i p16 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(p, zero), zero);
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(p16, _mm_set1_epi32(Pair16(w[j], 0))));
+		}
+		const __m128i result = _mm_packs_epi32(_mm_srai_epi32(acc, SCALE_SHIFT), zero);
+		*(int*)(dst + x*4) = _mm_cvtsi128_si32(_mm_packus_epi16(result, zero));
+	}
+	return width;
+}
+
+//
+// AVX2
+//
+// Unpack and pack work within each 128 bit lane, so the
+// results come back in byte order after the final pack.
+//
+
+SIMD_TARGET_AVX2
+static unsigned int VerticalAVX2(const unsigned char* const* lines, const int16_t* weights, int taps,
+	unsigned char* dst, unsigned int bytes)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i round = _mm256_set1_epi32(SCALE_ROUND);
+
+	unsigned int i = 0;
+	for (; i + 32 <= bytes; i += 32) {
+		__m256i acc0 = round;
+		__m256i acc1 = round;
+		__m256i acc2 = round;
+		__m256i acc3 = round;
+		for (int j = 0; j < taps; j += 2) {
+			const bool bPair = (j + 1 < taps);
+			const __m256i w = _mm256_set1_epi32(Pair16(weights[j], bPair ? weights[j + 1] : 0));
+			const __m256i a = _mm256_loadu_si256((const __m256i*)(lines[j] + i));
+			const __m256i b = bPair ? _mm256_loadu_si256((const __m256i*)(lines[j + 1] + i)) : zero;
+			const __m256i a_lo = _mm256_unpacklo_epi8(a, zero);
+			const __m256i a_hi = _mm256_unpackhi_epi8(a, zero);
+			const __m256i b_lo = _mm256_unpacklo_epi8(b, zero);
+			const __m256i b_hi = _mm256_unpackhi_epi8(b, zero);
+			acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(a_lo, b_lo), w));
+			acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(a_lo, b_lo), w));
+			acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi16(a_hi, b_hi), w));
+			acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi16(a_hi, b_hi), w));
+		}
+		const __m256i lo = _mm256_packs_epi32(_mm256_srai_epi32(acc0, SCALE_SHIFT), _mm256_srai_epi32(acc1, SCALE_SHIFT));
+		const __m256i hi = _mm256_packs_epi32(_mm256_srai_epi32(acc2, SCALE_SHIFT), _mm256_srai_epi32(acc3, SCALE_SHIFT));
+		_mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+	}
+	return i;
+}
+
+// Eight pixels gathered by index
+SIMD_TARGET_AVX2
+static unsigned int NearestAVX2(const unsigned char* src, const int* start, unsigned char* dst, unsigned int width)
+{
+	unsigned int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		const __m256i index = _mm256_loadu_si256((const __m256i*)(start + x));
+		const __m256i pixels = _mm256_i32gather_epi32((const int*)src, index, 4);
+		_mm256_storeu_si256((__m256i*)(dst + x*4), pixels);
+	}
+	return x;
+}
+
+#endif // SIMD_X86
+
+FrameScaler::FrameScaler()
+{
+	m_Level = ResolveSimdLevel(SIMD_AUTO);
+	SetThreads(0);
+}
+
+FrameScaler::~FrameScaler()
+{
+	StopWorkers();
+}
+
+void FrameScaler::SetThreads(unsigned int threads)
+{
+	m_bCoreThreads = (threads == 0);
+	if (threads == 0)
+		threads = GetProcessCores();
+	StopWorkers();
+	m_nThreads = threads;
+	m_Lines.resize(m_nThreads);
+}
+
+void FrameScaler::StartWorkers()
+{
+	if (!m_Workers.empty() || m_nThreads < 2)
+		return;
+	m_bStop = false;
+	for (unsigned int i = 1; i < m_nThreads; i++)
+		m_Workers.emplace_back(&FrameScaler::Worker, this, i, m_Job);
+}
+
+void FrameScaler::StopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_bStop = true;
+	}
+	m_Start.notify_all();
+	for (auto& worker : m_Workers)
+		worker.join();
+	m_Workers.clear();
+}
+
+// Wait for each job and take bands until none are left
+void FrameScaler::Worker(unsigned int index, unsigned int job)
+{
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Start.wait(lock, [&] { return m_bStop || m_Job != job; });
+			if (m_bStop)
+				return;
+			job = m_Job;
+		}
+		WorkBands(m_Lines[index]);
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_nDone++;
+		}
+		m_Done.notify_one();
+	}
+}
+
+void FrameScaler::WorkBands(std::vector<unsigned char>& line)
+{
+	unsigned int band = m_NextBand.fetch_add(1);
+	while (band < m_nBands) {
+		ScaleBand(band, line);
+		band = m_NextBand.fetch_add(1);
+	}
+}
+
+// Weights for each destination pixel from the source pixels it covers
+void FrameScaler::MakeAxis(int srcLen, int dstLen, ScaleFilter filter, ScaleAxis& axis)
+{
+	if (axis.srcLen == srcLen && axis.dstLen == dstLen && axis.filter == filter)
+		return;
+
+	axis.srcLen = srcLen;
+	axis.dstLen = dstLen;
+	axis.filter = filter;
+	axis.start.assign(dstLen, 0);
+
+	const double scale = (double)srcLen/(double)dstLen;
+	const bool bArea = (filter == SCALE_AREA && scale > 1.0);
+
+	if (filter == SCALE_NEAREST || srcLen == dstLen) {
+		// One source pixel
+		axis.taps = 1;
+		axis.weights.assign(dstLen, (int16_t)SCALE_ONE);
+		for (int i = 0; i < dstLen; i++)
+			axis.start[i] = std::min(srcLen - 1, (int)(((double)i + 0.5)*scale));
+		return;
+	}
+
+	axis.taps = std::min(srcLen, bArea ? (int)ceil(scale) + 1 : 2);
+	axis.weights.assign((size_t)dstLen*axis.taps, 0);
+
+	std::vector<double> w(axis.taps);
+	for (int i = 0; i < dstLen; i++) {
+		int first = 0;
+		double cover[2]{};
+		if (bArea) {
+			// Source pixels covered by the destination pixel
+			first = (int)floor((double)i*scale);
+		}
+		else {
+			// Two source pixels either side of the centre
+			double centre = ((double)i + 0.5)*scale - 0.5;
+			centre = std::max(0.0, std::min((double)(srcLen - 1), centre));
+			first = std::min((int)floor(centre), srcLen - 2);
+			cover[1] = centre - (double)first;
+			cover[0] = 1.0 - cover[1];
+		}
+		const int start = std::max(0, std::min(first, srcLen - axis.taps));
+		for (int j = 0; j < axis.taps; j++) {
+			const int k = start + j;
+			if (bArea) {
+				const double left = std::max((double)k, (double)i*scale);
+				const double right = std::min((double)(k + 1), (double)(i + 1)*scale);
+				w[j] = (right > left) ? (right - left)/scale : 0.0;
+			}
+			else {
+				w[j] = (k == first) ? cover[0] : ((k == first + 1) ? cover[1] : 0.0);
+			}
+		}
+
+		// Fixed point, adjusted so that the weights sum to one
+		int16_t* weights = axis.weights.data() + (size_t)i*axis.taps;
+		int sum = 0;
+		int largest = 0;
+		for (int j = 0; j < axis.taps; j++) {
+			weights[j] = (int16_t)floor(w[j]*SCALE_ONE + 0.5);
+			sum += weights[j];
+			if (weights[j] > weights[largest]) largest = j;
+		}
+		weights[largest] = (int16_t)(weights[largest] + (SCALE_ONE - sum));
+		axis.start[i] = start;
+	}
+}
+
+bool FrameScaler::Scale(const unsigned char* src, unsigned int srcPitch, const FitRect& srcRect,
+	unsigned char* dst, unsigned int dstPitch, const FitRect& dstRect, ScaleFilter filter, const FitRect* region)
+{
+	if (!src || !dst || srcRect.width <= 0 || srcRect.height <= 0 || dstRect.width <= 0 || dstRect.height <= 0)
+		return false;
+
+	MakeAxis(srcRect.width, dstRect.width, filter, m_X);
+	MakeAxis(srcRect.height, dstRect.height, filter, m_Y);
+
+	// Part of the destination rectangle to scale
+	int x0 = 0;
+	int y0 = 0;
+	int x1 = dstRect.width;
+	int y1 = dstRect.height;
+	if (region) {
+		x0 = std::max(x0, region->x - dstRect.x);
+		y0 = std::max(y0, region->y - dstRect.y);
+		x1 = std::min(x1, region->x + region->width - dstRect.x);
+		y1 = std::min(y1, region->y + region->height - dstRect.y);
+		if (x1 <= x0 || y1 <= y0)
+			return true;
+	}
+
+	m_Src = src;
+	m_SrcPitch = srcPitch;
+	m_SrcRect = srcRect;
+	m_Dst = dst;
+	m_DstPitch = dstPitch;
+	m_DstRect = dstRect;
+	m_X0 = (unsigned int)x0;
+	m_X1 = (unsigned int)x1;
+	m_Y0 = (unsigned int)y0;
+	m_Y1 = (unsigned int)y1;
+
+	// Bands of lines taken by each thread in turn
+	const unsigned int lines = m_Y1 - m_Y0;
+	const bool bLarge = ((m_X1 - m_X0)*lines >= SCALE_THREAD_PIXELS);
+	// The affinity may have been set since the scaler was made
+	if (bLarge && m_bCoreThreads && m_Workers.empty()) {
+		m_nThreads = GetProcessCores();
+		m_Lines.resize(m_nThreads);
+	}
+	const bool bThreads = (bLarge && m_nThreads > 1);
+	const unsigned int bands = bThreads ? m_nThreads*4 : 1;
+	m_BandLines = (lines + bands - 1)/bands;
+	m_nBands = (lines + m_BandLines - 1)/m_BandLines;
+	m_NextBand = 0;
+
+	if (!bThreads) {
+		WorkBands(m_Lines[0]);
+		return true;
+	}
+
+	StartWorkers();
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_nDone = 0;
+		m_Job++;
+	}
+	m_Start.notify_all();
+	WorkBands(m_Lines[0]);
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Done.wait(lock, [&] { return m_nDone == (unsigned int)m_Workers.size(); });
+
+	return true;
+}
+
+// Scale the destination lines of one band
+void FrameScaler::ScaleBand(unsigned int band, std::vector<unsigned char>& line)
+{
+	const unsigned int y0 = m_Y0 + band*m_BandLines;
+	const unsigned int y1 = std::min(y0 + m_BandLines, m_Y1);
+	const unsigned int x0 = m_X0;
+	const unsigned int width = m_X1 - m_X0;
+	const unsigned char* src = m_Src + (size_t)m_SrcRect.x*4;
+	if (line.size() < (size_t)m_SrcRect.width*4)
+		line.resize((size_t)m_SrcRect.width*4);
+
+	// Source columns used by the destination columns
+	const unsigned int c0 = (unsigned int)m_X.start[x0];
+	const unsigned int c1 = (unsigned int)std::min(m_X.start[m_X1 - 1] + m_X.taps, m_SrcRect.width);
+	const unsigned int bytes = (c1 - c0)*4;
+
+	// Kernels index from column 0 of the source rectangle
+	// and from the destination column x0
+	const int* start = m_X.start.data() + x0;
+	const int16_t* xweights = m_X.weights.data() + (size_t)x0*m_X.taps;
+
+	std::vector<const unsigned char*> lines(m_Y.taps);
+	std::vector<const unsigned char*> columns(m_Y.taps);
+	const int taps = m_Y.taps;
+
+	for (unsigned int y = y0; y < y1; y++) {
+
+		unsigned char* dstline = m_Dst + (size_t)(m_DstRect.y + (int)y)*m_DstPitch + (size_t)m_DstRect.x*4;
+		unsigned char* dst = dstline + (size_t)x0*4;
+		for (int j = 0; j < taps; j++)
+			lines[j] = src + (size_t)(m_SrcRect.y + m_Y.start[y] + j)*m_SrcPitch;
+
+		if (m_X.filter == SCALE_NEAREST) {
+			unsigned int x = 0;
+#ifdef SIMD_X86
+			if (m_Level == SIMD_AVX2)
+				x = NearestAVX2(lines[0], start, dst, width);
+#endif
+			NearestScalar(lines[0], start, dst, x, width);
+			continue;
+		}
+
+		// Vertical filter into the line buffer, or directly to the
+		// destination if the width is not scaled. A line that is not
+		// scaled vertically is used as it is.
+		const unsigned char* filtered = lines[0];
+		if (!m_Y.IsIdentity()) {
+			unsigned char* out = m_X.IsIdentity() ? dstline : line.data();
+			const int16_t* weights = m_Y.weights.data() + (size_t)y*m_Y.taps;
+			for (int j = 0; j < taps; j++)
+				columns[j] = lines[j] + (size_t)c0*4;
+			unsigned int i = 0;
+#ifdef SIMD_X86
+			if (m_Level == SIMD_AVX2)
+				i = VerticalAVX2(columns.data(), weights, taps, out + (size_t)c0*4, bytes);
+			else if (m_Level == SIMD_SSE2)
+				i = VerticalSSE2(columns.data(), weights, taps, out + (size_t)c0*4, bytes);
+#endif
+			VerticalScalar(columns.data(), weights, taps, out + (size_t)c0*4, i, bytes);
+			if (out == dstline)
+				continue;
+			filtered = out;
+		}
+		else if (m_X.IsIdentity()) {
+			memcpy(dst, filtered + (size_t)x0*4, (size_t)width*4);
+			continue;
+		}
+
+		// Horizontal filter to the destination
+		unsigned int x = 0;
+#ifdef SIMD_X86
+		if (m_Level == SIMD_AVX2 || m_Level == SIMD_SSE2)
+			x = HorizontalSSE2(filtered, start, xweights, m_X.taps, dst, width);
+#endif
+		HorizontalScalar(filtered, start, xweights, m_X.taps, dst, x, width);
+	}
+}
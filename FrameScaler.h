@@ -0,0 +1,132 @@
+//
+//		FrameScaler
+//
+//		Scale part of a BGRA image to a rectangle of another.
+//
+//		  o SCALE_NEAREST  - nearest pixel, as GDI COLORONCOLOR
+//		  o SCALE_BILINEAR - two taps in each direction
+//		  o SCALE_AREA     - average of the source pixels covered by each
+//		                     destination pixel. Bilinear when enlarging.
+//
+//		Filters are separable with 14 bit fixed point weights. Each output line
+//		is filtered vertically from the source lines into a line buffer, then
+//		horizontally into the destination. The SSE2 and AVX2 kernels give the
+//		same result as the scalar reference.
+//
+//		Large frames are divided into bands of lines that are scaled on
+//		worker threads, each with its own line buffer.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "FrameFit.h"
+#include "CpuFeatures.h"
+
+enum ScaleFilter {
+	SCALE_NEAREST = 0,
+	SCALE_BILINEAR,
+	SCALE_AREA
+};
+
+class FrameScaler {
+
+public:
+
+	FrameScaler();
+	~FrameScaler();
+
+	// Threads used for large frames including the calling thread.
+	// 0 for one per core the process may run on, read when the
+	// workers are started.
+	void SetThreads(unsigned int threads);
+	unsigned int GetThreads() const { return m_nThreads; }
+
+	// Kernel instruction set, SIMD_AUTO for the best available
+	void SetSimdLevel(SimdLevel level) { m_Level = ResolveSimdLevel(level); }
+	SimdLevel GetSimdLevel() const { return m_Level; }
+
+	// Scale the source rectangle of a BGRA image to the destination
+	// rectangle of another. Pitches are bytes per line.
+	// If region is given, only that part of the destination rectangle
+	// is written, with the same result as scaling all of it.
+	bool Scale(const unsigned char* src, unsigned int srcPitch, const FitRect& srcRect,
+		unsigned char* dst, unsigned int dstPitch, const FitRect& dstRect, ScaleFilter filter,
+		const FitRect* region = nullptr);
+
+private:
+
+	// Source positions and weights for each destination pixel along one axis
+	struct ScaleAxis {
+		int srcLen = 0;
+		int dstLen = 0;
+		ScaleFilter filter = SCALE_NEAREST;
+		int taps = 0;                 // Weights for each destination pixel
+		std::vector<int> start;       // First source pixel, relative to the source rectangle
+		std::vector<int16_t> weights; // dstLen x taps, summing to 1 << 14
+		bool IsIdentity() const { return srcLen == dstLen; }
+	};
+
+	static void MakeAxis(int srcLen, int dstLen, ScaleFilter filter, ScaleAxis& axis);
+	void ScaleBand(unsigned int band, std::vector<unsigned char>& line);
+	void WorkBands(std::vector<unsigned char>& line);
+	void Worker(unsigned int index, unsigned int job);
+	void StartWorkers();
+	void StopWorkers();
+
+	SimdLevel m_Level = SIMD_SCALAR;
+	ScaleAxis m_X;
+	ScaleAxis m_Y;
+
+	// The current scale
+	const unsigned char* m_Src = nullptr;
+	unsigned int m_SrcPitch = 0;
+	FitRect m_SrcRect;
+	unsigned char* m_Dst = nullptr;
+	unsigned int m_DstPitch = 0;
+	FitRect m_DstRect;
+	unsigned int m_X0 = 0;   // Region of the destination rectangle
+	unsigned int m_X1 = 0;
+	unsigned int m_Y0 = 0;
+	unsigned int m_Y1 = 0;
+	unsigned int m_BandLines = 0;
+	unsigned int m_nBands = 0;
+	std::atomic<unsigned int> m_NextBand{0};
+
+	// Workers wait for the job number to change
+	unsigned int m_nThreads = 1;
+	bool m_bCoreThreads = false; // One thread per core of the process affinity
+	std::vector<std::thread> m_Workers;
+	std::vector<std::vector<unsigned char>> m_Lines; // Line buffer for each thread
+	std::mutex m_Mutex;
+	std::condition_variable m_Start;
+	std::condition_variable m_Done;
+	unsigned int m_Job = 0;
+	unsigned int m_nDone = 0;
+	bool m_bStop = false;
+
+};
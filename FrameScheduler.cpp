@@ -0,0 +1,152 @@
+//
+//		FrameScheduler
+//
+//		Decides when the render loop next has work to do.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "FrameScheduler.h"
+
+FrameScheduler::FrameScheduler()
+{
+	CancelAll();
+}
+
+void FrameScheduler::Schedule(ScheduleTask task, double time)
+{
+	m_Deadline[task] = time;
+	m_bScheduled[task] = true;
+}
+
+void FrameScheduler::Cancel(ScheduleTask task)
+{
+	m_Deadline[task] = 0.0;
+	m_bScheduled[task] = false;
+}
+
+void FrameScheduler::CancelAll()
+{
+	for (int i = 0; i < SCHEDULE_TASKS; i++)
+		Cancel((ScheduleTask)i);
+}
+
+bool FrameScheduler::IsScheduled(ScheduleTask task) const
+{
+	return m_bScheduled[task];
+}
+
+double FrameScheduler::GetDeadline(ScheduleTask task) const
+{
+	return m_Deadline[task];
+}
+
+void FrameScheduler::Wake()
+{
+	// Only the first wake before the next poll interrupts the wait
+	if (!m_bWoken.exchange(true, std::memory_order_acq_rel) && m_WakeCallback)
+		m_WakeCallback();
+}
+
+double FrameScheduler::GetWaitTime(double now) const
+{
+	if (m_bWoken.load(std::memory_order_acquire))
+		return 0.0;
+
+	double wait = -1.0;
+	for (int i = 0; i < SCHEDULE_TASKS; i++) {
+		if (!m_bScheduled[i])
+			continue;
+		const double remaining = (m_Deadline[i] > now) ? m_Deadline[i] - now : 0.0;
+		if (wait < 0.0 || remaining < wait)
+			wait = remaining;
+	}
+	return wait;
+}
+
+unsigned int FrameScheduler::Poll(double now)
+{
+	unsigned int due = 0;
+	m_PollTimes[m_Stats.polls % SCHEDULE_HISTORY] = now;
+	m_Stats.polls++;
+
+	if (m_bWoken.exchange(false, std::memory_order_acq_rel)) {
+		due |= SCHEDULE_WOKEN;
+		m_Stats.wakes++;
+	}
+
+	for (int i = 0; i < SCHEDULE_TASKS; i++) {
+		if (!m_bScheduled[i] || m_Deadline[i] > now)
+			continue;
+		due |= SCHEDULE_DUE(i);
+		const double late = (now - m_Deadline[i])*1000.0;
+		m_Stats.deadlines++;
+		m_Stats.lateMean += (late - m_Stats.lateMean)/(double)m_Stats.deadlines;
+		if (late > m_Stats.lateMax) m_Stats.lateMax = late;
+		Cancel((ScheduleTask)i);
+	}
+
+	if (due) {
+		m_DueTimes[m_Stats.due % SCHEDULE_HISTORY] = now;
+		m_Stats.due++;
+	}
+
+	return due;
+}
+
+double FrameScheduler::GetWakesPerMinute(double now) const
+{
+	return GetPerMinute(m_PollTimes, m_Stats.polls, now);
+}
+
+double FrameScheduler::GetRendersPerMinute(double now) const
+{
+	return GetPerMinute(m_DueTimes, m_Stats.due, now);
+}
+
+double FrameScheduler::GetPerMinute(const double* times, uint64_t total, double now)
+{
+	const uint64_t count = (total < SCHEDULE_HISTORY) ? total : SCHEDULE_HISTORY;
+	unsigned int recent = 0;
+	double oldest = now;
+	for (uint64_t i = 0; i < count; i++) {
+		const double time = times[(total - 1 - i) % SCHEDULE_HISTORY];
+		if (now - time > 60.0)
+			break;
+		recent++;
+		oldest = time;
+	}
+
+	// All of the history is in the last minute.
+	// Estimate the rate from the time it covers.
+	if (recent == SCHEDULE_HISTORY && now > oldest)
+		return (double)recent*60.0/(now - oldest);
+
+	return (double)recent;
+}
+
+void FrameScheduler::ResetStats()
+{
+	m_Stats = FrameSchedulerStats();
+	for (unsigned int i = 0; i < SCHEDULE_HISTORY; i++) {
+		m_PollTimes[i] = 0.0;
+		m_DueTimes[i] = 0.0;
+	}
+}
@@ -0,0 +1,122 @@
+//
+//		FrameScheduler
+//
+//		Decides when the render loop next has work to do.
+//
+//		Each kind of work has a deadline : the next video frame, the next
+//		slide, or the refresh of a frame already drawn. Work can also be
+//		requested at once with Wake, from any thread, for example when a
+//		frame has been received or the display has changed. The loop waits
+//		for messages until the earliest deadline or a wake, then renders
+//		only if something is due. With no deadline and no wake it waits
+//		without a time limit, so a still wallpaper uses no CPU.
+//
+//		Deadlines are one shot. Render sets the next ones for the mode shown.
+//
+//		The times of recent polls give the rate the loop is woken, for work
+//		or by messages that need none, and of those with work to do.
+//		Both are zero while a still wallpaper is shown and nothing happens.
+//
+//		Times are seconds on any monotonic clock passed in by the caller,
+//		so the scheduler can be run with a simulated clock.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+
+enum ScheduleTask {
+	SCHEDULE_FRAME = 0,  // A video frame is due
+	SCHEDULE_SLIDE,      // The next slide is due
+	SCHEDULE_REFRESH,    // The frame shown is drawn again
+	SCHEDULE_TASKS
+};
+
+// Bits returned by Poll
+#define SCHEDULE_DUE(task) (1u << (task))
+#define SCHEDULE_WOKEN     (1u << SCHEDULE_TASKS)
+
+// Wakes and how late deadlines were met
+struct FrameSchedulerStats {
+	uint64_t polls = 0;      // Times the loop woke
+	uint64_t due = 0;        // Polls with something due
+	uint64_t deadlines = 0;  // Deadlines met
+	uint64_t wakes = 0;      // Requests with Wake
+	double lateMean = 0.0;   // Time after the deadline it was met (msec)
+	double lateMax = 0.0;
+};
+
+class FrameScheduler {
+
+public:
+
+	FrameScheduler();
+
+	// Set the deadline for a task, replacing any earlier one
+	void Schedule(ScheduleTask task, double time);
+	// Remove the deadline for a task
+	void Cancel(ScheduleTask task);
+	void CancelAll();
+	bool IsScheduled(ScheduleTask task) const;
+	double GetDeadline(ScheduleTask task) const;
+
+	// Work is due now. Thread safe.
+	void Wake();
+	// Called by Wake to interrupt the wait, e.g. to set an event
+	void SetWakeCallback(std::function<void()> callback) { m_WakeCallback = callback; }
+
+	// Seconds to wait from now. 0 if something is due,
+	// negative if there is nothing to wait for.
+	double GetWaitTime(double now) const;
+
+	// Return the tasks due at time now and whether Wake was called.
+	// Deadlines returned are removed.
+	unsigned int Poll(double now);
+
+	// Polls in the minute before now, whether or not something was due.
+	// Poll is called each time the loop wakes.
+	double GetWakesPerMinute(double now) const;
+	// Polls with something due in the minute before now
+	double GetRendersPerMinute(double now) const;
+
+	const FrameSchedulerStats& GetStats() const { return m_Stats; }
+	void ResetStats();
+
+private:
+
+	// Polls in the minute before now from the times of the last polls
+	static const unsigned int SCHEDULE_HISTORY = 64;
+	static double GetPerMinute(const double* times, uint64_t total, double now);
+
+	// Times of the last polls, and of those with something due
+	double m_PollTimes[SCHEDULE_HISTORY]{};
+	double m_DueTimes[SCHEDULE_HISTORY]{};
+
+	double m_Deadline[SCHEDULE_TASKS];
+	bool m_bScheduled[SCHEDULE_TASKS];
+	std::atomic<bool> m_bWoken{false};
+	std::function<void()> m_WakeCallback;
+	FrameSchedulerStats m_Stats;
+
+};
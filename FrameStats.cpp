@@ -0,0 +1,312 @@
+//
+//		FrameStats
+//
+//		Time taken by each stage of the frame pipeline.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "FrameStats.h"
+#include <stdio.h>
+#include <chrono>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Largest duration recorded (usec), the end of the last bucket
+static const uint64_t histogrammax = ((uint64_t)2*HISTOGRAM_SUB_BUCKETS << (HISTOGRAM_BUCKETS/HISTOGRAM_SUB_BUCKETS - 2)) - 1;
+
+// Highest bit set, v > 0
+static unsigned int HighBit(uint32_t v)
+{
+#ifdef _MSC_VER
+	unsigned long index = 0;
+	_BitScanReverse(&index, v);
+	return (unsigned int)index;
+#else
+	return 31u - (unsigned int)__builtin_clz(v);
+#endif
+}
+
+//
+// FrameHistogram
+//
+
+FrameHistogram::FrameHistogram()
+{
+	Reset();
+}
+
+void FrameHistogram::Record(uint64_t usec)
+{
+	if (usec > histogrammax)
+		usec = histogrammax;
+	m_Buckets[GetBucket(usec)].fetch_add(1, std::memory_order_relaxed);
+	m_Sum.fetch_add(usec, std::memory_order_relaxed);
+	m_Count.fetch_add(1, std::memory_order_relaxed);
+	uint64_t max = m_Max.load(std::memory_order_relaxed);
+	while (usec > max && !m_Max.compare_exchange_weak(max, usec, std::memory_order_relaxed)) {}
+}
+
+void FrameHistogram::Reset()
+{
+	for (unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++)
+		m_Buckets[i].store(0, std::memory_order_relaxed);
+	m_Count.store(0, std::memory_order_relaxed);
+	m_Sum.store(0, std::memory_order_relaxed);
+	m_Max.store(0, std::memory_order_relaxed);
+}
+
+// Durations below 32 usec have a bucket each.
+// Above that, each power of two is divided into 16 buckets.
+unsigned int FrameHistogram::GetBucket(uint64_t usec)
+{
+	if (usec > histogrammax)
+		usec = histogrammax;
+	if (usec < HISTOGRAM_SUB_BUCKETS)
+		return (unsigned int)usec;
+	const unsigned int shift = HighBit((uint32_t)usec) - HISTOGRAM_SUB_BITS;
+	return (shift << HISTOGRAM_SUB_BITS) + (unsigned int)(usec >> shift);
+}
+
+uint64_t FrameHistogram::GetBucketLow(unsigned int bucket)
+{
+	const unsigned int octave = bucket >> HISTOGRAM_SUB_BITS;
+	if (octave <= 1)
+		return bucket;
+	const unsigned int shift = octave - 1;
+	return (uint64_t)(bucket - (shift << HISTOGRAM_SUB_BITS)) << shift;
+}
+
+uint64_t FrameHistogram::GetBucketWidth(unsigned int bucket)
+{
+	const unsigned int octave = bucket >> HISTOGRAM_SUB_BITS;
+	if (octave <= 1)
+		return 1;
+	return (uint64_t)1 << (octave - 1);
+}
+
+uint64_t FrameHistogram::GetBucketCount(unsigned int bucket) const
+{
+	if (bucket >= HISTOGRAM_BUCKETS)
+		return 0;
+	return m_Buckets[bucket].load(std::memory_order_relaxed);
+}
+
+uint64_t FrameHistogram::Snapshot(uint64_t* counts) const
+{
+	uint64_t total = 0;
+	for (unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		counts[i] = m_Buckets[i].load(std::memory_order_relaxed);
+		total += counts[i];
+	}
+	return total;
+}
+
+// The middle of the bucket holding the duration at the rank
+double FrameHistogram::Percentile(const uint64_t* counts, uint64_t total, double fraction)
+{
+	if (total == 0)
+		return 0.0;
+	uint64_t rank = (uint64_t)(fraction*(double)total + 0.5);
+	if (rank < 1) rank = 1;
+	if (rank > total) rank = total;
+	uint64_t sum = 0;
+	for (unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		sum += counts[i];
+		if (sum >= rank)
+			return ((double)GetBucketLow(i) + (double)(GetBucketWidth(i) - 1)/2.0)/1000.0;
+	}
+	return 0.0;
+}
+
+double FrameHistogram::GetPercentile(double fraction) const
+{
+	uint64_t counts[HISTOGRAM_BUCKETS];
+	const uint64_t total = Snapshot(counts);
+	const double max = (double)m_Max.load(std::memory_order_relaxed)/1000.0;
+	const double value = Percentile(counts, total, fraction);
+	return (value < max) ? value : max;
+}
+
+FrameHistogramStats FrameHistogram::GetStats() const
+{
+	FrameHistogramStats stats;
+	uint64_t counts[HISTOGRAM_BUCKETS];
+	const uint64_t total = Snapshot(counts);
+	if (total == 0)
+		return stats;
+
+	// The count, sum and buckets are not read at the same instant
+	// while frames are recorded, so the mean and maximum are limited
+	// to the buckets read.
+	const uint64_t count = m_Count.load(std::memory_order_relaxed);
+	const uint64_t sum = m_Sum.load(std::memory_order_relaxed);
+	stats.count = total;
+	stats.max = (double)m_Max.load(std::memory_order_relaxed)/1000.0;
+	stats.mean = (count > 0) ? (double)sum/(double)count/1000.0 : 0.0;
+	stats.p50 = Percentile(counts, total, 0.50);
+	stats.p90 = Percentile(counts, total, 0.90);
+	stats.p99 = Percentile(counts, total, 0.99);
+	stats.p999 = Percentile(counts, total, 0.999);
+	if (stats.p50 > stats.max) stats.p50 = stats.max;
+	if (stats.p90 > stats.max) stats.p90 = stats.max;
+	if (stats.p99 > stats.max) stats.p99 = stats.max;
+	if (stats.p999 > stats.max) stats.p999 = stats.max;
+	if (stats.mean > stats.max) stats.mean = stats.max;
+
+	return stats;
+}
+
+//
+// FrameStats
+//
+
+FrameStats::FrameStats()
+{
+}
+
+FrameStats& FrameStats::Shared()
+{
+	static FrameStats stats;
+	return stats;
+}
+
+uint64_t FrameStats::Ticks()
+{
+	using namespace std::chrono;
+	return (uint64_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void FrameStats::Record(FrameStage stage, uint64_t usec)
+{
+	if (stage < STAGE_COUNT && IsEnabled())
+		m_Stages[stage].Record(usec);
+}
+
+void FrameStats::Reset()
+{
+	for (int i = 0; i < STAGE_COUNT; i++)
+		m_Stages[i].Reset();
+}
+
+const char* FrameStats::StageName(FrameStage stage)
+{
+	switch (stage) {
+		case STAGE_RECEIVE:  return "Receive";
+		case STAGE_READ:     return "Read";
+		case STAGE_CONVERT:  return "Convert";
+		case STAGE_SCALE:    return "Scale";
+		case STAGE_PRESENT:  return "Present";
+		case STAGE_INTERVAL: return "Interval";
+		default:             return "Unknown";
+	}
+}
+
+std::string FrameStats::GetSummary() const
+{
+	std::string str;
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		const FrameHistogramStats stats = m_Stages[i].GetStats();
+		if (stats.count == 0)
+			continue;
+		char tmp[256]{};
+		snprintf(tmp, 256, "%s %.2f / %.2f / %.2f msec (max %.2f)\n",
+			StageName((FrameStage)i), stats.p50, stats.p90, stats.p99, stats.max);
+		str += tmp;
+	}
+	return str;
+}
+
+bool FrameStats::Save(const std::string& path) const
+{
+	FILE* file = nullptr;
+#ifdef _MSC_VER
+	if (fopen_s(&file, path.c_str(), "w") != 0)
+		file = nullptr;
+#else
+	file = fopen(path.c_str(), "w");
+#endif
+	if (!file)
+		return false;
+
+	fprintf(file, "# SpoutWallPaper frame statistics (msec)\n");
+	fprintf(file, "# stage, count, mean, p50, p90, p99, p99.9, max\n");
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		const FrameHistogramStats stats = m_Stages[i].GetStats();
+		fprintf(file, "%s, %llu, %.3f, %.3f, %.3f, %.3f, %.3f, %.3f\n",
+			StageName((FrameStage)i), (unsigned long long)stats.count,
+			stats.mean, stats.p50, stats.p90, stats.p99, stats.p999, stats.max);
+	}
+
+	// Buckets that have a count
+	fprintf(file, "\n# stage, bucket low (usec), bucket width (usec), count\n");
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		const FrameHistogram& histogram = m_Stages[i];
+		for (unsigned int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+			const uint64_t count = histogram.GetBucketCount(b);
+			if (count > 0) {
+				fprintf(file, "%s, %llu, %llu, %llu\n", StageName((FrameStage)i),
+					(unsigned long long)FrameHistogram::GetBucketLow(b),
+					(unsigned long long)FrameHistogram::GetBucketWidth(b),
+					(unsigned long long)count);
+			}
+		}
+	}
+
+	const bool bWritten = (ferror(file) == 0);
+	fclose(file);
+	return bWritten;
+}
+
+//
+// FrameStageTimer
+//
+
+FrameStageTimer::FrameStageTimer(FrameStage stage, FrameStats& stats)
+	: m_Stats(stats), m_Stage(stage)
+{
+	m_bActive = stats.IsEnabled();
+	if (m_bActive)
+		m_Start = FrameStats::Ticks();
+}
+
+void FrameStageTimer::Pause()
+{
+	if (m_bActive && m_Start > 0) {
+		m_Elapsed += FrameStats::Ticks() - m_Start;
+		m_Start = 0;
+	}
+}
+
+void FrameStageTimer::Resume()
+{
+	if (m_bActive && m_Start == 0)
+		m_Start = FrameStats::Ticks();
+}
+
+void FrameStageTimer::Stop()
+{
+	if (!m_bActive)
+		return;
+	Pause();
+	m_Stats.Record(m_Stage, m_Elapsed);
+	m_bActive = false;
+}
@@ -0,0 +1,166 @@
+//
+//		FrameStats
+//
+//		Time taken by each stage of the frame pipeline.
+//
+//		Each stage records its durations in a histogram of log-linear
+//		buckets, 16 to each power of two from 1 usec up to 134 seconds,
+//		so that a percentile is within about 3% of the true value.
+//		Recording is an atomic add to a bucket and can be done on any
+//		thread without a lock. Percentiles can be read on any thread
+//		while frames are recorded.
+//
+//		  o STAGE_RECEIVE  - ReceiveImage on the Spout reader thread
+//		  o STAGE_READ     - A frame read from the pipe, decoded or read from the cache
+//		  o STAGE_CONVERT  - yuv420p converted to BGRA or scaled by libswscale
+//		  o STAGE_SCALE    - Frame scaled to the desktop by the presenter
+//		  o STAGE_PRESENT  - Frame drawn to the desktop, including scaling
+//		  o STAGE_INTERVAL - Time between new frames taken by the render loop
+//
+//		The stages share one FrameStats so that all of them can be shown
+//		together. If disabled, a FrameStageTimer does not read the clock.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+enum FrameStage {
+	STAGE_RECEIVE = 0,
+	STAGE_READ,
+	STAGE_CONVERT,
+	STAGE_SCALE,
+	STAGE_PRESENT,
+	STAGE_INTERVAL,
+	STAGE_COUNT
+};
+
+// Histogram buckets
+#define HISTOGRAM_SUB_BITS 4 // 16 buckets for each power of two
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS (24 << HISTOGRAM_SUB_BITS) // Up to 2^27 usec
+
+// Summary of a histogram (msec)
+struct FrameHistogramStats {
+	uint64_t count = 0;
+	double mean = 0.0;
+	double p50 = 0.0;
+	double p90 = 0.0;
+	double p99 = 0.0;
+	double p999 = 0.0;
+	double max = 0.0;
+};
+
+class FrameHistogram {
+
+public:
+
+	FrameHistogram();
+
+	// Add a duration (usec)
+	void Record(uint64_t usec);
+	void Reset();
+
+	uint64_t GetCount() const { return m_Count.load(std::memory_order_relaxed); }
+	// Duration at or below which a fraction of the durations fall (msec)
+	double GetPercentile(double fraction) const;
+	FrameHistogramStats GetStats() const;
+
+	// Bucket of a duration and the range of durations in a bucket (usec)
+	static unsigned int GetBucket(uint64_t usec);
+	static uint64_t GetBucketLow(unsigned int bucket);
+	static uint64_t GetBucketWidth(unsigned int bucket);
+	// Count of a bucket
+	uint64_t GetBucketCount(unsigned int bucket) const;
+
+private:
+
+	// Copy of the bucket counts, taken without stopping the writers
+	uint64_t Snapshot(uint64_t* counts) const;
+	static double Percentile(const uint64_t* counts, uint64_t total, double fraction);
+
+	std::atomic<uint64_t> m_Buckets[HISTOGRAM_BUCKETS];
+	std::atomic<uint64_t> m_Count{0};
+	std::atomic<uint64_t> m_Sum{0}; // usec
+	std::atomic<uint64_t> m_Max{0}; // usec
+
+};
+
+class FrameStats {
+
+public:
+
+	FrameStats();
+
+	// Statistics shared by all stages of the pipeline
+	static FrameStats& Shared();
+
+	// Clock used for the durations (usec)
+	static uint64_t Ticks();
+
+	void Record(FrameStage stage, uint64_t usec);
+	void Reset();
+
+	void SetEnabled(bool bEnabled) { m_bEnabled.store(bEnabled, std::memory_order_relaxed); }
+	bool IsEnabled() const { return m_bEnabled.load(std::memory_order_relaxed); }
+
+	const FrameHistogram& GetHistogram(FrameStage stage) const { return m_Stages[stage]; }
+	static const char* StageName(FrameStage stage);
+
+	// One line for each stage recorded (msec)
+	std::string GetSummary() const;
+	// Write the summary and the buckets of each stage to a text file
+	bool Save(const std::string& path) const;
+
+private:
+
+	FrameHistogram m_Stages[STAGE_COUNT];
+	std::atomic<bool> m_bEnabled{true};
+
+};
+
+// Records the time from construction to destruction for a stage.
+// Stop() records early and Cancel() records nothing. Pause() and
+// Resume() leave out work that is not part of the stage.
+class FrameStageTimer {
+
+public:
+
+	FrameStageTimer(FrameStage stage, FrameStats& stats = FrameStats::Shared());
+	~FrameStageTimer() { Stop(); }
+
+	void Pause();
+	void Resume();
+	void Stop();
+	void Cancel() { m_bActive = false; }
+
+private:
+
+	FrameStats& m_Stats;
+	FrameStage m_Stage;
+	uint64_t m_Start = 0;   // Start of the running part, 0 if paused
+	uint64_t m_Elapsed = 0; // Time before the last pause
+	bool m_bActive = false; // Recording
+
+};
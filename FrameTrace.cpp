@@ -0,0 +1,304 @@
+//
+//		FrameTrace
+//
+//		Timeline of the render loop and the frame threads for profiling.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "FrameTrace.h"
+#include "FrameStats.h"
+#include <stdio.h>
+#include <algorithm>
+
+// Duration of an instant event
+static const uint64_t traceinstant = ~(uint64_t)0;
+
+// One event in a ring buffer.
+// The sequence is odd while the owner thread writes the event, so that
+// a copy taken while it changes is detected and left out.
+struct TraceEvent {
+	std::atomic<uint64_t> sequence{0}; // 0 if never written
+	std::atomic<uint64_t> start{0};    // usec, FrameStats clock
+	std::atomic<uint64_t> duration{0}; // usec
+	std::atomic<const char*> name{nullptr};
+	std::atomic<const char*> category{nullptr};
+	std::atomic<uint32_t> thread{0};
+};
+
+struct TraceBuffer {
+	std::unique_ptr<TraceEvent[]> events;
+	size_t capacity = 0;
+	std::atomic<uint64_t> next{0};     // Events written, only changed by the owner
+	std::atomic<bool> bInUse{false};   // Owned by a running thread
+	uint32_t thread = 0;               // Number of the owner thread
+	std::string name;                  // Name of the owner thread
+};
+
+// A copy of an event for saving
+struct TraceRecord {
+	uint64_t start;
+	uint64_t duration;
+	const char* name;
+	const char* category;
+	uint32_t thread;
+};
+
+// The buffer of this thread, given back when the thread ends
+struct TraceThread {
+	std::shared_ptr<TraceBuffer> buffer;
+	const FrameTrace* owner = nullptr;
+	std::string name; // Given to a buffer when it is taken
+	~TraceThread() { if (buffer) buffer->bInUse.store(false); }
+};
+static thread_local TraceThread tracethread;
+
+FrameTrace::FrameTrace()
+{
+}
+
+FrameTrace::~FrameTrace()
+{
+}
+
+FrameTrace& FrameTrace::Shared()
+{
+	static FrameTrace trace;
+	return trace;
+}
+
+void FrameTrace::SetEnabled(bool bEnabled)
+{
+	if (bEnabled && !IsEnabled()) {
+		// Events from before are left out of the new trace
+		m_Origin.store(FrameStats::Ticks());
+		m_Events.store(0);
+		m_Overwritten.store(0);
+	}
+	m_bEnabled.store(bEnabled);
+}
+
+void FrameTrace::SetCapacity(size_t events)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Capacity = (events > 0) ? events : 1;
+}
+
+TraceBuffer* FrameTrace::GetBuffer()
+{
+	if (tracethread.owner == this)
+		return tracethread.buffer.get();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// A buffer left by a thread that has ended, or a new one
+	std::shared_ptr<TraceBuffer> buffer;
+	for (size_t i = 0; i < m_Buffers.size() && !buffer; i++) {
+		bool bInUse = false;
+		if (m_Buffers[i]->bInUse.compare_exchange_strong(bInUse, true))
+			buffer = m_Buffers[i];
+	}
+	if (!buffer) {
+		buffer = std::make_shared<TraceBuffer>();
+		buffer->events.reset(new TraceEvent[m_Capacity]);
+		buffer->capacity = m_Capacity;
+		buffer->bInUse.store(true);
+		m_Buffers.push_back(buffer);
+	}
+	buffer->thread = m_NextThread++;
+	buffer->name = tracethread.name;
+
+	if (tracethread.buffer)
+		tracethread.buffer->bInUse.store(false);
+	tracethread.buffer = buffer;
+	tracethread.owner = this;
+	return buffer.get();
+}
+
+void FrameTrace::Record(const char* name, const char* category, uint64_t start, uint64_t duration)
+{
+	TraceBuffer* buffer = GetBuffer();
+	const uint64_t n = buffer->next.load(std::memory_order_relaxed);
+	TraceEvent& event = buffer->events[n % buffer->capacity];
+
+	// The oldest event is lost if it is part of this trace
+	if (event.sequence.load(std::memory_order_relaxed) != 0
+		&& event.start.load(std::memory_order_relaxed) >= m_Origin.load(std::memory_order_relaxed))
+		m_Overwritten.fetch_add(1, std::memory_order_relaxed);
+
+	event.sequence.store(2*n + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	event.start.store(start, std::memory_order_relaxed);
+	event.duration.store(duration, std::memory_order_relaxed);
+	event.name.store(name, std::memory_order_relaxed);
+	event.category.store(category, std::memory_order_relaxed);
+	event.thread.store(buffer->thread, std::memory_order_relaxed);
+	event.sequence.store(2*n + 2, std::memory_order_release);
+
+	buffer->next.store(n + 1, std::memory_order_relaxed);
+	m_Events.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameTrace::Complete(const char* name, const char* category, uint64_t start)
+{
+	if (!IsEnabled())
+		return;
+	const uint64_t end = FrameStats::Ticks();
+	Record(name, category, start, (end > start) ? end - start : 0);
+}
+
+void FrameTrace::Instant(const char* name, const char* category)
+{
+	if (!IsEnabled())
+		return;
+	Record(name, category, FrameStats::Ticks(), traceinstant);
+}
+
+void FrameTrace::SetThreadName(const char* name)
+{
+	tracethread.name = name ? name : "";
+	// Renamed after it has recorded
+	if (tracethread.owner == this && tracethread.buffer) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		tracethread.buffer->name = tracethread.name;
+	}
+}
+
+// Names are string literals but are escaped in case
+static void WriteString(FILE* file, const char* str)
+{
+	fputc('"', file);
+	for (const char* c = str ? str : ""; *c; c++) {
+		if (*c == '"' || *c == '\\')
+			fputc('\\', file);
+		if ((unsigned char)*c >= 0x20)
+			fputc(*c, file);
+	}
+	fputc('"', file);
+}
+
+bool FrameTrace::Save(const std::string& path) const
+{
+	// Copies of the events of this trace
+	std::vector<TraceRecord> records;
+	std::vector<std::pair<uint32_t, std::string>> names;
+	std::vector<std::shared_ptr<TraceBuffer>> buffers;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		buffers = m_Buffers;
+		for (size_t i = 0; i < m_Buffers.size(); i++) {
+			if (!m_Buffers[i]->name.empty())
+				names.push_back(std::make_pair(m_Buffers[i]->thread, m_Buffers[i]->name));
+		}
+	}
+	const uint64_t origin = m_Origin.load();
+	for (size_t i = 0; i < buffers.size(); i++) {
+		const TraceBuffer& buffer = *buffers[i];
+		for (size_t e = 0; e < buffer.capacity; e++) {
+			const TraceEvent& event = buffer.events[e];
+			const uint64_t sequence = event.sequence.load(std::memory_order_acquire);
+			if (sequence == 0 || (sequence & 1) != 0)
+				continue;
+			TraceRecord record;
+			record.start = event.start.load(std::memory_order_relaxed);
+			record.duration = event.duration.load(std::memory_order_relaxed);
+			record.name = event.name.load(std::memory_order_relaxed);
+			record.category = event.category.load(std::memory_order_relaxed);
+			record.thread = event.thread.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			// Written again while it was copied
+			if (event.sequence.load(std::memory_order_relaxed) != sequence)
+				continue;
+			if (record.start >= origin)
+				records.push_back(record);
+		}
+	}
+	std::sort(records.begin(), records.end(), [](const TraceRecord& a, const TraceRecord& b) {
+		return a.start < b.start;
+	});
+
+	FILE* file = nullptr;
+#ifdef _MSC_VER
+	if (fopen_s(&file, path.c_str(), "w") != 0)
+		file = nullptr;
+#else
+	file = fopen(path.c_str(), "w");
+#endif
+	if (!file)
+		return false;
+
+	// Times are usec from the start of the trace
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(file, "{\"ph\":\"M\",\"pid\":1,\"tid\":0,\"name\":\"process_name\",\"args\":{\"name\":\"SpoutWallPaper\"}}");
+	for (size_t i = 0; i < names.size(); i++) {
+		fprintf(file, ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", names[i].first);
+		WriteString(file, names[i].second.c_str());
+		fprintf(file, "}}");
+	}
+	for (size_t i = 0; i < records.size(); i++) {
+		const TraceRecord& record = records[i];
+		fprintf(file, ",\n{\"name\":");
+		WriteString(file, record.name);
+		fprintf(file, ",\"cat\":");
+		WriteString(file, record.category);
+		if (record.duration == traceinstant) {
+			fprintf(file, ",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%llu}",
+				record.thread, (unsigned long long)(record.start - origin));
+		}
+		else {
+			fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%llu}",
+				record.thread, (unsigned long long)(record.start - origin), (unsigned long long)record.duration);
+		}
+	}
+	fprintf(file, "\n]}\n");
+
+	const bool bWritten = (ferror(file) == 0);
+	fclose(file);
+	return bWritten;
+}
+
+FrameTraceStats FrameTrace::GetStats() const
+{
+	FrameTraceStats stats;
+	stats.events = m_Events.load();
+	stats.overwritten = m_Overwritten.load();
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	stats.buffers = m_Buffers.size();
+	for (size_t i = 0; i < m_Buffers.size(); i++)
+		stats.bytes += m_Buffers[i]->capacity*sizeof(TraceEvent);
+	return stats;
+}
+
+//
+// TraceScope
+//
+
+TraceScope::TraceScope(const char* name, const char* category)
+	: m_Name(name), m_Category(category)
+{
+	if (FrameTrace::Shared().IsEnabled())
+		m_Start = FrameStats::Ticks();
+}
+
+TraceScope::~TraceScope()
+{
+	if (m_Start > 0)
+		FrameTrace::Shared().Complete(m_Name, m_Category, m_Start);
+}
@@ -0,0 +1,140 @@
+//
+//		FrameTrace
+//
+//		Timeline of the render loop and the frame threads for profiling.
+//
+//		Scoped events are recorded into a ring buffer for each thread and
+//		saved as Chrome trace-event JSON that can be opened in Perfetto
+//		(ui.perfetto.dev) or chrome://tracing.
+//
+//		Each thread writes only to its own buffer, so recording needs no
+//		lock. When a buffer is full the oldest events are overwritten,
+//		so memory is limited to the buffer size for each thread that has
+//		recorded. A buffer is reused by a new thread after its thread ends.
+//		A buffer is only allocated when its thread first records an event,
+//		and thread names are kept by each thread until then, so threads
+//		that are named but never traced use no buffer.
+//		Events can be saved on any thread while they are recorded.
+//
+//		Tracing is off until enabled. When it is off, a TraceScope only
+//		checks a flag.
+//
+//		  TRACE_SCOPE("Render", "render");          // Time to the end of the scope
+//		  TRACE_INSTANT("Slide", "mode");           // A point in time
+//
+//		Names and categories must be string literals, because only the
+//		pointer is kept.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(name, category) TraceScope TRACE_CONCAT(tracescope, __LINE__)(name, category)
+#define TRACE_INSTANT(name, category) FrameTrace::Shared().Instant(name, category)
+
+// Events kept for each thread unless set otherwise
+#define TRACE_DEFAULT_CAPACITY 16384
+
+struct TraceBuffer;
+
+struct FrameTraceStats {
+	uint64_t events = 0;      // Events recorded since tracing was enabled
+	uint64_t overwritten = 0; // Oldest events lost because a buffer was full
+	size_t buffers = 0;       // Thread buffers allocated
+	size_t bytes = 0;         // Memory of the buffers
+};
+
+class FrameTrace {
+
+public:
+
+	FrameTrace();
+	~FrameTrace();
+
+	// Trace shared by all threads
+	static FrameTrace& Shared();
+
+	// Start a new trace or stop recording.
+	// Events already recorded are kept until the next start.
+	void SetEnabled(bool bEnabled);
+	bool IsEnabled() const { return m_bEnabled.load(std::memory_order_relaxed); }
+
+	// Events kept for each thread.
+	// Used for buffers allocated after it is set.
+	void SetCapacity(size_t events);
+	size_t GetCapacity() const { return m_Capacity; }
+
+	// A scope that ended now and started at start (FrameStats::Ticks)
+	void Complete(const char* name, const char* category, uint64_t start);
+	// A point in time
+	void Instant(const char* name, const char* category);
+
+	// Name shown for the calling thread.
+	// Does not allocate a buffer for the thread.
+	void SetThreadName(const char* name);
+
+	// Write the events recorded as Chrome trace-event JSON
+	bool Save(const std::string& path) const;
+
+	FrameTraceStats GetStats() const;
+
+private:
+
+	void Record(const char* name, const char* category, uint64_t start, uint64_t duration);
+	// Buffer of the calling thread, allocated on first use
+	TraceBuffer* GetBuffer();
+
+	std::atomic<bool> m_bEnabled{false};
+	std::atomic<uint64_t> m_Origin{0}; // When tracing was last enabled (usec)
+	size_t m_Capacity = TRACE_DEFAULT_CAPACITY;
+	uint32_t m_NextThread = 1;         // Thread numbers shown in the trace
+	std::atomic<uint64_t> m_Events{0};
+	std::atomic<uint64_t> m_Overwritten{0};
+	mutable std::mutex m_Mutex;        // Buffer list and thread names
+	std::vector<std::shared_ptr<TraceBuffer>> m_Buffers;
+
+};
+
+// Records the time from construction to destruction if tracing is enabled
+class TraceScope {
+
+public:
+
+	TraceScope(const char* name, const char* category);
+	~TraceScope();
+
+private:
+
+	const char* m_Name;
+	const char* m_Category;
+	uint64_t m_Start = 0; // 0 if not recording
+
+};
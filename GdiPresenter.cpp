@@ -0,0 +1,265 @@
+//
+//		GdiPresenter
+//
+//		Presenter drawing to a window with GDI.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "GdiPresenter.h"
+#include "FrameStats.h"
+#include "FrameTrace.h"
+
+GdiPresenter::GdiPresenter()
+{
+}
+
+GdiPresenter::~GdiPresenter()
+{
+	Release();
+}
+
+void GdiPresenter::SetWindow(HWND hwnd)
+{
+	if (hwnd == m_hWnd)
+		return;
+	Reset();
+	m_hWnd = hwnd;
+}
+
+void GdiPresenter::Release()
+{
+	Reset();
+	ReleaseSurface();
+	m_Scaled.Release();
+	m_bScaledValid = false;
+}
+
+// Release the window DC. The size is read again when it is next acquired.
+void GdiPresenter::Reset()
+{
+	if (m_hdc)
+		ReleaseDC(m_hWnd, m_hdc);
+	m_hdc = NULL;
+	m_Width = 0;
+	m_Height = 0;
+	Invalidate();
+}
+
+// Get the window DC and size.
+// The worker window can be destroyed or resized by Explorer at any time,
+// so the size is read each time and the DC released if it has changed.
+bool GdiPresenter::Acquire()
+{
+	if (!m_hWnd)
+		return false;
+
+	RECT dr{};
+	if (!IsWindow(m_hWnd) || !GetWindowRect(m_hWnd, &dr)) {
+		Reset();
+		return false;
+	}
+	const unsigned int width = (unsigned int)(dr.right - dr.left);
+	const unsigned int height = (unsigned int)(dr.bottom - dr.top);
+	if (m_hdc && (width != m_Width || height != m_Height))
+		Reset();
+	if (m_hdc)
+		return true;
+
+	// Must use GetDCEx for the desktop worker window
+	m_hdc = GetDCEx(m_hWnd, NULL, DCX_WINDOW);
+	if (!m_hdc)
+		return false;
+
+	m_Width = width;
+	m_Height = height;
+	SetStretchBltMode(m_hdc, COLORONCOLOR); // Fastest method
+
+	return true;
+}
+
+bool GdiPresenter::GetTargetSize(unsigned int& width, unsigned int& height)
+{
+	const bool bAcquired = Acquire();
+	width = m_Width;
+	height = m_Height;
+	return bAcquired;
+}
+
+bool GdiPresenter::DibSection::Create(unsigned int w, unsigned int h)
+{
+	if (bits && w == width && h == height)
+		return true;
+
+	Release();
+	if (w == 0 || h == 0)
+		return false;
+
+	BITMAPINFO bmi{};
+	bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmi.bmiHeader.biWidth = (LONG)w;
+	bmi.bmiHeader.biHeight = -(LONG)h; // Top down
+	bmi.bmiHeader.biPlanes = 1;
+	bmi.bmiHeader.biBitCount = 32;
+	bmi.bmiHeader.biCompression = BI_RGB;
+	void* pixels = nullptr;
+	hBitmap = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &pixels, NULL, 0);
+	if (!hBitmap)
+		return false;
+	hdc = CreateCompatibleDC(NULL);
+	if (!hdc) {
+		DeleteObject(hBitmap);
+		hBitmap = NULL;
+		return false;
+	}
+	hOldBitmap = SelectObject(hdc, hBitmap);
+	bits = (unsigned char*)pixels;
+	width = w;
+	height = h;
+
+	return true;
+}
+
+void GdiPresenter::DibSection::Release()
+{
+	if (hdc) {
+		SelectObject(hdc, hOldBitmap);
+		DeleteDC(hdc);
+	}
+	if (hBitmap)
+		DeleteObject(hBitmap);
+	hdc = NULL;
+	hBitmap = NULL;
+	hOldBitmap = NULL;
+	bits = nullptr;
+	width = 0;
+	height = 0;
+}
+
+unsigned char* GdiPresenter::GetSurface(unsigned int width, unsigned int height)
+{
+	if (!m_Surface.Create(width, height))
+		return nullptr;
+	return m_Surface.bits;
+}
+
+void GdiPresenter::ReleaseSurface()
+{
+	m_Surface.Release();
+}
+
+bool GdiPresenter::Draw(const unsigned char* frame, unsigned int width, unsigned int height,
+	const FitRect& src, const FitRect& dst, bool bClear, const std::vector<FitRect>* regions)
+{
+	// The size has just been read by GetTargetSize
+	if (!m_hdc && !Acquire())
+		return false;
+
+	// Clear borders not covered by the frame
+	if (bClear) {
+		RECT rc = { 0, 0, (LONG)m_Width, (LONG)m_Height };
+		FillRect(m_hdc, &rc, (HBRUSH)GetStockObject(BLACK_BRUSH));
+	}
+
+	BOOL bDrawn = FALSE;
+	const bool bScale = (src.width != dst.width || src.height != dst.height);
+	if (bScale && m_Scaled.Create((unsigned int)dst.width, (unsigned int)dst.height)) {
+		// Filtered by the scaler, then copied without stretching.
+		// Changed regions are scaled into the bitmap holding the last frame.
+		const FitRect scaled = { 0, 0, dst.width, dst.height };
+		TRACE_SCOPE("Scale and BitBlt", "present");
+		FrameStageTimer scale(STAGE_SCALE);
+		if (regions && m_bScaledValid) {
+			bDrawn = TRUE;
+			for (size_t i = 0; i < regions->size() && bDrawn; i++) {
+				const FitRect& region = (*regions)[i];
+				const FitRect part = { region.x - dst.x, region.y - dst.y, region.width, region.height };
+				scale.Resume();
+				m_Scaler.Scale(frame, width*4, src, m_Scaled.bits, m_Scaled.width*4, scaled, GetFilter(), &part);
+				scale.Pause();
+				bDrawn = BitBlt(m_hdc, region.x, region.y, region.width, region.height, m_Scaled.hdc, part.x, part.y, SRCCOPY);
+			}
+		}
+		else {
+			m_Scaler.Scale(frame, width*4, src, m_Scaled.bits, m_Scaled.width*4, scaled, GetFilter());
+			scale.Pause();
+			bDrawn = BitBlt(m_hdc, dst.x, dst.y, dst.width, dst.height, m_Scaled.hdc, 0, 0, SRCCOPY);
+		}
+		// Finish with the bitmap before it is written again
+		GdiFlush();
+		m_bScaledValid = (bDrawn != FALSE);
+	}
+	else if (frame == m_Surface.bits && width == m_Surface.width && height == m_Surface.height) {
+		TRACE_SCOPE("StretchBlt", "present");
+		if (regions) {
+			bDrawn = TRUE;
+			for (size_t i = 0; i < regions->size() && bDrawn; i++) {
+				const FitRect& region = (*regions)[i];
+				bDrawn = BitBlt(m_hdc, region.x, region.y, region.width, region.height,
+					m_Surface.hdc, src.x + region.x - dst.x, src.y + region.y - dst.y, SRCCOPY);
+			}
+		}
+		else {
+			bDrawn = StretchBlt(m_hdc,
+				dst.x, dst.y, dst.width, dst.height,
+				m_Surface.hdc, src.x, src.y, src.width, src.height, SRCCOPY);
+		}
+		GdiFlush();
+		m_bScaledValid = false;
+	}
+	else {
+		// The header only changes with the frame size
+		if (m_bmi.bmiHeader.biWidth != (LONG)width || m_bmi.bmiHeader.biHeight != -(LONG)height) {
+			ZeroMemory(&m_bmi, sizeof(BITMAPINFO));
+			m_bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+			m_bmi.bmiHeader.biSizeImage = (DWORD)(width*height*4);
+			m_bmi.bmiHeader.biWidth = (LONG)width;
+			m_bmi.bmiHeader.biHeight = -(LONG)height; // Top down
+			m_bmi.bmiHeader.biPlanes = 1;
+			m_bmi.bmiHeader.biBitCount = 32;
+			m_bmi.bmiHeader.biCompression = BI_RGB;
+		}
+		TRACE_SCOPE("StretchDIBits", "present");
+		if (regions) {
+			// Not scaled, so each region is copied one to one
+			bDrawn = TRUE;
+			for (size_t i = 0; i < regions->size() && bDrawn; i++) {
+				const FitRect& region = (*regions)[i];
+				bDrawn = (StretchDIBits(m_hdc,
+					region.x, region.y, region.width, region.height,
+					src.x + region.x - dst.x, src.y + region.y - dst.y, region.width, region.height,
+					frame, &m_bmi, DIB_RGB_COLORS, SRCCOPY) != 0);
+			}
+		}
+		else {
+			bDrawn = (StretchDIBits(m_hdc,
+				dst.x, dst.y, dst.width, dst.height,
+				src.x, src.y, src.width, src.height,
+				frame, &m_bmi, DIB_RGB_COLORS, SRCCOPY) != 0);
+		}
+		m_bScaledValid = false;
+	}
+
+	// The window may have gone. Get the DC again next time.
+	if (!bDrawn)
+		Reset();
+
+	return bDrawn != FALSE;
+}
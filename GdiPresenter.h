@@ -0,0 +1,90 @@
+//
+//		GdiPresenter
+//
+//		Presenter drawing to a window with GDI.
+//
+//		The window DC and the bitmap header for the frame size are kept
+//		between frames instead of being set up for every frame. The window
+//		size is read for each frame. The DC is released if the window has
+//		gone or its size has changed, and by Reset when the display changes.
+//
+//		The surface is a DIB section selected into a memory DC. A frame
+//		written to it is drawn with StretchBlt, others with StretchDIBits.
+//		Frames that need scaling are scaled by the FrameScaler into a second
+//		DIB section of the destination size and copied with BitBlt. This
+//		bitmap is kept so that only the changed regions of the next frame
+//		need to be scaled and copied.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <windows.h>
+#include "Presenter.h"
+
+class GdiPresenter : public Presenter {
+
+public:
+
+	GdiPresenter();
+	~GdiPresenter();
+
+	// Window to draw to. For the desktop, the WorkerW window.
+	void SetWindow(HWND hwnd);
+	// Release all GDI objects
+	void Release();
+
+	bool GetTargetSize(unsigned int& width, unsigned int& height) override;
+	void Reset() override;
+	unsigned char* GetSurface(unsigned int width, unsigned int height) override;
+	void ReleaseSurface() override;
+
+protected:
+
+	bool Draw(const unsigned char* frame, unsigned int width, unsigned int height,
+		const FitRect& src, const FitRect& dst, bool bClear, const std::vector<FitRect>* regions) override;
+
+private:
+
+	// Bitmap selected into a memory DC with its pixels
+	struct DibSection {
+		HDC hdc = NULL;
+		HBITMAP hBitmap = NULL;
+		HGDIOBJ hOldBitmap = NULL;
+		unsigned char* bits = nullptr;
+		unsigned int width = 0;
+		unsigned int height = 0;
+		bool Create(unsigned int w, unsigned int h);
+		void Release();
+	};
+
+	bool Acquire();
+
+	HWND m_hWnd = NULL;
+	HDC m_hdc = NULL;                  // Window DC held until Reset or the size changes
+	unsigned int m_Width = 0;          // Window size when the DC was acquired
+	unsigned int m_Height = 0;
+	BITMAPINFO m_bmi{};                // Header for StretchDIBits frames
+	DibSection m_Surface;              // Frames written by the caller
+	DibSection m_Scaled;               // Frames scaled to the destination size
+	bool m_bScaledValid = false;       // m_Scaled holds the last frame drawn
+
+};
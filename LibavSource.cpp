@@ -0,0 +1,303 @@
+//
+//		LibavSource
+//
+//		Video source decoding in this process with the FFmpeg libraries.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "LibavSource.h"
+#include "FrameStats.h"
+#include "FrameTrace.h"
+
+#ifdef USE_LIBAV
+
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+#include <libavutil/frame.h>
+#include <libavutil/mathematics.h>
+}
+
+#ifdef _MSC_VER
+#pragma comment (lib, "avformat.lib")
+#pragma comment (lib, "avcodec.lib")
+#pragma comment (lib, "swscale.lib")
+#pragma comment (lib, "avutil.lib")
+#endif
+
+LibavSource::LibavSource()
+{
+}
+
+LibavSource::~LibavSource()
+{
+	Close();
+}
+
+bool LibavSource::Open(const VideoSourceParams& params, FrameRing* ring)
+{
+	Close();
+
+	if (!ring || ring->GetWidth() != params.fit.width || ring->GetHeight() != params.fit.height)
+		return false;
+
+	// Open the file and decoder here so that failure can be reported
+	if (avformat_open_input(&m_Format, params.path.c_str(), nullptr, nullptr) < 0) {
+		m_Format = nullptr;
+		return false;
+	}
+	if (avformat_find_stream_info(m_Format, nullptr) < 0) {
+		Release();
+		return false;
+	}
+	m_Stream = av_find_best_stream(m_Format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+	if (m_Stream < 0) {
+		Release();
+		return false;
+	}
+
+	AVStream* stream = m_Format->streams[m_Stream];
+	const AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
+	if (!codec) {
+		Release();
+		return false;
+	}
+	m_Codec = avcodec_alloc_context3(codec);
+	if (!m_Codec || avcodec_parameters_to_context(m_Codec, stream->codecpar) < 0) {
+		Release();
+		return false;
+	}
+	// Decoder threads chosen by FFmpeg for the cores available
+	m_Codec->thread_count = 0;
+	if (avcodec_open2(m_Codec, codec, nullptr) < 0) {
+		Release();
+		return false;
+	}
+	m_Frame = av_frame_alloc();
+	m_Last = av_frame_alloc();
+	if (!m_Frame || !m_Last) {
+		Release();
+		return false;
+	}
+
+	m_Params = params;
+	m_Ring = ring;
+	m_LoopTiming.Reset();
+	m_bBoundary = false;
+	m_nFrames = 0;
+	m_OutputTime = 0;
+	m_bStop = false;
+	m_bFinished = false;
+	m_bOpen = true;
+	m_Thread = std::thread(&LibavSource::Decode, this);
+
+	return true;
+}
+
+void LibavSource::Close()
+{
+	if (m_Thread.joinable()) {
+		m_bStop = true;
+		m_Ring->WakeWriter();
+		m_Thread.join();
+	}
+	Release();
+	m_Ring = nullptr;
+	m_bOpen = false;
+}
+
+void LibavSource::Release()
+{
+	if (m_Sws) sws_freeContext(m_Sws);
+	m_Sws = nullptr;
+	if (m_Frame) av_frame_free(&m_Frame);
+	if (m_Last) av_frame_free(&m_Last);
+	if (m_Codec) avcodec_free_context(&m_Codec);
+	if (m_Format) avformat_close_input(&m_Format);
+	m_Stream = -1;
+}
+
+// Decoder thread
+void LibavSource::Decode()
+{
+	FrameTrace::Shared().SetThreadName("FFmpeg decoder");
+
+	AVPacket* packet = av_packet_alloc();
+
+	while (packet && !m_bStop) {
+
+		if (av_read_frame(m_Format, packet) < 0) {
+
+			// End of the file
+			// Drain the frames still in the decoder
+			avcodec_send_packet(m_Codec, nullptr);
+			if (!ReceiveFrames())
+				break;
+
+			// Stop if the file produced no frames at all
+			if (m_bStop || m_nFrames == 0)
+				break;
+
+			// Seek back to the start and continue
+			AVStream* stream = m_Format->streams[m_Stream];
+			const int64_t start = (stream->start_time != AV_NOPTS_VALUE) ? stream->start_time : 0;
+			if (av_seek_frame(m_Format, m_Stream, start, AVSEEK_FLAG_BACKWARD) < 0)
+				break;
+			avcodec_flush_buffers(m_Codec);
+			av_frame_unref(m_Last);
+			m_bBoundary = true;
+			m_nFrames = 0;
+			continue;
+		}
+
+		if (packet->stream_index == m_Stream) {
+			// Every frame is received after each packet is sent,
+			// so the decoder can always accept the next packet
+			if (avcodec_send_packet(m_Codec, packet) == 0 && !ReceiveFrames()) {
+				av_packet_unref(packet);
+				break;
+			}
+		}
+		av_packet_unref(packet);
+	}
+
+	if (packet) av_packet_free(&packet);
+	m_bFinished = true;
+}
+
+// Output all frames the decoder has ready.
+// Returns false if stopped.
+bool LibavSource::ReceiveFrames()
+{
+	while (!m_bStop && avcodec_receive_frame(m_Codec, m_Frame) == 0) {
+		const bool bOutput = OutputFrame(m_Frame);
+		av_frame_unref(m_Frame);
+		if (!bOutput)
+			return false;
+	}
+	return !m_bStop;
+}
+
+// Output a decoded frame.
+// Variable rate video is resampled to the paced rate by the frame
+// timestamps. A frame is repeated until the next one is due and
+// a frame due at the same time as the one before is dropped.
+bool LibavSource::OutputFrame(AVFrame* frame)
+{
+	if (!m_Params.bVariableRate || frame->best_effort_timestamp == AV_NOPTS_VALUE)
+		return WriteFrame(frame);
+
+	// Frame number at the paced rate from the start of the loop
+	if (!m_Last->buf[0])
+		m_StartTime = frame->best_effort_timestamp;
+	const AVRational period = { (int)m_Params.rateDen, (int)m_Params.rateNum };
+	const int64_t index = av_rescale_q(frame->best_effort_timestamp - m_StartTime,
+		m_Format->streams[m_Stream]->time_base, period);
+	if (m_Last->buf[0] && index < (int64_t)m_nFrames)
+		return true;
+
+	// Cropping changes the frame, so each repeat is a new reference
+	while (m_Last->buf[0] && index > (int64_t)m_nFrames) {
+		AVFrame* repeat = av_frame_clone(m_Last);
+		const bool bWritten = repeat && WriteFrame(repeat);
+		av_frame_free(&repeat);
+		if (!bWritten)
+			return false;
+	}
+	av_frame_unref(m_Last);
+	av_frame_ref(m_Last, frame);
+
+	return WriteFrame(frame);
+}
+
+// Crop and scale a decoded frame into the next ring slot
+bool LibavSource::WriteFrame(AVFrame* frame)
+{
+	// Reading and decoding since the last frame was output
+	FrameStats& stats = FrameStats::Shared();
+	if (stats.IsEnabled() && m_OutputTime > 0)
+		stats.Record(STAGE_READ, FrameStats::Ticks() - m_OutputTime);
+
+	// Wait for a free slot
+	m_LoopTiming.BeginWait();
+	unsigned char* slot = m_Ring->WaitWrite(m_bStop);
+	m_LoopTiming.EndWait();
+	if (!slot)
+		return false;
+
+	// The part of the frame that is scaled to the output.
+	// Fill and Center crop the scaled video to the output size.
+	const FitSize& fit = m_Params.fit;
+	if (fit.scaleWidth > 0 && fit.scaleHeight > 0 && (fit.width < fit.scaleWidth || fit.height < fit.scaleHeight)) {
+		const double sx = (double)frame->width/(double)fit.scaleWidth;
+		const double sy = (double)frame->height/(double)fit.scaleHeight;
+		const size_t cropWidth = (size_t)((double)fit.width*sx + 0.5);
+		const size_t cropHeight = (size_t)((double)fit.height*sy + 0.5);
+		// Even offsets keep chroma planes aligned with luma
+		const size_t left = (((size_t)frame->width - cropWidth)/2) & ~(size_t)1;
+		const size_t top = (((size_t)frame->height - cropHeight)/2) & ~(size_t)1;
+		frame->crop_left = left;
+		frame->crop_top = top;
+		frame->crop_right = (size_t)frame->width - cropWidth - left;
+		frame->crop_bottom = (size_t)frame->height - cropHeight - top;
+		av_frame_apply_cropping(frame, AV_FRAME_CROP_UNALIGNED);
+	}
+
+	// Scale and convert to BGRA directly into the slot
+	SwsContext* sws = sws_getCachedContext(m_Sws,
+		frame->width, frame->height, (AVPixelFormat)frame->format,
+		(int)fit.width, (int)fit.height, AV_PIX_FMT_BGRA,
+		SWS_AREA, nullptr, nullptr, nullptr);
+	if (!sws)
+		return false;
+	if (sws != m_Sws) {
+		// Colour matrix and range of the video.
+		// The frame range is used if known, otherwise limited range.
+		const int matrix = (m_Params.color.matrix == YUV_BT709) ? SWS_CS_ITU709 : SWS_CS_ITU601;
+		const int srcRange = (frame->color_range == AVCOL_RANGE_JPEG) ? 1 : 0;
+		sws_setColorspaceDetails(sws, sws_getCoefficients(matrix), srcRange,
+			sws_getCoefficients(SWS_CS_DEFAULT), 1, 0, 1 << 16, 1 << 16);
+		m_Sws = sws;
+	}
+
+	uint8_t* dst[4] = { slot, nullptr, nullptr, nullptr };
+	int dstStride[4] = { (int)fit.width*4, 0, 0, 0 };
+	{
+		TRACE_SCOPE("sws_scale", "read");
+		FrameStageTimer convert(STAGE_CONVERT, stats);
+		sws_scale(m_Sws, frame->data, frame->linesize, 0, frame->height, dst, dstStride);
+	}
+
+	// The first frame and the first after seeking back start a loop
+	if (m_FrameSink) m_FrameSink(slot, m_nFrames == 0);
+	m_Ring->EndWrite();
+	m_LoopTiming.AddFrame(m_bBoundary);
+	m_bBoundary = false;
+	m_nFrames++;
+	if (m_FrameCallback) m_FrameCallback();
+	m_OutputTime = stats.IsEnabled() ? FrameStats::Ticks() : 0;
+
+	return true;
+}
+
+#endif
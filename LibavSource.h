@@ -0,0 +1,101 @@
+//
+//		LibavSource
+//
+//		Video source decoding in this process with the FFmpeg libraries.
+//
+//		libavformat reads the file and libavcodec decodes on a thread of this
+//		process, so there is no FFmpeg process, pipe or console window.
+//		Each frame is cropped by adjusting the plane pointers and scaled by
+//		libswscale straight into a FrameRing slot. At the end of the file
+//		the decoder is drained and the file is seeked back to the start.
+//
+//		Built only if USE_LIBAV is defined. The FFmpeg "shared" or "dev"
+//		build is required, FFmpeg 4.4 or later. Add its "include" folder to
+//		the include directories and its "lib" folder to the library directories.
+//		avformat, avcodec, swscale and avutil dlls must be with the executable.
+//
+//		On Linux it builds with the FFmpeg development packages. The pipeline
+//		benchmark (Benchmark/PipelineBench.cpp) gives the command line and
+//		compares it with the pipe backend on the same video file.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#ifdef USE_LIBAV
+
+#include <thread>
+#include <atomic>
+#include "VideoSource.h"
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVFrame;
+struct SwsContext;
+
+class LibavSource : public VideoSource {
+
+public:
+
+	LibavSource();
+	~LibavSource();
+
+	bool Open(const VideoSourceParams& params, FrameRing* ring) override;
+	void Close() override;
+	bool IsOpen() const override { return m_bOpen; }
+	bool IsFinished() const override { return m_bFinished.load(); }
+	void SetFrameCallback(std::function<void()> callback) override { m_FrameCallback = callback; }
+	void SetFrameSink(std::function<void(const unsigned char*, bool)> sink) override { m_FrameSink = sink; }
+	const LoopTiming& GetLoopTiming() const override { return m_LoopTiming; }
+	VideoBackend GetBackend() const override { return VIDEO_LIBAV; }
+
+private:
+
+	void Decode();
+	bool ReceiveFrames();
+	bool OutputFrame(AVFrame* frame);
+	bool WriteFrame(AVFrame* frame);
+	void Release();
+
+	VideoSourceParams m_Params;
+	FrameRing* m_Ring = nullptr;
+	AVFormatContext* m_Format = nullptr;
+	AVCodecContext* m_Codec = nullptr;
+	AVFrame* m_Frame = nullptr;
+	AVFrame* m_Last = nullptr; // Last frame written, repeated for variable rate video
+	int64_t m_StartTime = 0;   // Timestamp of the first frame of the loop
+	SwsContext* m_Sws = nullptr;
+	int m_Stream = -1;
+
+	std::thread m_Thread;
+	std::atomic<bool> m_bStop{false};
+	std::atomic<bool> m_bFinished{false};
+	bool m_bOpen = false;
+	bool m_bBoundary = false; // The next frame starts a new loop
+	unsigned int m_nFrames = 0; // Frames output in this loop
+	uint64_t m_OutputTime = 0; // When the last frame was output (usec, FrameStats clock)
+	std::function<void()> m_FrameCallback;
+	std::function<void(const unsigned char*, bool)> m_FrameSink;
+	LoopTiming m_LoopTiming;
+
+};
+
+#endif
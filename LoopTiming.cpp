@@ -0,0 +1,72 @@
+//
+//		LoopTiming
+//
+//		Frame intervals of a looping video source.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "LoopTiming.h"
+
+LoopTiming::LoopTiming()
+{
+}
+
+void LoopTiming::Reset()
+{
+	m_Loops = 0;
+	m_LoopStall = 0.0;
+	m_MaxLoopStall = 0.0;
+	m_FrameInterval = 0.0;
+	m_FrameCount = 0;
+	m_Waited = std::chrono::steady_clock::duration(0);
+}
+
+void LoopTiming::BeginWait()
+{
+	m_WaitStart = std::chrono::steady_clock::now();
+}
+
+void LoopTiming::EndWait()
+{
+	m_Waited += std::chrono::steady_clock::now() - m_WaitStart;
+}
+
+// Record the interval since the previous frame, less any wait for a slot
+void LoopTiming::AddFrame(bool bBoundary)
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (m_FrameCount > 0) {
+		const double interval = std::chrono::duration<double, std::milli>(now - m_LastFrameTime - m_Waited).count();
+		if (bBoundary) {
+			m_LoopStall = interval;
+			if (interval > m_MaxLoopStall) m_MaxLoopStall = interval;
+			m_Loops++;
+		}
+		else {
+			// Running average of intervals within a loop
+			const double average = m_FrameInterval.load();
+			m_FrameInterval = (average > 0.0) ? average*0.95 + interval*0.05 : interval;
+		}
+	}
+	m_LastFrameTime = now;
+	m_Waited = std::chrono::steady_clock::duration(0);
+	m_FrameCount++;
+}
@@ -0,0 +1,81 @@
+//
+//		LoopTiming
+//
+//		Frame intervals of a looping video source.
+//
+//		The time between the last frame of a loop and the first frame of
+//		the next is recorded so that loop transitions can be checked
+//		against the average interval between frames within a loop.
+//
+//		Time the source spends waiting for a free slot in the ring is
+//		left out, so the intervals are the time taken to read and decode
+//		a frame, not the pace at which the consumer takes them.
+//
+//		Frames are added on the source thread and the results
+//		can be read on any thread.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
+class LoopTiming {
+
+public:
+
+	LoopTiming();
+
+	void Reset();
+
+	// Record a frame published now.
+	// bBoundary is true for the first frame of a new loop.
+	void AddFrame(bool bBoundary);
+
+	// The source is waiting for a free slot, and has one.
+	// The wait is not counted in the interval to the next frame.
+	void BeginWait();
+	void EndWait();
+
+	// Loop boundaries passed
+	unsigned int GetLoops() const { return m_Loops.load(); }
+	// Frame interval at the last loop boundary and the maximum (msec)
+	double GetLoopStall() const { return m_LoopStall.load(); }
+	double GetMaxLoopStall() const { return m_MaxLoopStall.load(); }
+	// Average frame interval within a loop (msec)
+	double GetFrameInterval() const { return m_FrameInterval.load(); }
+	// Frames added since Reset. Read on the source thread.
+	uint64_t GetFrameCount() const { return m_FrameCount; }
+
+private:
+
+	std::atomic<unsigned int> m_Loops{0};
+	std::atomic<double> m_LoopStall{0.0};
+	std::atomic<double> m_MaxLoopStall{0.0};
+	std::atomic<double> m_FrameInterval{0.0};
+	std::chrono::steady_clock::time_point m_LastFrameTime;
+	std::chrono::steady_clock::time_point m_WaitStart;
+	std::chrono::steady_clock::duration m_Waited{0}; // Since the last frame
+	uint64_t m_FrameCount = 0; // Frames since Reset
+
+};
@@ -0,0 +1,81 @@
+//
+//		MemoryPresenter
+//
+//		Presenter drawing to a BGRA pixel buffer in memory.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "MemoryPresenter.h"
+#include "FrameStats.h"
+#include <string.h>
+
+MemoryPresenter::MemoryPresenter()
+{
+}
+
+void MemoryPresenter::SetTargetSize(unsigned int width, unsigned int height)
+{
+	m_Width = width;
+	m_Height = height;
+	m_Target.assign((size_t)width*height*4, 0);
+	Invalidate();
+}
+
+bool MemoryPresenter::GetTargetSize(unsigned int& width, unsigned int& height)
+{
+	width = m_Width;
+	height = m_Height;
+	return (m_Width > 0 && m_Height > 0);
+}
+
+void MemoryPresenter::Reset()
+{
+	Invalidate();
+}
+
+unsigned char* MemoryPresenter::GetSurface(unsigned int width, unsigned int height)
+{
+	const size_t size = (size_t)width*height*4;
+	if (m_Surface.size() != size)
+		m_Surface.assign(size, 0);
+	return m_Surface.data();
+}
+
+bool MemoryPresenter::Draw(const unsigned char* frame, unsigned int width, unsigned int height,
+	const FitRect& src, const FitRect& dst, bool bClear, const std::vector<FitRect>* regions)
+{
+	(void)height;
+	if (m_Target.empty())
+		return false;
+
+	if (bClear)
+		memset(m_Target.data(), 0, m_Target.size());
+
+	FrameStageTimer scale(STAGE_SCALE);
+	if (!regions)
+		return m_Scaler.Scale(frame, width*4, src, m_Target.data(), m_Width*4, dst, GetFilter());
+
+	for (size_t i = 0; i < regions->size(); i++) {
+		if (!m_Scaler.Scale(frame, width*4, src, m_Target.data(), m_Width*4, dst, GetFilter(), &(*regions)[i]))
+			return false;
+	}
+	return true;
+}
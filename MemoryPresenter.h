@@ -0,0 +1,62 @@
+//
+//		MemoryPresenter
+//
+//		Presenter drawing to a BGRA pixel buffer in memory.
+//
+//		Frames are scaled by the FrameScaler with the presenter filter,
+//		so that the render path can be run and timed without a window
+//		on any platform.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <vector>
+#include "Presenter.h"
+
+class MemoryPresenter : public Presenter {
+
+public:
+
+	MemoryPresenter();
+
+	// Target buffer size
+	void SetTargetSize(unsigned int width, unsigned int height);
+	const unsigned char* GetTarget() const { return m_Target.data(); }
+
+	bool GetTargetSize(unsigned int& width, unsigned int& height) override;
+	void Reset() override;
+	unsigned char* GetSurface(unsigned int width, unsigned int height) override;
+	void ReleaseSurface() override { m_Surface.clear(); }
+
+protected:
+
+	bool Draw(const unsigned char* frame, unsigned int width, unsigned int height,
+		const FitRect& src, const FitRect& dst, bool bClear, const std::vector<FitRect>* regions) override;
+
+private:
+
+	unsigned int m_Width = 0;
+	unsigned int m_Height = 0;
+	std::vector<unsigned char> m_Target;
+	std::vector<unsigned char> m_Surface;
+
+};
@@ -0,0 +1,131 @@
+//
+//		PipeSource
+//
+//		Video source using ffmpeg.exe with raw frames sent through a pipe.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "PipeSource.h"
+#include <stdio.h>
+
+PipeSource::PipeSource()
+{
+}
+
+PipeSource::~PipeSource()
+{
+	Close();
+}
+
+std::string PipeSource::GetCommand(const VideoSourceParams& params)
+{
+	const FitSize& fit = params.fit;
+
+	// FFmpeg scales and crops so that only the pixels shown are sent
+	std::string filter;
+	char tmp[128]{};
+	if (params.bVariableRate) {
+		// Frames are paced at a constant rate. Repeat or drop frames
+		// by their timestamps so that each one is shown at its time.
+		snprintf(tmp, 128, "fps=%u/%u", params.rateNum, params.rateDen);
+		filter = tmp;
+	}
+	std::string scale;
+	if (fit.scaleWidth != params.videoWidth || fit.scaleHeight != params.videoHeight) {
+		// Area averaging for best quality when reducing size
+		snprintf(tmp, 128, "scale=%u:%u:flags=area", fit.scaleWidth, fit.scaleHeight);
+		scale = tmp;
+	}
+	if (params.bYuv) {
+		// YUV is always sent as limited range. Scale does nothing
+		// if the video is already limited range at this size.
+		scale += scale.empty() ? "scale=out_range=tv" : ":out_range=tv";
+	}
+	if (!scale.empty()) {
+		if (!filter.empty()) filter += ",";
+		filter += scale;
+	}
+	if (fit.width != fit.scaleWidth || fit.height != fit.scaleHeight) {
+		// Centre crop
+		snprintf(tmp, 128, "crop=%u:%u", fit.width, fit.height);
+		if (!filter.empty()) filter += ",";
+		filter += tmp;
+	}
+
+	// Frames are not read at native frame rate (-re) but as fast as
+	// the frame slots are free. They are shown at their presentation time.
+	std::string command = params.ffmpegPath;
+	// Loop the input indefinitely within the same process.
+	// FFmpeg seeks back to the start without re-opening the file.
+	command += " -stream_loop -1 ";
+	command += " -i ";
+	command += "\"";
+	command += params.path;
+	command += "\"";
+	// Scale and crop to the negotiated size
+	if (!filter.empty()) {
+		command += " -vf ";
+		command += filter;
+	}
+	if (params.bYuv) {
+		// Planar YUV 4:2:0 is 1.5 bytes per pixel instead of 4 for BGRA
+		// and is the native output of most decoders
+		command += " -f image2pipe -vcodec rawvideo -pix_fmt yuv420p -";
+	}
+	else {
+		// Specify BGRA pixel format to allow high speed bitmap drawing
+		command += " -f image2pipe -vcodec rawvideo -pix_fmt bgra -";
+	}
+
+	return command;
+}
+
+bool PipeSource::Open(const VideoSourceParams& params, FrameRing* ring)
+{
+	Close();
+
+	if (!ring || ring->GetWidth() != params.fit.width || ring->GetHeight() != params.fit.height)
+		return false;
+
+	// Frames per loop to detect loop boundaries
+	m_Reader.SetLoopFrames(params.loopFrames);
+
+	// Convert YUV frames to BGRA for drawing on the reader thread
+	if (params.bYuv) {
+		const unsigned int width = params.fit.width;
+		const unsigned int height = params.fit.height;
+		const YuvColor color = params.color;
+		m_Reader.SetConverter(YuvFrameSize(width, height), [width, height, color](const unsigned char* src, unsigned char* dst) {
+			YuvToBgra(src, dst, width, height, color);
+		});
+	}
+	else {
+		m_Reader.SetConverter(0, nullptr);
+	}
+
+	// Start the reader thread on the FFmpeg pipe
+	return m_Reader.Open(GetCommand(params), ring);
+}
+
+void PipeSource::Close()
+{
+	m_Reader.Close();
+}
@@ -0,0 +1,58 @@
+//
+//		PipeSource
+//
+//		Video source using ffmpeg.exe with raw frames sent through a pipe.
+//
+//		FFmpeg scales and crops to the negotiated size and loops the input
+//		with -stream_loop. Frames are read by a FrameReader and converted
+//		from yuv420p to BGRA if required.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include "VideoSource.h"
+#include "FrameReader.h"
+
+class PipeSource : public VideoSource {
+
+public:
+
+	PipeSource();
+	~PipeSource();
+
+	bool Open(const VideoSourceParams& params, FrameRing* ring) override;
+	void Close() override;
+	bool IsOpen() const override { return m_Reader.IsOpen(); }
+	bool IsFinished() const override { return m_Reader.IsFinished(); }
+	void SetFrameCallback(std::function<void()> callback) override { m_Reader.SetFrameCallback(callback); }
+	void SetFrameSink(std::function<void(const unsigned char*, bool)> sink) override { m_Reader.SetFrameSink(sink); }
+	const LoopTiming& GetLoopTiming() const override { return m_Reader.GetLoopTiming(); }
+	VideoBackend GetBackend() const override { return VIDEO_PIPE; }
+
+	// FFmpeg command line for the parameters
+	static std::string GetCommand(const VideoSourceParams& params);
+
+private:
+
+	FrameReader m_Reader;
+
+};
@@ -0,0 +1,355 @@
+//
+//		PixelKernels
+//
+//		Row kernels for 32 bit pixel buffers.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "PixelKernels.h"
+#include <string.h>
+
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif
+#ifdef SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+//
+// Formats
+//
+
+// Position of red and whether alpha is defined
+template <PixelFormat Format> struct PixelLayout;
+template <> struct PixelLayout<PIXEL_BGRA> { static const int R = 2; static const bool bAlpha = true; };
+template <> struct PixelLayout<PIXEL_RGBA> { static const int R = 0; static const bool bAlpha = true; };
+template <> struct PixelLayout<PIXEL_BGRX> { static const int R = 2; static const bool bAlpha = false; };
+
+// What a conversion does to each pixel
+template <PixelFormat Src, PixelFormat Dst>
+struct PixelConversion {
+	// Exchange red and blue
+	static const bool bSwap = PixelLayout<Src>::R != PixelLayout<Dst>::R;
+	// Set alpha to 255
+	static const bool bOpaque = !PixelLayout<Src>::bAlpha && PixelLayout<Dst>::bAlpha;
+};
+
+//
+// Convert
+//
+// Row() converts the pixels of a line from x to the end.
+// The SIMD kernels finish the line with the scalar kernel.
+//
+
+typedef void (*ConvertRow)(const unsigned char* src, unsigned char* dst, unsigned int x, unsigned int width);
+
+template <PixelFormat Src, PixelFormat Dst, SimdLevel Level>
+struct ConvertKernel {
+	static void Row(const unsigned char* src, unsigned char* dst, unsigned int x, unsigned int width)
+	{
+		typedef PixelConversion<Src, Dst> Conversion;
+		for (; x < width; x++) {
+			const unsigned char* s = src + (size_t)x*4;
+			unsigned char* d = dst + (size_t)x*4;
+			const unsigned char c0 = s[0], c1 = s[1], c2 = s[2], c3 = s[3];
+			d[0] = Conversion::bSwap ? c2 : c0;
+			d[1] = c1;
+			d[2] = Conversion::bSwap ? c0 : c2;
+			d[3] = Conversion::bOpaque ? 255 : c3;
+		}
+	}
+};
+
+#ifdef SIMD_X86
+
+template <PixelFormat Src, PixelFormat Dst>
+struct ConvertKernel<Src, Dst, SIMD_SSE2> {
+	static void Row(const unsigned char* src, unsigned char* dst, unsigned int x, unsigned int width)
+	{
+		typedef PixelConversion<Src, Dst> Conversion;
+		const __m128i rb = _mm_set1_epi32(0x00FF00FF);
+		const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+		for (; x + 4 <= width; x += 4) {
+			__m128i p = _mm_loadu_si128((const __m128i*)(src + (size_t)x*4));
+			if (Conversion::bSwap) {
+				// Bytes 0 and 2 of each pixel exchanged by 16 bit shifts
+				const __m128i c = _mm_and_si128(p, rb);
+				p = _mm_or_si128(_mm_andnot_si128(rb, p),
+					_mm_or_si128(_mm_slli_epi32(c, 16), _mm_srli_epi32(c, 16)));
+			}
+			if (Conversion::bOpaque)
+				p = _mm_or_si128(p, alpha);
+			_mm_storeu_si128((__m128i*)(dst + (size_t)x*4), p);
+		}
+		ConvertKernel<Src, Dst, SIMD_SCALAR>::Row(src, dst, x, width);
+	}
+};
+
+template <PixelFormat Src, PixelFormat Dst>
+struct ConvertKernel<Src, Dst, SIMD_AVX2> {
+	SIMD_TARGET_AVX2
+	static void Row(const unsigned char* src, unsigned char* dst, unsigned int x, unsigned int width)
+	{
+		typedef PixelConversion<Src, Dst> Conversion;
+		const __m256i rb = _mm256_set1_epi32(0x00FF00FF);
+		const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+		for (; x + 8 <= width; x += 8) {
+			__m256i p = _mm256_loadu_si256((const __m256i*)(src + (size_t)x*4));
+			if (Conversion::bSwap) {
+				const __m256i c = _mm256_and_si256(p, rb);
+				p = _mm256_or_si256(_mm256_andnot_si256(rb, p),
+					_mm256_or_si256(_mm256_slli_epi32(c, 16), _mm256_srli_epi32(c, 16)));
+			}
+			if (Conversion::bOpaque)
+				p = _mm256_or_si256(p, alpha);
+			_mm256_storeu_si256((__m256i*)(dst + (size_t)x*4), p);
+		}
+		ConvertKernel<Src, Dst, SIMD_SCALAR>::Row(src, dst, x, width);
+	}
+};
+
+#endif // SIMD_X86
+
+#ifdef SIMD_NEON
+
+template <PixelFormat Src, PixelFormat Dst>
+struct ConvertKernel<Src, Dst, SIMD_NEON> {
+	static void Row(const unsigned char* src, unsigned char* dst, unsigned int x, unsigned int width)
+	{
+		typedef PixelConversion<Src, Dst> Conversion;
+		for (; x + 16 <= width; x += 16) {
+			// Channels de-interleaved into separate registers
+			uint8x16x4_t p = vld4q_u8(src + (size_t)x*4);
+			if (Conversion::bSwap) {
+				const uint8x16_t c = p.val[0];
+				p.val[0] = p.val[2];
+				p.val[2] = c;
+			}
+			if (Conversion::bOpaque)
+				p.val[3] = vdupq_n_u8(255);
+			vst4q_u8(dst + (size_t)x*4, p);
+		}
+		ConvertKernel<Src, Dst, SIMD_SCALAR>::Row(src, dst, x, width);
+	}
+};
+
+#endif // SIMD_NEON
+
+// Kernels for every pair of formats
+template <SimdLevel Level>
+static ConvertRow GetConvertRow(PixelFormat src, PixelFormat dst)
+{
+	static const ConvertRow rows[PIXEL_FORMATS][PIXEL_FORMATS] = {
+		{ ConvertKernel<PIXEL_BGRA, PIXEL_BGRA, Level>::Row,
+		  ConvertKernel<PIXEL_BGRA, PIXEL_RGBA, Level>::Row,
+		  ConvertKernel<PIXEL_BGRA, PIXEL_BGRX, Level>::Row },
+		{ ConvertKernel<PIXEL_RGBA, PIXEL_BGRA, Level>::Row,
+		  ConvertKernel<PIXEL_RGBA, PIXEL_RGBA, Level>::Row,
+		  ConvertKernel<PIXEL_RGBA, PIXEL_BGRX, Level>::Row },
+		{ ConvertKernel<PIXEL_BGRX, PIXEL_BGRA, Level>::Row,
+		  ConvertKernel<PIXEL_BGRX, PIXEL_RGBA, Level>::Row,
+		  ConvertKernel<PIXEL_BGRX, PIXEL_BGRX, Level>::Row }
+	};
+	return rows[src][dst];
+}
+
+static ConvertRow GetConvertRow(PixelFormat src, PixelFormat dst, SimdLevel level)
+{
+	switch (level) {
+#ifdef SIMD_X86
+		case SIMD_AVX2: return GetConvertRow<SIMD_AVX2>(src, dst);
+		case SIMD_SSE2: return GetConvertRow<SIMD_SSE2>(src, dst);
+#endif
+#ifdef SIMD_NEON
+		case SIMD_NEON: return GetConvertRow<SIMD_NEON>(src, dst);
+#endif
+		default:        return GetConvertRow<SIMD_SCALAR>(src, dst);
+	}
+}
+
+//
+// Blend
+//
+// Row() blends the bytes of a line from i to the end.
+// Weight is 1-255, so that both weights fit in a byte and
+// a*(256 - weight) + b*weight + 128 fits in 16 bits.
+//
+
+typedef void (*BlendRow)(const unsigned char* a, const unsigned char* b, unsigned char* dst,
+	unsigned int i, unsigned int bytes, unsigned int weight);
+
+template <SimdLevel Level>
+struct BlendKernel {
+	static void Row(const unsigned char* a, const unsigned char* b, unsigned char* dst,
+		unsigned int i, unsigned int bytes, unsigned int weight)
+	{
+		const unsigned int inverse = 256 - weight;
+		for (; i < bytes; i++)
+			dst[i] = (unsigned char)((a[i]*inverse + b[i]*weight + 128) >> 8);
+	}
+};
+
+#ifdef SIMD_X86
+
+template <>
+struct BlendKernel<SIMD_SSE2> {
+	static void Row(const unsigned char* a, const unsigned char* b, unsigned char* dst,
+		unsigned int i, unsigned int bytes, unsigned int weight)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i wa = _mm_set1_epi16((short)(256 - weight));
+		const __m128i wb = _mm_set1_epi16((short)weight);
+		const __m128i round = _mm_set1_epi16(128);
+		for (; i + 16 <= bytes; i += 16) {
+			const __m128i pa = _mm_loadu_si128((const __m128i*)(a + i));
+			const __m128i pb = _mm_loadu_si128((const __m128i*)(b + i));
+			__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pa, zero), wa),
+				_mm_mullo_epi16(_mm_unpacklo_epi8(pb, zero), wb));
+			__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pa, zero), wa),
+				_mm_mullo_epi16(_mm_unpackhi_epi8(pb, zero), wb));
+			lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+			hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+		}
+		BlendKernel<SIMD_SCALAR>::Row(a, b, dst, i, bytes, weight);
+	}
+};
+
+template <>
+struct BlendKernel<SIMD_AVX2> {
+	SIMD_TARGET_AVX2
+	static void Row(const unsigned char* a, const unsigned char* b, unsigned char* dst,
+		unsigned int i, unsigned int bytes, unsigned int weight)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i wa = _mm256_set1_epi16((short)(256 - weight));
+		const __m256i wb = _mm256_set1_epi16((short)weight);
+		const __m256i round = _mm256_set1_epi16(128);
+		for (; i + 32 <= bytes; i += 32) {
+			// Unpack and pack are within each 128 bit lane so the order is kept
+			const __m256i pa = _mm256_loadu_si256((const __m256i*)(a + i));
+			const __m256i pb = _mm256_loadu_si256((const __m256i*)(b + i));
+			__m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(pa, zero), wa),
+				_mm256_mullo_epi16(_mm256_unpacklo_epi8(pb, zero), wb));
+			__m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(pa, zero), wa),
+				_mm256_mullo_epi16(_mm256_unpackhi_epi8(pb, zero), wb));
+			lo = _mm256_srli_epi16(_mm256_add_epi16(lo, round), 8);
+			hi = _mm256_srli_epi16(_mm256_add_epi16(hi, round), 8);
+			_mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+		}
+		BlendKernel<SIMD_SCALAR>::Row(a, b, dst, i, bytes, weight);
+	}
+};
+
+#endif // SIMD_X86
+
+#ifdef SIMD_NEON
+
+template <>
+struct BlendKernel<SIMD_NEON> {
+	static void Row(const unsigned char* a, const unsigned char* b, unsigned char* dst,
+		unsigned int i, unsigned int bytes, unsigned int weight)
+	{
+		const uint8x8_t wa = vdup_n_u8((uint8_t)(256 - weight));
+		const uint8x8_t wb = vdup_n_u8((uint8_t)weight);
+		for (; i + 16 <= bytes; i += 16) {
+			const uint8x16_t pa = vld1q_u8(a + i);
+			const uint8x16_t pb = vld1q_u8(b + i);
+			const uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(pa), wa), vget_low_u8(pb), wb);
+			const uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(pa), wa), vget_high_u8(pb), wb);
+			// Rounding shift is (x + 128) >> 8
+			vst1q_u8(dst + i, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+		}
+		BlendKernel<SIMD_SCALAR>::Row(a, b, dst, i, bytes, weight);
+	}
+};
+
+#endif // SIMD_NEON
+
+static BlendRow GetBlendRow(SimdLevel level)
+{
+	switch (level) {
+#ifdef SIMD_X86
+		case SIMD_AVX2: return BlendKernel<SIMD_AVX2>::Row;
+		case SIMD_SSE2: return BlendKernel<SIMD_SSE2>::Row;
+#endif
+#ifdef SIMD_NEON
+		case SIMD_NEON: return BlendKernel<SIMD_NEON>::Row;
+#endif
+		default:        return BlendKernel<SIMD_SCALAR>::Row;
+	}
+}
+
+//
+// Buffers
+//
+
+void ConvertPixels(const unsigned char* src, unsigned int srcpitch, PixelFormat srcformat,
+	unsigned char* dst, unsigned int dstpitch, PixelFormat dstformat,
+	unsigned int width, unsigned int height, SimdLevel level)
+{
+	if (!src || !dst || width == 0 || height == 0)
+		return;
+	if ((unsigned int)srcformat >= PIXEL_FORMATS || (unsigned int)dstformat >= PIXEL_FORMATS)
+		return;
+	if (srcpitch == 0) srcpitch = width*4;
+	if (dstpitch == 0) dstpitch = width*4;
+
+	const ConvertRow row = GetConvertRow(srcformat, dstformat, ResolveSimdLevel(level));
+	for (unsigned int y = 0; y < height; y++)
+		row(src + (size_t)y*srcpitch, dst + (size_t)y*dstpitch, 0, width);
+}
+
+void BlendPixels(const unsigned char* a, const unsigned char* b, unsigned char* dst,
+	unsigned int width, unsigned int height, unsigned int pitch,
+	unsigned int weight, SimdLevel level)
+{
+	if (!a || !b || !dst || width == 0 || height == 0)
+		return;
+	if (pitch == 0)
+		pitch = width*4;
+
+	// Either end is a copy
+	if (weight == 0 || weight >= 256) {
+		const unsigned char* src = (weight == 0) ? a : b;
+		if (src != dst) {
+			for (unsigned int y = 0; y < height; y++)
+				memcpy(dst + (size_t)y*pitch, src + (size_t)y*pitch, (size_t)width*4);
+		}
+		return;
+	}
+
+	const BlendRow row = GetBlendRow(ResolveSimdLevel(level));
+	for (unsigned int y = 0; y < height; y++) {
+		const size_t offset = (size_t)y*pitch;
+		row(a + offset, b + offset, dst + offset, 0, width*4, weight);
+	}
+}
+
+const char* PixelFormatName(PixelFormat format)
+{
+	switch (format) {
+		case PIXEL_BGRA: return "BGRA";
+		case PIXEL_RGBA: return "RGBA";
+		case PIXEL_BGRX: return "BGRX";
+		default:         return "Unknown";
+	}
+}
@@ -0,0 +1,66 @@
+//
+//		PixelKernels
+//
+//		Row kernels for 32 bit pixel buffers.
+//
+//		  o Convert - copy between BGRA, RGBA and BGRX (alpha not used)
+//		  o Blend   - mix two buffers by a weight, for cross fades
+//
+//		Each kernel is a template specialised at compile time for the
+//		source and destination formats and for the instruction set.
+//		Scalar, SSE2, AVX2 and NEON variants are selected when called
+//		by the SimdLevel, SIMD_AUTO for the best this CPU supports.
+//		All variants produce exactly the same result as the scalar kernel.
+//
+//		Benchmark/KernelBench.cpp times every variant of these kernels,
+//		the YuvConvert, FrameScaler and FrameChange kernels and checks
+//		them against the scalar result.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include "CpuFeatures.h"
+
+// Byte order of a 32 bit pixel
+enum PixelFormat {
+	PIXEL_BGRA = 0,
+	PIXEL_RGBA,
+	PIXEL_BGRX, // Alpha undefined, written as 255 for a format with alpha
+	PIXEL_FORMATS
+};
+
+// Convert a buffer between pixel formats.
+// Pitch is bytes per line, 0 for width*4. Source and destination may be the same.
+void ConvertPixels(const unsigned char* src, unsigned int srcpitch, PixelFormat srcformat,
+	unsigned char* dst, unsigned int dstpitch, PixelFormat dstformat,
+	unsigned int width, unsigned int height, SimdLevel level = SIMD_AUTO);
+
+// Blend two buffers of the same format and size.
+// dst = (a*(256 - weight) + b*weight + 128)/256 for each byte.
+// Weight 0 is a and 256 is b. Pitch is bytes per line, 0 for width*4.
+// The destination may be the same as either source.
+void BlendPixels(const unsigned char* a, const unsigned char* b, unsigned char* dst,
+	unsigned int width, unsigned int height, unsigned int pitch,
+	unsigned int weight, SimdLevel level = SIMD_AUTO);
+
+// Name for statistics
+const char* PixelFormatName(PixelFormat format);
@@ -0,0 +1,164 @@
+//
+//		Presenter
+//
+//		Draws BGRA frames to a target placed with a fit mode.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "Presenter.h"
+#include "FrameStats.h"
+#include "FrameTrace.h"
+#include <math.h>
+#include <chrono>
+#include <algorithm>
+
+bool Presenter::Present(const unsigned char* frame, unsigned int width, unsigned int height, FitMode mode,
+	const FrameChange* change)
+{
+	unsigned int targetWidth = 0;
+	unsigned int targetHeight = 0;
+	if (!frame || width == 0 || height == 0 || !GetTargetSize(targetWidth, targetHeight))
+		return false;
+
+	TRACE_SCOPE("Present", "present");
+	const auto start = std::chrono::steady_clock::now();
+
+	// Source and destination for the fit mode
+	const FitRect src = FitSource(width, height, targetWidth, targetHeight, mode);
+	const FitRect dst = FitDestination(width, height, targetWidth, targetHeight, mode);
+	// Borders only need to be cleared if the frame does not cover the target
+	const bool bClear = m_bInvalid && (dst.x > 0 || dst.y > 0);
+
+	// Only the changed tiles if the frame is placed as it was last time
+	const bool bSame = !m_bInvalid
+		&& width == m_LastWidth && height == m_LastHeight && m_Filter == m_LastFilter
+		&& src.x == m_LastSrc.x && src.y == m_LastSrc.y && src.width == m_LastSrc.width && src.height == m_LastSrc.height
+		&& dst.x == m_LastDst.x && dst.y == m_LastDst.y && dst.width == m_LastDst.width && dst.height == m_LastDst.height;
+	const bool bPartial = bSame && change && DirtyRegions(*change, width, height, src, dst);
+
+	if (!Draw(frame, width, height, src, dst, bClear, bPartial ? &m_Regions : nullptr)) {
+		m_bInvalid = true;
+		return false;
+	}
+	m_bInvalid = false;
+	m_LastSrc = src;
+	m_LastDst = dst;
+	m_LastWidth = width;
+	m_LastHeight = height;
+	m_LastFilter = m_Filter;
+
+	double dirty = 1.0;
+	if (bPartial) {
+		double area = 0.0;
+		for (size_t i = 0; i < m_Regions.size(); i++)
+			area += (double)m_Regions[i].width*(double)m_Regions[i].height;
+		dirty = area/((double)dst.width*(double)dst.height);
+		m_Stats.partial++;
+	}
+
+	const double msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	m_Stats.presents++;
+	m_Stats.mean += (msec - m_Stats.mean)/(double)m_Stats.presents;
+	m_Stats.dirty += (dirty - m_Stats.dirty)/(double)m_Stats.presents;
+	if (msec > m_Stats.max) m_Stats.max = msec;
+	m_Stats.last = msec;
+	FrameStats::Shared().Record(STAGE_PRESENT, (uint64_t)(msec*1000.0));
+
+	return true;
+}
+
+bool Presenter::DirtyRegions(const FrameChange& change, unsigned int width, unsigned int height,
+	const FitRect& src, const FitRect& dst)
+{
+	m_Regions.clear();
+	m_Runs.clear();
+
+	const unsigned int tile = change.GetTileSize();
+	const unsigned int tilesX = change.GetTilesX();
+	const unsigned int tilesY = change.GetTilesY();
+	const std::vector<unsigned char>& changed = change.GetChanged();
+	// The tiles must be for a frame of this size
+	if (tilesX != (width + tile - 1)/tile || tilesY != (height + tile - 1)/tile || changed.size() < (size_t)tilesX*tilesY)
+		return false;
+
+	// Runs of changed tiles on each line of tiles. A run with the same
+	// extent as one ending on the line above is joined to it.
+	for (unsigned int ty = 0; ty < tilesY; ty++) {
+		const size_t line = m_Runs.size();
+		const int y = (int)(ty*tile);
+		const int h = (int)std::min(tile, height - ty*tile);
+		unsigned int tx = 0;
+		while (tx < tilesX) {
+			if (!changed[(size_t)ty*tilesX + tx]) {
+				tx++;
+				continue;
+			}
+			const unsigned int tx0 = tx;
+			while (tx < tilesX && changed[(size_t)ty*tilesX + tx])
+				tx++;
+			const int x = (int)(tx0*tile);
+			const int w = (int)(std::min(tx*tile, width) - tx0*tile);
+			bool bJoined = false;
+			for (size_t i = 0; i < line; i++) {
+				if (m_Runs[i].x == x && m_Runs[i].width == w && m_Runs[i].y + m_Runs[i].height == y) {
+					m_Runs[i].height += h;
+					bJoined = true;
+					break;
+				}
+			}
+			if (!bJoined)
+				m_Runs.push_back({ x, y, w, h });
+		}
+	}
+
+	// Source pixels reached by the filter beyond a changed pixel
+	const double scaleX = (double)src.width/(double)dst.width;
+	const double scaleY = (double)src.height/(double)dst.height;
+	const int reachX = (m_Filter == SCALE_NEAREST) ? 1 : (int)ceil(scaleX) + 2;
+	const int reachY = (m_Filter == SCALE_NEAREST) ? 1 : (int)ceil(scaleY) + 2;
+
+	const double limit = m_DirtyThreshold*(double)dst.width*(double)dst.height;
+	double area = 0.0;
+	for (size_t i = 0; i < m_Runs.size(); i++) {
+		const FitRect& run = m_Runs[i];
+		// Source rectangle relative to the fit source
+		const int sx0 = std::max(run.x - reachX, src.x) - src.x;
+		const int sy0 = std::max(run.y - reachY, src.y) - src.y;
+		const int sx1 = std::min(run.x + run.width + reachX, src.x + src.width) - src.x;
+		const int sy1 = std::min(run.y + run.height + reachY, src.y + src.height) - src.y;
+		if (sx1 <= sx0 || sy1 <= sy0)
+			continue; // Cropped by the fit
+		// Destination pixels with any part in it
+		FitRect region;
+		region.x = dst.x + std::max(0, (int)floor((double)sx0/scaleX));
+		region.y = dst.y + std::max(0, (int)floor((double)sy0/scaleY));
+		region.width = dst.x + std::min(dst.width, (int)ceil((double)sx1/scaleX)) - region.x;
+		region.height = dst.y + std::min(dst.height, (int)ceil((double)sy1/scaleY)) - region.y;
+		if (region.width <= 0 || region.height <= 0)
+			continue;
+		area += (double)region.width*(double)region.height;
+		if (area > limit)
+			return false;
+		m_Regions.push_back(region);
+	}
+
+	return true;
+}
@@ -0,0 +1,136 @@
+//
+//		Presenter
+//
+//		Draws BGRA frames to a target placed with a fit mode.
+//
+//		A presenter keeps the surfaces it needs between frames and only
+//		refreshes them when Reset is called after the display changes.
+//
+//		  o GdiPresenter    - the desktop worker window (Windows)
+//		  o MemoryPresenter - a pixel buffer, for testing and benchmarks
+//
+//		Frames that need scaling are filtered with the FrameScaler.
+//
+//		If the tiles of the frame that have changed since the last Present
+//		are given, only the parts of the target they cover are drawn. Each
+//		run of changed tiles is widened by the reach of the scaling filter
+//		and mapped to the destination, so the result is the same as drawing
+//		the whole frame. The whole frame is drawn instead if the dirty area
+//		is more than a fraction of the destination, or if the placement,
+//		frame size or filter have changed.
+//
+//		The time taken by each Present is recorded.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "FrameFit.h"
+#include "FrameScaler.h"
+#include "FrameChange.h"
+
+// Time taken to present frames (msec)
+struct PresenterStats {
+	uint64_t presents = 0;
+	uint64_t partial = 0;    // Presents that only drew the changed tiles
+	double mean = 0.0;
+	double max = 0.0;
+	double last = 0.0;
+	double dirty = 0.0;      // Mean fraction of the destination drawn
+};
+
+class Presenter {
+
+public:
+
+	virtual ~Presenter() {}
+
+	// Size of the target in pixels. Cached until Reset.
+	virtual bool GetTargetSize(unsigned int& width, unsigned int& height) = 0;
+
+	// The target or display has changed.
+	// Cached surfaces and the target size are refreshed on next use.
+	virtual void Reset() = 0;
+
+	// Buffer of width*height BGRA pixels that can be presented without a copy.
+	// Valid until the next call with a different size or ReleaseSurface.
+	// Returns nullptr if the presenter has none.
+	virtual unsigned char* GetSurface(unsigned int width, unsigned int height) = 0;
+	virtual void ReleaseSurface() = 0;
+
+	// Filter used when frames are scaled to the target
+	void SetFilter(ScaleFilter filter) { m_Filter = filter; }
+	ScaleFilter GetFilter() const { return m_Filter; }
+
+	// The whole target is drawn at the next Present,
+	// clearing the target outside the frame
+	void Invalidate() { m_bInvalid = true; }
+	bool IsInvalid() const { return m_bInvalid; }
+
+	// Fraction of the destination area above which
+	// the whole frame is drawn instead of the changed tiles. Default 0.5.
+	void SetDirtyThreshold(double fraction) { m_DirtyThreshold = fraction; }
+	double GetDirtyThreshold() const { return m_DirtyThreshold; }
+
+	// Draw a width x height BGRA frame placed in the target with the fit mode.
+	// If change is given, it holds the tiles of the frame that have changed
+	// since the frame last presented.
+	bool Present(const unsigned char* frame, unsigned int width, unsigned int height, FitMode mode,
+		const FrameChange* change = nullptr);
+
+	const PresenterStats& GetStats() const { return m_Stats; }
+	void ResetStats() { m_Stats = PresenterStats(); }
+
+protected:
+
+	// Draw the source rectangle of the frame to the destination rectangle of the target.
+	// If regions is not null, only those parts of the destination are drawn.
+	// They are in target pixels and inside the destination.
+	virtual bool Draw(const unsigned char* frame, unsigned int width, unsigned int height,
+		const FitRect& src, const FitRect& dst, bool bClear, const std::vector<FitRect>* regions) = 0;
+
+	FrameScaler m_Scaler;
+
+private:
+
+	// Destination regions covering the changed tiles.
+	// Returns false if the whole frame should be drawn.
+	bool DirtyRegions(const FrameChange& change, unsigned int width, unsigned int height,
+		const FitRect& src, const FitRect& dst);
+
+	ScaleFilter m_Filter = SCALE_AREA;
+	bool m_bInvalid = true;
+	double m_DirtyThreshold = 0.5;
+	PresenterStats m_Stats;
+
+	// Placement of the last frame drawn
+	FitRect m_LastSrc{};
+	FitRect m_LastDst{};
+	unsigned int m_LastWidth = 0;
+	unsigned int m_LastHeight = 0;
+	ScaleFilter m_LastFilter = SCALE_AREA;
+
+	std::vector<FitRect> m_Regions;
+	std::vector<FitRect> m_Runs;       // Runs of changed tiles in frame pixels
+
+};
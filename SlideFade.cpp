@@ -0,0 +1,141 @@
+//
+//		SlideFade
+//
+//		Cross fade between slides drawn by a Presenter.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "SlideFade.h"
+#include "PixelKernels.h"
+#include "FrameTrace.h"
+#include <chrono>
+
+SlideFade::SlideFade()
+{
+}
+
+void SlideFade::Start(const std::string& path, FrameBuffer& slide, unsigned int width, unsigned int height,
+	double now, bool bFade)
+{
+	// A transition still in progress ends at the slide it was fading to
+	if (IsFading())
+		EndFade(nullptr);
+
+	if (bFade && m_Duration > 0.0 && !m_Slide.empty() && width == m_Width && height == m_Height)
+		m_From = std::move(m_Slide);
+
+	m_Slide = std::move(slide);
+	m_Width = width;
+	m_Height = height;
+	m_Path = path;
+	m_bPending = true;
+	m_Start = now;
+	m_Cost = 0.0;
+	// The first frame drawn is the first that differs from the slide shown
+	m_Next = IsFading() ? now + m_Interval : now;
+}
+
+bool SlideFade::Present(Presenter& presenter, double now)
+{
+	if (m_Slide.empty())
+		return false;
+
+	// Nothing to draw between transitions or before the next frame is due
+	if (IsFading() ? now < m_Next : !m_bPending)
+		return true;
+
+	const auto start = std::chrono::steady_clock::now();
+	const double t = IsFading() ? (now - m_Start)/m_Duration : 1.0;
+
+	if (t >= 1.0) {
+		// A cut, or the last frame of a transition, is the slide itself
+		const bool bDrawn = presenter.Present(m_Slide.data(), m_Width, m_Height, FIT_STRETCH);
+		if (bDrawn)
+			m_bPending = false;
+		if (IsFading()) {
+			m_Cost += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			EndFade(&presenter);
+		}
+		else if (bDrawn) {
+			m_Stats.cuts++;
+		}
+		return bDrawn;
+	}
+
+	// Mixed into the surface of the presenter so that it is drawn without a copy
+	unsigned char* dst = presenter.GetSurface(m_Width, m_Height);
+	if (!dst) {
+		if (m_Blend.empty())
+			m_Blend = FramePool::Shared().Acquire((size_t)m_Width*m_Height*4);
+		dst = m_Blend.data();
+	}
+	if (!dst)
+		return false;
+
+	const unsigned int weight = (t <= 0.0) ? 0 : (unsigned int)(t*256.0);
+	{
+		TRACE_SCOPE("Blend slides", "present");
+		BlendPixels(m_From.data(), m_Slide.data(), dst, m_Width, m_Height, m_Width*4, weight);
+	}
+	const auto blended = std::chrono::steady_clock::now();
+	const bool bDrawn = presenter.Present(dst, m_Width, m_Height, FIT_STRETCH);
+	const auto end = std::chrono::steady_clock::now();
+
+	const double blend = std::chrono::duration<double, std::milli>(blended - start).count();
+	const double present = std::chrono::duration<double, std::milli>(end - blended).count();
+	m_Stats.frames++;
+	m_Stats.blend += (blend - m_Stats.blend)/(double)m_Stats.frames;
+	m_Stats.present += (present - m_Stats.present)/(double)m_Stats.frames;
+	m_Cost += blend + present;
+
+	// The last frame is at the end of the transition
+	m_Next = now + m_Interval;
+	if (m_Next > m_Start + m_Duration)
+		m_Next = m_Start + m_Duration;
+
+	return bDrawn;
+}
+
+void SlideFade::Release()
+{
+	m_From.reset();
+	m_Slide.reset();
+	m_Blend.reset();
+	m_Path.clear();
+	m_bPending = false;
+	m_Width = 0;
+	m_Height = 0;
+}
+
+void SlideFade::EndFade(Presenter* presenter)
+{
+	m_From.reset();
+	m_Blend.reset();
+	// The surface is not needed until the next transition
+	if (presenter)
+		presenter->ReleaseSurface();
+
+	m_Stats.fades++;
+	m_Stats.cost += (m_Cost - m_Stats.cost)/(double)m_Stats.fades;
+	if (m_Cost > m_Stats.max)
+		m_Stats.max = m_Cost;
+	m_Cost = 0.0;
+}
@@ -0,0 +1,111 @@
+//
+//		SlideFade
+//
+//		Cross fade between slides drawn by a Presenter.
+//
+//		Slides are BGRA frames already fitted to the target size. The slide
+//		shown and the next one are held, and for each frame of a transition
+//		they are mixed by BlendPixels into the surface of the presenter and
+//		drawn. Frames are only drawn while a transition is in progress. The
+//		blend surface and the last slide are released at the end, so that
+//		only the slide shown is held between transitions.
+//
+//		The time taken by each transition is recorded.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "Presenter.h"
+#include "FramePool.h"
+
+// Transitions drawn and the time taken (msec)
+struct SlideFadeStats {
+	uint64_t fades = 0;      // Transitions drawn
+	uint64_t frames = 0;     // Frames blended for them
+	uint64_t cuts = 0;       // Slides drawn without a transition, including redraws
+	double blend = 0.0;      // Mean time to blend a frame
+	double present = 0.0;    // Mean time to present a frame
+	double cost = 0.0;       // Mean time spent on a transition, including the last frame
+	double max = 0.0;        // Longest time spent on a transition
+};
+
+class SlideFade {
+
+public:
+
+	SlideFade();
+
+	// Length of a transition (msec). Default 1000, 0 to cut.
+	void SetDuration(double msec) { m_Duration = msec; }
+	double GetDuration() const { return m_Duration; }
+	// Time between the frames of a transition (msec). Default 30 fps.
+	void SetInterval(double msec) { m_Interval = msec; }
+	double GetInterval() const { return m_Interval; }
+
+	// Show a width x height BGRA slide from time now (msec).
+	// Blends from the slide shown if it has the same size, otherwise cuts.
+	// The slide buffer is taken.
+	void Start(const std::string& path, FrameBuffer& slide, unsigned int width, unsigned int height,
+		double now, bool bFade = true);
+
+	bool IsFading() const { return !m_From.empty(); }
+	bool HasSlide() const { return !m_Slide.empty(); }
+	// Image of the slide shown
+	const std::string& GetPath() const { return m_Path; }
+
+	// Time the next frame of the transition is due (msec). Negative if not fading.
+	double GetNextTime() const { return IsFading() ? m_Next : -1.0; }
+
+	// Draw the frame due at time now. The slide is drawn once after a cut,
+	// and at the end of a transition, and then not again until the next.
+	bool Present(Presenter& presenter, double now);
+
+	// Release the slides
+	void Release();
+
+	const SlideFadeStats& GetStats() const { return m_Stats; }
+	void ResetStats() { m_Stats = SlideFadeStats(); }
+
+private:
+
+	void EndFade(Presenter* presenter);
+
+	double m_Duration = 1000.0;
+	double m_Interval = 1000.0/30.0;
+
+	FrameBuffer m_From;                // Slide faded from, empty if not fading
+	FrameBuffer m_Slide;               // Slide shown or faded to
+	FrameBuffer m_Blend;               // Frames blended if the presenter has no surface
+	unsigned int m_Width = 0;
+	unsigned int m_Height = 0;
+	std::string m_Path;
+	bool m_bPending = false;           // The slide has not been drawn yet
+
+	double m_Start = 0.0;              // Start of the transition (msec)
+	double m_Next = 0.0;               // Next frame due
+	double m_Cost = 0.0;               // Time spent on the transition so far
+
+	SlideFadeStats m_Stats;
+
+};
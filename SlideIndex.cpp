@@ -0,0 +1,504 @@
+//
+//		SlideIndex
+//
+//		Images in a slideshow folder and its subfolders.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "SlideIndex.h"
+#include "FrameTrace.h"
+#include "stb_image.h"
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+static const char indexMagic[4] = { 'S', 'W', 'I', 'X' };
+static const uint32_t indexVersion = 1;
+
+#ifdef _WIN32
+static const char pathSeparator = '\\';
+#else
+static const char pathSeparator = '/';
+#endif
+
+static std::string JoinPath(const std::string& folder, const std::string& name)
+{
+	if (folder.empty())
+		return name;
+	return folder + pathSeparator + name;
+}
+
+static int64_t FileTime(const fs::file_time_type& time)
+{
+	return (int64_t)time.time_since_epoch().count();
+}
+
+static FILE* OpenFile(const std::string& path, const char* mode)
+{
+	FILE* file = nullptr;
+#ifdef _MSC_VER
+	if (fopen_s(&file, path.c_str(), mode) != 0)
+		file = nullptr;
+#else
+	file = fopen(path.c_str(), mode);
+#endif
+	return file;
+}
+
+SlideIndex::SlideIndex()
+{
+}
+
+void SlideIndex::SetThreads(unsigned int threads)
+{
+	m_nThreads = threads;
+}
+
+bool SlideIndex::Scan(const std::string& folder, const std::string& indexpath, const std::atomic<bool>* bCancel)
+{
+	TRACE_SCOPE("Index slides", "image");
+	const auto start = std::chrono::steady_clock::now();
+	m_Stats = SlideIndexStats();
+	m_Images.clear();
+
+	std::error_code ec;
+	if (folder.empty() || !fs::is_directory(fs::path(folder), ec))
+		return false;
+
+	// Folders from the last scan, in memory or from the index file
+	if (folder != m_Root) {
+		m_Folders.clear();
+		m_Root = folder;
+		if (!indexpath.empty())
+			m_Stats.bLoaded = Load(indexpath, folder);
+	}
+	const std::map<std::string, SlideFolder> previous = std::move(m_Folders);
+	m_Folders.clear();
+
+	// Folders waiting and being scanned
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<std::string> queue;
+	unsigned int pending = 1;
+	bool bRoot = false;
+	queue.push_back(std::string());
+	std::atomic<unsigned int> listed{0};
+	std::atomic<unsigned int> opened{0};
+
+	auto work = [&]() {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			wake.wait(lock, [&]() { return !queue.empty() || pending == 0; });
+			// Folders not started are dropped when cancelled
+			if (bCancel && bCancel->load() && !queue.empty()) {
+				pending -= (unsigned int)queue.size();
+				queue.clear();
+				wake.notify_all();
+				continue;
+			}
+			if (queue.empty())
+				break;
+			const std::string relative = queue.front();
+			queue.pop_front();
+			lock.unlock();
+
+			SlideFolder result;
+			const bool bScanned = ScanFolder(m_Root, relative, previous, result, listed, opened, bCancel);
+
+			lock.lock();
+			if (bScanned) {
+				for (const std::string& name : result.subfolders) {
+					queue.push_back(JoinPath(relative, name));
+					pending++;
+				}
+				if (relative.empty())
+					bRoot = true;
+				m_Folders[relative] = std::move(result);
+			}
+			pending--;
+			wake.notify_all();
+		}
+	};
+
+	// Mostly waiting for the disk, so more threads than cores
+	unsigned int threads = m_nThreads;
+	if (threads == 0)
+		threads = std::min(16u, std::max(4u, std::thread::hardware_concurrency()));
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < threads; i++)
+		workers.push_back(std::thread(work));
+	work();
+	for (std::thread& worker : workers)
+		worker.join();
+
+	// The folders found so far are not kept, so the next scan
+	// starts again from the index file
+	if (!bRoot || (bCancel && bCancel->load())) {
+		m_Folders.clear();
+		m_Root.clear();
+		return false;
+	}
+
+	// Folders in path order, images in name order within each
+	for (const auto& it : m_Folders) {
+		for (const SlideEntry& image : it.second.images) {
+			m_Images.push_back(image);
+			m_Images.back().path = JoinPath(it.first, image.path);
+		}
+	}
+
+	m_Stats.folders = (unsigned int)m_Folders.size();
+	m_Stats.listed = listed.load();
+	m_Stats.opened = opened.load();
+	m_Stats.images = (unsigned int)m_Images.size();
+
+	// Save if a folder was listed again or has gone
+	if (!indexpath.empty() && (m_Stats.listed > 0 || m_Folders.size() != previous.size() || !m_Stats.bLoaded))
+		Save(indexpath);
+
+	m_Stats.msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
+
+bool SlideIndex::ScanFolder(const std::string& root, const std::string& relative,
+	const std::map<std::string, SlideFolder>& previous, SlideFolder& result,
+	std::atomic<unsigned int>& listed, std::atomic<unsigned int>& opened,
+	const std::atomic<bool>* bCancel)
+{
+	const fs::path folder = relative.empty() ? fs::path(root) : fs::path(root) / fs::path(relative);
+	std::error_code ec;
+	const int64_t mtime = FileTime(fs::last_write_time(folder, ec));
+	if (ec)
+		return false;
+
+	// Nothing added, removed or renamed
+	auto last = previous.find(relative);
+	if (last != previous.end() && last->second.mtime == mtime) {
+		result = last->second;
+		return true;
+	}
+
+	listed++;
+	result.mtime = mtime;
+
+	// Images that have not changed are not opened again
+	std::map<std::string, const SlideEntry*> known;
+	if (last != previous.end()) {
+		for (const SlideEntry& image : last->second.images)
+			known[image.path] = &image;
+	}
+
+	for (fs::directory_iterator it(folder, ec), end; !ec && it != end; it.increment(ec)) {
+		if (bCancel && bCancel->load())
+			return false;
+		std::string name;
+		try {
+			name = it->path().filename().string();
+		}
+		catch (...) {
+			continue; // Not representable in the code page
+		}
+		std::error_code fec;
+		// Links are not followed so that there are no loops
+		if (it->is_symlink(fec))
+			continue;
+		if (it->is_directory(fec)) {
+			result.subfolders.push_back(name);
+			continue;
+		}
+		if (!IsImageName(name) || !it->is_regular_file(fec))
+			continue;
+
+		SlideEntry entry;
+		entry.path = name;
+		entry.size = (uint64_t)it->file_size(fec);
+		if (fec)
+			continue;
+		entry.mtime = FileTime(it->last_write_time(fec));
+		if (fec)
+			continue;
+
+		auto image = known.find(name);
+		if (image != known.end() && image->second->size == entry.size && image->second->mtime == entry.mtime) {
+			result.images.push_back(*image->second);
+			continue;
+		}
+
+		opened++;
+		if (ProbeImage((folder / it->path().filename()).string(), name, entry))
+			result.images.push_back(entry);
+	}
+	if (ec)
+		return false;
+
+	std::sort(result.subfolders.begin(), result.subfolders.end());
+	std::sort(result.images.begin(), result.images.end(), [](const SlideEntry& a, const SlideEntry& b) {
+		return a.path < b.path;
+	});
+	return true;
+}
+
+bool SlideIndex::IsImageName(const std::string& name)
+{
+	static const char* extensions[] = { ".jpg", ".jpeg", ".png", ".gif", ".bmp", ".tga", ".tif", ".tiff" };
+	const size_t dot = name.find_last_of('.');
+	if (dot == std::string::npos)
+		return false;
+	std::string extension = name.substr(dot);
+	for (char& c : extension)
+		c = (char)tolower((unsigned char)c);
+	for (const char* e : extensions) {
+		if (extension == e)
+			return true;
+	}
+	return false;
+}
+
+ImageFormat SlideIndex::SniffFormat(const unsigned char* header, size_t bytes)
+{
+	static const unsigned char png[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+	if (bytes >= 3 && header[0] == 0xFF && header[1] == 0xD8 && header[2] == 0xFF)
+		return IMAGE_JPEG;
+	if (bytes >= 8 && memcmp(header, png, 8) == 0)
+		return IMAGE_PNG;
+	if (bytes >= 6 && (memcmp(header, "GIF87a", 6) == 0 || memcmp(header, "GIF89a", 6) == 0))
+		return IMAGE_GIF;
+	if (bytes >= 2 && header[0] == 'B' && header[1] == 'M')
+		return IMAGE_BMP;
+	if (bytes >= 4 && (memcmp(header, "II*\0", 4) == 0 || memcmp(header, "MM\0*", 4) == 0))
+		return IMAGE_TIFF;
+	// TGA has no signature
+	return IMAGE_UNKNOWN;
+}
+
+bool SlideIndex::ProbeImage(const std::string& path, const std::string& name, SlideEntry& entry)
+{
+	FILE* file = OpenFile(path, "rb");
+	if (!file)
+		return false;
+
+	unsigned char header[16]{};
+	const size_t bytes = fread(header, 1, sizeof(header), file);
+	ImageFormat format = SniffFormat(header, bytes);
+	if (format == IMAGE_UNKNOWN) {
+		const size_t dot = name.find_last_of('.');
+		if (dot != std::string::npos && name.size() - dot == 4
+			&& tolower((unsigned char)name[dot + 1]) == 't' && tolower((unsigned char)name[dot + 2]) == 'g'
+			&& tolower((unsigned char)name[dot + 3]) == 'a')
+			format = IMAGE_TGA;
+	}
+
+	// Size from the header. stb_image does not read TIFF.
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	bool bInfo = false;
+	if (format != IMAGE_UNKNOWN && format != IMAGE_TIFF) {
+		fseek(file, 0, SEEK_SET);
+		bInfo = (stbi_info_from_file(file, &width, &height, &channels) != 0);
+	}
+	fclose(file);
+
+	// A TGA is only recognised by its header
+	if (format == IMAGE_UNKNOWN || (format == IMAGE_TGA && !bInfo))
+		return false;
+
+	entry.format = format;
+	entry.width = bInfo ? (unsigned int)width : 0;
+	entry.height = bInfo ? (unsigned int)height : 0;
+	return true;
+}
+
+const char* SlideIndex::ImageFormatName(ImageFormat format)
+{
+	switch (format) {
+		case IMAGE_JPEG: return "JPEG";
+		case IMAGE_PNG:  return "PNG";
+		case IMAGE_GIF:  return "GIF";
+		case IMAGE_BMP:  return "BMP";
+		case IMAGE_TGA:  return "TGA";
+		case IMAGE_TIFF: return "TIFF";
+		default:         return "Unknown";
+	}
+}
+
+//
+// Index file
+//
+
+static void WriteValue(std::vector<unsigned char>& data, const void* value, size_t bytes)
+{
+	const unsigned char* p = (const unsigned char*)value;
+	data.insert(data.end(), p, p + bytes);
+}
+
+static void WriteU32(std::vector<unsigned char>& data, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		data.push_back((unsigned char)(value >> (i*8)));
+}
+
+static void WriteU64(std::vector<unsigned char>& data, uint64_t value)
+{
+	for (int i = 0; i < 8; i++)
+		data.push_back((unsigned char)(value >> (i*8)));
+}
+
+static void WriteString(std::vector<unsigned char>& data, const std::string& str)
+{
+	WriteU32(data, (uint32_t)str.size());
+	WriteValue(data, str.data(), str.size());
+}
+
+// Reads from a buffer, failing at the end
+struct IndexReader {
+	const unsigned char* p;
+	const unsigned char* end;
+	bool bOk = true;
+
+	bool Read(void* value, size_t bytes) {
+		if (!bOk || (size_t)(end - p) < bytes) {
+			bOk = false;
+			return false;
+		}
+		memcpy(value, p, bytes);
+		p += bytes;
+		return true;
+	}
+	uint32_t U32() {
+		unsigned char b[4]{};
+		Read(b, 4);
+		return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+	}
+	uint64_t U64() {
+		const uint64_t lo = U32();
+		return lo | ((uint64_t)U32() << 32);
+	}
+	std::string String() {
+		const uint32_t length = U32();
+		if (!bOk || (size_t)(end - p) < length) {
+			bOk = false;
+			return std::string();
+		}
+		std::string str((const char*)p, length);
+		p += length;
+		return str;
+	}
+};
+
+bool SlideIndex::Load(const std::string& indexpath, const std::string& folder)
+{
+	FILE* file = OpenFile(indexpath, "rb");
+	if (!file)
+		return false;
+	std::vector<unsigned char> data;
+	unsigned char buffer[65536];
+	size_t bytes = 0;
+	while ((bytes = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		data.insert(data.end(), buffer, buffer + bytes);
+	fclose(file);
+
+	IndexReader reader = { data.data(), data.data() + data.size() };
+	char magic[4]{};
+	reader.Read(magic, 4);
+	if (!reader.bOk || memcmp(magic, indexMagic, 4) != 0 || reader.U32() != indexVersion || reader.String() != folder)
+		return false;
+
+	std::map<std::string, SlideFolder> folders;
+	const uint32_t count = reader.U32();
+	for (uint32_t i = 0; i < count && reader.bOk; i++) {
+		const std::string relative = reader.String();
+		SlideFolder& entry = folders[relative];
+		entry.mtime = (int64_t)reader.U64();
+		const uint32_t subfolders = reader.U32();
+		for (uint32_t j = 0; j < subfolders && reader.bOk; j++)
+			entry.subfolders.push_back(reader.String());
+		const uint32_t images = reader.U32();
+		for (uint32_t j = 0; j < images && reader.bOk; j++) {
+			SlideEntry image;
+			image.path = reader.String();
+			image.size = reader.U64();
+			image.mtime = (int64_t)reader.U64();
+			image.width = reader.U32();
+			image.height = reader.U32();
+			unsigned char format = 0;
+			reader.Read(&format, 1);
+			image.format = (ImageFormat)format;
+			entry.images.push_back(image);
+		}
+	}
+	if (!reader.bOk)
+		return false;
+
+	m_Folders.swap(folders);
+	return true;
+}
+
+bool SlideIndex::Save(const std::string& indexpath) const
+{
+	std::vector<unsigned char> data;
+	WriteValue(data, indexMagic, 4);
+	WriteU32(data, indexVersion);
+	WriteString(data, m_Root);
+	WriteU32(data, (uint32_t)m_Folders.size());
+	for (const auto& it : m_Folders) {
+		WriteString(data, it.first);
+		WriteU64(data, (uint64_t)it.second.mtime);
+		WriteU32(data, (uint32_t)it.second.subfolders.size());
+		for (const std::string& name : it.second.subfolders)
+			WriteString(data, name);
+		WriteU32(data, (uint32_t)it.second.images.size());
+		for (const SlideEntry& image : it.second.images) {
+			WriteString(data, image.path);
+			WriteU64(data, image.size);
+			WriteU64(data, (uint64_t)image.mtime);
+			WriteU32(data, image.width);
+			WriteU32(data, image.height);
+			data.push_back((unsigned char)image.format);
+		}
+	}
+
+	// Replaced only when complete
+	const std::string tmppath = indexpath + ".tmp";
+	FILE* file = OpenFile(tmppath, "wb");
+	if (!file)
+		return false;
+	bool bWritten = (fwrite(data.data(), 1, data.size(), file) == data.size());
+	if (fclose(file) != 0)
+		bWritten = false;
+	std::error_code ec;
+	if (bWritten)
+		fs::rename(fs::path(tmppath), fs::path(indexpath), ec);
+	if (!bWritten || ec) {
+		fs::remove(fs::path(tmppath), ec);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,138 @@
+//
+//		SlideIndex
+//
+//		Images in a slideshow folder and its subfolders, kept in an index
+//		file so that a large library is not scanned again each time.
+//
+//		Folders are scanned on several threads. Files with an image
+//		extension, in any case, are opened to find the format from the
+//		first bytes and the image size from the header. Files that are
+//		not images of a known format are left out.
+//
+//		The index file records each folder with its modified time, its
+//		subfolders and its images with their size and modified time. On
+//		later scans only the folders themselves are checked. A folder is
+//		listed again only if its time has changed, which happens when
+//		files are added, removed or renamed in it, and only new or
+//		changed files in it are opened.
+//
+//		Index file layout, little endian
+//		  "SWIX", version, root folder, folder count
+//		  For each folder
+//		    path relative to the root, modified time
+//		    subfolder count and names
+//		    image count and, for each, name, size, modified time,
+//		    width, height and format
+//		  Strings are a 32 bit length and the characters.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+
+enum ImageFormat {
+	IMAGE_UNKNOWN = 0,
+	IMAGE_JPEG,
+	IMAGE_PNG,
+	IMAGE_GIF,
+	IMAGE_BMP,
+	IMAGE_TGA,
+	IMAGE_TIFF
+};
+
+// An image in the folder
+struct SlideEntry {
+	std::string path;          // Relative to the folder
+	uint64_t size = 0;         // File size and modified time
+	int64_t mtime = 0;
+	unsigned int width = 0;    // 0 if the header could not be read
+	unsigned int height = 0;
+	ImageFormat format = IMAGE_UNKNOWN;
+};
+
+// The last scan
+struct SlideIndexStats {
+	unsigned int folders = 0;   // Folders in the library
+	unsigned int listed = 0;    // Folders listed because they had changed
+	unsigned int images = 0;
+	unsigned int opened = 0;    // Files opened for the format and size
+	bool bLoaded = false;       // Index file was read
+	double msec = 0.0;          // Time for the scan
+};
+
+class SlideIndex {
+
+public:
+
+	SlideIndex();
+
+	// Threads to scan with, 0 for the default
+	void SetThreads(unsigned int threads);
+
+	// Find the images in a folder and its subfolders.
+	// The index file is read first and written again if anything has
+	// changed. Empty indexpath for no index file.
+	// Returns false if the folder cannot be read.
+	// A scan is stopped when bCancel is set. It returns false and the
+	// index file is not written.
+	bool Scan(const std::string& folder, const std::string& indexpath, const std::atomic<bool>* bCancel = nullptr);
+
+	// Images found by the last scan, sorted by path
+	const std::vector<SlideEntry>& GetImages() const { return m_Images; }
+
+	const SlideIndexStats& GetStats() const { return m_Stats; }
+
+	// Does the file name have an image extension
+	static bool IsImageName(const std::string& name);
+	// Format from the first bytes of a file
+	static ImageFormat SniffFormat(const unsigned char* header, size_t bytes);
+	// Open a file for the format and size.
+	// Returns false if it is not an image of a known format.
+	static bool ProbeImage(const std::string& path, const std::string& name, SlideEntry& entry);
+	static const char* ImageFormatName(ImageFormat format);
+
+private:
+
+	struct SlideFolder {
+		int64_t mtime = 0;
+		std::vector<std::string> subfolders;
+		std::vector<SlideEntry> images; // Paths are the file name only
+	};
+
+	static bool ScanFolder(const std::string& root, const std::string& relative,
+		const std::map<std::string, SlideFolder>& previous, SlideFolder& result,
+		std::atomic<unsigned int>& listed, std::atomic<unsigned int>& opened,
+		const std::atomic<bool>* bCancel);
+	bool Load(const std::string& indexpath, const std::string& folder);
+	bool Save(const std::string& indexpath) const;
+
+	unsigned int m_nThreads = 0;
+	std::string m_Root;
+	std::map<std::string, SlideFolder> m_Folders; // By path relative to the root
+	std::vector<SlideEntry> m_Images;
+	SlideIndexStats m_Stats;
+
+};
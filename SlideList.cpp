@@ -0,0 +1,104 @@
+//
+//		SlideList
+//
+//		Paths of the slides in a slideshow, changed one path at a time.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "SlideList.h"
+
+SlideList::SlideList()
+{
+}
+
+void SlideList::Assign(const std::vector<std::string>& paths)
+{
+	m_Paths.clear();
+	m_Index.clear();
+	m_Paths.reserve(paths.size());
+	for (const std::string& path : paths)
+		Add(path);
+}
+
+void SlideList::clear()
+{
+	m_Paths.clear();
+	m_Index.clear();
+}
+
+int SlideList::Find(const std::string& path) const
+{
+	auto it = m_Index.find(path);
+	return (it == m_Index.end()) ? -1 : (int)it->second;
+}
+
+bool SlideList::Add(const std::string& path)
+{
+	if (!m_Index.emplace(path, m_Paths.size()).second)
+		return false;
+	m_Paths.push_back(path);
+	return true;
+}
+
+bool SlideList::Remove(const std::string& path, size_t& index, size_t& moved)
+{
+	auto it = m_Index.find(path);
+	if (it == m_Index.end())
+		return false;
+
+	index = it->second;
+	moved = m_Paths.size() - 1;
+	m_Index.erase(it);
+	if (index != moved) {
+		m_Paths[index] = std::move(m_Paths[moved]);
+		m_Index[m_Paths[index]] = index;
+	}
+	m_Paths.pop_back();
+	return true;
+}
+
+bool SlideList::Rename(const std::string& oldpath, const std::string& newpath)
+{
+	auto it = m_Index.find(oldpath);
+	if (it == m_Index.end() || m_Index.count(newpath) > 0)
+		return false;
+
+	const size_t index = it->second;
+	m_Index.erase(it);
+	m_Index[newpath] = index;
+	m_Paths[index] = newpath;
+	return true;
+}
+
+// The paths starting with the folder and a separator follow each other
+std::vector<std::string> SlideList::Within(const std::string& folder) const
+{
+	std::vector<std::string> paths;
+	if (folder.empty())
+		return paths;
+	for (const char separator : { '\\', '/' }) {
+		const std::string prefix = folder + separator;
+		for (auto it = m_Index.lower_bound(prefix); it != m_Index.end()
+			&& it->first.compare(0, prefix.size(), prefix) == 0; it++)
+			paths.push_back(it->first);
+	}
+	return paths;
+}
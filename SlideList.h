@@ -0,0 +1,75 @@
+//
+//		SlideList
+//
+//		Paths of the slides in a slideshow, changed one path at a time.
+//
+//		Paths are held in a vector for the slideshow to index and in a
+//		sorted map to find them. Adding, removing and renaming a path take
+//		logarithmic time. A removed path is replaced by the last path so
+//		that no other path moves and the caller can follow the one that did.
+//
+//		The paths within a subfolder are together in the sorted map, so
+//		they are found without looking at the other paths.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+
+class SlideList {
+
+public:
+
+	SlideList();
+
+	// Replace all paths
+	void Assign(const std::vector<std::string>& paths);
+	void clear();
+	bool empty() const { return m_Paths.empty(); }
+	size_t size() const { return m_Paths.size(); }
+	const std::string& operator[](size_t index) const { return m_Paths[index]; }
+
+	// Index of a path, -1 if not listed
+	int Find(const std::string& path) const;
+
+	// Add a path at the end. False if already listed.
+	bool Add(const std::string& path);
+
+	// Remove a path. The last path moves from 'moved' to 'index',
+	// which are the same if the path removed was the last.
+	// False if not listed.
+	bool Remove(const std::string& path, size_t& index, size_t& moved);
+
+	// Change a path in place. False if not listed or the new path is.
+	bool Rename(const std::string& oldpath, const std::string& newpath);
+
+	// Paths within a folder and its subfolders
+	std::vector<std::string> Within(const std::string& folder) const;
+
+private:
+
+	std::vector<std::string> m_Paths;
+	std::map<std::string, size_t> m_Index; // Sorted by path
+
+};
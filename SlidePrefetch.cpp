@@ -0,0 +1,235 @@
+//
+//		SlidePrefetch
+//
+//		Slides prepared on a worker thread before they are due.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "SlidePrefetch.h"
+#include "FrameTrace.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+SlidePrefetch::SlidePrefetch()
+{
+}
+
+SlidePrefetch::~SlidePrefetch()
+{
+	Close();
+}
+
+std::string SlidePrefetch::MakeKey(const std::string& path, unsigned int width, unsigned int height, FitMode mode)
+{
+	return path + "|" + std::to_string(width) + "x" + std::to_string(height) + "|" + std::to_string((int)mode);
+}
+
+void SlidePrefetch::Prefetch(const std::vector<std::string>& paths, unsigned int width, unsigned int height, FitMode mode)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	m_Queue.clear();
+	std::map<std::string, std::chrono::steady_clock::time_point> ready;
+	for (const std::string& path : paths) {
+		SlideJob job;
+		job.path = path;
+		job.width = width;
+		job.height = height;
+		job.mode = mode;
+		job.key = MakeKey(path, width, height, mode);
+		// Only the next slide is held as a frame
+		job.bFrame = m_bFrames && m_Cache && path == paths.front() && job.key != m_FrameKey;
+		auto it = m_Ready.find(job.key);
+		if (it != m_Ready.end())
+			ready.insert(*it);
+		if ((it == m_Ready.end() || job.bFrame) && job.key != m_Current)
+			m_Queue.push_back(job);
+	}
+	m_Ready.swap(ready);
+
+	m_FrameWanted = (m_bFrames && !paths.empty()) ? MakeKey(paths.front(), width, height, mode) : std::string();
+	if (m_FrameKey != m_FrameWanted) {
+		m_Frame.reset();
+		m_FrameKey.clear();
+	}
+
+	if (!m_Thread.joinable()) {
+		m_bStop = false;
+		m_Thread = std::thread(&SlidePrefetch::Work, this);
+	}
+	m_Wake.notify_one();
+}
+
+bool SlidePrefetch::Take(const std::string& path, unsigned int width, unsigned int height, FitMode mode, double wait)
+{
+	const std::string key = MakeKey(path, width, height, mode);
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	// Finish preparing rather than start again, unless the worker is held
+	// up for longer than the limit. The caller then prepares the slide.
+	bool bWaited = false;
+	if (m_Current == key) {
+		TRACE_SCOPE("Wait for slide", "image");
+		SetWorkerPriority(true);
+		const auto limit = std::chrono::duration<double, std::milli>(wait > 0.0 ? wait : 0.0);
+		if (!m_Done.wait_for(lock, limit, [&]() { return m_Current != key; }))
+			m_Stats.timeouts++;
+		SetWorkerPriority(false);
+		bWaited = true;
+	}
+
+	auto it = m_Ready.find(key);
+	if (it == m_Ready.end() || bWaited) {
+		if (it != m_Ready.end())
+			m_Ready.erase(it);
+		// Not needed from the queue now
+		for (auto job = m_Queue.begin(); job != m_Queue.end(); job++) {
+			if (job->key == key) {
+				m_Queue.erase(job);
+				break;
+			}
+		}
+		m_Stats.misses++;
+		return false;
+	}
+
+	const double lead = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - it->second).count();
+	m_Ready.erase(it);
+	m_Stats.hits++;
+	m_Stats.lead += (lead - m_Stats.lead)/(double)m_Stats.hits;
+	return true;
+}
+
+bool SlidePrefetch::TakeFrame(const std::string& path, unsigned int width, unsigned int height, FitMode mode, double wait, FrameBuffer& frame)
+{
+	Take(path, width, height, mode, wait);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_FrameKey.empty() || m_FrameKey != MakeKey(path, width, height, mode))
+		return false;
+	frame = std::move(m_Frame);
+	m_FrameKey.clear();
+	return true;
+}
+
+void SlidePrefetch::Close()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_bStop = true;
+		m_Queue.clear();
+		m_Wake.notify_one();
+	}
+	if (m_Thread.joinable())
+		m_Thread.join();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Ready.clear();
+	m_Frame.reset();
+	m_FrameKey.clear();
+	m_FrameWanted.clear();
+	m_bStop = false;
+}
+
+SlidePrefetchStats SlidePrefetch::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Stats;
+}
+
+void SlidePrefetch::ResetStats()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Stats = SlidePrefetchStats();
+}
+
+// Called with the mutex locked, so the thread is not joined meanwhile
+void SlidePrefetch::SetWorkerPriority(bool bWaiting)
+{
+#ifdef _WIN32
+	if (m_Thread.joinable())
+		SetThreadPriority(m_Thread.native_handle(),
+			bWaiting ? GetThreadPriority(GetCurrentThread()) : THREAD_PRIORITY_LOWEST);
+#else
+	(void)bWaiting;
+#endif
+}
+
+void SlidePrefetch::Prepare(const SlideJob& job)
+{
+	if (job.bFrame) {
+		// Fitted and cached, then read
+		FrameBuffer frame;
+		if (m_Cache->GetFrame(job.path, job.width, job.height, job.mode, frame)) {
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (job.key == m_FrameWanted) {
+				m_Frame = std::move(frame);
+				m_FrameKey = job.key;
+			}
+		}
+	}
+	else if (m_Cache && m_Cache->IsOpen())
+		m_Cache->GetWallpaper(job.path, job.width, job.height, job.mode);
+	else
+		WallpaperCache::HashFile(job.path); // Read into the system file cache
+}
+
+void SlidePrefetch::Work()
+{
+	FrameTrace::Shared().SetThreadName("Slide prefetch");
+#ifdef _WIN32
+	// Only uses time the render loop and other programs do not
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#endif
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (true) {
+		m_Wake.wait(lock, [this]() { return m_bStop || !m_Queue.empty(); });
+		if (m_bStop)
+			break;
+
+		const SlideJob job = m_Queue.front();
+		m_Queue.pop_front();
+		m_Current = job.key;
+		lock.unlock();
+
+		const auto start = std::chrono::steady_clock::now();
+		{
+			TRACE_SCOPE("Prefetch slide", "image");
+			Prepare(job);
+		}
+		const auto end = std::chrono::steady_clock::now();
+		const double msec = std::chrono::duration<double, std::milli>(end - start).count();
+
+		lock.lock();
+		m_Current.clear();
+		m_Ready[job.key] = end;
+		m_Stats.prepared++;
+		m_Stats.mean += (msec - m_Stats.mean)/(double)m_Stats.prepared;
+		if (msec > m_Stats.max)
+			m_Stats.max = msec;
+		m_Done.notify_all();
+	}
+	m_Current.clear();
+	m_Done.notify_all();
+}
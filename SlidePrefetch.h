@@ -0,0 +1,126 @@
+//
+//		SlidePrefetch
+//
+//		Slides prepared on a worker thread before they are due.
+//
+//		The next slide, or the next few random picks, are fitted into the
+//		WallpaperCache at low priority while the current one is shown, so
+//		that the change at the slide time only has to find the cached file.
+//		If the cache is not open, the image file is read so that it is in
+//		the system file cache, which avoids the delay of a cold network share.
+//
+//		A slide that is being prepared when it is due is waited for rather
+//		than prepared twice. The worker runs at the priority of the caller
+//		while it is waited for, and the wait is limited so that the caller
+//		can prepare the slide itself if the worker does not finish in time.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "WallpaperCache.h"
+
+// Slides ready when due and the time taken to prepare them (msec)
+struct SlidePrefetchStats {
+	uint64_t prepared = 0; // Slides prepared by the worker
+	uint64_t hits = 0;     // Slides that were ready when due
+	uint64_t misses = 0;   // Slides that were not, including any waited for
+	uint64_t timeouts = 0; // Waits that were longer than the limit
+	double mean = 0.0;     // Time to prepare a slide
+	double max = 0.0;
+	double lead = 0.0;     // Average time a slide was ready before it was due
+};
+
+class SlidePrefetch {
+
+public:
+
+	SlidePrefetch();
+	~SlidePrefetch();
+
+	// Cache to prepare slides in, nullptr to only read the files
+	void SetCache(WallpaperCache* cache) { m_Cache = cache; }
+
+	// Slides to prepare next, in order, for the desktop size and fit mode.
+	// Replaces any not started. Slides ready but not listed are forgotten.
+	// Starts the worker thread if necessary.
+	void Prefetch(const std::vector<std::string>& paths, unsigned int width, unsigned int height, FitMode mode);
+
+	// A slide is due. Waits up to "wait" msec if it is being prepared.
+	// Returns true if it was ready.
+	bool Take(const std::string& path, unsigned int width, unsigned int height, FitMode mode, double wait);
+
+	// Also read the first slide listed into a frame for the presenter. Default false.
+	void SetFrames(bool bFrames) { m_bFrames = bFrames; }
+	// The frame of a slide that is due. Waits up to "wait" msec if it is being prepared.
+	// Returns true with the frame if it was ready.
+	bool TakeFrame(const std::string& path, unsigned int width, unsigned int height, FitMode mode, double wait, FrameBuffer& frame);
+
+	// Stop the thread and forget all slides
+	void Close();
+
+	SlidePrefetchStats GetStats() const;
+	void ResetStats();
+
+private:
+
+	struct SlideJob {
+		std::string path;
+		unsigned int width = 0;
+		unsigned int height = 0;
+		FitMode mode = FIT_STRETCH;
+		std::string key;
+		bool bFrame = false;  // Read into a frame as well
+	};
+
+	static std::string MakeKey(const std::string& path, unsigned int width, unsigned int height, FitMode mode);
+	void Prepare(const SlideJob& job);
+	void Work();
+	// Worker priority, the caller's while a slide is waited for
+	void SetWorkerPriority(bool bWaiting);
+
+	WallpaperCache* m_Cache = nullptr;
+	std::thread m_Thread;
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_Wake;    // A job is queued or the thread has to stop
+	std::condition_variable m_Done;    // The current job has finished
+	std::deque<SlideJob> m_Queue;
+	std::string m_Current;             // Key of the job being prepared
+	std::map<std::string, std::chrono::steady_clock::time_point> m_Ready; // Time each slide was ready
+	bool m_bStop = false;
+	SlidePrefetchStats m_Stats;
+
+	// The next slide read for the presenter
+	bool m_bFrames = false;
+	std::string m_FrameWanted;         // Key of the slide to read
+	std::string m_FrameKey;            // Key of the slide in m_Frame
+	FrameBuffer m_Frame;
+
+};
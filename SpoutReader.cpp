@@ -0,0 +1,174 @@
+//
+//		SpoutReader
+//
+//		Background thread that receives frames from a Spout sender
+//		into a FrameMailbox.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "SpoutReader.h"
+#include "FrameStats.h"
+#include "FrameTrace.h"
+
+SpoutReader::SpoutReader()
+{
+}
+
+SpoutReader::~SpoutReader()
+{
+	Release();
+}
+
+bool SpoutReader::Open(FrameMailbox* mailbox)
+{
+	if (!mailbox)
+		return false;
+
+	Close();
+
+	// A device is created in the SpoutDX class
+	if (!m_bDirectX) {
+		if (!m_Receiver.OpenDirectX11())
+			return false;
+		m_bDirectX = true;
+	}
+
+	m_Mailbox = mailbox;
+	m_Mailbox->Reset();
+	m_bStop = false;
+	m_bReceiving = true; // Until found otherwise
+	m_Thread = std::thread(&SpoutReader::ReceiveFrames, this);
+
+	return true;
+}
+
+void SpoutReader::Close()
+{
+	if (m_Thread.joinable()) {
+		m_bStop = true;
+		m_Thread.join();
+	}
+	m_bReceiving = false;
+	if (m_bDirectX)
+		m_Receiver.ReleaseReceiver();
+	// Frame buffers can be used by other sources
+	if (m_Mailbox)
+		m_Mailbox->Release();
+}
+
+void SpoutReader::Release()
+{
+	Close();
+	if (m_bDirectX) {
+		m_Receiver.CloseDirectX11();
+		m_bDirectX = false;
+	}
+}
+
+void SpoutReader::SetSenderName(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(m_NameMutex);
+	m_SenderName = name;
+	m_bNameChanged = true;
+}
+
+void SpoutReader::SetReceiving(bool bReceiving)
+{
+	if (m_bReceiving.exchange(bReceiving) != bReceiving && m_FrameCallback)
+		m_FrameCallback();
+}
+
+void SpoutReader::ReceiveFrames()
+{
+	FrameTrace::Shared().SetThreadName("Spout reader");
+
+	unsigned int width = 0;
+	unsigned int height = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_NameMutex);
+		if (!m_SenderName.empty())
+			m_Receiver.SetReceiverName(m_SenderName.c_str());
+		m_bNameChanged = false;
+	}
+
+	while (!m_bStop) {
+
+		// A sender selected from the menu
+		{
+			std::lock_guard<std::mutex> lock(m_NameMutex);
+			if (m_bNameChanged) {
+				m_Receiver.ReleaseReceiver();
+				m_Receiver.SetReceiverName(m_SenderName.empty() ? nullptr : m_SenderName.c_str());
+				m_bNameChanged = false;
+				width = 0;
+				height = 0;
+			}
+		}
+
+		// ReceiveImage handles sender detection, creation and update.
+		// Nothing is received until the size of the sender is known.
+		unsigned char* buffer = m_Mailbox->BeginWrite(width, height);
+		// Only the time taken for a new frame is recorded.
+		FrameStageTimer receive(STAGE_RECEIVE);
+		bool bReceived = false;
+		{
+			TRACE_SCOPE("ReceiveImage", "receive");
+			bReceived = m_Receiver.ReceiveImage(buffer, width, height); // RGB = false, invert = false
+		}
+		if (bReceived) {
+			SetReceiving(true);
+			// IsUpdated() returns true if the sender has changed
+			if (m_Receiver.IsUpdated()) {
+				receive.Cancel();
+				width = m_Receiver.GetSenderWidth();
+				height = m_Receiver.GetSenderHeight();
+				continue; // Receive at the new size
+			}
+			if (buffer && m_Receiver.IsFrameNew()) {
+				receive.Stop();
+				m_Mailbox->EndWrite();
+				if (m_FrameCallback)
+					m_FrameCallback();
+			}
+		}
+		else {
+			// Because SetReceiverName is used to select the sender,
+			// the receiver waits for that sender to re-open.
+			// Here we need to test to find if it was closed.
+			if (!m_Receiver.sendernames.hasSharedInfo(m_Receiver.GetSenderName())) {
+				// Clear the receiver name to receive from the active sender
+				m_Receiver.SetReceiverName();
+				m_Receiver.ReleaseReceiver();
+				width = 0;
+				height = 0;
+			}
+			// Receiving stops if there is no other sender
+			SetReceiving(m_Receiver.GetSenderCount() > 0);
+		}
+
+		receive.Cancel();
+
+		// Hold the frame rate to reduce CPU load.
+		// Also the wait for a sender to open.
+		m_Receiver.HoldFps(m_MaxFps);
+	}
+}
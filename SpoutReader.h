@@ -0,0 +1,92 @@
+//
+//		SpoutReader
+//
+//		Background thread that receives frames from a Spout sender
+//		into a FrameMailbox.
+//
+//		ReceiveImage waits for the copy of the sender texture to system
+//		memory, several msec for a large frame. On this thread, the render
+//		loop takes the newest frame received without waiting for it.
+//
+//		The DirectX device is opened by Open so that failure can be reported,
+//		and kept until Release. The receiver is only used by the thread while
+//		it runs, and is released when the thread is stopped by Close.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include "..\..\SpoutDirectX\SpoutDX\SpoutDX.h"
+#include "FrameMailbox.h"
+
+class SpoutReader {
+
+public:
+
+	SpoutReader();
+	~SpoutReader();
+
+	// Start receiving into the mailbox
+	bool Open(FrameMailbox* mailbox);
+	// Stop the thread, release the receiver
+	// and return the mailbox buffers to the pool
+	void Close();
+	// Close and release DirectX
+	void Release();
+	bool IsOpen() const { return m_Thread.joinable(); }
+
+	// Sender to receive from. Empty for the active sender.
+	void SetSenderName(const std::string& name);
+	// A sender is open. False if there are no senders.
+	bool IsReceiving() const { return m_bReceiving.load(); }
+
+	// Called on the thread after each frame is published
+	// and when receiving starts or stops
+	void SetFrameCallback(std::function<void()> callback) { m_FrameCallback = callback; }
+
+	// Frames received per second at most
+	void SetMaxFps(int fps) { m_MaxFps = fps; }
+
+private:
+
+	void ReceiveFrames();
+	void SetReceiving(bool bReceiving);
+
+	spoutDX m_Receiver;
+	bool m_bDirectX = false;
+	FrameMailbox* m_Mailbox = nullptr;
+	std::thread m_Thread;
+	std::atomic<bool> m_bStop{false};
+	std::atomic<bool> m_bReceiving{false};
+	std::function<void()> m_FrameCallback;
+	int m_MaxFps = 30;
+
+	// Sender name set for the thread
+	std::mutex m_NameMutex;
+	std::string m_SenderName;
+	bool m_bNameChanged = false;
+
+};
@@ -88,15 +88,128 @@
 //		17.03.24 - Version 1.003
 //		23.03.24 - Correct daily image displayed when sender changed
 //				   Version 1.004
+//		16.10.26 - Read FFmpeg video frames on a background thread into a FrameRing
+//				   Render() presents the newest frame and never waits on the pipe
+//				 - Loop video with -stream_loop in one FFmpeg process instead of
+//				   restarting FFmpeg at the end of the file. Loop stall in About.
+//				 - Add "Fit" menu for stretch, fit, fill or center placement.
+//				   FFmpeg scales video to the size shown on the desktop and
+//				   is restarted with the new size if the desktop changes.
+//				 - FFmpeg sends yuv420p (1.5 bytes per pixel) instead of bgra.
+//				   Converted to BGRA on the reader thread with SSE2/AVX2.
+//				 - Video frames are shown at their presentation time from the
+//				   stream frame rate instead of FFmpeg -re and HoldFps(30).
+//				   Late frames are dropped. Add "Speed" menu for playback speed.
+//				   Pacing jitter shown in About. The average frame rate is used
+//				   and variable rate video is resampled by frame timestamps.
+//				 - FFprobe output read from a pipe instead of probe.bat and
+//				   myprobe.ini. Results cached in DATA\FFMPEG\probecache.txt.
+//				 - Add "Decoder" menu. Video is decoded by the ffmpeg.exe pipe
+//				   or, if built with USE_LIBAV, by the FFmpeg libraries.
+//				 - Add "Frame cache" option. One loop of a short video is recorded
+//				   to DATA\Cache while it plays and replayed from a memory mapped
+//				   file instead of decoding it again. Least recently used files
+//				   are removed when the cache is over its size limit. Only a video
+//				   with an exact frame count is recorded from the pipe.
+//				 - Frames are drawn by a GdiPresenter that keeps the worker window
+//				   DC while the window is there and its size is the same. Received
+//				   Spout frames are written to a DIB section drawn without a copy.
+//				 - Frames scaled to the desktop are filtered by FrameScaler
+//				   (SSE2/AVX2, threaded) instead of StretchDIBits COLORONCOLOR.
+//				   Nearest, Bilinear or Area filter selected in the "Fit" menu.
+//				 - Frames are hashed in tiles by FrameChange. A frame that is the
+//				   same as the last is not drawn, except once a second.
+//				   Frames skipped shown in About.
+//				 - Only the tiles of a frame that have changed are drawn. Each run
+//				   of changed tiles is scaled and copied to the desktop unless the
+//				   changed area is over half of the frame ("dirtythreshold"
+//				   percent in the registry). Partial presents shown in About.
+//				 - Spout frames are received by a SpoutReader thread into a
+//				   FrameMailbox. The newest frame is drawn without waiting for
+//				   ReceiveImage, and the message loop no longer sleeps in HoldFps.
+//				 - Video and Spout frame buffers are 64 byte aligned and recycled
+//				   by a shared FramePool instead of being allocated for each size.
+//				   Large pages if "largepages" is set in the registry.
+//				   Frame memory shown in About.
+//				 - Render is called by a FrameScheduler only when a video frame,
+//				   slide or refresh is due, or a frame has been received. The
+//				   30 msec timer is removed and a still wallpaper does not wake.
+//				 - Idle mode for the image, daily wallpaper and a slideshow of
+//				   one image. DirectX, the worker window DC and unused frame
+//				   buffers are released until another mode is selected.
+//				   Wakes per minute, with and without work, and idle state in About.
+//				 - Receive, read, convert, scale and present times and the
+//				   interval between frames are recorded in FrameStats histograms.
+//				   Percentiles and frame rate shown in About and the tray tooltip.
+//				   "Save statistics" writes them to DATA\framestats.txt.
+//				   Disabled if "framestats" is 0 in the registry.
+//				 - "Trace" menu records Render, ReceiveImage, fread, StretchDIBits,
+//				   OpenVideo, ffprobe, slide and mode changes into a FrameTrace
+//				   ring buffer for each thread ("tracebuffer" events). Saved to
+//				   DATA\trace.json as Chrome trace events when stopped or on exit.
+//				   Started with the program if "trace" is set in the registry.
+//				 - Image, daily and slideshow wallpapers are decoded once with
+//				   stb_image, fitted to the desktop and set as a BMP from a
+//				   WallpaperCache in DATA\Wallpapers so that Explorer does not
+//				   convert large images on each change. "wallpapercache" is the
+//				   budget in MB (default 512, 0 to set images as they are).
+//				   Image hashes are kept in DATA\wallpaperhashes.txt.
+//				 - The next slide, or the next three random picks, are prepared
+//				   by a SlidePrefetch thread at low priority while a slide is
+//				   shown. Slides ready when due shown in About. A slide being
+//				   prepared when due is waited for at normal priority for up to
+//				   a quarter of the slide time, then prepared on the caller.
+//				 - Slideshow images are found in subfolders as well, by extension
+//				   in any case and by the format in the file header. A SlideIndex
+//				   of folders, images, sizes and formats is kept in DATA\Slides so
+//				   that only folders changed since the last time are listed again.
+//				   The folder is scanned on a thread and the slideshow started
+//				   when the images are found. A scan is stopped if another
+//				   folder or mode is selected before it ends.
+//				 - The slideshow folder is watched by DirWatch while it is shown.
+//				   Images added, removed or renamed change the SlideList without
+//				   listing the folder again, after half a second without changes.
+//				   Only a folder added is listed, not one modified by a file
+//				   added to it, and a file already a slide is not opened again.
+//				   The next slide stays the same unless it was removed.
+//				 - Slides can be cross faded, selected in the duration dialog.
+//				   They are then drawn by the presenter instead of set as the
+//				   wallpaper. The next slide is read for the worker window size by
+//				   SlidePrefetch and SlideFade blends the two slides with the SIMD
+//				   BlendPixels kernel at 30 fps for "fadetime" msec (default 1000).
+//				   Nothing is drawn between fades. Fade times shown in About.
 //
 
 #include "stdafx.h"
 #include <windows.h>
 #include <stdio.h> // for printf if used
+#include <math.h> // for ceil
 #include <shlobj.h>
 #include <commdlg.h> // for explorer dialog
 #include "..\..\SpoutDirectX\SpoutDX\SpoutDX.h"
 #include "resource.h"
+#include "FrameRing.h"
+#include "VideoSource.h"
+#include "FrameFit.h"
+#include "YuvConvert.h"
+#include "FramePacer.h"
+#include "FrameScheduler.h"
+#include "VideoProbe.h"
+#include "FrameCache.h"
+#include "DiskCache.h"
+#include "GdiPresenter.h"
+#include "FrameChange.h"
+#include "FramePool.h"
+#include "FrameMailbox.h"
+#include "SpoutReader.h"
+#include "FrameStats.h"
+#include "FrameTrace.h"
+#include "WallpaperCache.h"
+#include "SlidePrefetch.h"
+#include "SlideIndex.h"
+#include "SlideList.h"
+#include "DirWatch.h"
+#include "SlideFade.h"
 
 // for PathStripPath
 #include <Shlwapi.h>
@@ -106,9 +219,15 @@
 #include <Urlmon.h>
 #pragma comment (lib, "Urlmon.lib")
 
+// For timeBeginPeriod
+#include <mmsystem.h>
+#pragma comment (lib, "Winmm.lib")
+
 #define TRAYICONID	1        // ID number for the Notify Icon
 #define SWM_TRAYMSG	WM_APP   // The message ID sent to our window
 #define SWM_EXIT WM_APP + 13 // Close the window
+#define SWM_SLIDES WM_APP + 14 // Slideshow folder changed
+#define SWM_SLIDESCAN WM_APP + 15 // Slideshow folder scanned
 #define MAX_LOADSTRING 100
 
 // Global Variables:
@@ -128,14 +247,25 @@ std::string namestring;
 char name[512]{};
 
 // Spout receiver
-spoutDX receiver;                       // Receiver object
+SpoutReader g_spoutreader;              // Receives frames on its own thread
+FrameMailbox g_mailbox;                 // Newest frame received
 HWND g_hWnd = NULL;                     // Window handle
-unsigned char* g_pixelBuffer = nullptr; // Receiving pixel buffer
 unsigned int g_SenderWidth = 0;         // Received sender width
 unsigned int g_SenderHeight = 0;        // Received sender height
 HWND g_WorkerHwnd = NULL;               // Worker window handle
 void Render();
 
+// Placement of the frame in the worker window
+FitMode g_FitMode = FIT_STRETCH;        // Stretch, fit, fill or center
+unsigned int g_TargetWidth = 0;         // Worker window size
+unsigned int g_TargetHeight = 0;
+GdiPresenter g_presenter;               // Draws frames to the worker window
+void SetFitMode(FitMode mode);
+void SetScaleFilter(ScaleFilter filter);
+FrameChange g_framechange;              // Detects frames that are the same as the last
+uint64_t g_PresentSkips = 0;            // Frames not drawn because they had not changed
+double g_LastPresent = 0.0;             // Time of the last frame drawn (msec, FramePacer clock)
+
 // For the Bing daily wallpaper image
 std::string g_wallpaperpath;      // Current wallpaper image
 bool bCurrentWallpaper = false;   // Showing current wallpaper
@@ -152,18 +282,87 @@ char startingfolder[MAX_PATH]{}; // Initial browse dialog folder
 int nCurrentImage = 0;
 DWORD g_slideshowtime = 30; // Seconds per frame
 double g_start = 0.0; // Start time
-std::vector<std::string> slidenames; // Slideshow file names
-int GetImageFiles(const char* spath, std::vector<std::string>& filenames);
+bool bNextSlide = false; // Show the next slide without waiting
+SlideList slidenames; // Slideshow file names
+std::deque<int> slidepicks; // Next random slides, chosen ahead so that they can be prepared
+SlidePrefetch g_prefetch;   // Prepares the next slides before they are due
+const size_t g_SlidePicks = 3; // Random slides prepared ahead
+void PrefetchSlides();
+int GetImageFiles(std::vector<std::string>& filenames);
+SlideIndex g_slideindex;    // Images in the slideshow folder and subfolders, indexed in DATA\Slides
+SlideIndexStats g_SlideIndexStats; // Last scan finished, for About
+std::thread g_slidescan;    // Scans the folder so that the window is not held up
+std::string g_slidescanpath; // Folder of the last scan asked for
+unsigned int g_SlideScans = 0; // Scans asked for, to ignore the result of one replaced
+bool g_bSlideScanning = false; // Waiting for the result of a scan
+bool g_bSlideScanNew = false;  // A new slideshow rather than the same folder listed again
+bool g_bSlideScanFound = false; // Set by the scan thread before it posts SWM_SLIDESCAN
+std::atomic<bool> g_bSlideScanCancel{false}; // Stops the scan thread
+void StartSlideScan(const std::string& folder, bool bNew);
+void RunSlideScan();
+void FinishSlideScan(unsigned int scan);
+void CancelSlideScan();
+void StartSlideshow(const std::string& folder, const std::vector<std::string>& filenames);
+void SlidesChanged();
+DirWatch g_dirwatch;        // Changes to the slideshow folder while it is shown
+uint64_t g_SlideChanges = 0; // Slides added, removed or renamed since the slideshow started
+void UpdateSlides();
+void AddSlide(const std::string& path, bool bFolder);
+void RemoveSlide(const std::string& path);
+bool bSlideFade = false;    // Slides drawn by the presenter with a cross fade instead of set as the wallpaper
+DWORD g_FadeTime = 1000;    // Cross fade (msec)
+SlideFade g_slidefade;      // The slide shown and the transition to the next
+bool GetSlideSize(unsigned int& width, unsigned int& height);
 
 // For FFmpeg video player
 std::string g_videopath;            // The full video path
 unsigned char g_SenderName[256]={}; // Sender name
+unsigned int g_VideoWidth = 0;      // Video file width
+unsigned int g_VideoHeight = 0;     // Video file height
 float g_FrameRate = 30.0f;          // Video frame rate
-double g_SenderFps = 0.0;           // For fps display averaging
+unsigned int g_FrameRateNum = 30;   // Video frame rate as a fraction
+unsigned int g_FrameRateDen = 1;
+bool g_bVariableRate = false;       // Frames are resampled to the frame rate
+YuvColor g_VideoColor;              // Video colour matrix
+bool g_bYuvPipe = true;             // FFmpeg sends yuv420p instead of bgra
+unsigned int g_VideoFrames = 0;     // Frames in the video (0 if not known)
+bool g_bExactFrames = false;        // g_VideoFrames are the frames sent in each loop
+double g_SenderFps = 0.0;           // Average rate of new frames taken by Render
+double g_LastFrame = 0.0;           // Time of the last new frame (msec, FramePacer clock)
 std::string g_exePath;              // Executable location
 std::string g_ffmpegPath;           // FFmpeg location
-std::string g_input;                // Input string to FFmpeg
-FILE* g_pipein = nullptr;           // Pipe for FFmpeg
+FrameRing g_frames;                 // Video frames read from FFmpeg
+VideoSource* g_source = nullptr;    // Video decoder thread
+VideoBackend g_VideoBackend = VIDEO_PIPE; // FFmpeg process or libraries
+void SetVideoBackend(VideoBackend backend);
+bool IsVideoOpen();
+FramePacer g_pacer;                 // Presentation clock for video frames
+ProbeCache g_probecache;            // FFprobe results for known videos
+int g_VideoSpeed = 100;             // Playback speed percent
+bool g_bTimerPeriod = false;        // 1 msec timer resolution for video
+static int speeds[5] = { 25, 50, 100, 150, 200 }; // percent
+void SetVideoSpeed(int speed);
+DWORD GetRenderWait();
+void ScheduleRender();
+FrameScheduler g_scheduler;         // Wakes the render loop when work is due
+HANDLE g_hWakeEvent = NULL;         // Set by the scheduler to wake the loop
+bool g_bIdle = false;               // Resources released for a still wallpaper
+void EnterIdle();
+DiskCache g_diskcache;              // Decoded video loops in DATA\Cache
+FrameCacheRecorder g_recorder;      // Records a loop of the video playing
+bool g_bFrameCache = true;          // Replay short videos from the cache
+DWORD g_FrameCacheClip = 1024;      // Largest loop to cache (MB)
+DWORD g_FrameCacheBudget = 4096;    // Total size of the cache (MB)
+WallpaperCache g_wallpapercache;    // Images fitted to the desktop in DATA\Wallpapers
+DWORD g_WallpaperBudget = 512;      // Total size of fitted images (MB), 0 to set images as they are
+void SetWallpaperImage(const std::string& path);
+bool GetDesktopSize(unsigned int& width, unsigned int& height);
+std::string GetFrameCachePath(const FitSize& fit);
+void SetFrameCache(bool bCache);
+void UpdateTrayTip();               // Frame rate and times in the tray tooltip
+void SaveFrameStats();              // Frame times to DATA\framestats.txt
+void SetTrace(bool bTrace);         // Start or stop recording a trace
+bool SaveTrace();                   // Trace events to DATA\trace.json
 
 // Forward declarations
 BOOL InitInstance(HINSTANCE, int);
@@ -172,6 +371,7 @@ void ShowContextMenu(HWND hWnd);
 ULONGLONG GetDllVersion(LPCTSTR lpszDllName);
 void RestoreWallPaper();
 bool OpenVideo(std::string filePath);
+bool StartVideo();
 void CloseVideo();
 bool OpenFile(char* filepath, int maxchars, bool bVideo = false);
 bool ffprobe(std::string videoPath);
@@ -237,6 +437,11 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 		return 0;
 	}
 
+	// Video information from previous FFprobe runs
+	std::string cachepath = g_exePath;
+	cachepath += "\\DATA\\FFMPEG\\probecache.txt";
+	g_probecache.Load(cachepath);
+
 	// Get the current wallpaper to restore if changed
 	char path[MAX_PATH]{};
 	if (SystemParametersInfoA(SPI_GETDESKWALLPAPER, MAX_PATH, (void*)path, 0)) {
@@ -248,6 +453,86 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 	ReadPathFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "slideshowfolder", g_slideshowpath);
 	ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "slideshowtime", &g_slideshowtime);
 
+	// Slides cross faded on the desktop and the time for each fade
+	DWORD dwFade = 0;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "slidefade", &dwFade))
+		bSlideFade = (dwFade != 0);
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "fadetime", &dwFade) && dwFade <= 10000)
+		g_FadeTime = dwFade;
+	g_slidefade.SetDuration((double)g_FadeTime);
+
+	// Get the last frame placement mode
+	DWORD dwFitMode = 0;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "fitmode", &dwFitMode) && dwFitMode <= (DWORD)FIT_CENTER)
+		g_FitMode = (FitMode)dwFitMode;
+
+	// Get the last scaling filter
+	DWORD dwFilter = 0;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "scalefilter", &dwFilter) && dwFilter <= (DWORD)SCALE_AREA)
+		g_presenter.SetFilter((ScaleFilter)dwFilter);
+
+	// Percentage of the frame changed above which all of it is drawn
+	DWORD dwDirty = 0;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "dirtythreshold", &dwDirty) && dwDirty <= 100)
+		g_presenter.SetDirtyThreshold((double)dwDirty/100.0);
+
+	// Get the last video decoder
+	DWORD dwBackend = 0;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "videodecoder", &dwBackend)
+		&& IsVideoBackendAvailable((VideoBackend)dwBackend))
+		g_VideoBackend = (VideoBackend)dwBackend;
+
+	// Frame cache option and sizes
+	DWORD dwFrameCache = 1;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "framecache", &dwFrameCache))
+		g_bFrameCache = (dwFrameCache != 0);
+	DWORD dwSize = 0;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "framecacheclip", &dwSize) && dwSize > 0)
+		g_FrameCacheClip = dwSize;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "framecachebudget", &dwSize) && dwSize > 0)
+		g_FrameCacheBudget = dwSize;
+	g_diskcache.Open(g_exePath + "\\DATA\\Cache", (uint64_t)g_FrameCacheBudget*1024*1024);
+
+	// Slideshow folder indexes, kept apart from the cache budgets
+	CreateDirectoryA((g_exePath + "\\DATA\\Slides").c_str(), NULL);
+
+	// Images fitted to the desktop for image, daily and slideshow wallpapers
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "wallpapercache", &dwSize))
+		g_WallpaperBudget = dwSize;
+	if (g_WallpaperBudget > 0)
+		g_wallpapercache.Open(g_exePath + "\\DATA\\Wallpapers", (uint64_t)g_WallpaperBudget*1024*1024);
+	g_prefetch.SetCache(&g_wallpapercache);
+
+	// Frame buffers from large pages if allowed
+	DWORD dwLargePages = 0;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "largepages", &dwLargePages))
+		FramePool::Shared().SetLargePages(dwLargePages != 0);
+
+	// Frame pipeline times are recorded unless "framestats" is 0
+	DWORD dwFrameStats = 1;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "framestats", &dwFrameStats))
+		FrameStats::Shared().SetEnabled(dwFrameStats != 0);
+
+	// Trace events kept for each thread ("tracebuffer")
+	// and tracing from the start if "trace" is set
+	DWORD dwTrace = 0;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "tracebuffer", &dwTrace) && dwTrace > 0)
+		FrameTrace::Shared().SetCapacity((size_t)dwTrace);
+	dwTrace = 0;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "trace", &dwTrace) && dwTrace != 0) {
+		FrameTrace::Shared().SetEnabled(true);
+		FrameTrace::Shared().SetThreadName("Render loop");
+	}
+
+	// Get the last video playback speed
+	DWORD dwSpeed = 0;
+	if (ReadDwordFromRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "videospeed", &dwSpeed)) {
+		for (int i = 0; i < 5; i++) {
+			if ((int)dwSpeed == speeds[i])
+				g_VideoSpeed = speeds[i];
+		}
+	}
+
 
 	//
 	// Optional command line : SpoutWallPaper "video name"
@@ -327,6 +612,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 
 	// Set the global worker window handle for drawing
 	g_WorkerHwnd = hWorker;
+	g_presenter.SetWindow(hWorker);
 
 	// Application initialization
 	if (!InitInstance(hInstance, nCmdShow)) {
@@ -336,14 +622,20 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 
 	hAccelTable = LoadAccelerators(hInstance, (LPCTSTR)IDC_STEALTHDIALOG);
 
-	// Set a timer to activate drawing
-	// High as possible but low enough to prevent hesitation
-	// and less than render rate (at 30fps framerate = 33 msec)
-	SetTimer(hWndMain, 1, 30, NULL);
+	// Event to wake the message loop when a frame is ready
+	// or something has to be drawn at once
+	g_hWakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	g_scheduler.SetWakeCallback([]() {
+		SetEvent(g_hWakeEvent);
+	});
+	g_scheduler.Wake();
 
-	// Initialize DirectX
+	// Initialize DirectX and start receiving.
 	// A device is created in the SpoutDX class.
-	if (!receiver.OpenDirectX11()) {
+	g_spoutreader.SetFrameCallback([]() {
+		g_scheduler.Wake();
+	});
+	if (!g_spoutreader.Open(&g_mailbox)) {
 		RestoreWallPaper();
 		if (g_hMutex) ReleaseMutex(g_hMutex);
 		return 0;
@@ -364,27 +656,51 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 	SetPriorityClass(hProcess, IDLE_PRIORITY_CLASS);
 
 	// Main message loop:
-	while (GetMessage(&msg, NULL, 0, 0)) {
-		if (!TranslateAccelerator(msg.hwnd, hAccelTable, &msg)||
-			!IsDialogMessage(msg.hwnd,&msg) ) 
-		{
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
+	// Wait for a message, a wake from the scheduler, or until the
+	// next frame, slide or refresh is due. Render only if one is.
+	bool bQuit = false;
+	while (!bQuit) {
+		MsgWaitForMultipleObjectsEx(1, &g_hWakeEvent, GetRenderWait(), QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+		while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+			if (msg.message == WM_QUIT) {
+				bQuit = true;
+				break;
+			}
+			if (!TranslateAccelerator(msg.hwnd, hAccelTable, &msg)||
+				!IsDialogMessage(msg.hwnd,&msg) ) 
+			{
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
+			}
 		}
-		if(msg.wParam != WM_QUIT)
+		if (!bQuit && g_scheduler.Poll(FramePacer::Now())) {
 			Render();
-
-		Sleep(1); // Reduces CPU load
-
+			ScheduleRender();
+		}
 	}
 
-	KillTimer(hWndMain, 1);
+	// Keep the trace recorded up to the exit
+	if (FrameTrace::Shared().IsEnabled())
+		SaveTrace();
 
 	// Release FFmpeg resources and release buffers
 	CloseVideo();
 
-	// Release the receiver
-	receiver.ReleaseReceiver();
+	// Stop preparing slides
+	g_bSlideScanCancel = true;
+	if (g_slidescan.joinable())
+		g_slidescan.join();
+	g_prefetch.Close();
+	g_dirwatch.Close();
+	g_wallpapercache.Save();
+	// Videos used most recently are kept when the probe cache is full
+	g_probecache.Save(true);
+
+	// Release the worker window DC
+	g_presenter.Release();
+
+	// Stop receiving
+	g_spoutreader.Close();
 
 	// Restore the starting wallpaper unless it was changed and should be retained
 	if (bDailyWallpaper && !g_wallpaperpath.empty()) {
@@ -393,14 +709,17 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 		std::string confirm = " ";
 		if (!copyright.empty()) confirm += copyright;
 		if(SpoutMessageBox(NULL, confirm.c_str(), " ", MB_USERICON | MB_YESNO, "Keep new image as wallpaper ?") == IDYES) {
-			g_wallpaperpath.clear();
+			// The image itself rather than the fitted copy, which can be removed from the cache
+			g_wallpaperpath = g_dailywallpaperpath;
 		}
 	}
 
 	RestoreWallPaper();
 
 	// Release DirectX 11 resources
-	receiver.CloseDirectX11();
+	g_spoutreader.Release();
+
+	if (g_hWakeEvent) CloseHandle(g_hWakeEvent);
 
 	// Release the application mutex so another instance can be opened
 	if (g_hMutex) ReleaseMutex(g_hMutex);
@@ -413,10 +732,16 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 //
 void Render()
 {
+	TRACE_SCOPE("Render", "render");
+
 	// No rendering for wallpaper image
 	if (bShowDaily) {
 		return;
 	}
+
+	// The pixels to draw
+	unsigned char* pFrame = nullptr;
+	bool bNewFrame = false; // Not the last frame drawn again
 	
 	if (!slidenames.empty() && g_start > 0.0) {
 
@@ -428,16 +753,36 @@ void Render()
 		bCurrentWallpaper = false;
 
 		// Calculate frame time for slide duration
-		double msecs = ElapsedMicroseconds()/1000.0;
+		double msecs = FramePacer::Now()*1000.0;
 		double elapsed = msecs-g_start; // msec elapsed
 
 		std::string slidepath = g_slideshowpath;
 		slidepath += "\\";
-		if (nCurrentImage == 0 || elapsed > (double)(g_slideshowtime*1000)) { // seconds to msec
+		if (bNextSlide || elapsed >= (double)(g_slideshowtime*1000)) { // seconds to msec
 			
+			TRACE_SCOPE("Slide", "mode");
 			g_start = msecs;
+			bNextSlide = false;
 			slidepath += slidenames[nCurrentImage];
-			SystemParametersInfoA(SPI_SETDESKWALLPAPER, 0, (void*)slidepath.c_str(), SPIF_SENDCHANGE);
+			// Prepared in the background while the last slide was shown.
+			// Waited for up to a quarter of the slide time, then prepared here.
+			const double wait = (double)g_slideshowtime*1000.0/4.0;
+			unsigned int width = 0;
+			unsigned int height = 0;
+			if (bSlideFade) {
+				// Faded in from the slide shown by the presenter
+				if (GetSlideSize(width, height)) {
+					FrameBuffer slide;
+					if (g_prefetch.TakeFrame(slidepath, width, height, g_FitMode, wait, slide)
+						|| g_wallpapercache.GetFrame(slidepath, width, height, g_FitMode, slide))
+						g_slidefade.Start(slidepath, slide, width, height, msecs);
+				}
+			}
+			else {
+				if (GetSlideSize(width, height))
+					g_prefetch.Take(slidepath, width, height, g_FitMode, wait);
+				SetWallpaperImage(slidepath);
+			}
 			
 			// Not showing original wallpaper
 			bCurrentWallpaper = false;
@@ -450,7 +795,10 @@ void Render()
 			
 			// Update image index
 			if (bRandom) {
-				nCurrentImage = rand()%(slidenames.size());
+				if (slidepicks.empty())
+					slidepicks.push_back(rand()%(slidenames.size()));
+				nCurrentImage = slidepicks.front();
+				slidepicks.pop_front();
 			}
 			else {
 				nCurrentImage++;
@@ -458,7 +806,24 @@ void Render()
 					nCurrentImage = 0;
 			}
 
+			// Start preparing the next slides
+			PrefetchSlides();
+
+		}
+		else if (bSlideFade && g_presenter.IsInvalid() && !g_slidefade.IsFading() && g_slidefade.HasSlide()) {
+			// The desktop size or fit mode has changed. Fit the slide shown again.
+			unsigned int width = 0;
+			unsigned int height = 0;
+			FrameBuffer slide;
+			if (GetSlideSize(width, height)
+				&& g_wallpapercache.GetFrame(g_slidefade.GetPath(), width, height, g_FitMode, slide))
+				g_slidefade.Start(g_slidefade.GetPath(), slide, width, height, msecs, false);
 		}
+
+		// Frames of a transition. Nothing is drawn between transitions.
+		if (bSlideFade)
+			g_slidefade.Present(g_presenter, msecs);
+
 		return;
 	}
 
@@ -468,64 +833,43 @@ void Render()
 		// Spout wallpaper
 		//
 
-		// Get pixels from the sender shared texture.
-		// ReceiveImage handles sender detection, creation and update.
-		// Windows bitmaps are bottom-up. Although the rgba pixel buffer can be flipped by
-		// the ReceiveImage function, it can also be drawn upside down as shown further below.
-		// Approx 5-8 msec
-		if (receiver.ReceiveImage(g_pixelBuffer, g_SenderWidth, g_SenderHeight)) { // RGB = false, invert = false
-			
-			// IsUpdated() returns true if the sender has changed
-			if (receiver.IsUpdated()) {
-
-				// Update globals
-				g_SenderWidth = receiver.GetSenderWidth();
-				g_SenderHeight = receiver.GetSenderHeight();
-
-				// Update the receiving buffer
-				if (g_pixelBuffer) delete[] g_pixelBuffer;
-				g_pixelBuffer = new unsigned char[g_SenderWidth * g_SenderHeight * 4];
-
-				// Not showing current wallpaper
-				bCurrentWallpaper = false;
-
-				return; // return for next receive
+		// Frames are received from the sender by the reader thread.
+		// Take the newest frame, or draw the last one again for the
+		// refresh once a second. Nothing is drawn otherwise.
+		if (!g_spoutreader.IsOpen() && !g_spoutreader.Open(&g_mailbox))
+			return;
+		unsigned int width = 0;
+		unsigned int height = 0;
+		pFrame = g_mailbox.TakeLatest(width, height);
+		bNewFrame = (pFrame != nullptr);
+		if (!pFrame && g_spoutreader.IsReceiving()
+			&& (g_presenter.IsInvalid() || FramePacer::Now()*1000.0 - g_LastPresent >= 1000.0))
+			pFrame = g_mailbox.GetHeld(width, height);
+
+		if (pFrame) {
+			if (width != g_SenderWidth || height != g_SenderHeight) {
+				// The sender has changed
+				g_SenderWidth = width;
+				g_SenderHeight = height;
+				g_presenter.Invalidate();
 			}
+			// Not showing current wallpaper
+			bCurrentWallpaper = false;
 		}
-		else {
-
-			// Because SetReceiverName is used to select the sender,
-			// the receiver waits for that sender to re-open.
-			// Here we need to test to find if it was closed.
-			if (!receiver.sendernames.hasSharedInfo(receiver.GetSenderName())) {
-
-				// Clear the receiver name
-				receiver.SetReceiverName();
-
-				if (g_pixelBuffer) {
-					receiver.ReleaseReceiver();
-					delete[] g_pixelBuffer;
-					g_pixelBuffer = nullptr;
-				}
-
-				// Return now if there is there another sender
-				if (receiver.GetSenderCount() > 0) {
-					return;
-				}
-
-			}
+		else if (!g_spoutreader.IsReceiving()) {
 
 			// If a daily wallpaper has been downloaded, show it
 			if (bDailyWallpaper && !g_wallpaperpath.empty()) {
-				SystemParametersInfoA(SPI_SETDESKWALLPAPER, 0, (void*)g_dailywallpaperpath.c_str(), SPIF_SENDCHANGE);
+				SetWallpaperImage(g_dailywallpaperpath);
 				bShowDaily = true;
+				g_spoutreader.Close();
 			}
 			else {
 				// Otherwise restore wallpaper
 				RestoreWallPaper();
 			}
 
-		} // endif ReceiveImage
+		}
 	}
 	else {
 
@@ -533,58 +877,100 @@ void Render()
 		// Video using FFmpeg
 		//
 
+		// Not receiving from Spout while a video is shown
+		if (g_spoutreader.IsOpen())
+			g_spoutreader.Close();
+
 		// initialize FFmpeg pipe for the video file
-		if (!g_pipein) {
+		if (!IsVideoOpen()) {
 			if (!OpenVideo(g_videopath.c_str())) {
 				return;
 			}
 		}
-		else {
-			// Read a frame from the FFmpeg input pipe
-			if (g_pipein && g_pixelBuffer && g_SenderWidth > 0 && g_SenderHeight > 0) {
-				if (fread(g_pixelBuffer, 1, g_SenderWidth*g_SenderHeight*4, g_pipein) == 0) {
-					// fread = 0 means the end of the file
-					// Use the same file and pixel buffer
-					fflush(g_pipein);
-					_pclose(g_pipein);
-					g_pipein = _popen(g_input.c_str(), "rb");
-				}
-			}
+		else if (g_source->IsFinished()) {
+			// FFmpeg could not be restarted at the end of the file
+			CloseVideo();
+			RestoreWallPaper();
+			return;
+		}
+		else if (g_recorder.IsComplete()) {
+			// A loop has been recorded. Replay it from the cache.
+			g_diskcache.Evict(g_recorder.GetPath());
+			if (!StartVideo())
+				return;
 		}
+
+		// Frames are read from the FFmpeg pipe by the reader thread
+		// and taken in order when they are due on the presentation clock.
+		// Late frames are skipped. Nothing is drawn if the next frame is not due.
+		const double now = FramePacer::Now();
+		const unsigned int pending = g_frames.GetPending();
+		if (!g_pacer.IsRunning()) {
+			if (pending == 0)
+				return;
+			// The first frame is due now
+			g_pacer.Start(now, g_FrameRateNum, g_FrameRateDen);
+			g_pacer.SetSpeed(now, (double)g_VideoSpeed/100.0);
+		}
+		const unsigned int take = g_pacer.Select(now, pending);
+		for (unsigned int i = 0; i < take; i++)
+			pFrame = g_frames.AcquireNext();
+		bNewFrame = (take > 0);
+
 	} // endif video or receiver
 
 	//
-	// Draw the received image (approx 2 msec)
+	// Draw the received image
+	// Times of each stage are recorded by FrameStats and shown in About
 	//
-	if (g_pixelBuffer) {
-
-		// Must use GetDCEx
-		HDC hdc = GetDCEx(g_WorkerHwnd, 0, DCX_WINDOW);
-		RECT dr{};
-		GetWindowRect(g_WorkerHwnd, &dr);
-
-		BITMAPINFO bmi{};
-		ZeroMemory(&bmi, sizeof(BITMAPINFO));
-		bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-		bmi.bmiHeader.biSizeImage = (LONG)(g_SenderWidth * g_SenderHeight * 4); // Pixel buffer size
-		bmi.bmiHeader.biWidth = (LONG)g_SenderWidth; // Width of buffer
-		bmi.bmiHeader.biHeight = -(LONG)g_SenderHeight; // Height of buffer allowing for bottom up
-		bmi.bmiHeader.biPlanes = 1;
-		bmi.bmiHeader.biBitCount = 32;
-		bmi.bmiHeader.biCompression = BI_RGB;
-		// StretchDIBits adapts the pixel buffer to the window size.
-		// The sender can be resized or changed.
-		// Very fast (< 1msec at 1280x720)
-		SetStretchBltMode(hdc, COLORONCOLOR); // Fastest method
-		StretchDIBits(hdc,
-			0, 0, (dr.right - dr.left), (dr.bottom - dr.top), // destination rectangle
-			0, 0, g_SenderWidth, g_SenderHeight, // source rectangle
-			g_pixelBuffer,
-			&bmi, DIB_RGB_COLORS, SRCCOPY);
-		ReleaseDC(g_WorkerHwnd, hdc);
-
-		// Hold at 30 fps reduces CPU load
-		receiver.HoldFps(30);
+	if (pFrame) {
+
+		// Has the desktop size changed ?
+		unsigned int width = 0;
+		unsigned int height = 0;
+		if (!g_presenter.GetTargetSize(width, height))
+			return;
+		if (width != g_TargetWidth || height != g_TargetHeight) {
+			g_TargetWidth = width;
+			g_TargetHeight = height;
+			g_presenter.Invalidate();
+			// Restart FFmpeg to produce frames for the new size
+			if (!g_videopath.empty() && IsVideoOpen()) {
+				StartVideo();
+				return;
+			}
+		}
+
+		// Time between new frames and the average frame rate
+		if (bNewFrame) {
+			const double now = FramePacer::Now()*1000.0;
+			if (g_LastFrame > 0.0 && now > g_LastFrame) {
+				const double interval = now - g_LastFrame;
+				FrameStats::Shared().Record(STAGE_INTERVAL, (uint64_t)(interval*1000.0));
+				if (g_SenderFps > 0.0)
+					g_SenderFps = 0.95*g_SenderFps + 0.05*(1000.0/interval);
+				else
+					g_SenderFps = 1000.0/interval;
+			}
+			g_LastFrame = now;
+		}
+
+		// Skip the present if the frame is the same as the last one.
+		// Drawn again once a second in case the desktop has been painted over.
+		const bool bChanged = g_framechange.Update(pFrame, g_SenderWidth, g_SenderHeight);
+		const double msecs = FramePacer::Now()*1000.0;
+		if (!bChanged && !g_presenter.IsInvalid() && (msecs - g_LastPresent) < 1000.0) {
+			g_PresentSkips++;
+		}
+		else {
+			// All of it is drawn for the refresh
+			if (msecs - g_LastPresent >= 1000.0)
+				g_presenter.Invalidate();
+			// Draw the tiles of the frame that have changed, placed for the fit mode.
+			// Very fast (< 1msec at 1280x720)
+			g_presenter.Present(pFrame, g_SenderWidth, g_SenderHeight, g_FitMode, &g_framechange);
+			g_LastPresent = msecs;
+		}
 
 		return;
 	}
@@ -711,6 +1097,51 @@ void ShowContextMenu(HWND hWnd)
 		AppendMenu(hMenu, MF_STRING, IDM_IMAGE, _T("Image"));
 		AppendMenu(hMenu, MF_STRING, IDM_DAILY, _T("Daily"));
 		AppendMenu(hMenu, MF_STRING, IDM_SLIDESHOW, _T("Slideshow"));
+
+		// Frame placement sub-menu
+		HMENU hFitMenu = CreatePopupMenu();
+		if (hFitMenu) {
+			AppendMenu(hFitMenu, MF_STRING, IDM_FIT_STRETCH, _T("Stretch"));
+			AppendMenu(hFitMenu, MF_STRING, IDM_FIT_FIT, _T("Fit"));
+			AppendMenu(hFitMenu, MF_STRING, IDM_FIT_FILL, _T("Fill"));
+			AppendMenu(hFitMenu, MF_STRING, IDM_FIT_CENTER, _T("Center"));
+			CheckMenuItem(hFitMenu, IDM_FIT_STRETCH + (int)g_FitMode, MF_BYCOMMAND | MF_CHECKED);
+			AppendMenu(hFitMenu, MF_SEPARATOR, 0, NULL);
+			AppendMenu(hFitMenu, MF_STRING, IDM_SCALE_NEAREST, _T("Nearest"));
+			AppendMenu(hFitMenu, MF_STRING, IDM_SCALE_BILINEAR, _T("Bilinear"));
+			AppendMenu(hFitMenu, MF_STRING, IDM_SCALE_AREA, _T("Area"));
+			CheckMenuItem(hFitMenu, IDM_SCALE_NEAREST + (int)g_presenter.GetFilter(), MF_BYCOMMAND | MF_CHECKED);
+			AppendMenu(hMenu, MF_POPUP, (UINT_PTR)hFitMenu, _T("Fit"));
+		}
+
+		// Video playback speed sub-menu
+		HMENU hSpeedMenu = CreatePopupMenu();
+		if (hSpeedMenu) {
+			AppendMenu(hSpeedMenu, MF_STRING, IDM_SPEED_025, _T("0.25x"));
+			AppendMenu(hSpeedMenu, MF_STRING, IDM_SPEED_050, _T("0.5x"));
+			AppendMenu(hSpeedMenu, MF_STRING, IDM_SPEED_100, _T("Normal"));
+			AppendMenu(hSpeedMenu, MF_STRING, IDM_SPEED_150, _T("1.5x"));
+			AppendMenu(hSpeedMenu, MF_STRING, IDM_SPEED_200, _T("2x"));
+			for (int i = 0; i < 5; i++) {
+				if (speeds[i] == g_VideoSpeed)
+					CheckMenuItem(hSpeedMenu, IDM_SPEED_025 + i, MF_BYCOMMAND | MF_CHECKED);
+			}
+			AppendMenu(hMenu, MF_POPUP, (UINT_PTR)hSpeedMenu, _T("Speed"));
+		}
+
+		// Video decoder sub-menu
+		HMENU hDecoderMenu = CreatePopupMenu();
+		if (hDecoderMenu) {
+			AppendMenu(hDecoderMenu, MF_STRING, IDM_DECODER_PIPE, _T("FFmpeg process"));
+			AppendMenu(hDecoderMenu, MF_STRING | (IsVideoBackendAvailable(VIDEO_LIBAV) ? 0 : MF_GRAYED), IDM_DECODER_LIBAV, _T("FFmpeg libraries"));
+			CheckMenuItem(hDecoderMenu, IDM_DECODER_PIPE + (int)g_VideoBackend, MF_BYCOMMAND | MF_CHECKED);
+			AppendMenu(hDecoderMenu, MF_SEPARATOR, 0, NULL);
+			AppendMenu(hDecoderMenu, MF_STRING | (g_bFrameCache ? MF_CHECKED : 0), IDM_FRAMECACHE, _T("Frame cache"));
+			AppendMenu(hMenu, MF_POPUP, (UINT_PTR)hDecoderMenu, _T("Decoder"));
+		}
+
+		AppendMenu(hMenu, MF_STRING | (FrameStats::Shared().IsEnabled() ? 0 : MF_GRAYED), IDM_SAVESTATS, _T("Save statistics"));
+		AppendMenu(hMenu, MF_STRING | (FrameTrace::Shared().IsEnabled() ? MF_CHECKED : 0), IDM_TRACE, _T("Trace"));
 		AppendMenu(hMenu, MF_STRING, IDM_ABOUT, _T("About"));
 		InsertMenu(hMenu, -1, MF_BYPOSITION, SWM_EXIT, _T("Exit"));
 
@@ -772,64 +1203,149 @@ void RestoreWallPaper()
 
 bool OpenVideo(std::string filePath)
 {
+	TRACE_SCOPE("OpenVideo", "video");
+
 	if (filePath.empty() || _access(filePath.c_str(), 0) == -1)
 		return false;
 
 	// Get information from the video file using ffprobe
-	// to set the width, height globals, g_SenderWidth and g_SenderHeight
+	// to set the width, height globals, g_VideoWidth and g_VideoHeight
 	if (!ffprobe(filePath)) {
 		MessageBoxA(NULL, "FFprobe error", "Warning", MB_OK);
 		return false;
 	}
 
-	if (g_pipein) {
-		fflush(g_pipein);
-		_pclose(g_pipein);
-		g_pipein = nullptr;
+	// Size of the desktop to show the video
+	g_presenter.GetTargetSize(g_TargetWidth, g_TargetHeight);
+	g_presenter.Invalidate();
+
+	return StartVideo();
+}
+
+// Start decoding the video file at the size shown on the desktop
+// Also used to restart with a new size if the desktop or fit mode changes
+bool StartVideo()
+{
+	// Stop decoding
+	if (g_source) g_source->Close();
+	// An unfinished recording is discarded
+	g_recorder.Stop();
+	// The clock starts again with the first frame
+	g_pacer.Stop();
+
+	// Negotiate the frame size with the desktop size and fit mode.
+	// The source scales and crops so that only the pixels shown are produced.
+	VideoSourceParams params;
+	params.path = g_videopath;
+	params.ffmpegPath = g_ffmpegPath;
+	params.videoWidth = g_VideoWidth;
+	params.videoHeight = g_VideoHeight;
+	params.fit = NegotiateFit(g_VideoWidth, g_VideoHeight, g_TargetWidth, g_TargetHeight, g_FitMode);
+	params.color = g_VideoColor;
+	// Loop boundaries of the pipe are found by counting frames
+	params.loopFrames = g_bExactFrames ? g_VideoFrames : 0;
+	params.rateNum = g_FrameRateNum;
+	params.rateDen = g_FrameRateDen;
+	params.bVariableRate = g_bVariableRate;
+	params.bYuv = g_bYuvPipe;
+	g_SenderWidth = params.fit.width;
+	g_SenderHeight = params.fit.height;
+
+	// Replay a loop recorded before, or record one if it is small enough
+	VideoBackend backend = g_VideoBackend;
+	bool bRecord = false;
+	if (g_bFrameCache) {
+		params.cachePath = GetFrameCachePath(params.fit);
+		if (g_diskcache.Touch(params.cachePath))
+			backend = VIDEO_CACHE;
+		else if (!params.cachePath.empty() && g_VideoFrames > 0 && (g_bExactFrames || g_VideoBackend == VIDEO_LIBAV))
+			bRecord = ((uint64_t)g_VideoFrames*g_SenderWidth*g_SenderHeight*4 <= (uint64_t)g_FrameCacheClip*1024*1024);
+	}
+
+	// Create the source for the decoder selected
+	if (!g_source || g_source->GetBackend() != backend) {
+		delete g_source;
+		g_source = CreateVideoSource(backend);
+		if (!g_source) {
+			// Not available in this build
+			g_VideoBackend = backend = VIDEO_PIPE;
+			g_source = CreateVideoSource(VIDEO_PIPE);
+		}
+	}
+
+	if (backend == VIDEO_PIPE) {
+		// _popen will open a console window.
+		// To hide the output, open a console first and then hide it.
+		// An application can have only one console window.
+		FILE* pCout = nullptr;
+		if (AllocConsole()) freopen_s(&pCout, "CONOUT$", "w", stdout);
+		ShowWindow(GetConsoleWindow(), SW_HIDE);
+	}
+
+	// Frame slots for the video size.
+	// One is drawn while the source fills the others ahead of time.
+	if (!g_frames.Allocate(g_SenderWidth, g_SenderHeight, 4)) {
+		MessageBoxA(NULL, "Video frame allocation failed", "Warning", MB_OK | MB_TOPMOST);
+		return false;
+	}
+
+	// Wake the message loop to draw each new frame
+	g_source->SetFrameCallback([]() {
+		g_scheduler.Wake();
+	});
+
+	// Frames of the first complete loop are written to the cache
+	if (bRecord && g_recorder.Start(params.cachePath, g_SenderWidth, g_SenderHeight, g_FrameRateNum, g_FrameRateDen,
+		(uint64_t)g_FrameCacheClip*1024*1024, params.loopFrames)) {
+		g_source->SetFrameSink([](const unsigned char* frame, bool bLoopStart) {
+			g_recorder.AddFrame(frame, bLoopStart);
+		});
+	}
+	else {
+		g_source->SetFrameSink(nullptr);
 	}
 
-	// _popen will open a console window.
-	// To hide the output, open a console first and then hide it.
-	// An application can have only one console window.
-	FILE* pCout = nullptr;
-	if (AllocConsole()) freopen_s(&pCout, "CONOUT$", "w", stdout);
-	ShowWindow(GetConsoleWindow(), SW_HIDE);
-
-	// Open an input pipe from ffmpeg
-	g_input = g_ffmpegPath;
-	// Read input at native frame rate 
-	g_input += " -re ";
-	g_input += " -i ";
-	g_input += "\"";
-	g_input += filePath;
-	g_input += "\"";
-	// Specify BGRA pixel format to allow high speed bitmap drawing
-	g_input += " -f image2pipe -vcodec rawvideo -pix_fmt bgra -";
-	g_pipein = _popen(g_input.c_str(), "rb");
-	if (g_pipein) {
-		if (g_pixelBuffer) delete[] g_pixelBuffer;
-		unsigned int buffersize = g_SenderWidth*g_SenderHeight * 4;
-		g_pixelBuffer = new unsigned char[buffersize];
+	// Start decoding
+	if (g_source->Open(params, &g_frames)) {
+		// Wait for frames due with 1 msec resolution
+		if (!g_bTimerPeriod)
+			g_bTimerPeriod = (timeBeginPeriod(1) == TIMERR_NOERROR);
 		return true;
 	}
 	else {
-		MessageBoxA(NULL, "FFmpeg open failed", "Warning", MB_OK | MB_TOPMOST);
+		g_recorder.Stop();
+		g_frames.Release();
+		MessageBoxA(NULL, "Video open failed", "Warning", MB_OK | MB_TOPMOST);
 	}
 
 	return false;
 }
 
+// Is a video source decoding
+bool IsVideoOpen()
+{
+	return (g_source && g_source->IsOpen());
+}
+
 void CloseVideo()
 {
-	if (g_pipein) {
-		fflush(g_pipein);
-		_pclose(g_pipein);
-		g_pipein = nullptr;
+	// Stop decoding
+	if (g_source) {
+		g_source->Close();
+		delete g_source;
+		g_source = nullptr;
+	}
+	g_recorder.Stop();
+	g_frames.Release();
+	g_pacer.Stop();
+	if (g_bTimerPeriod) {
+		timeEndPeriod(1);
+		g_bTimerPeriod = false;
 	}
-	if (g_pixelBuffer) delete[] g_pixelBuffer;
-	g_pixelBuffer = nullptr;
 	g_SenderWidth = 0;
 	g_SenderHeight = 0;
+	g_VideoWidth = 0;
+	g_VideoHeight = 0;
 	g_videopath.clear();
 }
 
@@ -900,129 +1416,202 @@ bool OpenFolder(char* filepath, int maxchars)
 }
 
 
-// Run FFprobe on a video file and produce an ini file with the stream information
+// Get the video stream information with FFprobe, or from the cache
+// if the file has not changed since it was last probed
 bool ffprobe(std::string videoPath)
 {
-	// Get information from the movie file using ffprobe and write to an ini file
-	// Use a batch file with the required ffprobe options and pass the path to ShellExecute
-	std::string probepath = "\"";
-	probepath += g_exePath;
-	probepath += "\\DATA\\FFMPEG\\probe.bat";
-	probepath += "\"";
-
-	// Input to ffprobe
-	std::string input = "\"";
-	input += videoPath;
-	input += "\"";
-
-	// In the batch file, %~dp0 returns the Drive and Path to the batch script
-
-	// Open ffprobe and wait for completion
-	STARTUPINFOA si = { sizeof(STARTUPINFOA) };
-	si = { sizeof(STARTUPINFOA) };
-	DWORD dwExitCode = 0;
-	ZeroMemory((void*)&si, sizeof(STARTUPINFO));
-	si.cb = sizeof(STARTUPINFO);
-	si.dwFlags = STARTF_USESHOWWINDOW;
-	si.wShowWindow = SW_HIDE; // hide the ffprobe console window
-	PROCESS_INFORMATION pi={};
-	std::string cmdstring = probepath + " " + input;
-	if (CreateProcessA(NULL, (LPSTR)cmdstring.c_str(), NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
-		if (pi.hProcess) {
-			do {
-				GetExitCodeProcess(pi.hProcess, &dwExitCode);
-			} while (dwExitCode == STILL_ACTIVE);
-			CloseHandle(pi.hProcess);
-		}
-		if (pi.hThread)	CloseHandle(pi.hThread);
-	}
-	else {
-		MessageBoxA(NULL, "FFprobe CreateProcess failed", "Warning", MB_OK | MB_TOPMOST);
-		return false;
+	g_VideoWidth = 0;
+	g_VideoHeight = 0;
+	g_VideoFrames = 0;
+	g_bExactFrames = false;
+
+	VideoInfo video;
+	if (!g_probecache.Find(videoPath, video)) {
+		std::string probepath = g_exePath;
+		probepath += "\\DATA\\FFMPEG\\ffprobe.exe";
+		if (!ProbeVideo(probepath, videoPath, video))
+			return false;
+		g_probecache.Store(videoPath, video);
 	}
+	// Saved if changed
+	g_probecache.Save();
+
+	g_VideoWidth = video.width;
+	g_VideoHeight = video.height;
+	g_VideoFrames = video.frames;
+	g_FrameRateNum = video.rateNum;
+	g_FrameRateDen = video.rateDen;
+	g_bVariableRate = video.bVariableRate;
+	g_FrameRate = (float)((double)video.rateNum/(double)video.rateDen);
+
+	// Colour matrix for YUV conversion.
+	// If not specified, assume BT.709 for HD and BT.601 for SD video.
+	if (video.colorSpace == "bt709")
+		g_VideoColor.matrix = YUV_BT709;
+	else if (video.colorSpace == "smpte170m" || video.colorSpace == "bt470bg" || video.colorSpace == "fcc")
+		g_VideoColor.matrix = YUV_BT601;
+	else
+		g_VideoColor.matrix = (g_VideoHeight >= 720) ? YUV_BT709 : YUV_BT601;
+	g_VideoColor.format = YUV_I420;
+	g_VideoColor.bFullRange = false; // FFmpeg is asked for limited range
 
-	// Read the ini file produced by FFprobe to get the video information
-	char initfile[MAX_PATH]={};
-	strcpy_s(initfile, MAX_PATH, g_exePath.c_str());
-	strcat_s(initfile, MAX_PATH, "\\DATA\\FFMPEG\\myprobe.ini");
-	if (_access(initfile, 0) == -1) {
-		MessageBoxA(NULL, "FFprobe ini file not found", "Warning", MB_OK | MB_TOPMOST);
+	// The frame count of the container is exact unless frames are resampled.
+	// Otherwise estimate the number of frames from the duration.
+	g_bExactFrames = (g_VideoFrames > 0 && !g_bVariableRate);
+	if (g_VideoFrames == 0 && video.duration > 0.0)
+		g_VideoFrames = (unsigned int)(video.duration*(double)g_FrameRate + 0.5);
+
+	if (g_VideoWidth == 0 || g_VideoHeight == 0)
 		return false;
+
+	return true;
+}
+
+// Get image files for slideshow, found by the last scan
+int GetImageFiles(std::vector<std::string>&filenames)
+{
+	// Paths relative to the folder
+	const std::vector<SlideEntry>& images = g_slideindex.GetImages();
+	for (const SlideEntry& image : images)
+		filenames.push_back(image.path);
+
+	return (int)images.size();
+
+} // end GetImageFiles
+
+
+// Find the images in a folder on a thread, so that a large library does
+// not hold up the window. SWM_SLIDESCAN is posted when they are found.
+void StartSlideScan(const std::string& folder, bool bNew)
+{
+	g_slidescanpath = folder;
+	g_bSlideScanNew = bNew;
+	g_bSlideScanning = true;
+	g_SlideScans++;
+
+	// A scan still running is stopped and this one started
+	// by FinishSlideScan when it has ended
+	if (g_slidescan.joinable()) {
+		g_bSlideScanCancel = true;
+		return;
 	}
+	RunSlideScan();
+}
 
-	// For example :
-	// [streams.stream.0]
-	// width=1280
-	// height = 720
 
-	char tmp[MAX_PATH]={};
-	DWORD dwResult = 0;
-	g_SenderWidth = 0;
-	g_SenderHeight = 0;
+// Start the scan thread for the last scan asked for
+void RunSlideScan()
+{
+	const std::string folder = g_slidescanpath;
+	const unsigned int scan = g_SlideScans;
+	g_bSlideScanFound = false;
+	g_bSlideScanCancel = false;
+
+	// Only folders changed since the last time are listed again.
+	// The index is not in DATA\Cache, where it would be removed
+	// as the least recently used file when a video is recorded.
+	const std::string indexpath = g_exePath + "\\DATA\\Slides\\" + DiskCache::HashKey(folder) + ".index";
+	g_slidescan = std::thread([folder, indexpath, scan]() {
+		FrameTrace::Shared().SetThreadName("Slide scan");
+		g_bSlideScanFound = g_slideindex.Scan(folder, indexpath, &g_bSlideScanCancel);
+		PostMessage(hWndMain, SWM_SLIDESCAN, (WPARAM)scan, 0);
+	});
+}
 
-	// Find the first video stream
-	char stream[32]={};
-	for (int i=0; i<10; i++) { // arbritrary maximum
-		sprintf_s(stream, 32, "streams.stream.%d", i);
-		if (GetPrivateProfileStringA((LPCSTR)stream, (LPSTR)"codec_type", (LPSTR)"0", (LPSTR)tmp, 8, initfile) > 0) {
-			if (strcmp(tmp, "video") == 0) {
-				if (GetPrivateProfileStringA((LPCSTR)stream, (LPSTR)"width", NULL, (LPSTR)tmp, 8, initfile) > 0)
-					g_SenderWidth = atoi(tmp);
-				if (GetPrivateProfileStringA((LPCSTR)stream, (LPSTR)"height", NULL, (LPSTR)tmp, 8, initfile) > 0)
-					g_SenderHeight = atoi(tmp);
-				dwResult = GetPrivateProfileStringA((LPCSTR)"streams.stream.0", (LPSTR)"r_frame_rate", (LPSTR)"30/1", (LPSTR)tmp, 11, initfile);
-				if (dwResult == 0)
-					dwResult = GetPrivateProfileStringA((LPCSTR)"streams.stream.0", (LPSTR)"avg_frame_rate", (LPSTR)"30/1", (LPSTR)tmp, 11, initfile);
-				break;
-			}
-		}
+
+// The images of a scan are found. Starts the slideshow, or replaces
+// the slides if the folder was listed again.
+void FinishSlideScan(unsigned int scan)
+{
+	// The thread has posted and is ending
+	if (g_slidescan.joinable())
+		g_slidescan.join();
+
+	// Replaced by a later scan, which can start now,
+	// or cancelled by another mode
+	if (scan != g_SlideScans || !g_bSlideScanning) {
+		if (g_bSlideScanning)
+			RunSlideScan();
+		return;
 	}
+	g_bSlideScanning = false;
+	g_SlideIndexStats = g_slideindex.GetStats();
+
+	std::vector<std::string> filenames;
+	if (g_bSlideScanFound)
+		GetImageFiles(filenames);
 
-	if (dwResult > 0) {
-		std::string iniValue = tmp;
-		auto pos = iniValue.find("/");
-		double num = atof(iniValue.substr(0, pos).c_str());
-		double den = atof(iniValue.substr(pos + 1, iniValue.npos).c_str());
-		if (num > 0 && den > 0) {
-			g_FrameRate = (float)(num / den);
+	if (g_bSlideScanNew) {
+		if (filenames.empty()) {
+			slidenames.clear();
+			SpoutMessageBox(NULL, "No image files in the folder", "SpoutWallPaper", MB_ICONWARNING | MB_OK);
+			return;
 		}
+		StartSlideshow(g_slidescanpath, filenames);
+		return;
 	}
 
-	if (g_SenderWidth == 0 || g_SenderHeight == 0)
-		return false;
-
-	return true;
+	// Listed again because folder changes were lost.
+	// The next slide stays the same if it is still there.
+	if (slidenames.empty() || g_start <= 0.0 || g_slidescanpath != g_slideshowpath)
+		return;
+	const std::string next = slidenames[nCurrentImage];
+	slidenames.Assign(filenames);
+	const int index = slidenames.Find(next);
+	nCurrentImage = (index >= 0) ? index : 0;
+	slidepicks.clear();
+	g_SlideChanges++;
+	SlidesChanged();
 }
 
-// Get image files for slideshow
-int GetImageFiles(const char* spath, std::vector<std::string>&filenames)
+
+// Another mode is selected. A scan still running is
+// stopped and does not start the slideshow.
+void CancelSlideScan()
 {
-	char tmp[MAX_PATH]{};
-	HANDLE filehandle = NULL;
-	WIN32_FIND_DATAA filedata;
-
-	sprintf_s(tmp, MAX_PATH, "%s\\*.*", spath);
-	int nFiles = 0;
-	filehandle = FindFirstFileA((LPCSTR)tmp, (LPWIN32_FIND_DATAA)&filedata);
-	if (PtrToUint(filehandle) > 0) {
-		do {
-			if ((filedata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
-				if (strstr((char*)filedata.cFileName, ".jpg") != 0
-					|| strstr((char*)filedata.cFileName, ".png") != 0
-					|| strstr((char*)filedata.cFileName, ".gif") != 0
-					|| strstr((char*)filedata.cFileName, ".bmp") != 0
-					|| strstr((char*)filedata.cFileName, ".tga") != 0
-					|| strstr((char*)filedata.cFileName, ".tif") != 0) {
-						slidenames.push_back(filedata.cFileName);
-						nFiles++;
-				}
-			}
-		} while (FindNextFileA(filehandle, (LPWIN32_FIND_DATAA)&filedata));
-	}
+	if (!g_bSlideScanning)
+		return;
+	g_bSlideScanning = false;
+	g_SlideScans++;
+	g_bSlideScanCancel = true;
+}
 
-	return nFiles;
 
-} // end GetImageFiles
+// Show the images found in a folder
+void StartSlideshow(const std::string& folder, const std::vector<std::string>& filenames)
+{
+	slidenames.Assign(filenames);
+	// Close video
+	CloseVideo();
+	// Close receiver
+	g_spoutreader.Close();
+	// Disable daily wallpaper display
+	bShowDaily = false;
+	// Save selected folder
+	strcpy_s(g_slideshowpath, MAX_PATH, folder.c_str());
+	// Write to the registry for the next start
+	WritePathToRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "slideshowfolder", g_slideshowpath);
+	// TODO - user select slide time
+	WriteDwordToRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "slideshowtime", g_slideshowtime);
+	WriteDwordToRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "slidefade", (DWORD)bSlideFade);
+	// The first slide is cut in and the next ones read for the presenter
+	g_slidefade.Release();
+	g_prefetch.Close();
+	g_prefetch.SetFrames(bSlideFade);
+	// Reset counter and timer
+	nCurrentImage = 0;
+	slidepicks.clear();
+	// Set start time
+	g_start = FramePacer::Now()*1000.0;
+	bNextSlide = true;
+	// Keep the slides up to date with the folder
+	g_SlideChanges = 0;
+	g_dirwatch.SetCallback([]() { PostMessage(hWndMain, SWM_SLIDES, 0, 0); });
+	g_dirwatch.Open(g_slideshowpath);
+	// Show the first slide
+	TRACE_INSTANT("Mode slideshow", "mode");
+	g_scheduler.Wake();
+}
 
 
 // Message handler for the app
@@ -1035,6 +1624,16 @@ INT_PTR CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 
 	switch (message) {
 
+	case SWM_SLIDES:
+		// Files added, removed or renamed in the slideshow folder
+		UpdateSlides();
+		break;
+
+	case SWM_SLIDESCAN:
+		// Images found in the slideshow folder
+		FinishSlideScan((unsigned int)wParam);
+		break;
+
 	case SWM_TRAYMSG:
 
 		switch(lParam) {
@@ -1044,6 +1643,11 @@ INT_PTR CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 			case WM_RBUTTONDOWN:
 			case WM_CONTEXTMENU:
 				ShowContextMenu(hWnd);
+				break;
+			case WM_MOUSEMOVE:
+				// The tooltip is about to show
+				UpdateTrayTip();
+				break;
 		}
 		break;
 
@@ -1066,19 +1670,20 @@ INT_PTR CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 			namestring = *iter; // the selected Sender in the list
 			strcpy_s(name, namestring.c_str());
 			spout.SetActiveSender(name); // make it active
-			receiver.SetReceiverName(name); // set the name for the receiver to use
+			g_spoutreader.SetSenderName(name); // set the name for the receiver to use
 			// Close video
 			CloseVideo();
-			// Clear slideshow
+			// Clear slideshow and stop a folder scan
 			slidenames.clear();
+			CancelSlideScan();
 			// Disable daily wallpaper display
 			// Do not bypass  Spout and Video in Render()
 			bShowDaily = false;
 			// Not showing original wallpaper
 			bCurrentWallpaper = false;
-			// Set timer for 30 msec
-			KillTimer(hWndMain, 1);
-			SetTimer(hWndMain, 1, 30, NULL);
+			// Draw in the new mode
+			TRACE_INSTANT("Mode Spout", "mode");
+			g_scheduler.Wake();
 			break;
 		}
 
@@ -1099,16 +1704,17 @@ INT_PTR CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 						// Set the new video path
 						g_videopath = filepath;
 						// Close receiver
-						receiver.ReleaseReceiver();
-						// Clear any slideshow
+						g_spoutreader.Close();
+						// Clear any slideshow and stop a folder scan
 						slidenames.clear();
+						CancelSlideScan();
 						// Disable daily wallpaper display
 						bShowDaily = false;
 						// Not showing original wallpaper
 						bCurrentWallpaper = false;
-						// Set timer for 30 msec
-						KillTimer(hWndMain, 1);
-						SetTimer(hWndMain, 1, 30, NULL);
+						// Draw in the new mode
+						TRACE_INSTANT("Mode video", "mode");
+						g_scheduler.Wake();
 					}
 					else {
 						CloseVideo();
@@ -1125,14 +1731,15 @@ INT_PTR CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 				// Stop video
 				CloseVideo();
 				// Close receiver
-				receiver.ReleaseReceiver();
-				// Clear any slideshow
+				g_spoutreader.Close();
+				// Clear any slideshow and stop a folder scan
 				slidenames.clear();
+				CancelSlideScan();
 				// Default is image not downloaded
 				bDailyWallpaper = false;
 				if (OpenFile(filepath, MAX_PATH)) {
 					// Set the new wallpaper
-					SystemParametersInfoA(SPI_SETDESKWALLPAPER, 0, (void*)filepath, SPIF_SENDCHANGE);
+					SetWallpaperImage(filepath);
 					// Save the image path
 					g_dailywallpaperpath = filepath;
 					// Flag download of wallpaper for exit
@@ -1144,9 +1751,9 @@ INT_PTR CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 					// Replace Bing daily image details with the image name
 					PathStripPathA(filepath);
 					copyright = filepath;
-					// Set timer for every 2 seconds
-					KillTimer(hWndMain, 1);
-					SetTimer(hWndMain, 1, 2000, NULL);
+					// Draw in the new mode
+					TRACE_INSTANT("Mode image", "mode");
+					g_scheduler.Wake();
 				}
 			}
 			break;
@@ -1160,9 +1767,10 @@ INT_PTR CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 					// Stop video
 					CloseVideo();
 					// Close receiver
-					receiver.ReleaseReceiver();
-					// Clear any slideshow
+					g_spoutreader.Close();
+					// Clear any slideshow and stop a folder scan
 					slidenames.clear();
+					CancelSlideScan();
 					// Default is image not downloaded
 					bDailyWallpaper = false;
 
@@ -1215,7 +1823,7 @@ INT_PTR CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 
 								if (!filePath.empty()) {
 									// Set the new wallpaper
-									SystemParametersInfoA(SPI_SETDESKWALLPAPER, 0, (void*)filePath.c_str(), SPIF_SENDCHANGE);
+									SetWallpaperImage(filePath);
 									// Save the daily wallpaper image path
 									g_dailywallpaperpath = filePath;
 									// Not showing original wallpaper
@@ -1224,9 +1832,9 @@ INT_PTR CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 									bDailyWallpaper = true;
 									// Bypass Spout and Video in Render()
 									bShowDaily = true;
-									// Set timer for every 2 seconds
-									KillTimer(hWndMain, 1);
-									SetTimer(hWndMain, 1, 2000, NULL);
+									// Draw in the new mode
+									TRACE_INSTANT("Mode daily", "mode");
+									g_scheduler.Wake();
 
 								}
 							}
@@ -1239,51 +1847,68 @@ INT_PTR CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 			case IDM_SLIDESHOW:
 			{
 				char path[MAX_PATH]{};
-				char name[MAX_PATH]{};
 				strcpy_s(path, MAX_PATH, g_slideshowpath); // starting folder
 				if (OpenFolder(path, MAX_PATH)) {
-					slidenames.clear();
-					if (GetImageFiles(path, slidenames) > 0) {
-						// Allow selection of slide duration
-						if (SelectSlideDuration()) {
-							// Close video
-							CloseVideo();
-							// Close receiver
-							receiver.ReleaseReceiver();
-							// Disable daily wallpaper display
-							bShowDaily = false;
-							// Save selected folder
-							strcpy_s(g_slideshowpath, MAX_PATH, path);
-							// Write to the registry for the next start
-							WritePathToRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "slideshowfolder", g_slideshowpath);
-							// TODO - user select slide time
-							WriteDwordToRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "slideshowtime", g_slideshowtime);
-							// Reset counter and timer
-							nCurrentImage = 0;
-							// Set start time
-							g_start = ElapsedMicroseconds()/1000.0;
-							// Set timer for every 1 second
-							KillTimer(hWndMain, 1);
-							SetTimer(hWndMain, 1, 1000, NULL);
-						}
-						else {
-							slidenames.clear();
-							nCurrentImage = 0;
-							g_start = 0.0;
-						}
+					// Allow selection of slide duration
+					if (SelectSlideDuration()) {
+						// The folder is scanned on a thread and the
+						// slideshow started when the images are found
+						StartSlideScan(path, true);
 					}
 					else {
-						SpoutMessageBox(NULL, "No image files in the folder", "SpoutWallPaper", MB_ICONWARNING | MB_OK);
+						slidenames.clear();
+						CancelSlideScan();
+						nCurrentImage = 0;
+						g_start = 0.0;
 					}
 				}
 				else {
 					slidenames.clear();
+					CancelSlideScan();
 					nCurrentImage = 0;
 					g_start = 0.0;
 				}
 			}
 			break;
 		
+			case IDM_FIT_STRETCH:
+			case IDM_FIT_FIT:
+			case IDM_FIT_FILL:
+			case IDM_FIT_CENTER:
+				SetFitMode((FitMode)(wmId - IDM_FIT_STRETCH));
+				break;
+
+			case IDM_SCALE_NEAREST:
+			case IDM_SCALE_BILINEAR:
+			case IDM_SCALE_AREA:
+				SetScaleFilter((ScaleFilter)(wmId - IDM_SCALE_NEAREST));
+				break;
+
+			case IDM_SPEED_025:
+			case IDM_SPEED_050:
+			case IDM_SPEED_100:
+			case IDM_SPEED_150:
+			case IDM_SPEED_200:
+				SetVideoSpeed(speeds[wmId - IDM_SPEED_025]);
+				break;
+
+			case IDM_DECODER_PIPE:
+			case IDM_DECODER_LIBAV:
+				SetVideoBackend((VideoBackend)(wmId - IDM_DECODER_PIPE));
+				break;
+
+			case IDM_FRAMECACHE:
+				SetFrameCache(!g_bFrameCache);
+				break;
+
+			case IDM_SAVESTATS:
+				SaveFrameStats();
+				break;
+
+			case IDM_TRACE:
+				SetTrace(!FrameTrace::Shared().IsEnabled());
+				break;
+
 			case IDM_ABOUT:
 			{
 				HICON hIcon = LoadIcon(hInst, MAKEINTRESOURCE(IDI_STEALTHDLG));
@@ -1295,6 +1920,132 @@ INT_PTR CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 					str += copyright;
 					str += "\n\n";
 				}
+				// Video loop transition timing
+				if (IsVideoOpen()) {
+					char tmp[256]{};
+					sprintf_s(tmp, 256, "\nVideo decoder : %s\n", VideoBackendName(g_source->GetBackend()));
+					str += tmp;
+					const LoopTiming& timing = g_source->GetLoopTiming();
+					if (timing.GetLoops() > 0) {
+						sprintf_s(tmp, 256, "Video loops %u\nLoop stall %.1f msec (max %.1f), frame %.1f msec\n",
+							timing.GetLoops(), timing.GetLoopStall(), timing.GetMaxLoopStall(), timing.GetFrameInterval());
+						str += tmp;
+					}
+					if (g_recorder.IsRecording()) {
+						str += "Recording loop to frame cache\n";
+					}
+				}
+				// Video frame pacing
+				if (IsVideoOpen() && g_pacer.IsRunning()) {
+					const FramePacerStats& stats = g_pacer.GetStats();
+					char tmp[256]{};
+					sprintf_s(tmp, 256, "\nVideo %.3f fps%s at %.2fx\nFrames %llu, dropped %llu, repeated %llu\nJitter %.2f msec (sd %.2f, max %.2f)\n",
+						(double)g_FrameRateNum/(double)g_FrameRateDen, g_bVariableRate ? " (variable)" : "", g_pacer.GetSpeed(),
+						stats.presented, stats.dropped, stats.repeated,
+						stats.jitterMean, stats.jitterStd, stats.jitterMax);
+					str += tmp;
+				}
+				// Time to draw a frame to the desktop
+				if (g_presenter.GetStats().presents > 0) {
+					const PresenterStats& present = g_presenter.GetStats();
+					char tmp[256]{};
+					sprintf_s(tmp, 256, "Present %.2f msec (max %.2f)\nPartial presents %.1f%%, area drawn %.1f%%\n",
+						present.mean, present.max,
+						100.0*(double)present.partial/(double)present.presents, 100.0*present.dirty);
+					str += tmp;
+				}
+				// Frame pipeline times
+				if (FrameStats::Shared().IsEnabled()) {
+					const std::string summary = FrameStats::Shared().GetSummary();
+					if (!summary.empty()) {
+						char tmp[256]{};
+						sprintf_s(tmp, 256, "\nFrames %.1f fps, times 50%% / 90%% / 99%%\n", g_SenderFps);
+						str += tmp;
+						str += summary;
+					}
+				}
+				// Trace recording
+				if (FrameTrace::Shared().IsEnabled()) {
+					const FrameTraceStats trace = FrameTrace::Shared().GetStats();
+					char tmp[256]{};
+					sprintf_s(tmp, 256, "Tracing %llu events (%llu overwritten, %.1f MB)\n",
+						trace.events, trace.overwritten, (double)trace.bytes/1048576.0);
+					str += tmp;
+				}
+				// Unchanged frames not drawn
+				if (g_framechange.GetStats().frames > 0) {
+					const FrameChangeStats& change = g_framechange.GetStats();
+					char tmp[256]{};
+					sprintf_s(tmp, 256, "Unchanged frames skipped %.1f%%, detect %.2f msec\n",
+						100.0*(double)g_PresentSkips/(double)change.frames, change.mean);
+					str += tmp;
+				}
+				// Render loop wakes
+				if (g_scheduler.GetStats().polls > 0) {
+					const FrameSchedulerStats& schedule = g_scheduler.GetStats();
+					char tmp[256]{};
+					const double now = FramePacer::Now();
+					sprintf_s(tmp, 256, "Wakes %.0f a minute%s, %.0f with work\nRenders %llu, late %.2f msec (max %.2f)\n",
+						g_scheduler.GetWakesPerMinute(now), g_bIdle ? " (idle)" : "", g_scheduler.GetRendersPerMinute(now),
+						schedule.due, schedule.lateMean, schedule.lateMax);
+					str += tmp;
+				}
+				// Slideshow library
+				if (!slidenames.empty() && g_start > 0.0) {
+					const SlideIndexStats& index = g_SlideIndexStats;
+					char tmp[256]{};
+					sprintf_s(tmp, 256, "\nSlides %u in %u folders, indexed in %.0f msec (%u folders listed)\n",
+						index.images, index.folders, index.msec, index.listed);
+					str += tmp;
+					if (g_dirwatch.IsOpen()) {
+						const DirWatchStats watch = g_dirwatch.GetStats();
+						sprintf_s(tmp, 256, "Folder watched, %u slides now, %llu changed in %llu updates%s\n",
+							(unsigned int)slidenames.size(), g_SlideChanges, watch.batches,
+							watch.overflows > 0 ? " (rescanned)" : "");
+						str += tmp;
+					}
+				}
+				// Cross fades drawn and the time taken
+				if (g_slidefade.GetStats().fades > 0) {
+					const SlideFadeStats& fade = g_slidefade.GetStats();
+					char tmp[256]{};
+					sprintf_s(tmp, 256, "Cross fades %llu, %.1f msec each (max %.1f), %.0f frames, blend %.2f msec\n",
+						fade.fades, fade.cost, fade.max, (double)fade.frames/(double)fade.fades, fade.blend);
+					str += tmp;
+				}
+				// Slides prepared before they were due
+				{
+					const SlidePrefetchStats prefetch = g_prefetch.GetStats();
+					if (prefetch.hits + prefetch.misses > 0) {
+						char tmp[256]{};
+						sprintf_s(tmp, 256, "Slides ready %llu of %llu, %.1f sec ahead, prepare %.0f msec (max %.0f)\n",
+							prefetch.hits, prefetch.hits + prefetch.misses, prefetch.lead/1000.0, prefetch.mean, prefetch.max);
+						str += tmp;
+						if (prefetch.timeouts > 0) {
+							sprintf_s(tmp, 256, "Slides not ready in time %llu\n", prefetch.timeouts);
+							str += tmp;
+						}
+					}
+				}
+				// Images fitted to the desktop
+				if (g_wallpapercache.IsOpen()) {
+					const WallpaperCacheStats wallpapers = g_wallpapercache.GetStats();
+					if (wallpapers.hits + wallpapers.fitted + wallpapers.failed > 0) {
+						char tmp[256]{};
+						sprintf_s(tmp, 256, "Wallpapers fitted %llu, cached %llu, fit %.0f msec (max %.0f)\n",
+							wallpapers.fitted, wallpapers.hits, wallpapers.mean, wallpapers.max);
+						str += tmp;
+					}
+				}
+				// Memory held for frames
+				{
+					const FramePoolStats pool = FramePool::Shared().GetStats();
+					char tmp[256]{};
+					sprintf_s(tmp, 256, "Frame memory %.1f MB in %u buffers (%.1f MB in use, peak %.1f MB)\n",
+						(double)pool.bytes/1048576.0, (unsigned int)pool.buffers,
+						(double)pool.usedBytes/1048576.0, (double)pool.peakBytes/1048576.0);
+					str += tmp;
+				}
 				SpoutMessageBox(NULL, str.c_str(), " ", MB_USERICON | MB_OK, "SpoutWallPaper");
 			}
 			break;
@@ -1306,6 +2057,18 @@ INT_PTR CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 	case WM_INITDIALOG:
 		return OnInitDialog(hWnd);
 
+	case WM_DISPLAYCHANGE:
+		// Desktop resolution changed.
+		// The presenter gets the new size and Render detects it.
+		g_presenter.Reset();
+		g_scheduler.Wake();
+		// An image is fitted again to the new size
+		if (bShowDaily && !g_dailywallpaperpath.empty())
+			SetWallpaperImage(g_dailywallpaperpath);
+		if (!slidenames.empty() && g_start > 0.0)
+			PrefetchSlides();
+		break;
+
 	case WM_CLOSE:
 		DestroyWindow(hWnd);
 		break;
@@ -1320,6 +2083,465 @@ INT_PTR CALLBACK DlgProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 }
 
 
+// Change the frame placement in the worker window
+void SetFitMode(FitMode mode)
+{
+	if (mode == g_FitMode)
+		return;
+
+	g_FitMode = mode;
+	g_presenter.Invalidate();
+	g_scheduler.Wake();
+	WriteDwordToRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "fitmode", (DWORD)g_FitMode);
+
+	// Fit the image shown again
+	if (bShowDaily && !g_dailywallpaperpath.empty())
+		SetWallpaperImage(g_dailywallpaperpath);
+	// and prepare the next slides for the new mode
+	if (!slidenames.empty() && g_start > 0.0)
+		PrefetchSlides();
+
+	// Restart FFmpeg to produce frames for the new mode
+	if (!g_videopath.empty() && IsVideoOpen())
+		StartVideo();
+}
+
+
+// Change the filter for frames scaled to the desktop
+void SetScaleFilter(ScaleFilter filter)
+{
+	if (filter == g_presenter.GetFilter())
+		return;
+
+	g_presenter.SetFilter(filter);
+	g_presenter.ResetStats();
+	g_presenter.Invalidate();
+	g_scheduler.Wake();
+	WriteDwordToRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "scalefilter", (DWORD)filter);
+}
+
+
+// Change the video playback speed (percent)
+void SetVideoSpeed(int speed)
+{
+	g_VideoSpeed = speed;
+	WriteDwordToRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "videospeed", (DWORD)g_VideoSpeed);
+
+	// The clock continues from the current frame
+	if (g_pacer.IsRunning())
+		g_pacer.SetSpeed(FramePacer::Now(), (double)g_VideoSpeed/100.0);
+}
+
+
+// Change the video decoder
+void SetVideoBackend(VideoBackend backend)
+{
+	if (backend == g_VideoBackend || !IsVideoBackendAvailable(backend))
+		return;
+
+	g_VideoBackend = backend;
+	WriteDwordToRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "videodecoder", (DWORD)g_VideoBackend);
+
+	// Restart the video with the new decoder
+	if (!g_videopath.empty() && IsVideoOpen())
+		StartVideo();
+}
+
+
+// Frame cache file for the video at the output size.
+// The key changes if the file is modified.
+std::string GetFrameCachePath(const FitSize& fit)
+{
+	uint64_t size = 0;
+	int64_t mtime = 0;
+	if (!g_diskcache.IsOpen() || !GetFileStamp(g_videopath, size, mtime))
+		return std::string();
+	char key[512]{};
+	sprintf_s(key, 512, "|%llu|%lld|%ux%u|%ux%u", (unsigned long long)size, (long long)mtime,
+		fit.scaleWidth, fit.scaleHeight, fit.width, fit.height);
+	return g_diskcache.GetPath(g_videopath + key, ".frames");
+}
+
+
+// Replay short videos from the frame cache
+void SetFrameCache(bool bCache)
+{
+	if (bCache == g_bFrameCache)
+		return;
+
+	g_bFrameCache = bCache;
+	WriteDwordToRegistry(HKEY_CURRENT_USER, "Software\\Leading Edge\\SpoutWallpaper", "framecache", (DWORD)g_bFrameCache);
+
+	// Restart the video with or without the cache
+	if (!g_videopath.empty() && IsVideoOpen())
+		StartVideo();
+}
+
+
+// Size of the primary monitor that images are fitted to
+bool GetDesktopSize(unsigned int& width, unsigned int& height)
+{
+	const int cx = GetSystemMetrics(SM_CXSCREEN);
+	const int cy = GetSystemMetrics(SM_CYSCREEN);
+	if (cx <= 0 || cy <= 0)
+		return false;
+	width = (unsigned int)cx;
+	height = (unsigned int)cy;
+	return true;
+}
+
+
+// Size slides are fitted to. The primary monitor for the wallpaper,
+// or the worker window for slides cross faded by the presenter.
+bool GetSlideSize(unsigned int& width, unsigned int& height)
+{
+	if (bSlideFade)
+		return g_presenter.GetTargetSize(width, height);
+	return GetDesktopSize(width, height);
+}
+
+
+// Set an image as the wallpaper.
+// Fitted to the primary monitor from the wallpaper cache if it can be decoded.
+void SetWallpaperImage(const std::string& path)
+{
+	std::string wallpaper = path;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	if (g_wallpapercache.IsOpen() && GetDesktopSize(width, height))
+		wallpaper = g_wallpapercache.GetWallpaper(path, width, height, g_FitMode);
+	SystemParametersInfoA(SPI_SETDESKWALLPAPER, 0, (void*)wallpaper.c_str(), SPIF_SENDCHANGE);
+}
+
+
+// Prepare the slide after the one shown, and the next few random picks,
+// on the prefetch thread before they are due
+void PrefetchSlides()
+{
+	unsigned int width = 0;
+	unsigned int height = 0;
+	if (slidenames.size() < 2 || !GetSlideSize(width, height))
+		return;
+
+	if (bRandom) {
+		while (slidepicks.size() < g_SlidePicks)
+			slidepicks.push_back(rand()%(slidenames.size()));
+	}
+
+	std::string folder = g_slideshowpath;
+	folder += "\\";
+	std::vector<std::string> paths;
+	paths.push_back(folder + slidenames[nCurrentImage]);
+	for (int pick : slidepicks)
+		paths.push_back(folder + slidenames[pick]);
+	g_prefetch.Prefetch(paths, width, height, g_FitMode);
+}
+
+
+// Apply the changes to the slideshow folder since the last update.
+// Only the paths changed are looked at unless notifications were lost.
+// The next slide stays the same if it is still there.
+void UpdateSlides()
+{
+	bool bOverflow = false;
+	const std::vector<DirChange> changes = g_dirwatch.TakeChanges(bOverflow);
+	if (slidenames.empty() || g_start <= 0.0 || (changes.empty() && !bOverflow))
+		return;
+
+	TRACE_SCOPE("Slides changed", "image");
+
+	if (bOverflow) {
+		// List the folder again on the scan thread. Only changed folders
+		// are read. Not needed if a scan has started since.
+		if (!g_bSlideScanning)
+			StartSlideScan(g_slideshowpath, false);
+		return;
+	}
+	else {
+		for (const DirChange& change : changes) {
+			switch (change.action) {
+				case DIR_ADDED:
+				case DIR_MODIFIED:
+					// A file copied in may only be complete when it is modified.
+					// A folder is modified by each file added to it, which is
+					// reported itself, so only a folder added is listed.
+					AddSlide(change.path, change.action == DIR_ADDED);
+					break;
+				case DIR_REMOVED:
+					RemoveSlide(change.path);
+					break;
+				case DIR_RENAMED:
+					if (slidenames.Find(change.oldpath) >= 0) {
+						if (SlideIndex::IsImageName(change.path)) {
+							slidenames.Rename(change.oldpath, change.path);
+							g_SlideChanges++;
+						}
+						else {
+							RemoveSlide(change.oldpath);
+						}
+					}
+					else {
+						// The slides in a folder renamed keep their place
+						const std::vector<std::string> paths = slidenames.Within(change.oldpath);
+						for (const std::string& path : paths)
+							slidenames.Rename(path, change.path + path.substr(change.oldpath.size()));
+						g_SlideChanges += paths.size();
+						if (paths.empty())
+							AddSlide(change.path, true);
+					}
+					break;
+			}
+		}
+	}
+
+	SlidesChanged();
+}
+
+
+// The slides have been added to, removed or listed again
+void SlidesChanged()
+{
+	if (slidenames.empty()) {
+		// Nothing left to show
+		slidepicks.clear();
+		nCurrentImage = 0;
+		g_start = 0.0;
+		g_prefetch.Close();
+		return;
+	}
+
+	// Prepare the next slides again if they have changed
+	PrefetchSlides();
+	g_scheduler.Wake();
+}
+
+
+// Add an image, or the images in a folder if bFolder, to the slideshow
+void AddSlide(const std::string& path, bool bFolder)
+{
+	// Already a slide, so not opened again
+	if (slidenames.Find(path) >= 0)
+		return;
+
+	const std::string fullpath = std::string(g_slideshowpath) + "\\" + path;
+	const DWORD dwAttributes = GetFileAttributesA(fullpath.c_str());
+	if (dwAttributes == INVALID_FILE_ATTRIBUTES)
+		return;
+
+	if (dwAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+		// A folder copied or moved in
+		if (!bFolder || (dwAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+			return;
+		WIN32_FIND_DATAA fd{};
+		HANDLE hFind = FindFirstFileA((fullpath + "\\*").c_str(), &fd);
+		if (hFind == INVALID_HANDLE_VALUE)
+			return;
+		do {
+			// Files without an image extension are not opened
+			if (strcmp(fd.cFileName, ".") == 0 || strcmp(fd.cFileName, "..") == 0)
+				continue;
+			if ((fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || SlideIndex::IsImageName(fd.cFileName))
+				AddSlide(path + "\\" + fd.cFileName, true);
+		} while (FindNextFileA(hFind, &fd));
+		FindClose(hFind);
+		return;
+	}
+
+	SlideEntry entry;
+	if (SlideIndex::IsImageName(path) && SlideIndex::ProbeImage(fullpath, path, entry)) {
+		if (slidenames.Add(path))
+			g_SlideChanges++;
+	}
+}
+
+
+// Remove an image, or the images in a folder, from the slideshow.
+// The last slide takes the place of each one removed.
+void RemoveSlide(const std::string& path)
+{
+	std::vector<std::string> paths;
+	if (slidenames.Find(path) >= 0)
+		paths.push_back(path);
+	else
+		paths = slidenames.Within(path);
+
+	for (const std::string& removed : paths) {
+		size_t index = 0;
+		size_t moved = 0;
+		if (!slidenames.Remove(removed, index, moved))
+			continue;
+		g_SlideChanges++;
+		// The next slide and the random picks follow the slide moved
+		if ((size_t)nCurrentImage == moved)
+			nCurrentImage = (int)index;
+		if ((size_t)nCurrentImage >= slidenames.size())
+			nCurrentImage = 0;
+		for (auto it = slidepicks.begin(); it != slidepicks.end(); ) {
+			if ((size_t)*it == moved)
+				*it = (int)index;
+			if ((size_t)*it >= slidenames.size())
+				it = slidepicks.erase(it);
+			else
+				++it;
+		}
+	}
+}
+
+
+// Time until the scheduler has work due (msec).
+// INFINITE if there is none to wait for.
+DWORD GetRenderWait()
+{
+	const double wait = g_scheduler.GetWaitTime(FramePacer::Now());
+	if (wait < 0.0)
+		return INFINITE;
+	return (DWORD)ceil(wait*1000.0);
+}
+
+
+// Set the deadlines for the next render in the mode shown.
+// Frames received by the Spout or video reader wake the loop themselves.
+void ScheduleRender()
+{
+	g_scheduler.CancelAll();
+
+	// The slideshow folder is watched until another mode is selected.
+	// A single slide is idle but more can be added.
+	if (slidenames.empty() || g_start <= 0.0) {
+		if (g_dirwatch.IsOpen())
+			g_dirwatch.Close();
+		if (g_slidefade.HasSlide())
+			g_slidefade.Release();
+	}
+
+	// Nothing changes for a still wallpaper
+	if (bShowDaily || (slidenames.size() == 1 && g_start > 0.0)) {
+		EnterIdle();
+		return;
+	}
+	// Resources are created again as they are used
+	g_bIdle = false;
+
+	// The next frame of a transition, or the next slide
+	if (!slidenames.empty() && g_start > 0.0) {
+		if (g_slidefade.IsFading()) {
+			g_scheduler.Schedule(SCHEDULE_FRAME, g_slidefade.GetNextTime()/1000.0);
+			return;
+		}
+		g_scheduler.Schedule(SCHEDULE_SLIDE, (g_start + (double)g_slideshowtime*1000.0)/1000.0);
+		return;
+	}
+
+	// The next video frame if one has been decoded
+	if (!g_videopath.empty()) {
+		const double now = FramePacer::Now();
+		if (g_pacer.IsRunning() && g_frames.GetPending() > 0)
+			g_scheduler.Schedule(SCHEDULE_FRAME, now + g_pacer.GetWaitTime(now));
+		return;
+	}
+
+	// Draw the Spout frame again once a second
+	if (g_spoutreader.IsReceiving() && g_LastPresent > 0.0)
+		g_scheduler.Schedule(SCHEDULE_REFRESH, g_LastPresent/1000.0 + 1.0);
+}
+
+
+// Release everything that is only needed to draw frames.
+// Nothing wakes the loop until another mode is selected.
+void EnterIdle()
+{
+	if (g_bIdle)
+		return;
+
+	// Video and Spout are stopped by the menu selection
+	CloseVideo();
+	g_spoutreader.Release();
+
+	// Window DC and bitmaps
+	g_presenter.Release();
+	g_framechange.Reset();
+
+	// No more slides to prepare
+	g_prefetch.Close();
+	g_wallpapercache.Save();
+
+	// Frame memory not held by anything
+	FramePool::Shared().Trim();
+
+	// The next frame does not follow the last one
+	g_LastFrame = 0.0;
+	g_SenderFps = 0.0;
+
+	TRACE_INSTANT("Idle", "mode");
+	g_bIdle = true;
+}
+
+
+// Frame rate and pipeline times in the tray tooltip
+void UpdateTrayTip()
+{
+	wchar_t ws[128]{};
+	const FrameHistogramStats present = FrameStats::Shared().GetHistogram(STAGE_PRESENT).GetStats();
+	if (FrameStats::Shared().IsEnabled() && present.count > 0 && g_SenderFps > 0.0) {
+		swprintf_s(ws, 128, L"SpoutWallPaper\n%.1f fps\nPresent %.2f msec (99%% %.2f)",
+			g_SenderFps, present.p50, present.p99);
+	}
+	else {
+		wcscpy_s(ws, 128, L"SpoutWallPaper");
+	}
+	// Only if the text has changed
+	if (wcscmp(ws, niData.szTip) == 0)
+		return;
+	lstrcpyn(niData.szTip, ws, sizeof(niData.szTip)/sizeof(TCHAR));
+	niData.uFlags = NIF_TIP;
+	Shell_NotifyIcon(NIM_MODIFY, &niData);
+}
+
+
+// Frame pipeline times and histograms to DATA\framestats.txt
+void SaveFrameStats()
+{
+	const std::string path = g_exePath + "\\DATA\\framestats.txt";
+	if (FrameStats::Shared().Save(path)) {
+		std::string str = "Frame statistics saved to\n";
+		str += path;
+		SpoutMessageBox(NULL, str.c_str(), "SpoutWallPaper", MB_ICONINFORMATION | MB_OK);
+	}
+	else {
+		SpoutMessageBox(NULL, "Could not save frame statistics", "SpoutWallPaper", MB_ICONWARNING | MB_OK);
+	}
+}
+
+
+// Tracing is started from the menu and the events
+// recorded are saved when it is stopped
+void SetTrace(bool bTrace)
+{
+	if (bTrace) {
+		FrameTrace::Shared().SetEnabled(true);
+		FrameTrace::Shared().SetThreadName("Render loop");
+		return;
+	}
+	FrameTrace::Shared().SetEnabled(false);
+	if (SaveTrace()) {
+		std::string str = "Trace saved to\n";
+		str += g_exePath + "\\DATA\\trace.json";
+		str += "\n\nOpen it with ui.perfetto.dev or chrome://tracing";
+		SpoutMessageBox(NULL, str.c_str(), "SpoutWallPaper", MB_ICONINFORMATION | MB_OK);
+	}
+	else {
+		SpoutMessageBox(NULL, "Could not save the trace", "SpoutWallPaper", MB_ICONWARNING | MB_OK);
+	}
+}
+
+
+// Trace events as Chrome trace-event JSON
+bool SaveTrace()
+{
+	return FrameTrace::Shared().Save(g_exePath + "\\DATA\\trace.json");
+}
+
+
 // Select slide duration aft selecting folder
 bool SelectSlideDuration()
 {
@@ -1376,6 +2598,12 @@ INT_PTR CALLBACK SlideDuration(HWND hDlg, UINT message, WPARAM wParam, LPARAM lP
 		else
 			CheckDlgButton(hDlg, IDC_SLIDE_RANDOM, BST_UNCHECKED);
 
+		// Cross fade
+		if (bSlideFade)
+			CheckDlgButton(hDlg, IDC_SLIDE_FADE, BST_CHECKED);
+		else
+			CheckDlgButton(hDlg, IDC_SLIDE_FADE, BST_UNCHECKED);
+
 		return (INT_PTR)TRUE;
 
 	case WM_COMMAND:
@@ -1395,6 +2623,11 @@ INT_PTR CALLBACK SlideDuration(HWND hDlg, UINT message, WPARAM wParam, LPARAM lP
 				bRandom = true;
 			else
 				bRandom = false;
+			// Cross fade slides
+			if (IsDlgButtonChecked(hDlg, IDC_SLIDE_FADE) == BST_CHECKED)
+				bSlideFade = true;
+			else
+				bSlideFade = false;
 			EndDialog(hDlg, 1);
 			return (INT_PTR)TRUE;
 		case IDCANCEL:
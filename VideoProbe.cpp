@@ -0,0 +1,405 @@
+//
+//		VideoProbe
+//
+//		Video stream information from FFprobe.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "VideoProbe.h"
+#include "FrameTrace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Cache file format version
+static const char* cacheheader = "# SpoutWallPaper probe cache 3";
+
+static FILE* OpenCacheFile(const std::string& path, const char* mode)
+{
+#ifdef _MSC_VER
+	FILE* file = nullptr;
+	if (fopen_s(&file, path.c_str(), mode) != 0)
+		return nullptr;
+	return file;
+#else
+	return fopen(path.c_str(), mode);
+#endif
+}
+
+// Parse a frame rate such as "30000/1001"
+static bool ParseRate(const std::string& value, unsigned int& num, unsigned int& den)
+{
+	const size_t pos = value.find('/');
+	if (pos == std::string::npos)
+		return false;
+	const unsigned int n = (unsigned int)strtoul(value.substr(0, pos).c_str(), nullptr, 10);
+	const unsigned int d = (unsigned int)strtoul(value.substr(pos + 1).c_str(), nullptr, 10);
+	if (n == 0 || d == 0)
+		return false; // "0/0" if not known
+	num = n;
+	den = d;
+	return true;
+}
+
+bool ParseProbeOutput(const std::string& output, VideoInfo& info)
+{
+	info = VideoInfo();
+	std::string rframerate;
+	std::string avgframerate;
+
+	size_t start = 0;
+	while (start < output.size()) {
+		size_t end = output.find('\n', start);
+		if (end == std::string::npos)
+			end = output.size();
+		std::string line = output.substr(start, end - start);
+		start = end + 1;
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		const size_t pos = line.find('=');
+		if (pos == std::string::npos)
+			continue;
+		const std::string key = line.substr(0, pos);
+		const std::string value = line.substr(pos + 1);
+
+		// Values are "N/A" if not known
+		if (key == "width")
+			info.width = (unsigned int)atoi(value.c_str());
+		else if (key == "height")
+			info.height = (unsigned int)atoi(value.c_str());
+		else if (key == "nb_frames")
+			info.frames = (unsigned int)atoi(value.c_str());
+		else if (key == "duration")
+			info.duration = atof(value.c_str());
+		else if (key == "color_space")
+			info.colorSpace = value;
+		else if (key == "r_frame_rate")
+			rframerate = value;
+		else if (key == "avg_frame_rate")
+			avgframerate = value;
+	}
+
+	// Average frame rate, or the base rate if not known.
+	// The base rate is the lowest rate that all frame times fit and is
+	// often twice the real rate for interlaced or variable rate video.
+	unsigned int rnum = 0;
+	unsigned int rden = 0;
+	const bool bBase = ParseRate(rframerate, rnum, rden);
+	if (ParseRate(avgframerate, info.rateNum, info.rateDen)) {
+		// The average of a constant rate video is often rounded, or taken
+		// over a duration that is not a whole number of frames, so it can
+		// differ slightly from the base rate. Rates within 0.5% are the
+		// same, and the base rate is exact.
+		if (bBase) {
+			const double base = (double)rnum/(double)rden;
+			const double average = (double)info.rateNum/(double)info.rateDen;
+			if (fabs(average - base) <= base*0.005) {
+				info.rateNum = rnum;
+				info.rateDen = rden;
+			}
+			else {
+				// Frames are not evenly spaced at the average rate
+				info.bVariableRate = true;
+			}
+		}
+	}
+	else if (bBase) {
+		info.rateNum = rnum;
+		info.rateDen = rden;
+	}
+
+	return (info.width > 0 && info.height > 0);
+}
+
+#ifdef _WIN32
+
+// Run a command without a console window and return its standard output
+static bool RunCommand(const std::string& command, std::string& output)
+{
+	SECURITY_ATTRIBUTES sa{};
+	sa.nLength = sizeof(SECURITY_ATTRIBUTES);
+	sa.bInheritHandle = TRUE;
+	HANDLE hRead = NULL;
+	HANDLE hWrite = NULL;
+	if (!CreatePipe(&hRead, &hWrite, &sa, 0))
+		return false;
+	// The read end stays with this process
+	SetHandleInformation(hRead, HANDLE_FLAG_INHERIT, 0);
+
+	STARTUPINFOA si{};
+	si.cb = sizeof(STARTUPINFOA);
+	si.dwFlags = STARTF_USESTDHANDLES;
+	si.hStdInput = NULL;
+	si.hStdOutput = hWrite;
+	si.hStdError = NULL;
+	PROCESS_INFORMATION pi{};
+	std::string cmdline = command; // CreateProcess can modify the command line
+	if (!CreateProcessA(NULL, &cmdline[0], NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi)) {
+		CloseHandle(hRead);
+		CloseHandle(hWrite);
+		return false;
+	}
+	// Only the child holds the write end, so ReadFile
+	// returns false when the process has finished
+	CloseHandle(hWrite);
+
+	char buffer[4096];
+	DWORD dwRead = 0;
+	while (ReadFile(hRead, buffer, sizeof(buffer), &dwRead, NULL) && dwRead > 0)
+		output.append(buffer, dwRead);
+	CloseHandle(hRead);
+
+	DWORD dwExitCode = 1;
+	WaitForSingleObject(pi.hProcess, INFINITE);
+	GetExitCodeProcess(pi.hProcess, &dwExitCode);
+	CloseHandle(pi.hProcess);
+	CloseHandle(pi.hThread);
+
+	return (dwExitCode == 0);
+}
+
+#else
+
+static bool RunCommand(const std::string& command, std::string& output)
+{
+	FILE* pipe = popen(command.c_str(), "r");
+	if (!pipe)
+		return false;
+	char buffer[4096];
+	size_t n = 0;
+	while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+		output.append(buffer, n);
+	return (pclose(pipe) == 0);
+}
+
+#endif
+
+bool ProbeVideo(const std::string& ffprobepath, const std::string& videopath, VideoInfo& info)
+{
+	// Only the entries needed from the first video stream, one per line
+	std::string command = "\"";
+	command += ffprobepath;
+	command += "\" -v error -select_streams v:0";
+	command += " -show_entries stream=width,height,nb_frames,duration,color_space,r_frame_rate,avg_frame_rate";
+	command += " -of default=noprint_wrappers=1 \"";
+	command += videopath;
+	command += "\"";
+
+	TRACE_SCOPE("ffprobe", "video");
+	std::string output;
+	if (!RunCommand(command, output))
+		return false;
+
+	return ParseProbeOutput(output, info);
+}
+
+bool GetFileStamp(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+#ifdef _WIN32
+	struct _stat64 st {};
+	if (_stat64(path.c_str(), &st) != 0)
+		return false;
+#else
+	struct stat st {};
+	if (stat(path.c_str(), &st) != 0)
+		return false;
+#endif
+	size = (uint64_t)st.st_size;
+	mtime = (int64_t)st.st_mtime;
+	return true;
+}
+
+//
+// ProbeCache
+//
+// One line for each video :
+// size, modified time, width, height, frames, duration,
+// frame rate numerator and denominator, variable rate, colour space, path
+// separated by tabs. The path is last and can contain any other character.
+//
+
+ProbeCache::ProbeCache()
+{
+}
+
+bool ProbeCache::Load(const std::string& cachefile)
+{
+	m_CacheFile = cachefile;
+	m_Entries.clear();
+	m_bChanged = false;
+	m_bReordered = false;
+
+	FILE* file = OpenCacheFile(cachefile, "rb");
+	if (!file)
+		return true; // No cache yet
+
+	std::string contents;
+	char buffer[4096];
+	size_t n = 0;
+	while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		contents.append(buffer, n);
+	fclose(file);
+
+	size_t start = 0;
+	bool bHeader = true;
+	while (start < contents.size()) {
+		size_t end = contents.find('\n', start);
+		if (end == std::string::npos)
+			end = contents.size();
+		const std::string line = contents.substr(start, end - start);
+		start = end + 1;
+
+		// A cache from another version is ignored
+		if (bHeader) {
+			if (line != cacheheader)
+				return false;
+			bHeader = false;
+			continue;
+		}
+
+		std::vector<std::string> fields;
+		size_t pos = 0;
+		while (fields.size() < 10) {
+			const size_t tab = line.find('\t', pos);
+			if (tab == std::string::npos)
+				break;
+			fields.push_back(line.substr(pos, tab - pos));
+			pos = tab + 1;
+		}
+		if (fields.size() < 10 || pos >= line.size())
+			continue;
+
+		Entry entry;
+		entry.size = strtoull(fields[0].c_str(), nullptr, 10);
+		entry.mtime = strtoll(fields[1].c_str(), nullptr, 10);
+		entry.info.width = (unsigned int)strtoul(fields[2].c_str(), nullptr, 10);
+		entry.info.height = (unsigned int)strtoul(fields[3].c_str(), nullptr, 10);
+		entry.info.frames = (unsigned int)strtoul(fields[4].c_str(), nullptr, 10);
+		entry.info.duration = atof(fields[5].c_str());
+		entry.info.rateNum = (unsigned int)strtoul(fields[6].c_str(), nullptr, 10);
+		entry.info.rateDen = (unsigned int)strtoul(fields[7].c_str(), nullptr, 10);
+		entry.info.bVariableRate = (fields[8] == "1");
+		entry.info.colorSpace = fields[9];
+		entry.path = line.substr(pos);
+		if (entry.info.width == 0 || entry.info.height == 0 || entry.info.rateNum == 0 || entry.info.rateDen == 0)
+			continue;
+		m_Entries.push_back(entry);
+	}
+
+	return true;
+}
+
+bool ProbeCache::Save(bool bOrder)
+{
+	if (!(m_bChanged || (bOrder && m_bReordered)) || m_CacheFile.empty())
+		return true;
+
+	// Write a temporary file and replace the cache
+	// so that a partly written cache is never read
+	const std::string tmpfile = m_CacheFile + ".tmp";
+	FILE* file = OpenCacheFile(tmpfile, "wb");
+	if (!file)
+		return false;
+
+	fprintf(file, "%s\n", cacheheader);
+	for (size_t i = 0; i < m_Entries.size(); i++) {
+		const Entry& entry = m_Entries[i];
+		fprintf(file, "%llu\t%lld\t%u\t%u\t%u\t%.6f\t%u\t%u\t%d\t%s\t%s\n",
+			(unsigned long long)entry.size, (long long)entry.mtime,
+			entry.info.width, entry.info.height, entry.info.frames, entry.info.duration,
+			entry.info.rateNum, entry.info.rateDen, entry.info.bVariableRate ? 1 : 0,
+			entry.info.colorSpace.c_str(), entry.path.c_str());
+	}
+	const bool bWritten = (fclose(file) == 0);
+
+	if (bWritten) {
+		remove(m_CacheFile.c_str());
+		if (rename(tmpfile.c_str(), m_CacheFile.c_str()) == 0) {
+			m_bChanged = false;
+			m_bReordered = false;
+			return true;
+		}
+	}
+	remove(tmpfile.c_str());
+	return false;
+}
+
+bool ProbeCache::Find(const std::string& videopath, VideoInfo& info)
+{
+	uint64_t size = 0;
+	int64_t mtime = 0;
+	if (!GetFileStamp(videopath, size, mtime))
+		return false;
+
+	for (size_t i = 0; i < m_Entries.size(); i++) {
+		if (m_Entries[i].path == videopath) {
+			// The file has changed since it was probed
+			if (m_Entries[i].size != size || m_Entries[i].mtime != mtime)
+				return false;
+			info = m_Entries[i].info;
+			// Move to most recently used
+			if (i + 1 < m_Entries.size()) {
+				Entry entry = m_Entries[i];
+				m_Entries.erase(m_Entries.begin() + i);
+				m_Entries.push_back(entry);
+				m_bReordered = true;
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ProbeCache::Store(const std::string& videopath, const VideoInfo& info)
+{
+	Entry entry;
+	if (!GetFileStamp(videopath, entry.size, entry.mtime))
+		return;
+	entry.path = videopath;
+	entry.info = info;
+	// Tabs and line ends would break the cache file
+	if (entry.path.find_first_of("\t\r\n") != std::string::npos
+		|| entry.info.colorSpace.find_first_of("\t\r\n") != std::string::npos)
+		return;
+
+	for (size_t i = 0; i < m_Entries.size(); i++) {
+		if (m_Entries[i].path == videopath) {
+			m_Entries.erase(m_Entries.begin() + i);
+			break;
+		}
+	}
+	m_Entries.push_back(entry);
+
+	// Remove the least recently used
+	while (m_Entries.size() > m_MaxEntries && !m_Entries.empty())
+		m_Entries.erase(m_Entries.begin());
+
+	m_bChanged = true;
+}
@@ -0,0 +1,96 @@
+//
+//		VideoProbe
+//
+//		Video stream information from FFprobe.
+//
+//		FFprobe is run with its output on a pipe that is read until the
+//		process ends. No batch or ini file is used and there is no busy wait.
+//
+//		Results are kept in a cache file with the size and modified time of
+//		each video, so a video that has not changed is not probed again.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// First video stream of a file
+struct VideoInfo {
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int frames = 0;   // 0 if not in the container
+	double duration = 0.0;     // Seconds, 0 if not known
+	unsigned int rateNum = 30; // Frame rate as a fraction
+	unsigned int rateDen = 1;
+	bool bVariableRate = false; // Frame times are not a multiple of the rate
+	std::string colorSpace;    // e.g. "bt709", "smpte170m" or "unknown"
+};
+
+// Run FFprobe on a video file and read the first video stream
+bool ProbeVideo(const std::string& ffprobepath, const std::string& videopath, VideoInfo& info);
+
+// Read "key=value" lines produced by FFprobe
+bool ParseProbeOutput(const std::string& output, VideoInfo& info);
+
+// File size and modified time. False if the file does not exist.
+bool GetFileStamp(const std::string& path, uint64_t& size, int64_t& mtime);
+
+class ProbeCache {
+
+public:
+
+	ProbeCache();
+
+	// Read the cache file. A missing file is an empty cache.
+	bool Load(const std::string& cachefile);
+	// Write the cache file if entries have been added or removed.
+	// bOrder to write it as well if only the order of use has changed,
+	// which is kept until the program exits.
+	bool Save(bool bOrder = false);
+
+	// Information for a video unchanged since it was stored
+	bool Find(const std::string& videopath, VideoInfo& info);
+	// Add or replace the information for a video
+	void Store(const std::string& videopath, const VideoInfo& info);
+
+	size_t GetCount() const { return m_Entries.size(); }
+	// Entries kept, the least recently used are removed
+	void SetMaxEntries(size_t entries) { m_MaxEntries = entries; }
+
+private:
+
+	struct Entry {
+		std::string path;
+		uint64_t size = 0;
+		int64_t mtime = 0;
+		VideoInfo info;
+	};
+
+	std::vector<Entry> m_Entries; // Most recently used last
+	std::string m_CacheFile;
+	size_t m_MaxEntries = 256;
+	bool m_bChanged = false;
+	bool m_bReordered = false; // Entries used since the file was written
+
+};
@@ -0,0 +1,71 @@
+//
+//		VideoSource
+//
+//		Source of decoded video frames for the render loop.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "VideoSource.h"
+#include "PipeSource.h"
+#include "LibavSource.h"
+#include "CacheSource.h"
+
+VideoSource* CreateVideoSource(VideoBackend backend)
+{
+	switch (backend) {
+		case VIDEO_PIPE:
+			return new PipeSource();
+#ifdef USE_LIBAV
+		case VIDEO_LIBAV:
+			return new LibavSource();
+#endif
+		case VIDEO_CACHE:
+			return new CacheSource();
+		default:
+			return nullptr;
+	}
+}
+
+bool IsVideoBackendAvailable(VideoBackend backend)
+{
+	switch (backend) {
+		case VIDEO_PIPE:
+			return true;
+#ifdef USE_LIBAV
+		case VIDEO_LIBAV:
+			return true;
+#endif
+		case VIDEO_CACHE:
+			return true;
+		default:
+			return false;
+	}
+}
+
+const char* VideoBackendName(VideoBackend backend)
+{
+	switch (backend) {
+		case VIDEO_PIPE:  return "FFmpeg process";
+		case VIDEO_LIBAV: return "FFmpeg libraries";
+		case VIDEO_CACHE: return "Frame cache";
+		default:          return "Unknown";
+	}
+}
@@ -0,0 +1,104 @@
+//
+//		VideoSource
+//
+//		Source of decoded video frames for the render loop.
+//
+//		A source decodes a video file on its own thread, loops it, and writes
+//		BGRA frames of the negotiated size into the slots of a FrameRing.
+//
+//		  o VIDEO_PIPE  - ffmpeg.exe sends raw frames through a pipe (PipeSource)
+//		  o VIDEO_LIBAV - the FFmpeg libraries decode in this process (LibavSource)
+//		  o VIDEO_CACHE - frames of a loop replayed from a FrameCache file (CacheSource)
+//
+//		The libav source is only available if built with USE_LIBAV.
+//		See LibavSource.h.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <string>
+#include <functional>
+#include "FrameRing.h"
+#include "FrameFit.h"
+#include "YuvConvert.h"
+#include "LoopTiming.h"
+
+enum VideoBackend {
+	VIDEO_PIPE = 0,
+	VIDEO_LIBAV,
+	VIDEO_CACHE
+};
+
+// What to decode and the output wanted
+struct VideoSourceParams {
+	std::string path;              // Video file
+	std::string ffmpegPath;        // ffmpeg.exe for the pipe source
+	std::string cachePath;         // Frame cache file for the cache source
+	unsigned int videoWidth = 0;   // Size of the video file
+	unsigned int videoHeight = 0;
+	FitSize fit;                   // Scale and crop negotiated with the desktop
+	YuvColor color;                // Colour matrix of the video
+	unsigned int loopFrames = 0;   // Frames in one loop, 0 if not known
+	unsigned int rateNum = 30;     // Frame rate the frames are paced at
+	unsigned int rateDen = 1;
+	bool bVariableRate = false;    // Resample frames to the rate by their timestamps
+	bool bYuv = true;              // Pipe sends yuv420p instead of bgra
+};
+
+class VideoSource {
+
+public:
+
+	virtual ~VideoSource() {}
+
+	// Start decoding into the ring.
+	// The ring must be allocated for the output size fit.width x fit.height.
+	virtual bool Open(const VideoSourceParams& params, FrameRing* ring) = 0;
+	// Stop decoding
+	virtual void Close() = 0;
+	virtual bool IsOpen() const = 0;
+	// Decoding has stopped because of an error
+	virtual bool IsFinished() const = 0;
+
+	// Called on the source thread after each frame is published
+	virtual void SetFrameCallback(std::function<void()> callback) = 0;
+
+	// Called on the source thread with each BGRA frame before it is published.
+	// bLoopStart is true for the first frame of each loop.
+	virtual void SetFrameSink(std::function<void(const unsigned char* frame, bool bLoopStart)> sink) = 0;
+
+	// Loop boundary timing
+	virtual const LoopTiming& GetLoopTiming() const = 0;
+
+	virtual VideoBackend GetBackend() const = 0;
+
+};
+
+// Create a source for the backend.
+// Returns nullptr if the backend is not available in this build.
+VideoSource* CreateVideoSource(VideoBackend backend);
+
+// Is the backend available in this build
+bool IsVideoBackendAvailable(VideoBackend backend);
+
+// Name for menus and statistics
+const char* VideoBackendName(VideoBackend backend);
@@ -0,0 +1,514 @@
+//
+//		WallpaperCache
+//
+//		Images fitted to the desktop before they are set as the wallpaper.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "WallpaperCache.h"
+#include "VideoProbe.h"
+#include "PixelKernels.h"
+#include "FrameTrace.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <iterator>
+#include <chrono>
+#include <filesystem>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_NO_HDR
+#define STBI_NO_LINEAR
+#include "stb_image.h"
+
+namespace fs = std::filesystem;
+
+static const char* hashheader = "# SpoutWallPaper wallpaper hashes 2";
+
+static FILE* OpenCacheFile(const std::string& path, const char* mode)
+{
+	FILE* file = nullptr;
+#ifdef _MSC_VER
+	if (fopen_s(&file, path.c_str(), mode) != 0)
+		file = nullptr;
+#else
+	file = fopen(path.c_str(), mode);
+#endif
+	return file;
+}
+
+WallpaperCache::WallpaperCache()
+{
+	// Images are scaled on the calling thread, at its priority,
+	// as slides are prepared in the background at low priority
+	m_Scaler.SetThreads(1);
+}
+
+bool WallpaperCache::Open(const std::string& folder, uint64_t budget)
+{
+	if (!m_Cache.Open(folder, budget))
+		return false;
+
+	// Beside the folder rather than in it, where the
+	// DiskCache would count it and could remove it
+	fs::path path = fs::path(folder);
+	if (!path.has_filename())
+		path = path.parent_path();
+	m_HashFile = (path.parent_path() / "wallpaperhashes.txt").string();
+	LoadHashes();
+	return true;
+}
+
+std::string WallpaperCache::GetWallpaper(const std::string& path, unsigned int width, unsigned int height, FitMode mode)
+{
+	if (!m_Cache.IsOpen() || path.empty() || width == 0 || height == 0)
+		return path;
+
+	const std::string hash = GetContentHash(path);
+	if (hash.empty())
+		return path;
+
+	const ScaleFilter filter = m_Filter;
+	// "bgra" so that the 24 bit BMPs of earlier versions are not found
+	char key[128]{};
+	snprintf(key, 128, "|%ux%u|%d|%d|bgra", width, height, (int)mode, (int)filter);
+	const std::string bmppath = m_Cache.GetPath(hash + key, ".bmp");
+
+	// Fitted before
+	if (m_Cache.Touch(bmppath)) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stats.hits++;
+		return bmppath;
+	}
+
+	TRACE_SCOPE("Fit wallpaper", "image");
+	const auto start = std::chrono::steady_clock::now();
+	const bool bFitted = FitImage(path, bmppath, width, height, mode, filter);
+	const double msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (!bFitted) {
+			m_Stats.failed++;
+			return path;
+		}
+		m_Stats.fitted++;
+		m_Stats.mean += (msec - m_Stats.mean)/(double)m_Stats.fitted;
+		if (msec > m_Stats.max)
+			m_Stats.max = msec;
+	}
+
+	m_Cache.Evict(bmppath);
+	return bmppath;
+}
+
+bool WallpaperCache::GetFrame(const std::string& path, unsigned int width, unsigned int height, FitMode mode, FrameBuffer& frame)
+{
+	if (path.empty() || width == 0 || height == 0)
+		return false;
+	frame = FramePool::Shared().Acquire((size_t)width*height*4);
+	if (frame.empty())
+		return false;
+
+	// The fitted image is read as it is, without decoding or scaling
+	const std::string bmppath = GetWallpaper(path, width, height, mode);
+	if (bmppath != path) {
+		TRACE_SCOPE("Read wallpaper", "image");
+		if (ReadBitmap(bmppath, frame.data(), width, height))
+			return true;
+	}
+
+	// Not cached
+	if (!FitPixels(path, frame.data(), width, height, mode, m_Filter)) {
+		frame.reset();
+		return false;
+	}
+	return true;
+}
+
+WallpaperCacheStats WallpaperCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Stats;
+}
+
+// The contents are only read again if the file size or time has changed
+std::string WallpaperCache::GetContentHash(const std::string& path)
+{
+	uint64_t size = 0;
+	int64_t mtime = 0;
+	if (!GetFileStamp(path, size, mtime))
+		return std::string();
+	char stamp[64]{};
+	snprintf(stamp, 64, "|%llu|%lld", (unsigned long long)size, (long long)mtime);
+	const std::string key = path + stamp;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto it = m_Hashes.find(key);
+		if (it != m_Hashes.end()) {
+			// Now the most recently used
+			m_HashOrder.splice(m_HashOrder.end(), m_HashOrder, it->second);
+			return it->second->hash;
+		}
+	}
+
+	const std::string hash = HashFile(path);
+	if (!hash.empty()) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		StoreHash(key, hash);
+		m_bHashesChanged = true;
+	}
+	return hash;
+}
+
+// Called with the mutex locked, or before the cache is used
+void WallpaperCache::StoreHash(const std::string& key, const std::string& hash)
+{
+	auto it = m_Hashes.find(key);
+	if (it != m_Hashes.end()) {
+		it->second->hash = hash;
+		m_HashOrder.splice(m_HashOrder.end(), m_HashOrder, it->second);
+		return;
+	}
+	m_HashOrder.push_back({ key, hash });
+	m_Hashes[key] = std::prev(m_HashOrder.end());
+
+	// Remove the least recently used
+	while (m_HashOrder.size() > m_MaxHashes && !m_HashOrder.empty()) {
+		m_Hashes.erase(m_HashOrder.front().key);
+		m_HashOrder.pop_front();
+	}
+}
+
+// A missing file or one from another version is an empty list
+bool WallpaperCache::LoadHashes()
+{
+	m_HashOrder.clear();
+	m_Hashes.clear();
+	m_bHashesChanged = false;
+
+	FILE* file = OpenCacheFile(m_HashFile, "rb");
+	if (!file)
+		return true;
+
+	std::string contents;
+	char buffer[4096];
+	size_t n = 0;
+	while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		contents.append(buffer, n);
+	fclose(file);
+
+	size_t start = 0;
+	bool bHeader = true;
+	while (start < contents.size()) {
+		size_t end = contents.find('\n', start);
+		if (end == std::string::npos)
+			end = contents.size();
+		const std::string line = contents.substr(start, end - start);
+		start = end + 1;
+
+		if (bHeader) {
+			if (line != hashheader)
+				return false;
+			bHeader = false;
+			continue;
+		}
+
+		// Hash, tab, then path, size and time
+		const size_t tab = line.find('\t');
+		if (tab != 16 || tab + 1 >= line.size())
+			continue;
+		StoreHash(line.substr(tab + 1), line.substr(0, tab));
+	}
+	return true;
+}
+
+bool WallpaperCache::Save()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (!m_bHashesChanged || m_HashFile.empty())
+		return true;
+
+	// Write a temporary file and replace the list
+	// so that a partly written list is never read
+	const std::string tmpfile = m_HashFile + ".tmp";
+	FILE* file = OpenCacheFile(tmpfile, "wb");
+	if (!file)
+		return false;
+
+	fprintf(file, "%s\n", hashheader);
+	for (const HashEntry& entry : m_HashOrder) {
+		// Line ends would break the file
+		if (entry.key.find_first_of("\r\n") == std::string::npos)
+			fprintf(file, "%s\t%s\n", entry.hash.c_str(), entry.key.c_str());
+	}
+	const bool bWritten = (fclose(file) == 0);
+
+	if (bWritten) {
+		remove(m_HashFile.c_str());
+		if (rename(tmpfile.c_str(), m_HashFile.c_str()) == 0) {
+			m_bHashesChanged = false;
+			return true;
+		}
+	}
+	remove(tmpfile.c_str());
+	return false;
+}
+
+bool WallpaperCache::FitImage(const std::string& path, const std::string& bmppath,
+	unsigned int width, unsigned int height, FitMode mode, ScaleFilter filter)
+{
+	std::vector<unsigned char> desktop((size_t)width*height*4);
+	if (!FitPixels(path, desktop.data(), width, height, mode, filter))
+		return false;
+
+	// Written to a temporary name first so that a partly written file is never used
+	unsigned int temp = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		temp = m_nTemp++;
+	}
+	const std::string tmppath = bmppath + "." + std::to_string(temp) + ".tmp";
+	if (!SaveBitmap(tmppath, desktop.data(), width, height)) {
+		std::error_code ec;
+		fs::remove(fs::path(tmppath), ec);
+		return false;
+	}
+	std::error_code ec;
+	fs::rename(fs::path(tmppath), fs::path(bmppath), ec);
+	if (ec) {
+		fs::remove(fs::path(tmppath), ec);
+		return false;
+	}
+	return true;
+}
+
+bool WallpaperCache::FitPixels(const std::string& path, unsigned char* desktop,
+	unsigned int width, unsigned int height, FitMode mode, ScaleFilter filter)
+{
+	// Decoded as RGBA
+	int imageWidth = 0;
+	int imageHeight = 0;
+	int channels = 0;
+	unsigned char* image = nullptr;
+	{
+		TRACE_SCOPE("Decode image", "image");
+		image = stbi_load(path.c_str(), &imageWidth, &imageHeight, &channels, 4);
+	}
+	if (!image)
+		return false;
+	ConvertPixels(image, 0, PIXEL_RGBA, image, 0, PIXEL_BGRA, (unsigned int)imageWidth, (unsigned int)imageHeight);
+
+	// Placed on a black desktop
+	memset(desktop, 0, (size_t)width*height*4);
+	const FitRect src = FitSource((unsigned int)imageWidth, (unsigned int)imageHeight, width, height, mode);
+	const FitRect dst = FitDestination((unsigned int)imageWidth, (unsigned int)imageHeight, width, height, mode);
+	// The window thread does not wait for a slide being prepared
+	// at low priority. It uses a scaler of its own instead.
+	bool bScaled = false;
+	std::unique_lock<std::mutex> lock(m_ScaleMutex, std::try_to_lock);
+	if (lock.owns_lock()) {
+		bScaled = m_Scaler.Scale(image, (unsigned int)imageWidth*4, src, desktop, width*4, dst, filter);
+		lock.unlock();
+	}
+	else {
+		FrameScaler scaler;
+		scaler.SetThreads(1);
+		bScaled = scaler.Scale(image, (unsigned int)imageWidth*4, src, desktop, width*4, dst, filter);
+	}
+	stbi_image_free(image);
+
+	// Opaque, as the shell shows it
+	const size_t pixels = (size_t)width*height;
+	for (size_t i = 0; i < pixels; i++)
+		desktop[i*4 + 3] = 255;
+	return bScaled;
+}
+
+// xxHash64 primes
+static const uint64_t xxprime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t xxprime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t xxprime3 = 0x165667B19E3779F9ULL;
+static const uint64_t xxprime4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t xxprime5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t Rotate(uint64_t x, int bits)
+{
+	return (x << bits) | (x >> (64 - bits));
+}
+
+static inline uint64_t Read64(const unsigned char* p)
+{
+	uint64_t word = 0;
+	memcpy(&word, p, 8);
+	return word;
+}
+
+// Multiply and rotate one word into a lane
+static inline uint64_t Round(uint64_t acc, uint64_t word)
+{
+	return Rotate(acc + word*xxprime2, 31)*xxprime1;
+}
+
+// xxHash64 with seed 0, read in 1 MB blocks.
+// Every bit of a word changes all bits of the lane it is mixed into.
+std::string WallpaperCache::HashFile(const std::string& path)
+{
+	FILE* file = OpenCacheFile(path, "rb");
+	if (!file)
+		return std::string();
+
+	// Four lanes, each taking one word of every 32 bytes
+	uint64_t lanes[4] = { xxprime1 + xxprime2, xxprime2, 0, 0 - xxprime1 };
+	uint64_t total = 0;
+	std::vector<unsigned char> buffer(1024*1024);
+	size_t held = 0; // Bytes after the last 32 read, moved to the start
+	size_t bytes = 0;
+	while ((bytes = fread(buffer.data() + held, 1, buffer.size() - held, file)) > 0) {
+		total += bytes;
+		held += bytes;
+		size_t i = 0;
+		for (; i + 32 <= held; i += 32) {
+			for (int j = 0; j < 4; j++)
+				lanes[j] = Round(lanes[j], Read64(buffer.data() + i + j*8));
+		}
+		memmove(buffer.data(), buffer.data() + i, held - i);
+		held -= i;
+	}
+	const bool bError = (ferror(file) != 0);
+	fclose(file);
+	if (bError)
+		return std::string();
+
+	uint64_t hash = xxprime5;
+	if (total >= 32) {
+		hash = Rotate(lanes[0], 1) + Rotate(lanes[1], 7) + Rotate(lanes[2], 12) + Rotate(lanes[3], 18);
+		for (int j = 0; j < 4; j++)
+			hash = (hash ^ Round(0, lanes[j]))*xxprime1 + xxprime4;
+	}
+	hash += total;
+
+	// The bytes left over
+	const unsigned char* p = buffer.data();
+	const unsigned char* end = p + held;
+	for (; p + 8 <= end; p += 8)
+		hash = Rotate(hash ^ Round(0, Read64(p)), 27)*xxprime1 + xxprime4;
+	if (p + 4 <= end) {
+		uint32_t word = 0;
+		memcpy(&word, p, 4);
+		hash = Rotate(hash ^ ((uint64_t)word*xxprime1), 23)*xxprime2 + xxprime3;
+		p += 4;
+	}
+	for (; p < end; p++)
+		hash = Rotate(hash ^ ((uint64_t)*p*xxprime5), 11)*xxprime1;
+
+	hash ^= hash >> 33;
+	hash *= xxprime2;
+	hash ^= hash >> 29;
+	hash *= xxprime3;
+	hash ^= hash >> 32;
+	char tmp[17]{};
+	snprintf(tmp, 17, "%016llx", (unsigned long long)hash);
+	return tmp;
+}
+
+static void PutBytes(unsigned char* p, uint32_t value, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+		p[i] = (unsigned char)(value >> (i*8));
+}
+
+static uint32_t GetBytes(const unsigned char* p, int bytes)
+{
+	uint32_t value = 0;
+	for (int i = 0; i < bytes; i++)
+		value |= (uint32_t)p[i] << (i*8);
+	return value;
+}
+
+// Bottom up, as the shell expects. 32 bit lines need no padding.
+bool WallpaperCache::SaveBitmap(const std::string& path, const unsigned char* pixels,
+	unsigned int width, unsigned int height)
+{
+	if (!pixels || width == 0 || height == 0)
+		return false;
+
+	const uint32_t linebytes = width*4;
+	const uint32_t imagebytes = linebytes*height;
+
+	// BITMAPFILEHEADER and BITMAPINFOHEADER
+	unsigned char header[54]{};
+	header[0] = 'B';
+	header[1] = 'M';
+	PutBytes(header + 2, 54 + imagebytes, 4); // File size
+	PutBytes(header + 10, 54, 4);             // Offset to the pixels
+	PutBytes(header + 14, 40, 4);             // Info header size
+	PutBytes(header + 18, width, 4);
+	PutBytes(header + 22, height, 4);
+	PutBytes(header + 26, 1, 2);              // Planes
+	PutBytes(header + 28, 32, 2);             // Bits per pixel
+	PutBytes(header + 34, imagebytes, 4);
+
+	FILE* file = OpenCacheFile(path, "wb");
+	if (!file)
+		return false;
+
+	bool bWritten = (fwrite(header, 1, 54, file) == 54);
+	for (unsigned int y = 0; y < height && bWritten; y++) {
+		const unsigned char* src = pixels + (size_t)(height - 1 - y)*linebytes;
+		bWritten = (fwrite(src, 1, linebytes, file) == linebytes);
+	}
+	if (fclose(file) != 0)
+		bWritten = false;
+	return bWritten;
+}
+
+// Each line is read straight into its place in the frame
+bool WallpaperCache::ReadBitmap(const std::string& path, unsigned char* pixels,
+	unsigned int width, unsigned int height)
+{
+	if (!pixels || width == 0 || height == 0)
+		return false;
+
+	FILE* file = OpenCacheFile(path, "rb");
+	if (!file)
+		return false;
+	// Read ahead in large blocks rather than a line at a time
+	setvbuf(file, nullptr, _IOFBF, 1024*1024);
+
+	const uint32_t linebytes = width*4;
+	unsigned char header[54]{};
+	bool bRead = (fread(header, 1, 54, file) == 54)
+		&& header[0] == 'B' && header[1] == 'M'
+		&& GetBytes(header + 10, 4) == 54
+		&& GetBytes(header + 18, 4) == width
+		&& GetBytes(header + 22, 4) == height
+		&& GetBytes(header + 28, 2) == 32
+		&& GetBytes(header + 30, 4) == 0; // Not compressed
+
+	for (unsigned int y = 0; y < height && bRead; y++) {
+		unsigned char* dst = pixels + (size_t)(height - 1 - y)*linebytes;
+		bRead = (fread(dst, 1, linebytes, file) == linebytes);
+	}
+	fclose(file);
+	return bRead;
+}
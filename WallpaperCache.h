@@ -0,0 +1,137 @@
+//
+//		WallpaperCache
+//
+//		Images fitted to the desktop before they are set as the wallpaper.
+//
+//		Explorer decodes, scales and converts the wallpaper image each time
+//		it is changed, which takes a noticeable time for large images.
+//		Each image is instead decoded once with stb_image, placed on the
+//		desktop size with the fit mode and saved as an uncompressed BMP
+//		that the shell can use as it is. The BMP is 32 bit BGRA, the same
+//		as a frame, so that a slide is read from it without conversion.
+//
+//		Files are named from a hash of the image contents, the desktop
+//		size, the fit mode and the filter, so a moved or renamed image is
+//		still found and an edited one is fitted again. The folder is
+//		limited to a total size by a DiskCache, least recently used first.
+//
+//		The hash of each image is kept for its path, size and time so that
+//		the contents are only read again when the file changes. The most
+//		recently used hashes are saved next to the folder and read when it
+//		is opened, so that images are not read again after a restart.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <mutex>
+#include <unordered_map>
+#include <list>
+#include "DiskCache.h"
+#include "FrameFit.h"
+#include "FrameScaler.h"
+#include "FramePool.h"
+
+// Images fitted and the time taken (msec)
+struct WallpaperCacheStats {
+	uint64_t hits = 0;    // Fitted image found in the cache
+	uint64_t fitted = 0;  // Images decoded, fitted and saved
+	uint64_t failed = 0;  // Images that could not be decoded, used as they are
+	double mean = 0.0;    // Time to fit an image
+	double max = 0.0;
+};
+
+class WallpaperCache {
+
+public:
+
+	WallpaperCache();
+
+	// Folder for the fitted images, created if necessary,
+	// and the total size allowed in bytes.
+	// The image hashes saved beside the folder are read.
+	bool Open(const std::string& folder, uint64_t budget);
+	bool IsOpen() const { return m_Cache.IsOpen(); }
+
+	// Write the image hashes if they have changed
+	bool Save();
+
+	// Image hashes kept, the least recently used are removed
+	void SetMaxHashes(size_t hashes) { m_MaxHashes = hashes; }
+
+	// Filter used to scale images. Default SCALE_AREA.
+	void SetFilter(ScaleFilter filter) { m_Filter = filter; }
+
+	// Path of the image fitted to the desktop size, fitting it if not cached.
+	// Returns the image path itself if it cannot be decoded or the cache is not open.
+	// May be called on any thread.
+	std::string GetWallpaper(const std::string& path, unsigned int width, unsigned int height, FitMode mode);
+
+	// BGRA pixels of the image fitted to the desktop size, in a buffer from the shared FramePool.
+	// Read from the fitted image, which is fitted and saved first if not cached.
+	// Returns false if the image cannot be decoded. May be called on any thread.
+	bool GetFrame(const std::string& path, unsigned int width, unsigned int height, FitMode mode, FrameBuffer& frame);
+
+	WallpaperCacheStats GetStats() const;
+
+	// 64 bit hash of the contents of a file as 16 hex characters.
+	// Empty if the file cannot be read.
+	static std::string HashFile(const std::string& path);
+
+	// Save a BGRA image as an uncompressed 32 bit BMP
+	static bool SaveBitmap(const std::string& path, const unsigned char* pixels,
+		unsigned int width, unsigned int height);
+	// Read the BGRA pixels of a BMP saved by SaveBitmap.
+	// Returns false if it is not 32 bit or not the size given.
+	static bool ReadBitmap(const std::string& path, unsigned char* pixels,
+		unsigned int width, unsigned int height);
+
+private:
+
+	std::string GetContentHash(const std::string& path);
+	void StoreHash(const std::string& key, const std::string& hash);
+	bool LoadHashes();
+	bool FitImage(const std::string& path, const std::string& bmppath,
+		unsigned int width, unsigned int height, FitMode mode, ScaleFilter filter);
+	// Decode an image and place it on a black desktop
+	bool FitPixels(const std::string& path, unsigned char* desktop,
+		unsigned int width, unsigned int height, FitMode mode, ScaleFilter filter);
+
+	DiskCache m_Cache;
+	ScaleFilter m_Filter = SCALE_AREA;
+	FrameScaler m_Scaler; // Kept from one image to the next
+	std::mutex m_ScaleMutex;
+	mutable std::mutex m_Mutex;
+	struct HashEntry {
+		std::string key;  // Path, size and time
+		std::string hash; // Content hash
+	};
+	std::list<HashEntry> m_HashOrder; // Most recently used last
+	std::unordered_map<std::string, std::list<HashEntry>::iterator> m_Hashes;
+	std::string m_HashFile;
+	size_t m_MaxHashes = 4096;
+	bool m_bHashesChanged = false;
+	WallpaperCacheStats m_Stats;
+	unsigned int m_nTemp = 0; // Unique names for files being written
+
+};
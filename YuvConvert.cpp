@@ -0,0 +1,323 @@
+//
+//		YuvConvert
+//
+//		Planar YUV 4:2:0 to BGRA conversion.
+//
+//		For each pixel, with u and v offset by -128 and y by the range offset :
+//
+//		  R = (cy*y + crv*v + round) >> 13
+//		  G = (cy*y - cgu*u - cgv*v + round) >> 13
+//		  B = (cy*y + cbu*u + round) >> 13
+//
+//		clamped to 0-255. The SIMD kernels compute the pairs with a
+//		16 x 16 -> 32 bit multiply-add (pmaddwd) so that all results are exact.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#include "YuvConvert.h"
+
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif
+
+#define YUV_SHIFT 13
+#define YUV_ROUND (1 << (YUV_SHIFT - 1))
+
+// Fixed point coefficients scaled by 2^13
+struct YuvCoefficients {
+	int yoffset; // Subtracted from luma
+	int cy;      // Luma scale
+	int crv;     // V contribution to red
+	int cgu;     // U contribution to green (subtracted)
+	int cgv;     // V contribution to green (subtracted)
+	int cbu;     // U contribution to blue
+};
+
+static const YuvCoefficients coefficients[2][2] = {
+	// Limited range
+	{
+		{ 16, 9539, 13075, 3209, 6660, 16525 }, // BT.601
+		{ 16, 9539, 14686, 1747, 4366, 17305 }, // BT.709
+	},
+	// Full range
+	{
+		{ 0, 8192, 11485, 2819, 5850, 14516 },  // BT.601
+		{ 0, 8192, 12901, 1535, 3835, 15201 },  // BT.709
+	},
+};
+
+static const YuvCoefficients& GetCoefficients(const YuvColor& color)
+{
+	return coefficients[color.bFullRange ? 1 : 0][color.matrix == YUV_BT601 ? 0 : 1];
+}
+
+// Two 16 bit coefficients packed for _mm_madd_epi16
+static inline int Pair16(int lo, int hi)
+{
+	return (int)(((unsigned int)hi << 16) | ((unsigned int)lo & 0xFFFF));
+}
+
+static inline unsigned char Clamp255(int value)
+{
+	return (unsigned char)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+size_t YuvFrameSize(unsigned int width, unsigned int height)
+{
+	const size_t chromawidth = (width + 1)/2;
+	const size_t chromaheight = (height + 1)/2;
+	return (size_t)width*height + chromawidth*chromaheight*2;
+}
+
+//
+// Scalar reference.
+// Converts pixels from x to the end of the line.
+//
+static void ConvertLineScalar(const unsigned char* yline, const unsigned char* uline, const unsigned char* vline,
+	unsigned char* dst, unsigned int x, unsigned int width, bool bNV12, const YuvCoefficients& c)
+{
+	for (; x < width; x++) {
+		const int y = ((int)yline[x] - c.yoffset)*c.cy;
+		int u = 0;
+		int v = 0;
+		if (bNV12) {
+			u = (int)uline[(x/2)*2] - 128;
+			v = (int)uline[(x/2)*2 + 1] - 128;
+		}
+		else {
+			u = (int)uline[x/2] - 128;
+			v = (int)vline[x/2] - 128;
+		}
+		unsigned char* pixel = dst + x*4;
+		pixel[0] = Clamp255((y + c.cbu*u + YUV_ROUND) >> YUV_SHIFT);
+		pixel[1] = Clamp255((y - c.cgu*u - c.cgv*v + YUV_ROUND) >> YUV_SHIFT);
+		pixel[2] = Clamp255((y + c.crv*v + YUV_ROUND) >> YUV_SHIFT);
+		pixel[3] = 255;
+	}
+}
+
+#ifdef SIMD_X86
+
+//
+// SSE2
+//
+// Y, U and V are 8 pixels of signed 16 bit values.
+// U and V are already duplicated for each pair of pixels.
+//
+static inline void Convert8_SSE2(__m128i y, __m128i u, __m128i v, unsigned char* dst, const YuvCoefficients& c)
+{
+	const __m128i round = _mm_set1_epi32(YUV_ROUND);
+	const __m128i one = _mm_set1_epi16(1);
+	// Coefficient pairs for _mm_madd_epi16
+	const __m128i kyv_r = _mm_set1_epi32(Pair16(c.cy, c.crv));
+	const __m128i kyu_b = _mm_set1_epi32(Pair16(c.cy, c.cbu));
+	const __m128i kyu_g = _mm_set1_epi32(Pair16(c.cy, -c.cgu));
+	const __m128i kv1_g = _mm_set1_epi32(Pair16(-c.cgv, YUV_ROUND));
+
+	const __m128i yv_lo = _mm_unpacklo_epi16(y, v);
+	const __m128i yv_hi = _mm_unpackhi_epi16(y, v);
+	const __m128i yu_lo = _mm_unpacklo_epi16(y, u);
+	const __m128i yu_hi = _mm_unpackhi_epi16(y, u);
+	const __m128i v1_lo = _mm_unpacklo_epi16(v, one);
+	const __m128i v1_hi = _mm_unpackhi_epi16(v, one);
+
+	__m128i r_lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yv_lo, kyv_r), round), YUV_SHIFT);
+	__m128i r_hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yv_hi, kyv_r), round), YUV_SHIFT);
+	__m128i b_lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yu_lo, kyu_b), round), YUV_SHIFT);
+	__m128i b_hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yu_hi, kyu_b), round), YUV_SHIFT);
+	__m128i g_lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yu_lo, kyu_g), _mm_madd_epi16(v1_lo, kv1_g)), YUV_SHIFT);
+	__m128i g_hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yu_hi, kyu_g), _mm_madd_epi16(v1_hi, kv1_g)), YUV_SHIFT);
+
+	// 16 bit and clamp to 0-255
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi16(255);
+	__m128i r = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(r_lo, r_hi), zero), max);
+	__m128i g = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(g_lo, g_hi), zero), max);
+	__m128i b = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(b_lo, b_hi), zero), max);
+
+	// B G R A bytes
+	const __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+	const __m128i ra = _mm_or_si128(r, _mm_set1_epi16((short)0xFF00));
+	_mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi16(bg, ra));
+	_mm_storeu_si128((__m128i*)(dst + 16), _mm_unpackhi_epi16(bg, ra));
+}
+
+// Returns the number of pixels converted
+static unsigned int ConvertLineSSE2(const unsigned char* yline, const unsigned char* uline, const unsigned char* vline,
+	unsigned char* dst, unsigned int width, bool bNV12, const YuvCoefficients& c)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i yoffset = _mm_set1_epi16((short)c.yoffset);
+	const __m128i uvoffset = _mm_set1_epi16(128);
+	const __m128i lowbytes = _mm_set1_epi16(0x00FF);
+
+	unsigned int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		const __m128i y8 = _mm_loadu_si128((const __m128i*)(yline + x));
+		const __m128i y_lo = _mm_sub_epi16(_mm_unpacklo_epi8(y8, zero), yoffset);
+		const __m128i y_hi = _mm_sub_epi16(_mm_unpackhi_epi8(y8, zero), yoffset);
+		__m128i u, v;
+		if (bNV12) {
+			const __m128i uv = _mm_loadu_si128((const __m128i*)(uline + x));
+			u = _mm_sub_epi16(_mm_and_si128(uv, lowbytes), uvoffset);
+			v = _mm_sub_epi16(_mm_srli_epi16(uv, 8), uvoffset);
+		}
+		else {
+			u = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(uline + x/2)), zero), uvoffset);
+			v = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(vline + x/2)), zero), uvoffset);
+		}
+		// Each chroma sample for two pixels
+		Convert8_SSE2(y_lo, _mm_unpacklo_epi16(u, u), _mm_unpacklo_epi16(v, v), dst + x*4, c);
+		Convert8_SSE2(y_hi, _mm_unpackhi_epi16(u, u), _mm_unpackhi_epi16(v, v), dst + x*4 + 32, c);
+	}
+	return x;
+}
+
+//
+// AVX2
+//
+// 16 pixels of signed 16 bit values in pixel order.
+// Unpack and madd work within each 128 bit lane, so results are
+// [0-3 | 8-11] and [4-7 | 12-15] which pack back to pixel order.
+//
+SIMD_TARGET_AVX2
+static inline void Convert16_AVX2(__m256i y, __m256i u, __m256i v, unsigned char* dst, const YuvCoefficients& c)
+{
+	const __m256i round = _mm256_set1_epi32(YUV_ROUND);
+	const __m256i one = _mm256_set1_epi16(1);
+	const __m256i kyv_r = _mm256_set1_epi32(Pair16(c.cy, c.crv));
+	const __m256i kyu_b = _mm256_set1_epi32(Pair16(c.cy, c.cbu));
+	const __m256i kyu_g = _mm256_set1_epi32(Pair16(c.cy, -c.cgu));
+	const __m256i kv1_g = _mm256_set1_epi32(Pair16(-c.cgv, YUV_ROUND));
+
+	const __m256i yv_lo = _mm256_unpacklo_epi16(y, v);
+	const __m256i yv_hi = _mm256_unpackhi_epi16(y, v);
+	const __m256i yu_lo = _mm256_unpacklo_epi16(y, u);
+	const __m256i yu_hi = _mm256_unpackhi_epi16(y, u);
+	const __m256i v1_lo = _mm256_unpacklo_epi16(v, one);
+	const __m256i v1_hi = _mm256_unpackhi_epi16(v, one);
+
+	__m256i r_lo = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yv_lo, kyv_r), round), YUV_SHIFT);
+	__m256i r_hi = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yv_hi, kyv_r), round), YUV_SHIFT);
+	__m256i b_lo = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yu_lo, kyu_b), round), YUV_SHIFT);
+	__m256i b_hi = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yu_hi, kyu_b), round), YUV_SHIFT);
+	__m256i g_lo = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yu_lo, kyu_g), _mm256_madd_epi16(v1_lo, kv1_g)), YUV_SHIFT);
+	__m256i g_hi = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yu_hi, kyu_g), _mm256_madd_epi16(v1_hi, kv1_g)), YUV_SHIFT);
+
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i max = _mm256_set1_epi16(255);
+	__m256i r = _mm256_min_epi16(_mm256_max_epi16(_mm256_packs_epi32(r_lo, r_hi), zero), max);
+	__m256i g = _mm256_min_epi16(_mm256_max_epi16(_mm256_packs_epi32(g_lo, g_hi), zero), max);
+	__m256i b = _mm256_min_epi16(_mm256_max_epi16(_mm256_packs_epi32(b_lo, b_hi), zero), max);
+
+	// B G R A bytes. Unpack gives [0-3 | 8-11] and [4-7 | 12-15].
+	const __m256i bg = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+	const __m256i ra = _mm256_or_si256(r, _mm256_set1_epi16((short)0xFF00));
+	const __m256i lo = _mm256_unpacklo_epi16(bg, ra);
+	const __m256i hi = _mm256_unpackhi_epi16(bg, ra);
+	_mm256_storeu_si256((__m256i*)dst, _mm256_permute2x128_si256(lo, hi, 0x20));
+	_mm256_storeu_si256((__m256i*)(dst + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+SIMD_TARGET_AVX2
+static unsigned int ConvertLineAVX2(const unsigned char* yline, const unsigned char* uline, const unsigned char* vline,
+	unsigned char* dst, unsigned int width, bool bNV12, const YuvCoefficients& c)
+{
+	const __m256i yoffset = _mm256_set1_epi16((short)c.yoffset);
+	const __m256i uvoffset = _mm256_set1_epi16(128);
+	const __m128i lowbytes = _mm_set1_epi16(0x00FF);
+
+	unsigned int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		const __m256i y = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(yline + x))), yoffset);
+		__m256i u, v;
+		if (bNV12) {
+			const __m128i uv = _mm_loadu_si128((const __m128i*)(uline + x));
+			const __m128i u8 = _mm_and_si128(uv, lowbytes);
+			const __m128i v8 = _mm_srli_epi16(uv, 8);
+			u = _mm256_setr_m128i(_mm_unpacklo_epi16(u8, u8), _mm_unpackhi_epi16(u8, u8));
+			v = _mm256_setr_m128i(_mm_unpacklo_epi16(v8, v8), _mm_unpackhi_epi16(v8, v8));
+		}
+		else {
+			const __m128i u8 = _mm_loadl_epi64((const __m128i*)(uline + x/2));
+			const __m128i v8 = _mm_loadl_epi64((const __m128i*)(vline + x/2));
+			u = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(u8, u8));
+			v = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(v8, v8));
+		}
+		Convert16_AVX2(y, _mm256_sub_epi16(u, uvoffset), _mm256_sub_epi16(v, uvoffset), dst + x*4, c);
+	}
+	return x;
+}
+
+#endif // SIMD_X86
+
+void YuvToBgra(const unsigned char* yplane, unsigned int ypitch,
+	const unsigned char* uplane, const unsigned char* vplane, unsigned int uvpitch,
+	unsigned char* dst, unsigned int dstpitch,
+	unsigned int width, unsigned int height,
+	const YuvColor& color, SimdLevel level)
+{
+	if (!yplane || !uplane || !dst || width == 0 || height == 0)
+		return;
+	const bool bNV12 = (color.format == YUV_NV12);
+	if (!bNV12 && !vplane)
+		return;
+
+	const YuvCoefficients& c = GetCoefficients(color);
+	level = ResolveSimdLevel(level);
+
+	for (unsigned int y = 0; y < height; y++) {
+		const unsigned char* yline = yplane + (size_t)y*ypitch;
+		const unsigned char* uline = uplane + (size_t)(y/2)*uvpitch;
+		const unsigned char* vline = bNV12 ? nullptr : vplane + (size_t)(y/2)*uvpitch;
+		unsigned char* dline = dst + (size_t)y*dstpitch;
+		unsigned int x = 0;
+#ifdef SIMD_X86
+		if (level == SIMD_AVX2)
+			x = ConvertLineAVX2(yline, uline, vline, dline, width, bNV12, c);
+		else if (level == SIMD_SSE2)
+			x = ConvertLineSSE2(yline, uline, vline, dline, width, bNV12, c);
+#endif
+		// Remaining pixels
+		ConvertLineScalar(yline, uline, vline, dline, x, width, bNV12, c);
+	}
+}
+
+void YuvToBgra(const unsigned char* src, unsigned char* dst,
+	unsigned int width, unsigned int height,
+	const YuvColor& color, SimdLevel level)
+{
+	if (!src || !dst)
+		return;
+
+	// Planes are packed without padding
+	const unsigned int chromawidth = (width + 1)/2;
+	const unsigned int chromaheight = (height + 1)/2;
+	const unsigned char* yplane = src;
+	const unsigned char* uplane = src + (size_t)width*height;
+	if (color.format == YUV_NV12) {
+		YuvToBgra(yplane, width, uplane, nullptr, chromawidth*2, dst, width*4, width, height, color, level);
+	}
+	else {
+		const unsigned char* vplane = uplane + (size_t)chromawidth*chromaheight;
+		YuvToBgra(yplane, width, uplane, vplane, chromawidth, dst, width*4, width, height, color, level);
+	}
+}
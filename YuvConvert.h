@@ -0,0 +1,71 @@
+//
+//		YuvConvert
+//
+//		Planar YUV 4:2:0 to BGRA conversion.
+//
+//		Video is sent from FFmpeg as I420 (yuv420p) or NV12 at 1.5 bytes
+//		per pixel instead of 4 bytes for BGRA and converted to the BGRA
+//		buffer used for drawing.
+//
+//		BT.601 and BT.709 matrices with limited (16-235) or full (0-255) range.
+//		Fixed point with 13 fractional bits. The SSE2 and AVX2 kernels
+//		produce exactly the same result as the scalar reference.
+//
+// =========================================================================
+//
+//               Copyright(C) 2024 Lynn Jarvis.
+//               https://www.spout.zeal.co
+//
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.If not, see <http://www.gnu.org/licenses/>.
+//
+// =========================================================================
+//
+#pragma once
+
+#include <stddef.h>
+#include "CpuFeatures.h"
+
+enum YuvFormat {
+	YUV_I420 = 0, // Y plane, U plane, V plane
+	YUV_NV12      // Y plane, interleaved UV plane
+};
+
+enum YuvMatrix {
+	YUV_BT601 = 0,
+	YUV_BT709
+};
+
+// Colour description of a YUV source
+struct YuvColor {
+	YuvFormat format = YUV_I420;
+	YuvMatrix matrix = YUV_BT709;
+	bool bFullRange = false;
+};
+
+// Size in bytes of a packed 4:2:0 frame
+size_t YuvFrameSize(unsigned int width, unsigned int height);
+
+// Convert a packed 4:2:0 frame, as sent by FFmpeg rawvideo, to BGRA.
+// The destination is width*4 bytes per line.
+void YuvToBgra(const unsigned char* src, unsigned char* dst,
+	unsigned int width, unsigned int height,
+	const YuvColor& color, SimdLevel level = SIMD_AUTO);
+
+// Convert separate planes with any line pitch.
+// For NV12, uplane is the interleaved UV plane and vplane is not used.
+void YuvToBgra(const unsigned char* yplane, unsigned int ypitch,
+	const unsigned char* uplane, const unsigned char* vplane, unsigned int uvpitch,
+	unsigned char* dst, unsigned int dstpitch,
+	unsigned int width, unsigned int height,
+	const YuvColor& color, SimdLevel level = SIMD_AUTO);
@@ -10,6 +10,23 @@
 #define IDM_DAILY                               202
 #define IDM_SLIDESHOW                           203
 #define IDM_ABOUT                               204
+#define IDM_FIT_STRETCH                         205
+#define IDM_FIT_FIT                             206
+#define IDM_FIT_FILL                            207
+#define IDM_FIT_CENTER                          208
+#define IDM_SPEED_025                           209
+#define IDM_SPEED_050                           210
+#define IDM_SPEED_100                           211
+#define IDM_SPEED_150                           212
+#define IDM_SPEED_200                           213
+#define IDM_DECODER_PIPE                        214
+#define IDM_DECODER_LIBAV                       215
+#define IDM_FRAMECACHE                          216
+#define IDM_SCALE_NEAREST                       217
+#define IDM_SCALE_BILINEAR                      218
+#define IDM_SCALE_AREA                          219
+#define IDM_SAVESTATS                           220
+#define IDM_TRACE                               221
 
 #define IDC_STEALTHDIALOG                       300
 #define IDI_STEALTHDLG                          301
@@ -17,5 +34,6 @@
 #define IDC_LIVE_WALLPAPER						303
 #define IDC_SLIDE_DURATION                      304
 #define IDC_SLIDE_RANDOM                        305
+#define IDC_SLIDE_FADE                          306
 
 